@@ -1,4 +1,5 @@
 #include "PPCodePointCheck.h"
+#include <cstdint>
 
 #include <vector>
 #include <unordered_set>
@@ -212,47 +213,49 @@ bool PPCodePointCheck::isSign(const char32_t ch32)
 bool PPCodePointCheck::isNotHChar(const char32_t ch32)
 {
   for (const char ch: _h_char_exclude_list)
-    if (static_cast<char>(ch32) == ch)
+    if (ch32 == static_cast<char32_t>(ch))
       return true;
-  return !PPCodePointCheck::isBasicSourceCharacter(ch32);
+  // h-, q-, c-, s- and r-chars are any other member of the source
+  // character set, which holds every code point after phase 1.
+  return false;
 }
 
 bool PPCodePointCheck::isNotQChar(const char32_t ch32)
 {
   for (const char ch: _q_char_exclude_list)
-    if (static_cast<char>(ch32) == ch)
+    if (ch32 == static_cast<char32_t>(ch))
       return true;
-  return !PPCodePointCheck::isBasicSourceCharacter(ch32);
+  return false;
 }
 
 bool PPCodePointCheck::isNotCChar(const char32_t ch32)
 {
   for (const char ch: _c_char_exclude_list)
-    if (static_cast<char>(ch32) == ch)
+    if (ch32 == static_cast<char32_t>(ch))
       return true;
-  return !PPCodePointCheck::isBasicSourceCharacter(ch32);
+  return false;
 }
 
 bool PPCodePointCheck::isNotSChar(const char32_t ch32)
 {
   for (const char ch: _s_char_exclude_list)
-    if (static_cast<char>(ch32) == ch)
+    if (ch32 == static_cast<char32_t>(ch))
       return true;
-  return !PPCodePointCheck::isBasicSourceCharacter(ch32);
+  return false;
 }
 
 bool PPCodePointCheck::isNotRChar(const char32_t ch32)
 {
   for (const char ch: _r_char_exclude_list)
-    if (static_cast<char>(ch32) == ch)
+    if (ch32 == static_cast<char32_t>(ch))
       return true;
-  return !PPCodePointCheck::isBasicSourceCharacter(ch32);
+  return false;
 }
 
 bool PPCodePointCheck::isNotDChar(const char32_t ch32)
 {
   for (const char ch: _d_char_exclude_list)
-    if (static_cast<char>(ch32) == ch)
+    if (ch32 == static_cast<char32_t>(ch))
       return true;
   return !PPCodePointCheck::isBasicSourceCharacter(ch32);
 }
@@ -1,6 +1,7 @@
 #include "PPCodePointCheck.h"
 #include "PPCodeUnit.h"
 #include "utils/UStringTools.h"
+#include <cstring>
 
 std::shared_ptr<PPCodeUnitASCIIChar> PPCodeUnit::createASCIIChar(const char ch)
 {
@@ -22,11 +23,8 @@ PPCodeUnit::createWhitespaceCharacter(const std::string &u8str)
       ch = u8str[0];
     else
       return nullptr;
-  } else if (u8str.length() == 2) {
-    if (u8str == "\\\n")
-      ch = 0;
-    else
-      return nullptr;
+  } else if (u8str == "\\\n"  ||  u8str == "?\?/\n") {
+    ch = 0;
   } else {
     return nullptr;
   }
@@ -39,6 +37,16 @@ PPCodeUnit::createUniversalCharacterName(const char32_t ch32, const std::string
   return std::make_shared<PPCodeUnitUniversalCharacterName>(ch32, u8str);
 }
 
+std::shared_ptr<PPCodeUnitTrigraph> PPCodeUnit::createTrigraph(const char last)
+{
+  static const char lasts[] = "=/'()!<>-";
+  static const char chars[] = "#\\^[]|{}~";
+  const char *p = last ? strchr(lasts, last) : nullptr;
+  if (!p)
+    return nullptr;
+  return std::make_shared<PPCodeUnitTrigraph>(chars[p - lasts], last);
+}
+
 std::string PPCodeUnitASCIIChar::getRawText() const
 {
   return UStringTools::u32_to_u8(std::u32string(1, _ch32));
@@ -68,3 +76,13 @@ std::string PPCodeUnitUniversalCharacterName::getUTF8String() const
 {
   return UStringTools::u32_to_u8(std::u32string(1, _ch32));
 }
+
+std::string PPCodeUnitTrigraph::getRawText() const
+{
+  return std::string("??") + _last;
+}
+
+std::string PPCodeUnitTrigraph::getUTF8String() const
+{
+  return std::string(1, static_cast<char>(_ch32));
+}
@@ -13,7 +13,8 @@
 //   0x0B     vertical tab
 //   0x0C     form feed
 //   0x20     whitespace, ' '
-//   A backslash \ followed by a newline \n
+//   A backslash \ followed by a newline \n, the backslash possibly spelled as
+//   a trigraph
 // The value associated with a WhitespaceCharacter is the same as its ASCII
 // character for single characters, or same as the ASCII space character 0x20
 // for the backslash followed by a newline.
@@ -32,12 +33,17 @@
 //
 // UniversalCharacterName is just the universal-character-name as defined in the
 // C++ specification.
+//
+// Trigraph is one of the nine trigraph sequences, such as ??=, whose value is
+// the character it replaces, such as #. Like a universal-character-name, it is
+// reverted in raw strings.
 
 enum class PPCodeUnitType {
   ASCIIChar,
   NonASCIIChar,
   WhitespaceCharacter,
-  UniversalCharacterName
+  UniversalCharacterName,
+  Trigraph
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -47,6 +53,7 @@ class PPCodeUnitASCIIChar;
 class PPCodeUnitNonASCIIChar;
 class PPCodeUnitWhitespaceCharacter;
 class PPCodeUnitUniversalCharacterName;
+class PPCodeUnitTrigraph;
 
 // Union class of Unicode code point, universal-character-name, and
 // whitespace-sequence.
@@ -62,6 +69,7 @@ public:
 
   PPCodeUnitType getType() const { return _type; }
   char32_t getChar32() const { return _ch32; }
+  bool isLineSplice() const { return _type == PPCodeUnitType::WhitespaceCharacter  &&  _ch32 == 0; }
 
   virtual std::string getRawText() const = 0;
   virtual std::string getUTF8String() const { return getRawText(); }
@@ -74,6 +82,8 @@ public:
     createWhitespaceCharacter(const std::string&);
   static std::shared_ptr<PPCodeUnitUniversalCharacterName>
     createUniversalCharacterName(const char32_t, const std::string&);
+  // nullptr if the char is not the last char of a trigraph.
+  static std::shared_ptr<PPCodeUnitTrigraph> createTrigraph(const char);
 
 protected:
   const PPCodeUnitType _type;
@@ -123,4 +133,14 @@ private:
   const std::string _u8string;
 };
 
+class PPCodeUnitTrigraph: public PPCodeUnit {
+public:
+  PPCodeUnitTrigraph(const char ch, const char last):
+    PPCodeUnit(PPCodeUnitType::Trigraph, static_cast<char32_t>(ch)), _last(last) {}
+  virtual std::string getRawText() const override;
+  virtual std::string getUTF8String() const override;
+private:
+  const char _last;
+};
+
 #endif /* end of include guard */
@@ -18,8 +18,11 @@ bool PPCodeUnitCheck::isNondigit(const UnitPtr unit)
 
 bool PPCodeUnitCheck::isIdentifierNondigit(const UnitPtr unit)
 {
+  // The other implementation-defined characters are those of Annex E.1, as in
+  // identifiers, whether spelled as UTF-8 or as a universal-character-name.
   return PPCodePointCheck::isNondigit(unit->getChar32())
-    || (unit->getType() == PPCodeUnitType::UniversalCharacterName);
+    || (unit->getType() == PPCodeUnitType::UniversalCharacterName)
+    || isInAnnexE1(unit);
 }
 
 bool PPCodeUnitCheck::isInAnnexE1(const UnitPtr unit)
@@ -52,6 +52,8 @@ void PPCodeUnitStream::_pushCodeUnits()
   enum class State {
     Start,
 
+    Question,
+    QuestionQuestion,
     Backslash,
     SingleQuad,
     DoubleQuad,
@@ -62,6 +64,7 @@ void PPCodeUnitStream::_pushCodeUnits()
 
   std::string single_quad_u8str;
   std::string double_quad_u8str;
+  std::string backslash_u8str;  // \ or its trigraph
 
   const auto _toNext = [this] () {
     //const char32_t curr = this->_u32stream->getChar32();
@@ -77,6 +80,13 @@ void PPCodeUnitStream::_pushCodeUnits()
     this->_queue.push(ptr);
   };
 
+  const auto _emitBackslash = [&] () {
+    if (backslash_u8str == "?\?/")
+      _emitCodeUnit(PPCodeUnit::createTrigraph('/'));
+    else
+      _emitCodeUnit(PPCodeUnit::createASCIIChar('\\'));
+  };
+
   std::u32string u32str;
   State state = State::Start;
   _clearError();
@@ -90,6 +100,9 @@ void PPCodeUnitStream::_pushCodeUnits()
       fprintf(stderr,"State::Start\n");
       if (curr32 == U'\\') { // Line splicing, universal-character-name
         state = State::Backslash;
+        backslash_u8str = "\\";
+      } else if (curr32 == U'?') { // Trigraph
+        state = State::Question;
       } else if (PPCodePointCheck::isWhitespaceCharacter(curr32)) {
         state = State::End;
         _emitCodeUnit(PPCodeUnit::createWhitespaceCharacter(std::string(1, static_cast<char>(curr32))));
@@ -102,12 +115,51 @@ void PPCodeUnitStream::_pushCodeUnits()
       }
     }
 
+    else if (state == State::Question) {
+      fprintf(stderr,"State::Question\n");
+      if (curr32 == U'?') {
+        _toNext();
+        state = State::QuestionQuestion;
+      } else {
+        state = State::End;
+        _emitCodeUnit(PPCodeUnit::createASCIIChar('?'));
+      }
+    }
+
+    else if (state == State::QuestionQuestion) {
+      // Phase 1 replaces a trigraph before phase 2 splices lines, so ??/ is a
+      // backslash for line splicing and universal-character-names too. Of ???,
+      // the first ? is a code unit of its own.
+      fprintf(stderr,"State::QuestionQuestion\n");
+      const std::shared_ptr<PPCodeUnitTrigraph> trigraph =
+        curr32 < 0x80 ? PPCodeUnit::createTrigraph(static_cast<char>(curr32)) : nullptr;
+      if (curr32 == U'?') {
+        _toNext();
+        _emitCodeUnit(PPCodeUnit::createASCIIChar('?'));
+      } else if (curr32 == U'/') {
+        _toNext();
+        state = State::Backslash;
+        backslash_u8str = "?\?/";
+      } else if (trigraph) {
+        _toNext();
+        state = State::End;
+        _emitCodeUnit(trigraph);
+      } else {
+        state = State::End;
+        _emitCodeUnit(PPCodeUnit::createASCIIChar('?'));
+        _emitCodeUnit(PPCodeUnit::createASCIIChar('?'));
+      }
+    }
+
     else if (state == State::Backslash) {
       fprintf(stderr,"State::Backslash\n");
       if (curr32 == U'\n') { // line-splice
         state = State::End;
         _toNext();
-        _emitCodeUnit(PPCodeUnit::createWhitespaceCharacter("\\\n"));
+        _emitCodeUnit(PPCodeUnit::createWhitespaceCharacter(backslash_u8str + "\n"));
+        // A file ending in a line-splice still ends in a new-line.
+        if (_u32stream->isEmpty())
+          _emitCodeUnit(PPCodeUnit::createASCIIChar('\n'));
       } else if (curr32 == U'u') { // \uXXXX
         _toNext();
         state = State::SingleQuad;
@@ -116,12 +168,10 @@ void PPCodeUnitStream::_pushCodeUnits()
         _toNext();
         state = State::DoubleQuad;
         double_quad_u8str.clear();
-      } else if (PPCodePointCheck::isBasicSourceCharacter(curr32)) {
-        state = State::End;
-        _emitCodeUnit(PPCodeUnit::createASCIIChar('\\'));
       } else {
-        state = State::Error;
-        _setError(R"(Illegal character following \)");
+        // A stray backslash, the next character is a code unit of its own.
+        state = State::End;
+        _emitBackslash();
       }
     }
 
@@ -132,7 +182,7 @@ void PPCodeUnitStream::_pushCodeUnits()
         // Emit the universal-character-name the hex-quad is filled.
         state = State::End;
         const char32_t value = static_cast<char32_t>(std::stoull(single_quad_u8str, nullptr, 16));
-        _emitCodeUnit(PPCodeUnit::createUniversalCharacterName(value, std::string("\\u") + single_quad_u8str));
+        _emitCodeUnit(PPCodeUnit::createUniversalCharacterName(value, backslash_u8str + "u" + single_quad_u8str));
       } else if (single_quad_u8str.length() > 4) {
         // Impossible to reach this state given the structure of this DFA.
         state = State::Error;
@@ -143,7 +193,7 @@ void PPCodeUnitStream::_pushCodeUnits()
       } else {
         // The single-quad terminated prematurely, emit everything in ASCII.
         state = State::End;
-        _emitCodeUnit(PPCodeUnit::createASCIIChar('\\'));
+        _emitBackslash();
         _emitCodeUnit(PPCodeUnit::createASCIIChar('u'));
         for (const auto ch: single_quad_u8str)
           _emitCodeUnit(PPCodeUnit::createASCIIChar(ch));
@@ -156,7 +206,7 @@ void PPCodeUnitStream::_pushCodeUnits()
         // Emit the universal-character-name the hex-quad is filled.
         state = State::End;
         const char32_t value = static_cast<char32_t>(std::stoull(double_quad_u8str, nullptr, 16));
-        _emitCodeUnit(PPCodeUnit::createUniversalCharacterName(value, std::string("\\U") + double_quad_u8str));
+        _emitCodeUnit(PPCodeUnit::createUniversalCharacterName(value, backslash_u8str + "U" + double_quad_u8str));
       } else if (double_quad_u8str.length() > 8) {
         // Impossible to reach this state given the structure of this DFA.
         state = State::Error;
@@ -167,7 +217,7 @@ void PPCodeUnitStream::_pushCodeUnits()
       } else {
         // The single-quad terminated prematurely, emit everything in ASCII.
         state = State::End;
-        _emitCodeUnit(PPCodeUnit::createASCIIChar('\\'));
+        _emitBackslash();
         _emitCodeUnit(PPCodeUnit::createASCIIChar('U'));
         for (const auto ch: double_quad_u8str)
           _emitCodeUnit(PPCodeUnit::createASCIIChar(ch));
@@ -185,4 +235,27 @@ void PPCodeUnitStream::_pushCodeUnits()
     }
 
   } // while
+
+  // The input ended inside a trigraph or a backslash sequence: a filled
+  // hex-quad is still a universal-character-name, anything else is emitted in
+  // ASCII.
+  if (state == State::Question  ||  state == State::QuestionQuestion)
+    _emitCodeUnit(PPCodeUnit::createASCIIChar('?'));
+  if (state == State::QuestionQuestion)
+    _emitCodeUnit(PPCodeUnit::createASCIIChar('?'));
+  if (state == State::SingleQuad  &&  single_quad_u8str.length() == 4) {
+    const char32_t value = static_cast<char32_t>(std::stoull(single_quad_u8str, nullptr, 16));
+    _emitCodeUnit(PPCodeUnit::createUniversalCharacterName(value, backslash_u8str + "u" + single_quad_u8str));
+  } else if (state == State::DoubleQuad  &&  double_quad_u8str.length() == 8) {
+    const char32_t value = static_cast<char32_t>(std::stoull(double_quad_u8str, nullptr, 16));
+    _emitCodeUnit(PPCodeUnit::createUniversalCharacterName(value, backslash_u8str + "U" + double_quad_u8str));
+  } else if (state == State::Backslash  ||  state == State::SingleQuad  ||  state == State::DoubleQuad) {
+    _emitBackslash();
+    if (state == State::SingleQuad)
+      _emitCodeUnit(PPCodeUnit::createASCIIChar('u'));
+    if (state == State::DoubleQuad)
+      _emitCodeUnit(PPCodeUnit::createASCIIChar('U'));
+    for (const auto ch: state == State::SingleQuad ? single_quad_u8str : double_quad_u8str)
+      _emitCodeUnit(PPCodeUnit::createASCIIChar(ch));
+  }
 }
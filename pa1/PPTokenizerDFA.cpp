@@ -17,7 +17,7 @@ PPTokenizerDFA::PPTokenizerDFA(std::shared_ptr<PPCodeUnitStreamIfc> stream):
 
 bool PPTokenizerDFA::isEmpty() const
 {
-  return _stream->isEmpty()  &&  _queue.empty();
+  return _stream->isEmpty()  &&  _queue.empty()  &&  _errorMessage.empty();
 }
 
 std::shared_ptr<PPToken> PPTokenizerDFA::getPPToken() const
@@ -26,10 +26,17 @@ std::shared_ptr<PPToken> PPTokenizerDFA::getPPToken() const
   return _queue.front();
 }
 
+unsigned PPTokenizerDFA::getLine() const
+{
+  assert(!_lines.empty());
+  return _lines.front();
+}
+
 void PPTokenizerDFA::toNext()
 {
   assert(!_queue.empty());
   _queue.pop();
+  _lines.pop();
   if (_queue.empty())
     _pushTokens();
 }
@@ -70,6 +77,8 @@ void PPTokenizerDFA::_pushTokens()
     MultipleLineComment,
     MultipleLineCommentStar,
 
+    WhitespaceSequence,
+
     EqualSignOp,    // e.g., {+ +=}, {- -=}
 
     VerticalBar,    // |
@@ -137,10 +146,17 @@ void PPTokenizerDFA::_pushTokens()
   static const bool ResetFlags = true;
   static const bool DontResetFlags = false;
 
-  const auto _emitToken = [this] (const std::shared_ptr<PPToken> tok,
+  // Every token of this call starts on the line of the first code unit, but
+  // for the rare ones after a new-line.
+  unsigned line = _line;
+
+  const auto _emitToken = [this, &line] (const std::shared_ptr<PPToken> tok,
       const bool dont_reset_flags) {
     fprintf(stderr,"======== %s =======\n", tok->getRawText().c_str());
     this->_queue.push(tok);
+    this->_lines.push(line);
+    if (tok->getType() == PPTokenType::NewLine)
+      line++;
     if (!dont_reset_flags && tok->getType() != PPTokenType::WhitespaceSequence) {
       this->_isBeginningOfHeaderName = false;
       this->_isPreprocessingDirective = false;
@@ -148,9 +164,21 @@ void PPTokenizerDFA::_pushTokens()
     }
   };
 
-  const auto _toNext = [this] () {
+  // In a raw string, the code units spelled with a trigraph are reverted to
+  // the characters they are spelled with, which are looked at one at a time
+  // from here before the stream goes on.
+  std::queue<std::shared_ptr<PPCodeUnit>> reverted;
+
+  const auto _toNext = [this, &reverted] () {
+    if (!reverted.empty()) {
+      reverted.pop();
+      return;
+    }
     char32_t tmp;
     tmp = _stream->getCodeUnit()->getChar32();
+    // A new-line, or a line-splice.
+    if (tmp == U'\n'  ||  _stream->getCodeUnit()->isLineSplice())
+      this->_line++;
     fprintf(stderr,"%c(%0X) => ", tmp, tmp);
     this->_stream->toNext();
     if (!this->_stream->isEmpty()) {
@@ -159,15 +187,23 @@ void PPTokenizerDFA::_pushTokens()
     }
   };
 
-  while (!_stream->isEmpty()  &&  state != State::End  &&  state != State::Error) {
+  while ((!_stream->isEmpty()  ||  !reverted.empty())  &&  state != State::End  &&  state != State::Error) {
     // In a state block, e.g., the block for if (state == State::SomeState), the
     // developer needs to call _stream->toNext() explicitly otherwise the stream
     // PPCodeUnitStream object will NOT move forward.
     //
     // The reason for doing this is to allow a state to not consume the symbol
     // being processed, e.g., in State::LeftParenthesis.
-    const std::shared_ptr<PPCodeUnit> curr = _stream->getCodeUnit();
+    const std::shared_ptr<PPCodeUnit> curr = reverted.empty() ? _stream->getCodeUnit() : reverted.front();
     const char32_t currChar32 = curr->getChar32();
+
+    if ((state == State::RawStringDelimiter  ||  state == State::RawString  ||  state == State::RawStringKet)
+        &&  curr->getRawText().compare(0, 2, "??") == 0) {
+      _toNext();
+      for (const char ch: curr->getRawText())
+        reverted.push(PPCodeUnit::createASCIIChar(ch));
+      continue;
+    }
     fprintf(stderr,"\n==  U+%06X <%s> \n",
         static_cast<uint32_t>(currChar32), curr->getRawText().c_str());
 
@@ -267,20 +303,17 @@ void PPTokenizerDFA::_pushTokens()
       }
 
       else if (curr->getType() == PPCodeUnitType::WhitespaceCharacter) {
-        // no-op pass
+        comment_u8str = static_cast<char>(currChar32);
+        state = State::WhitespaceSequence;
       }
 
-      else if (!PPCodePointCheck::isBasicSourceCharacter(currChar32)) {
-        // TODO: Should probably emit some warnings here
+      else {
+        // Any other code point, e.g. @ or a stray backslash, is a
+        // non-whitespace-character.
         state = State::End;
         _emitToken(PPToken::createNonWhitespaceChar(UStringTools::u32_to_u8(std::u32string(1, currChar32))), ResetFlags);
       }
 
-      else {
-        state = State::Error;
-        fprintf(stderr,"Dude, you literally exhausted all cases in the pptokenizer's DFA. The DFA does not know what you want to do here\n");
-      }
-
     } // State::Start
 
 
@@ -399,7 +432,7 @@ void PPTokenizerDFA::_pushTokens()
       if (PPCodeUnitCheck::isIdentifierStart(curr)) {
         _toNext();
         state = State::UserDefinedCharacterLiteral;
-        ud_suffix_u8str = std::string(1, static_cast<char>(currChar32));
+        ud_suffix_u8str = curr->getUTF8String();
       } else {
         state = State::End;
         _emitToken(PPToken::createCharacterLiteral(character_literal_u8str), ResetFlags);
@@ -637,16 +670,19 @@ void PPTokenizerDFA::_pushTokens()
       // Previous: RawString or RawStringKet
       // "      => If raw_string_ket_u8str == raw_string_delimiter_u8str
       //           construct string_literal_u8str and transition to
-      //           StringLiteralEnd, otherwise append raw_string_ket_u8str and "
-      //           to raw_string_u8str and transition to RawString.
-      // )      => Append raw_string_ket_u8str and ) to raw_string_u8str. Clear
-      //           raw_string_ket_u8str.
+      //           StringLiteralEnd, otherwise append ), raw_string_ket_u8str
+      //           and " to raw_string_u8str and transition to RawString.
+      // )      => Append ) and raw_string_ket_u8str to raw_string_u8str. Clear
+      //           raw_string_ket_u8str, the new ) may start the delimiter.
       // d-char (excluding ")
       //        => Append currChar32 to raw_string_ket_u8str.
       // r-char (excluding d-char and ")
-      //        => Append raw_string_ket_u8str and curr->getRawText() to
-      //           raw_string_ket_u8str. Transition to RawString.
+      //        => Append ), raw_string_ket_u8str and curr->getRawText() to
+      //           raw_string_u8str. Transition to RawString.
       // other  => Error
+      //
+      // The ) that entered this state is not in raw_string_ket_u8str, it is
+      // appended to raw_string_u8str whenever the delimiter does not match.
 
       _toNext();
       if (currChar32 == U'\"') {
@@ -657,18 +693,18 @@ void PPTokenizerDFA::_pushTokens()
             "(" + raw_string_u8str + ")" +
             raw_string_delimiter_u8str + "\"";
         } else {
-          raw_string_u8str += raw_string_ket_u8str;
+          state = State::RawString;
+          raw_string_u8str += ")" + raw_string_ket_u8str;
           raw_string_u8str += static_cast<char>(currChar32);
         }
       } else if (currChar32 == U')') {
-        raw_string_u8str += raw_string_ket_u8str;
-        raw_string_u8str += static_cast<char>(currChar32);
+        raw_string_u8str += ")" + raw_string_ket_u8str;
         raw_string_ket_u8str.clear();
       } else if (!PPCodeUnitCheck::isNotDChar(curr)) {
         raw_string_ket_u8str += static_cast<char>(currChar32);
       } else if (!PPCodeUnitCheck::isNotRChar(curr)) {
         state = State::RawString;
-        raw_string_u8str += raw_string_ket_u8str + curr->getRawText();
+        raw_string_u8str += ")" + raw_string_ket_u8str + curr->getRawText();
       } else {
         state = State::Error;
         _setError(R"(Expect a d-char, ", or an r-char in parsing a raw string.)");
@@ -685,7 +721,7 @@ void PPTokenizerDFA::_pushTokens()
       if (PPCodeUnitCheck::isIdentifierStart(curr)) {
         _toNext();
         state = State::UserDefinedStringLiteral;
-        ud_suffix_u8str = std::string(1, static_cast<char>(currChar32));
+        ud_suffix_u8str = curr->getUTF8String();
       } else {
         state = State::End;
         _emitToken(PPToken::createStringLiteral(string_literal_u8str), ResetFlags);
@@ -700,7 +736,7 @@ void PPTokenizerDFA::_pushTokens()
       //                        not consumed.
       if (PPCodeUnitCheck::isIdentifierNonStart(curr)) {
         _toNext();
-        ud_suffix_u8str += static_cast<char>(currChar32);
+        ud_suffix_u8str += curr->getUTF8String();
       } else {
         state = State::End;
         _emitToken(PPToken::createUserDefinedStringLiteral(string_literal_u8str + ud_suffix_u8str), ResetFlags);
@@ -801,7 +837,7 @@ void PPTokenizerDFA::_pushTokens()
         _toNext();
         identifier_u8str += curr->getUTF8String();
         continue;
-      } else if (curr->getRawText() == "\\\n") {
+      } else if (curr->isLineSplice()) {
         // "foo\\\nbar" is parsed as an identifier "foorbar".
         _toNext();
       } else if (std::find(_ar_.begin(), _ar_.end(), identifier_u8str) != _ar_.end()) {
@@ -904,14 +940,14 @@ void PPTokenizerDFA::_pushTokens()
       if (currChar32 == U'e'  ||  currChar32 == U'E') {
         _toNext();
         state = State::PPNumber_E;
-        ppnumber_u8str += static_cast<char>(currChar32);
+        ppnumber_u8str += curr->getUTF8String();
       } else if (currChar32 == U'\'') {
         _toNext();
         state = State::PPNumber_Apostrophe;
-        ppnumber_u8str += static_cast<char>(currChar32);
+        ppnumber_u8str += curr->getUTF8String();
       } else if (currChar32 == U'.'  ||  PPCodePointCheck::isDigit(currChar32)  ||  PPCodeUnitCheck::isIdentifierNondigit(curr)) {
         _toNext();
-        ppnumber_u8str += static_cast<char>(currChar32);
+        ppnumber_u8str += curr->getUTF8String();
       } else {
         state = State::End;
         _emitToken(PPToken::createPPNumber(ppnumber_u8str), ResetFlags);
@@ -927,7 +963,7 @@ void PPTokenizerDFA::_pushTokens()
 
       if (PPCodePointCheck::isDigit(currChar32)) {
         state = State::PPNumber;
-        ppnumber_u8str += static_cast<char>(currChar32);
+        ppnumber_u8str += curr->getUTF8String();
       } else {
         state = State::Error;
         _setError(R"(Expecting a digit to form a pp-number)");
@@ -937,19 +973,19 @@ void PPTokenizerDFA::_pushTokens()
     else if (state == State::PPNumber_E) {
       // Previous: e E
       // + - . digit identifier-nondigit =>  PPNumber
-      // other     =>  Error
-      _toNext();
+      // other     =>  Emit pp-number, curr PPCodeUnit is not consumed.
       fprintf(stderr,"State::PPNumber_E\n");
 
       if (PPCodeUnitCheck::isSign(curr)
           || currChar32 == U'.'
           || PPCodeUnitCheck::isDigit(curr)
           || PPCodeUnitCheck::isIdentifierNondigit(curr)) {
+        _toNext();
         state = State::PPNumber;
-        ppnumber_u8str += static_cast<char>(currChar32);
+        ppnumber_u8str += curr->getUTF8String();
       } else {
-        state = State::Error;
-        _setError(R"(Expect a sign (+ or -), a dot, a digit, or an identifier-nondigit in parsing a pp-number.)");
+        state = State::End;
+        _emitToken(PPToken::createPPNumber(ppnumber_u8str), ResetFlags);
       }
     }
 
@@ -962,7 +998,7 @@ void PPTokenizerDFA::_pushTokens()
 
       if (PPCodePointCheck::isDigit(currChar32) || PPCodePointCheck::isNondigit(currChar32)) {
         state = State::PPNumber;
-        ppnumber_u8str += static_cast<char>(currChar32);
+        ppnumber_u8str += curr->getUTF8String();
       } else {
         state = State::Error;
         _setError(R"(Expects a digit or a nondigit after an apostrophe)");
@@ -1051,6 +1087,20 @@ void PPTokenizerDFA::_pushTokens()
     }
 
 
+    else if (state == State::WhitespaceSequence) {
+      // Previous: whitespace other than \n
+      // whitespace other than \n  =>  WhitespaceSequence
+      // other  =>  Emit comment_u8str as a whitespace-sequence
+      if (curr->getType() == PPCodeUnitType::WhitespaceCharacter  &&  currChar32 != U'\n') {
+        _toNext();
+        comment_u8str += static_cast<char>(currChar32);
+      } else {
+        state = State::End;
+        _emitToken(PPToken::createWhitespaceSequence(comment_u8str), ResetFlags);
+      }
+    }
+
+
     ////////////////////////////////////////////////////////////////////////////////
     // preprocessing-op-or-punc
     //
@@ -1310,7 +1360,7 @@ void PPTokenizerDFA::_pushTokens()
       // Previous: .
       // .      =>  DotDot
       // *      =>  Emit .*
-      // [0-9]  =>  PPNumber_LackDigit
+      // [0-9]  =>  PPNumber
       // other  =>  Emit ., curr PPCodeUnit is not consumed.
 
       if (currChar32 == U'*') {
@@ -1324,7 +1374,7 @@ void PPTokenizerDFA::_pushTokens()
         _toNext();
         ppnumber_u8str = ".";
         ppnumber_u8str += static_cast<char>(currChar32);
-        state = State::PPNumber_LackDigit;
+        state = State::PPNumber;
       } else {
         state = State::End;
         _emitToken(PPToken::createPreprocessingOpOrPunc("."), ResetFlags);
@@ -1338,11 +1388,12 @@ void PPTokenizerDFA::_pushTokens()
       // 0-9    =>  Emit ., transition to PPNumber.
       // other  =>  Emit . and . (same dot twice).
       //            The curr PPCodeUnit is not consumed.
-      _toNext();
       if (currChar32 == U'.') {
+        _toNext();
         state = State::End;
         _emitToken(PPToken::createPreprocessingOpOrPunc("..."), ResetFlags);
       } else if (PPCodePointCheck::isDigit(currChar32)) {
+        _toNext();
         state = State::PPNumber;
         _emitToken(PPToken::createPreprocessingOpOrPunc("."), ResetFlags);
         ppnumber_u8str  = ".";
@@ -1367,12 +1418,9 @@ void PPTokenizerDFA::_pushTokens()
         _toNext();
         state = State::End;
         _emitToken(PPToken::createPreprocessingOpOrPunc("::"), ResetFlags);
-      } else if (PPCodePointCheck::isBasicSourceCharacter(currChar32)) {
+      } else {
         state = State::End;
         _emitToken(PPToken::createPreprocessingOpOrPunc(":"), ResetFlags);
-      } else {
-        state = State::Error;
-        _setError(R"(Not a basic-source-character)");
       }
     }
 
@@ -1394,12 +1442,9 @@ void PPTokenizerDFA::_pushTokens()
       } else if (currChar32 == U':') {
         _toNext();
         state = State::PercentSign2;
-      } else if (PPCodePointCheck::isBasicSourceCharacter(currChar32)) {
+      } else {
         state = State::End;
         _emitToken(PPToken::createPreprocessingOpOrPunc("%"), ResetFlags);
-      } else {
-        state = State::Error;
-        _setError(R"(Not a basic-source-character)");
       }
     }
 
@@ -1430,16 +1475,24 @@ void PPTokenizerDFA::_pushTokens()
         _toNext();
         state = State::End;
         _emitToken(PPToken::createPreprocessingOpOrPunc("%:%:"), ResetFlags);
-      } else if (PPCodePointCheck::isBasicSourceCharacter(currChar32)) {
+      } else {
         state = State::PercentSign;
         _emitToken(PPToken::createPreprocessingOpOrPunc("%:"), ResetFlags);
-      } else {
-        state = State::Error;
-        _setError(R"(Not a basic-source-character)");
       }
     }
 
 
   } // while(1)
 
+  // The input ends with a new-line, which ends every token but a comment or a
+  // raw string.
+  if (_stream->isEmpty()  &&  state != State::Start  &&  state != State::End  &&  state != State::Error) {
+    _isUnterminated = true;
+    if (state == State::MultipleLineComment  ||  state == State::MultipleLineCommentStar)
+      _setError(R"(partial comment)");
+    else if (state == State::RawString  ||  state == State::RawStringKet)
+      _setError(R"(unterminated raw string literal)");
+    else
+      _setError(R"(unexpected end of input)");
+  }
 }
@@ -14,10 +14,17 @@ class PPTokenizerDFA {
 public:
   PPTokenizerDFA(std::shared_ptr<PPCodeUnitStreamIfc>);
 
+  // Not while there is an error, which the input ending inside a comment or a
+  // raw string is too.
   bool isEmpty() const;
   std::shared_ptr<PPToken> getPPToken() const;
+  // The physical source line, from 1, on which the current token starts.
+  unsigned getLine() const;
   void toNext();
   std::string getErrorMessage() const;
+  // Whether the error is the input ending inside a comment or a raw string,
+  // which more input could end.
+  bool isUnterminated() const { return _isUnterminated; }
 
 private:
   std::shared_ptr<PPCodeUnitStreamIfc> _stream;
@@ -25,9 +32,13 @@ private:
   void _setError(const std::string&&);
   void _clearError();
   std::string _errorMessage;
+  bool _isUnterminated = false;
 
   void _pushTokens();
   std::queue<std::shared_ptr<PPToken>> _queue;
+  std::queue<unsigned> _lines;  // of the tokens in _queue
+
+  unsigned _line = 1;           // of the next code unit
 
   bool _isBeginningOfLine = true;
   bool _isPreprocessingDirective = false;
@@ -6,7 +6,12 @@
  * for future use. Not very efficient as it copies the buffer around.
  */
 PPUTF32Stream::PPUTF32Stream(const std::string &utf8string):
-  _str(icu::UnicodeString::fromUTF8(utf8string)),
+  PPUTF32Stream(utf8string.data(), utf8string.size())
+{
+}
+
+PPUTF32Stream::PPUTF32Stream(const char *utf8, size_t length):
+  _str(icu::UnicodeString::fromUTF8(icu::StringPiece(utf8, length))),
   _itr(_str)
 {
   if (!_str.endsWith(icu::UnicodeString(reinterpret_cast<const UChar*>(u"\n"), 1))) {
@@ -42,13 +47,14 @@ std::u32string PPUTF32Stream::getUTF32String() const
   char32_t *buf = new char32_t[char32length];
   assert(buf);
 
-  UErrorCode err;
+  UErrorCode err = U_ZERO_ERROR;
   _str.toUTF32(reinterpret_cast<UChar32*>(buf), char32length, err);
   assert(U_SUCCESS(err));
 
+  std::u32string str(buf, char32length);
   delete []buf;
 
-  return std::u32string(buf, char32length);
+  return str;
 }
 
 std::string PPUTF32Stream::getRawText() const
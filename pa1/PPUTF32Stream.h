@@ -4,12 +4,14 @@
 #include "UTF32StreamIfc.h"
 #include "unicode/ucnv.h"
 #include "unicode/schriter.h"
+#include <cstddef>
 #include <memory>
 #include <string>
 
 class PPUTF32Stream: public UTF32StreamIfc {
 public:
   PPUTF32Stream(const std::string&);
+  PPUTF32Stream(const char *utf8, size_t length);
 
   virtual bool isEmpty() const override;
   virtual char32_t getChar32() const override;
@@ -2,6 +2,8 @@
 #include "PPCodeUnitStream.h"
 #include "PPUTF32Stream.h"
 #include <gtest/gtest.h>
+#include <tuple>
+#include <vector>
 
 TEST(PPCodeUnitStream, ASCIIText)
 {
@@ -212,3 +214,47 @@ TEST(PPCodeUnitStream, SimpleMixed)
 
   ASSERT_TRUE(stream->isEmpty());
 }
+
+TEST(PPCodeUnitStream, Trigraph)
+{
+  // A ??/ is a backslash for line splicing and universal-character-names too.
+  const std::string src = "?\?\?= ?\?x ?\?/\nx ?\?/u00E9";
+  auto u32stream = std::make_shared<PPUTF32Stream>(src);
+  auto stream = std::make_shared<PPCodeUnitStream>(u32stream);
+
+  std::vector<std::tuple<PPCodeUnitType, char32_t, std::string>> units;
+  for (; !stream->isEmpty(); stream->toNext()) {
+    const auto unit = stream->getCodeUnit();
+    units.emplace_back(unit->getType(), unit->getChar32(), unit->getRawText());
+  }
+
+  const std::vector<std::tuple<PPCodeUnitType, char32_t, std::string>> expected = {
+    std::make_tuple(PPCodeUnitType::ASCIIChar, U'?', "?"),
+    std::make_tuple(PPCodeUnitType::Trigraph, U'#', "?\?="),
+    std::make_tuple(PPCodeUnitType::WhitespaceCharacter, U' ', " "),
+    std::make_tuple(PPCodeUnitType::ASCIIChar, U'?', "?"),
+    std::make_tuple(PPCodeUnitType::ASCIIChar, U'?', "?"),
+    std::make_tuple(PPCodeUnitType::ASCIIChar, U'x', "x"),
+    std::make_tuple(PPCodeUnitType::WhitespaceCharacter, U' ', " "),
+    std::make_tuple(PPCodeUnitType::WhitespaceCharacter, 0, "?\?/\n"),
+    std::make_tuple(PPCodeUnitType::ASCIIChar, U'x', "x"),
+    std::make_tuple(PPCodeUnitType::WhitespaceCharacter, U' ', " "),
+    std::make_tuple(PPCodeUnitType::UniversalCharacterName, U'é', "?\?/u00E9"),
+    std::make_tuple(PPCodeUnitType::ASCIIChar, U'\n', "\n"),
+  };
+  EXPECT_EQ(expected, units);
+}
+
+TEST(PPCodeUnitStream, EndingLineSplice)
+{
+  // Still ends in a new-line.
+  auto u32stream = std::make_shared<PPUTF32Stream>("a\\\n");
+  auto stream = std::make_shared<PPCodeUnitStream>(u32stream);
+  stream->toNext();
+  ASSERT_TRUE(stream->getCodeUnit()->isLineSplice());
+  stream->toNext();
+  ASSERT_FALSE(stream->isEmpty());
+  ASSERT_EQ(U'\n', stream->getCodeUnit()->getChar32());
+  stream->toNext();
+  ASSERT_TRUE(stream->isEmpty());
+}
@@ -2,6 +2,7 @@
 #include "PPUTF32Stream.h"
 #include "PPCodeUnitStream.h"
 #include <gtest/gtest.h>
+#include <tuple>
 
 TEST(PPTokenizerDFA, HeaderNameH)
 {
@@ -28,6 +29,14 @@ TEST(PPTokenizerDFA, HeaderNameH)
     ppdfa->toNext();
   }
 
+  { // whitespace-sequence: the space before the header-name
+    ASSERT_FALSE(ppdfa->isEmpty());
+    const auto tok = ppdfa->getPPToken();
+    ASSERT_EQ(PPTokenType::WhitespaceSequence, tok->getType());
+    ASSERT_EQ(" ", tok->getRawText());
+    ppdfa->toNext();
+  }
+
   { // header: <stdio.h>
     ASSERT_FALSE(ppdfa->isEmpty());
     const auto tok = ppdfa->getPPToken();
@@ -71,6 +80,14 @@ TEST(PPTokenizerDFA, HeaderNameQ)
     ppdfa->toNext();
   }
 
+  { // whitespace-sequence: the space before the header-name
+    ASSERT_FALSE(ppdfa->isEmpty());
+    const auto tok = ppdfa->getPPToken();
+    ASSERT_EQ(PPTokenType::WhitespaceSequence, tok->getType());
+    ASSERT_EQ(" ", tok->getRawText());
+    ppdfa->toNext();
+  }
+
   { // header: <stdio.h>
     ASSERT_FALSE(ppdfa->isEmpty());
     const auto tok = ppdfa->getPPToken();
@@ -98,7 +115,13 @@ TEST(PPTokenizerDFA, SingleLineComment)
 
   auto ppdfa = std::make_shared<PPTokenizerDFA>(stream);
 
-  // Note that the first space character, 0x20, is completely ignored.
+  { // whitespace-sequence: the leading space
+    ASSERT_FALSE(ppdfa->isEmpty());
+    const auto tok = ppdfa->getPPToken();
+    ASSERT_EQ(PPTokenType::WhitespaceSequence, tok->getType());
+    ASSERT_EQ(" ", tok->getRawText());
+    ppdfa->toNext();
+  }
 
   { // whitespace-sequence: the comment
     ASSERT_FALSE(ppdfa->isEmpty());
@@ -346,3 +369,101 @@ TEST(PPTokenizerDFA, UserDefinedCharacterLiteral)
         ASSERT_TRUE(ppdfa->isEmpty());
       }
 }
+
+TEST(PPTokenizerDFA, NonASCIISuffix)
+{
+  // Code points past ASCII in a ud-suffix or a pp-number are kept whole, as
+  // UTF-8, whether spelled directly or as a universal-character-name.
+  const std::vector<std::tuple<std::string, PPTokenType, std::string>> cases = {
+    std::make_tuple(u8"1À", PPTokenType::PPNumber, u8"1À"),
+    std::make_tuple(R"(1\u00c0)", PPTokenType::PPNumber, u8"1À"),
+    std::make_tuple(u8"1eÀ", PPTokenType::PPNumber, u8"1eÀ"),
+    std::make_tuple(u8"\"s\"_À", PPTokenType::UserDefinedStringLiteral, u8"\"s\"_À"),
+    std::make_tuple(R"("s"_\u00c0)", PPTokenType::UserDefinedStringLiteral, u8"\"s\"_À"),
+    std::make_tuple(R"('c'_\u00c0)", PPTokenType::UserDefinedCharacterLiteral, u8"'c'_À"),
+  };
+
+  for (const auto &c: cases) {
+    auto u32stream = std::make_shared<PPUTF32Stream>(std::get<0>(c));
+    auto stream = std::make_shared<PPCodeUnitStream>(u32stream);
+    auto ppdfa = std::make_shared<PPTokenizerDFA>(stream);
+
+    ASSERT_FALSE(ppdfa->isEmpty());
+    const auto tok = ppdfa->getPPToken();
+    EXPECT_EQ(std::get<1>(c), tok->getType()) << std::get<0>(c);
+    EXPECT_EQ(std::get<2>(c), tok->getRawText()) << std::get<0>(c);
+    ppdfa->toNext();
+
+    ASSERT_FALSE(ppdfa->isEmpty());
+    EXPECT_EQ(PPTokenType::NewLine, ppdfa->getPPToken()->getType()) << std::get<0>(c);
+  }
+}
+
+TEST(PPTokenizerDFA, Line)
+{
+  const std::string src = "a \\\nb /* c\nd */ e\nR\"(f\ng)\" h\n";
+
+  auto u32stream = std::make_shared<PPUTF32Stream>(src);
+  auto stream = std::make_shared<PPCodeUnitStream>(u32stream);
+  auto ppdfa = std::make_shared<PPTokenizerDFA>(stream);
+
+  std::vector<std::pair<std::string, unsigned>> tokens;
+  for (; !ppdfa->isEmpty(); ppdfa->toNext()) {
+    const auto tok = ppdfa->getPPToken();
+    if (tok->getType() != PPTokenType::WhitespaceSequence)
+      tokens.emplace_back(tok->getRawText(), ppdfa->getLine());
+  }
+
+  const std::vector<std::pair<std::string, unsigned>> expected = {
+    {"a", 1}, {"b", 2}, {"e", 3}, {"\n", 3}, {"R\"(f\ng)\"", 4}, {"h", 5}, {"\n", 5},
+  };
+  EXPECT_EQ(expected, tokens);
+}
+
+TEST(PPTokenizerDFA, Trigraph)
+{
+  // Replaced, but in raw strings, where the trigraphs are characters again.
+  const std::string src = "?\?=define \"?\?/\"\" R\"a(?\?)a\" R\"?\?=(x)?\?=\"\n";
+
+  auto u32stream = std::make_shared<PPUTF32Stream>(src);
+  auto stream = std::make_shared<PPCodeUnitStream>(u32stream);
+  auto ppdfa = std::make_shared<PPTokenizerDFA>(stream);
+
+  std::vector<std::string> tokens;
+  for (; !ppdfa->isEmpty(); ppdfa->toNext()) {
+    ASSERT_EQ("", ppdfa->getErrorMessage());
+    const auto tok = ppdfa->getPPToken();
+    if (tok->getType() != PPTokenType::WhitespaceSequence)
+      tokens.push_back(tok->getRawText());
+  }
+
+  const std::vector<std::string> expected = {
+    "#", "define", "\"\\\"\"", "R\"a(?\?)a\"", "R\"?\?=(x)?\?=\"", "\n",
+  };
+  EXPECT_EQ(expected, tokens);
+}
+
+TEST(PPTokenizerDFA, UnterminatedAtEnd)
+{
+  // The tokens before, then the error instead of the end.
+  const std::vector<std::pair<std::string, std::string>> cases = {
+    {"a\n/* x\n", "partial comment"},
+    {"a\n/* x *", "partial comment"},
+    {"a\nR\"x( y )\"\nb\n", "unterminated raw string literal"},
+    {"a\nR\"x( y )x", "unterminated raw string literal"},
+  };
+  for (const auto &c: cases) {
+    auto u32stream = std::make_shared<PPUTF32Stream>(c.first);
+    auto stream = std::make_shared<PPCodeUnitStream>(u32stream);
+    auto ppdfa = std::make_shared<PPTokenizerDFA>(stream);
+
+    std::vector<std::string> tokens;
+    while (!ppdfa->isEmpty()  &&  ppdfa->getErrorMessage().empty()) {
+      tokens.push_back(ppdfa->getPPToken()->getRawText());
+      ppdfa->toNext();
+    }
+    EXPECT_EQ(std::vector<std::string>({"a", "\n"}), tokens) << c.first;
+    EXPECT_FALSE(ppdfa->isEmpty()) << c.first;
+    EXPECT_EQ(c.second, ppdfa->getErrorMessage()) << c.first;
+  }
+}
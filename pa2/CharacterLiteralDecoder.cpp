@@ -0,0 +1,76 @@
+#include "CharacterLiteralDecoder.h"
+
+#include "LiteralCharacters.h"
+
+#include <cstring>
+
+namespace {
+
+  CharacterLiteral invalid(const char *error)
+  {
+    CharacterLiteral r = {};
+    r.kind = CharacterLiteral::Invalid;
+    r.error = error;
+    return r;
+  }
+
+} // namespace
+
+CharacterLiteral CharacterLiteralDecoder::decode(const char *begin, const char *end)
+{
+  const char *p = begin;
+  EFundamentalType type = FT_CHAR;
+  if (p != end) {
+    switch (*p) {
+      case 'u': type = FT_CHAR16_T; ++p; break;
+      case 'U': type = FT_CHAR32_T; ++p; break;
+      case 'L': type = FT_WCHAR_T; ++p; break;
+    }
+  }
+  if (p == end  ||  *p != '\'')
+    return invalid("not a character literal");
+  ++p;
+
+  // A ud-suffix never contains a quote, so the literal ends at the last one.
+  const char *q = end;
+  do {
+    --q;
+  } while (q != p - 1  &&  *q != '\'');
+  if (q == p - 1  ||  q == p)
+    return invalid("malformed character literal");
+
+  uint32_t c;
+  if (*p == '\\') {
+    ++p;
+    if (const char *error = LiteralCharacters::decodeEscape(p, q, c))
+      return invalid(error);
+  } else {
+    c = LiteralCharacters::decodeUTF8(p);
+  }
+  if (p != q)
+    return invalid("multi code point character literals not supported");
+
+  if (c >= 0xD800  &&  c < 0xE000)
+    return invalid("character literal code point out of range");
+  if (type == FT_CHAR16_T  &&  c >= 0x10000)
+    return invalid("UTF-16 character literal out of range");
+  if (type == FT_CHAR  &&  c > 0x7F)
+    type = FT_INT;
+
+  CharacterLiteral r = {};
+  r.kind = CharacterLiteral::Character;
+  r.type = type;
+  r.value = c;
+  r.nbytes = type == FT_CHAR ? 1 : type == FT_CHAR16_T ? 2 : 4;
+  // Little endian, as everywhere in the token streams.
+  std::memcpy(r.bytes, &c, r.nbytes);
+
+  const char *suffix = q + 1;
+  if (suffix != end) {
+    if (*suffix != '_')
+      return invalid("ud_suffix does not start with _");
+    r.kind = CharacterLiteral::UserDefined;
+    r.prefixLength = suffix - begin;
+  }
+  return r;
+}
@@ -0,0 +1,56 @@
+#ifndef CharacterLiteralDecoder_h
+#define CharacterLiteralDecoder_h
+
+#include "FundamentalType.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// The result of decoding a character-literal (2.14.3) or a
+// user-defined-character-literal (2.14.8).
+//
+// Like IntegerLiteral everything lives inline. `bytes[0, nbytes)` is the
+// object representation of the value as emitted by PA2, and `value` is the
+// code point, which is also the value PA3 uses in controlling expressions.
+struct CharacterLiteral {
+  enum Kind {
+    Invalid,
+    Character,
+    UserDefined,
+  };
+
+  Kind kind;
+  EFundamentalType type;
+  uint32_t value;
+  size_t nbytes;
+  unsigned char bytes[sizeof(uint32_t)];
+
+  // UserDefined only: the ud-suffix starts at `begin + prefixLength`.
+  size_t prefixLength;
+
+  // Invalid only: a description of the error.
+  const char *error;
+
+  bool isSigned() const
+  { return type == FT_CHAR || type == FT_INT || type == FT_WCHAR_T; }
+};
+
+// Classifies and decodes character literals.
+//
+// Course-defined rules, as in the reference implementation:
+//
+//   - Multi-character literals are ill-formed.
+//   - An ordinary literal is a `char` if its code point is at most 127 and an
+//     `int` otherwise. `u` literals are `char16_t` and must fit one code unit,
+//     `U` and `L` literals are `char32_t` and 4-byte `wchar_t`.
+//   - Surrogate code points are ill-formed in every kind.
+class CharacterLiteralDecoder {
+public:
+  static CharacterLiteral decode(const char *begin, const char *end);
+
+  static CharacterLiteral decode(const std::string &s)
+  { return decode(s.data(), s.data() + s.size()); }
+};
+
+#endif /* end of include guard */
@@ -0,0 +1,116 @@
+#ifndef DebugPostTokenOutputStream_h
+#define DebugPostTokenOutputStream_h
+
+#include "FundamentalType.h"
+#include "HexDump.h"
+#include "TokenType.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <string>
+
+// convert EFundamentalType to a source code
+const std::map<EFundamentalType, std::string> FundamentalTypeToStringMap
+{
+	{FT_SIGNED_CHAR, "signed char"},
+	{FT_SHORT_INT, "short int"},
+	{FT_INT, "int"},
+	{FT_LONG_INT, "long int"},
+	{FT_LONG_LONG_INT, "long long int"},
+	{FT_UNSIGNED_CHAR, "unsigned char"},
+	{FT_UNSIGNED_SHORT_INT, "unsigned short int"},
+	{FT_UNSIGNED_INT, "unsigned int"},
+	{FT_UNSIGNED_LONG_INT, "unsigned long int"},
+	{FT_UNSIGNED_LONG_LONG_INT, "unsigned long long int"},
+	{FT_WCHAR_T, "wchar_t"},
+	{FT_CHAR, "char"},
+	{FT_CHAR16_T, "char16_t"},
+	{FT_CHAR32_T, "char32_t"},
+	{FT_BOOL, "bool"},
+	{FT_FLOAT, "float"},
+	{FT_DOUBLE, "double"},
+	{FT_LONG_DOUBLE, "long double"},
+	{FT_VOID, "void"},
+	{FT_NULLPTR_T, "nullptr_t"}
+};
+
+// DebugPostTokenOutputStream: helper class to produce PA2 output format
+// TokenStreamWriter (see TokenStream.h) has the same interface and produces the
+// binary token stream read by the later stages instead
+//
+// writes to `out`, without flushing line by line
+struct DebugPostTokenOutputStream
+{
+	explicit DebugPostTokenOutputStream(std::ostream& out = std::cout)
+		: out(out)
+	{}
+
+	std::ostream& out;
+
+	// the PA2 format has no source locations
+	void set_location(uint32_t, uint32_t) {}
+
+	// output: invalid <source>
+	void emit_invalid(const std::string& source)
+	{
+		out << "invalid " << source << '\n';
+	}
+
+	// output: simple <source> <token_type>
+	void emit_simple(const std::string& source, ETokenType token_type)
+	{
+		out << "simple " << source << " " << TokenTypeToStringMap.at(token_type) << '\n';
+	}
+
+	// output: identifier <source>
+	void emit_identifier(const std::string& source)
+	{
+		out << "identifier " << source << '\n';
+	}
+
+	// output: literal <source> <type> <hexdump(data,nbytes)>
+	void emit_literal(const std::string& source, EFundamentalType type, const void* data, size_t nbytes)
+	{
+		out << "literal " << source << " " << FundamentalTypeToStringMap.at(type) << " " << HexDump(data, nbytes) << '\n';
+	}
+
+	// output: literal <source> array of <num_elements> <type> <hexdump(data,nbytes)>
+	void emit_literal_array(const std::string& source, size_t num_elements, EFundamentalType type, const void* data, size_t nbytes)
+	{
+		out << "literal " << source << " array of " << num_elements << " " << FundamentalTypeToStringMap.at(type) << " " << HexDump(data, nbytes) << '\n';
+	}
+
+	// output: user-defined-literal <source> <ud_suffix> character <type> <hexdump(data,nbytes)>
+	void emit_user_defined_literal_character(const std::string& source, const std::string& ud_suffix, EFundamentalType type, const void* data, size_t nbytes)
+	{
+		out << "user-defined-literal " << source << " " << ud_suffix << " character " << FundamentalTypeToStringMap.at(type) << " " << HexDump(data, nbytes) << '\n';
+	}
+
+	// output: user-defined-literal <source> <ud_suffix> string array of <num_elements> <type> <hexdump(data, nbytes)>
+	void emit_user_defined_literal_string_array(const std::string& source, const std::string& ud_suffix, size_t num_elements, EFundamentalType type, const void* data, size_t nbytes)
+	{
+		out << "user-defined-literal " << source << " " << ud_suffix << " string array of " << num_elements << " " << FundamentalTypeToStringMap.at(type) << " " << HexDump(data, nbytes) << '\n';
+	}
+
+	// output: user-defined-literal <source> <ud_suffix> <prefix>
+	void emit_user_defined_literal_integer(const std::string& source, const std::string& ud_suffix, const std::string& prefix)
+	{
+		out << "user-defined-literal " << source << " " << ud_suffix << " integer " << prefix << '\n';
+	}
+
+	// output: user-defined-literal <source> <ud_suffix> <prefix>
+	void emit_user_defined_literal_floating(const std::string& source, const std::string& ud_suffix, const std::string& prefix)
+	{
+		out << "user-defined-literal " << source << " " << ud_suffix << " floating " << prefix << '\n';
+	}
+
+	// output : eof
+	void emit_eof()
+	{
+		out << "eof" << '\n';
+	}
+};
+
+#endif /* end of include guard */
@@ -0,0 +1,70 @@
+#ifndef FloatLiteralDecoder_h
+#define FloatLiteralDecoder_h
+
+#include "FundamentalType.h"
+
+#include <cstddef>
+#include <string>
+
+// The result of classifying a pp-number as a floating-literal (2.14.4) or a
+// user-defined-floating-literal (2.14.8).
+//
+// For a `Floating` the value is converted to `type` and `bytes[0, nbytes)` is
+// its object representation; a long double takes all of its 16 bytes, the
+// padding zeroed, as emitted by PA2.
+struct FloatingLiteral {
+  enum Kind {
+    Invalid,
+    Floating,
+    UserDefined,
+  };
+
+  Kind kind;
+
+  // Floating only.
+  EFundamentalType type;
+  size_t nbytes;
+  unsigned char bytes[sizeof(long double)];
+
+  // UserDefined only: the ud-suffix starts at `begin + prefixLength`.
+  size_t prefixLength;
+};
+
+// Correctly rounded decimal-to-binary conversion of floating-literals into
+// float, double and the x87 80-bit long double.
+//
+// The decoder scans the character span of the literal in place and produces
+// results bit-identical to `std::istringstream >> x`:
+//
+//   - Only the longest prefix of the form
+//         [+-] digits [. digits] [(e|E) [+-] digits]
+//     is converted, so suffixes such as `f`, `L` or a ud-suffix are ignored.
+//   - A prefix without any digit, or an exponent without digits, yields 0.
+//   - Values beyond the range of the type yield std::numeric_limits<T>::max(),
+//     tiny values round (half to even) to a subnormal or zero.
+//
+// float and double take the Clinger fast path when the significand and the
+// power of ten are both exact, and the Eisel-Lemire algorithm otherwise. long
+// double takes the Clinger fast path too. Whatever these cannot decide is
+// settled with exact big integer arithmetic.
+class FloatLiteralDecoder {
+public:
+  // Classifies a pp-number by the floating-literal grammar and converts it.
+  static FloatingLiteral decode(const char *begin, const char *end);
+
+  static FloatingLiteral decode(const std::string &s)
+  { return decode(s.data(), s.data() + s.size()); }
+
+  static float decodeFloat(const char *begin, const char *end);
+  static double decodeDouble(const char *begin, const char *end);
+  static long double decodeLongDouble(const char *begin, const char *end);
+
+  static float decodeFloat(const std::string &s)
+  { return decodeFloat(s.data(), s.data() + s.size()); }
+  static double decodeDouble(const std::string &s)
+  { return decodeDouble(s.data(), s.data() + s.size()); }
+  static long double decodeLongDouble(const std::string &s)
+  { return decodeLongDouble(s.data(), s.data() + s.size()); }
+};
+
+#endif /* end of include guard */
@@ -0,0 +1,67 @@
+#include "HexDump.h"
+
+#include <tmmintrin.h>
+
+namespace {
+
+  const char HexDigits[] = "0123456789ABCDEF";
+
+  void writeScalar(char *out, const unsigned char *p, size_t nbytes)
+  {
+    for (size_t i = 0; i < nbytes; i++) {
+      out[2 * i + 0] = HexDigits[p[i] >> 4];
+      out[2 * i + 1] = HexDigits[p[i] & 0x0F];
+    }
+  }
+
+  // pshufb looks up the digit of every nibble in one instruction, the two
+  // unpacks interleave high and low nibbles back into source order.
+  __attribute__((target("ssse3")))
+  void writeSSSE3(char *out, const unsigned char *p, size_t nbytes)
+  {
+    const __m128i digits = _mm_loadu_si128(reinterpret_cast<const __m128i *>(HexDigits));
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    for (; nbytes >= 16; nbytes -= 16, p += 16, out += 32) {
+      const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+      const __m128i high = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(v, 4), mask));
+      const __m128i low = _mm_shuffle_epi8(digits, _mm_and_si128(v, mask));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_unpacklo_epi8(high, low));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 16), _mm_unpackhi_epi8(high, low));
+    }
+    writeScalar(out, p, nbytes);
+  }
+
+  bool cpuHasSSSE3()
+  {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("ssse3");
+  }
+
+  // Until this is initialized, early callers just take the scalar path.
+  const bool HaveSSSE3 = cpuHasSSSE3();
+
+} // namespace
+
+void HexDump::write(char *out, const void *data, size_t nbytes)
+{
+  const unsigned char *p = static_cast<const unsigned char *>(data);
+  if (HaveSSSE3)
+    writeSSSE3(out, p, nbytes);
+  else
+    writeScalar(out, p, nbytes);
+}
+
+std::ostream &operator<<(std::ostream &os, const HexDump &h)
+{
+  const size_t ChunkBytes = 512;
+  char buf[2 * ChunkBytes];
+  const unsigned char *p = static_cast<const unsigned char *>(h._data);
+  for (size_t n = h._nbytes; n; ) {
+    const size_t chunk = n < ChunkBytes ? n : ChunkBytes;
+    HexDump::write(buf, p, chunk);
+    os.write(buf, 2 * chunk);
+    p += chunk;
+    n -= chunk;
+  }
+  return os;
+}
@@ -0,0 +1,30 @@
+#ifndef HexDump_h
+#define HexDump_h
+
+#include <cstddef>
+#include <ostream>
+
+// Uppercase hex dump of an object representation, as used by the PA2 output
+// format and every later stage that reuses it.
+//
+//     cout << "literal " << source << " int " << HexDump(data, nbytes) << endl;
+//
+// Streaming a HexDump formats the digits in a fixed-size buffer on the stack
+// and writes them to the stream, so no std::string is built however long the
+// literal is.
+class HexDump {
+public:
+  HexDump(const void *data, size_t nbytes): _data(data), _nbytes(nbytes) {}
+
+  // Writes the 2 * nbytes digits of data to out, high nibble first. Uses
+  // SSSE3 when the CPU has it, 16 bytes at a time.
+  static void write(char *out, const void *data, size_t nbytes);
+
+  friend std::ostream &operator<<(std::ostream &os, const HexDump &h);
+
+private:
+  const void *_data;
+  size_t _nbytes;
+};
+
+#endif /* end of include guard */
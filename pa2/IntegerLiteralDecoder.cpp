@@ -0,0 +1,250 @@
+#include "IntegerLiteralDecoder.h"
+
+#include "LiteralCharacters.h"
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // Type selection, 2.14.2 Table 6
+  ////////////////////////////////////////////////////////////////////////////////
+
+  struct Candidate {
+    EFundamentalType type;
+    unsigned long long max;
+    unsigned char size;
+  };
+
+  template <typename T>
+  constexpr Candidate candidate()
+  { return Candidate{FundamentalTypeOf<T>(), std::numeric_limits<T>::max(), sizeof(T)}; }
+
+  struct CandidateList {
+    size_t count;
+    Candidate types[6];
+  };
+
+  template <typename... T>
+  constexpr CandidateList candidates()
+  { return CandidateList{sizeof...(T), {candidate<T>()...}}; }
+
+  enum Suffix {
+    NoSuffix,
+    SuffixU,
+    SuffixL,
+    SuffixUL,
+    SuffixLL,
+    SuffixULL,
+    NumSuffixes,
+  };
+
+  // Indexed by suffix, then 0 for decimal and 1 for octal, hexadecimal and
+  // binary literals.
+  constexpr CandidateList TypeTable[NumSuffixes][2] = {
+    {
+      candidates<int, long int, long long int>(),
+      candidates<int, unsigned int, long int, unsigned long int, long long int, unsigned long long int>(),
+    },
+    {
+      candidates<unsigned int, unsigned long int, unsigned long long int>(),
+      candidates<unsigned int, unsigned long int, unsigned long long int>(),
+    },
+    {
+      candidates<long int, long long int>(),
+      candidates<long int, unsigned long int, long long int, unsigned long long int>(),
+    },
+    {
+      candidates<unsigned long int, unsigned long long int>(),
+      candidates<unsigned long int, unsigned long long int>(),
+    },
+    {
+      candidates<long long int>(),
+      candidates<long long int, unsigned long long int>(),
+    },
+    {
+      candidates<unsigned long long int>(),
+      candidates<unsigned long long int>(),
+    },
+  };
+
+  // integer-suffix: u, l, ll, ul, ull, lu, llu in any case, but not lL or Ll.
+  bool scanIntegerSuffix(const char *p, const char *end, Suffix &suffix)
+  {
+    bool u = false;
+    int l = 0;
+    if (p != end  &&  (*p == 'u'  ||  *p == 'U')) {
+      u = true;
+      ++p;
+    }
+    if (p != end  &&  (*p == 'l'  ||  *p == 'L')) {
+      l = (p + 1 != end  &&  p[1] == p[0]) ? 2 : 1;
+      p += l;
+    }
+    if (!u  &&  l  &&  p != end  &&  (*p == 'u'  ||  *p == 'U')) {
+      u = true;
+      ++p;
+    }
+    if (p != end)
+      return false;
+
+    static const Suffix suffixes[2][3] = {
+      {NoSuffix, SuffixL, SuffixLL},
+      {SuffixU, SuffixUL, SuffixULL},
+    };
+    suffix = suffixes[u][l];
+    return true;
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // Digit accumulation
+  ////////////////////////////////////////////////////////////////////////////////
+
+  const uint64_t Ones = 0x0101010101010101;
+  const uint64_t HighBits = Ones * 0x80;
+
+  // Sets the high bit of every byte of v in [lo, hi], all bytes must be ASCII.
+  // Neither sum carries out of its byte.
+  inline uint64_t bytesInRange(uint64_t v, unsigned char lo, unsigned char hi)
+  { return (v + Ones * (0x80 - lo)) & ~(v + Ones * (0x7F - hi)) & HighBits; }
+
+  // Replaces eight ASCII digits of the given radix by their values, or returns
+  // false if any byte is not such a digit.
+  template <unsigned Radix>
+  bool eightDigitValues(uint64_t &v)
+  {
+    if (v & HighBits)
+      return false;
+    if (Radix <= 10) {
+      if (bytesInRange(v, '0', '0' + Radix - 1) != HighBits)
+        return false;
+      v -= Ones * '0';
+      return true;
+    }
+    const uint64_t decimal = bytesInRange(v, '0', '9');
+    const uint64_t alpha = bytesInRange(v | Ones * 0x20, 'a', 'a' + Radix - 11);
+    if ((decimal | alpha) != HighBits)
+      return false;
+    v = (v & Ones * 0x0F) + (alpha >> 7) * 9;
+    return true;
+  }
+
+  // Combines eight digit values, most significant in the lowest byte, into one
+  // number. Each step merges neighbouring lanes into a lane twice as wide; for
+  // radices up to 16 the merged value still fits its lane.
+  template <unsigned Radix>
+  uint32_t combineEightDigits(uint64_t v)
+  {
+    const uint64_t r2 = Radix * Radix;
+    v = (v * Radix + (v >> 8)) & 0x00FF00FF00FF00FF;
+    v = (v * r2 + (v >> 16)) & 0x0000FFFF0000FFFF;
+    return static_cast<uint32_t>(v * (r2 * r2) + (v >> 32));
+  }
+
+  inline unsigned digitValue(char c)
+  {
+    if (c >= '0'  &&  c <= '9')
+      return c - '0';
+    const char lower = c | 0x20;
+    if (lower >= 'a'  &&  lower <= 'f')
+      return lower - 'a' + 10;
+    return 16;
+  }
+
+  // Accumulates the digits at [p, end) into value, setting overflow if it does
+  // not fit 64 bits, and returns the end of the digit sequence.
+  template <unsigned Radix>
+  const char *scanDigits(const char *p, const char *end, unsigned options, uint64_t &value, bool &overflow)
+  {
+    const uint64_t r8 = uint64_t(Radix * Radix * Radix * Radix) * (Radix * Radix * Radix * Radix);
+    const char *const start = p;
+    for (;;) {
+      uint64_t v;
+      if (end - p >= 8) {
+        std::memcpy(&v, p, sizeof(v));
+        if (eightDigitValues<Radix>(v)) {
+          const uint64_t chunk = combineEightDigits<Radix>(v);
+          overflow |= __builtin_mul_overflow(value, r8, &value);
+          overflow |= __builtin_add_overflow(value, chunk, &value);
+          p += 8;
+          continue;
+        }
+      }
+
+      if (p == end)
+        return p;
+      const unsigned d = digitValue(*p);
+      if (d < Radix) {
+        overflow |= __builtin_mul_overflow(value, Radix, &value);
+        overflow |= __builtin_add_overflow(value, d, &value);
+        ++p;
+        continue;
+      }
+
+      // A digit separator must sit between two digits.
+      if ((options & IntegerLiteralDecoder::DigitSeparators)  &&  *p == '\''
+          &&  p != start  &&  p[-1] != '\''  &&  p + 1 != end  &&  digitValue(p[1]) < Radix) {
+        ++p;
+        continue;
+      }
+      return p;
+    }
+  }
+
+} // namespace
+
+IntegerLiteral IntegerLiteralDecoder::decode(const char *begin, const char *end, unsigned options)
+{
+  IntegerLiteral r = {};
+  r.kind = IntegerLiteral::Invalid;
+  if (begin == end  ||  digitValue(*begin) >= 10)
+    return r;
+
+  uint64_t value = 0;
+  bool overflow = false;
+  bool decimal = false;
+  const char *p;
+  if (*begin != '0') {
+    decimal = true;
+    p = scanDigits<10>(begin, end, options, value, overflow);
+  } else if (end - begin >= 2  &&  (begin[1] | 0x20) == 'x') {
+    p = scanDigits<16>(begin + 2, end, options, value, overflow);
+    if (p == begin + 2)
+      return r;
+  } else if ((options & BinaryLiterals)  &&  end - begin >= 2  &&  (begin[1] | 0x20) == 'b') {
+    p = scanDigits<2>(begin + 2, end, options, value, overflow);
+    if (p == begin + 2)
+      return r;
+  } else {
+    p = scanDigits<8>(begin, end, options, value, overflow);
+  }
+
+  if (p != end  &&  *p == '_') {
+    if (LiteralCharacters::isUdSuffix(p, end)) {
+      r.kind = IntegerLiteral::UserDefined;
+      r.prefixLength = p - begin;
+    }
+    return r;
+  }
+
+  Suffix suffix;
+  if (!scanIntegerSuffix(p, end, suffix)  ||  overflow)
+    return r;
+
+  const CandidateList &list = TypeTable[suffix][decimal ? 0 : 1];
+  for (size_t i = 0; i < list.count; i++) {
+    const Candidate &c = list.types[i];
+    if (value <= c.max) {
+      r.kind = IntegerLiteral::Integer;
+      r.type = c.type;
+      r.value = value;
+      r.nbytes = c.size;
+      // x86-64 is little endian, the low nbytes are the object representation.
+      std::memcpy(r.bytes, &value, sizeof(r.bytes));
+      return r;
+    }
+  }
+  return r;
+}
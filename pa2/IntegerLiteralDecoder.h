@@ -0,0 +1,66 @@
+#ifndef IntegerLiteralDecoder_h
+#define IntegerLiteralDecoder_h
+
+#include "FundamentalType.h"
+
+#include <cstddef>
+#include <string>
+
+// The result of decoding a pp-number as an integer-literal (2.14.2) or a
+// user-defined-integer-literal (2.14.8).
+//
+// Everything lives inline, decoding never allocates. For an `Integer` the
+// value is already converted to `type`: `bytes[0, nbytes)` is its object
+// representation (little endian, as emitted by PA2), and `value` holds the
+// same bits zero-extended to 64 bits, so PA3 and PA9 can take the value and
+// the signedness from here without parsing the source again.
+struct IntegerLiteral {
+  enum Kind {
+    Invalid,
+    Integer,
+    UserDefined,
+  };
+
+  Kind kind;
+
+  // Integer only.
+  EFundamentalType type;
+  unsigned long long value;
+  size_t nbytes;
+  unsigned char bytes[sizeof(unsigned long long)];
+
+  // UserDefined only: the ud-suffix starts at `begin + prefixLength`.
+  size_t prefixLength;
+
+  bool isSigned() const
+  { return type == FT_INT || type == FT_LONG_INT || type == FT_LONG_LONG_INT; }
+};
+
+// Classifies and decodes integer-literals.
+//
+// The type of an integer-literal is the first type of 2.14.2 Table 6, given
+// its suffix and whether it is decimal, that can represent the value. If none
+// can, the literal is Invalid. The candidate lists are built at compile time
+// from FundamentalTypeOf<T>() and std::numeric_limits<T>.
+//
+// A user-defined-integer-literal needs a valid integer-literal prefix without
+// an integer-suffix, and a ud-suffix starting with `_`; the value is not range
+// checked, as in the reference implementation.
+//
+// Digits are accumulated eight at a time with SWAR arithmetic on 64-bit words
+// and one byte at a time for the tail.
+class IntegerLiteralDecoder {
+public:
+  // Extensions over C++11, off by default so that PA2 matches the reference.
+  enum Options {
+    BinaryLiterals = 1 << 0,   // 0b101
+    DigitSeparators = 1 << 1,  // 1'000'000
+  };
+
+  static IntegerLiteral decode(const char *begin, const char *end, unsigned options = 0);
+
+  static IntegerLiteral decode(const std::string &s, unsigned options = 0)
+  { return decode(s.data(), s.data() + s.size(), options); }
+};
+
+#endif /* end of include guard */
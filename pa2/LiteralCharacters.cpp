@@ -0,0 +1,69 @@
+#include "LiteralCharacters.h"
+
+namespace {
+
+  inline int hexValue(char c)
+  {
+    if (c >= '0'  &&  c <= '9')
+      return c - '0';
+    const char lower = c | 0x20;
+    if (lower >= 'a'  &&  lower <= 'f')
+      return lower - 'a' + 10;
+    return -1;
+  }
+
+} // namespace
+
+const char *LiteralCharacters::decodeEscape(const char *&p, const char *end, uint32_t &c)
+{
+  if (p == end)
+    return "invalid escape sequence";
+  switch (const char e = *p++) {
+    case '\'': case '"': case '?': case '\\':
+      c = e;
+      return nullptr;
+    case 'a': c = '\a'; return nullptr;
+    case 'b': c = '\b'; return nullptr;
+    case 'f': c = '\f'; return nullptr;
+    case 'n': c = '\n'; return nullptr;
+    case 'r': c = '\r'; return nullptr;
+    case 't': c = '\t'; return nullptr;
+    case 'v': c = '\v'; return nullptr;
+
+    case '0': case '1': case '2': case '3': case '4': case '5': case '6': case '7':
+      c = e - '0';
+      for (int i = 1; i < 3  &&  p != end  &&  *p >= '0'  &&  *p <= '7'; i++)
+        c = c * 8 + (*p++ - '0');
+      return nullptr;
+
+    case 'x':
+      if (p == end  ||  hexValue(*p) < 0)
+        return "invalid hex escape sequence";
+      c = 0;
+      for (; p != end  &&  hexValue(*p) >= 0; ++p) {
+        c = c * 16 + hexValue(*p);
+        if (c > 0x10FFFF)
+          return "hex escape out of range";
+      }
+      return nullptr;
+
+    case 'u': case 'U': {
+      const int n = e == 'u' ? 4 : 8;
+      if (end - p < n)
+        return "invalid universal-character-name";
+      c = 0;
+      for (int i = 0; i < n; i++) {
+        const int d = hexValue(*p++);
+        if (d < 0)
+          return "invalid universal-character-name";
+        c = c * 16 + d;
+      }
+      if (c > 0x10FFFF)
+        return "universal-character-name out of range";
+      return nullptr;
+    }
+
+    default:
+      return "invalid escape sequence";
+  }
+}
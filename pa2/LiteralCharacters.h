@@ -0,0 +1,55 @@
+#ifndef LiteralCharacters_h
+#define LiteralCharacters_h
+
+#include <cstdint>
+
+// Character-level helpers shared by the literal decoders.
+class LiteralCharacters {
+public:
+  // Decodes the escape sequence after a backslash at p (2.14.3, and UCNs) and
+  // advances p past it. Returns nullptr on success, otherwise a description
+  // of the error.
+  static const char *decodeEscape(const char *&p, const char *end, uint32_t &c);
+
+  // Decodes one code point of well-formed UTF-8, as produced by the tokenizer,
+  // and advances p past it.
+  static uint32_t decodeUTF8(const char *&p)
+  {
+    const unsigned char c = *p++;
+    if (c < 0x80)
+      return c;
+    int n;
+    uint32_t x;
+    if (c < 0xE0) {
+      n = 1;
+      x = c & 0x1F;
+    } else if (c < 0xF0) {
+      n = 2;
+      x = c & 0x0F;
+    } else {
+      n = 3;
+      x = c & 0x07;
+    }
+    while (n--)
+      x = (x << 6) | (*p++ & 0x3F);
+    return x;
+  }
+
+  // Whether [p, end) is a ud-suffix: `_` followed by identifier characters.
+  // Bytes of multibyte UTF-8 sequences have been validated by the tokenizer.
+  static bool isUdSuffix(const char *p, const char *end)
+  {
+    if (p == end  ||  *p != '_')
+      return false;
+    for (; p != end; ++p) {
+      const unsigned char c = *p;
+      const bool ok = (c >= '0'  &&  c <= '9')  ||  ((c | 0x20) >= 'a'  &&  (c | 0x20) <= 'z')
+        ||  c == '_'  ||  c >= 0x80;
+      if (!ok)
+        return false;
+    }
+    return true;
+  }
+};
+
+#endif /* end of include guard */
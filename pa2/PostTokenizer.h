@@ -0,0 +1,172 @@
+#ifndef PostTokenizer_h
+#define PostTokenizer_h
+
+#include "CharacterLiteralDecoder.h"
+#include "FloatLiteralDecoder.h"
+#include "IntegerLiteralDecoder.h"
+#include "StringLiteralDecoder.h"
+#include "TokenType.h"
+#include "pa1/PPToken.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Phases 5 to 7 as in PA2: converts preprocessing-tokens to tokens and hands
+// them to an output stream with the emit_* interface, DebugPostTokenOutputStream
+// or TokenStreamWriter.
+//
+// Whitespace and new-lines are not passed in. Adjacent string literals are held
+// back until the next other token and concatenated (phase 6). Tokens that do
+// not convert are emitted as invalid, and post-tokenization goes on.
+template <typename OutputStream>
+class PostTokenizer {
+public:
+  explicit PostTokenizer(OutputStream &out): _out(out), _numStrings(0) {}
+
+  void put(PPTokenType type, const std::string &source);
+
+  // As put(), into an output with set_location(), TokenStreamWriter: the
+  // token is at `line` of the file of string id `file`. Concatenated string
+  // literals are at the first one.
+  void put(PPTokenType type, const std::string &source, uint32_t file, uint32_t line);
+
+  // Flushes the pending string literals and emits eof.
+  void finish()
+  {
+    _flushStrings();
+    _out.emit_eof();
+  }
+
+private:
+  void _putNumber(const std::string &source);
+  void _putCharacter(const std::string &source);
+  void _flushStrings();
+
+  OutputStream &_out;
+
+  // The pending string literals, [0, _numStrings) of a buffer that is reused.
+  std::vector<std::string> _strings;
+  size_t _numStrings;
+  StringLiteral _literal;
+};
+
+template <typename OutputStream>
+void PostTokenizer<OutputStream>::put(PPTokenType type, const std::string &source, uint32_t file, uint32_t line)
+{
+  const bool string = type == PPTokenType::StringLiteral  ||  type == PPTokenType::UserDefinedStringLiteral;
+  if (!string)
+    _flushStrings();
+  if (!string  ||  _numStrings == 0)
+    _out.set_location(file, line);
+  put(type, source);
+}
+
+template <typename OutputStream>
+void PostTokenizer<OutputStream>::put(PPTokenType type, const std::string &source)
+{
+  if (type == PPTokenType::StringLiteral  ||  type == PPTokenType::UserDefinedStringLiteral) {
+    if (_numStrings == _strings.size())
+      _strings.emplace_back();
+    _strings[_numStrings++] = source;
+    return;
+  }
+  _flushStrings();
+
+  switch (type) {
+    case PPTokenType::Identifier:
+    case PPTokenType::PreprocessingOpOrPunc: {
+      // `#`, `##`, `%:` and `%:%:` are not in the map.
+      const auto it = StringToTokenTypeMap.find(source);
+      if (it != StringToTokenTypeMap.end())
+        _out.emit_simple(source, it->second);
+      else if (type == PPTokenType::Identifier)
+        _out.emit_identifier(source);
+      else
+        _out.emit_invalid(source);
+      break;
+    }
+    case PPTokenType::PPNumber:
+      _putNumber(source);
+      break;
+    case PPTokenType::CharacterLiteral:
+    case PPTokenType::UserDefinedCharacterLiteral:
+      _putCharacter(source);
+      break;
+    default:
+      _out.emit_invalid(source);
+      break;
+  }
+}
+
+template <typename OutputStream>
+void PostTokenizer<OutputStream>::_putNumber(const std::string &source)
+{
+  const IntegerLiteral i = IntegerLiteralDecoder::decode(source);
+  switch (i.kind) {
+    case IntegerLiteral::Integer:
+      _out.emit_literal(source, i.type, i.bytes, i.nbytes);
+      return;
+    case IntegerLiteral::UserDefined:
+      _out.emit_user_defined_literal_integer(source, source.substr(i.prefixLength), source.substr(0, i.prefixLength));
+      return;
+    case IntegerLiteral::Invalid:
+      break;
+  }
+
+  const FloatingLiteral f = FloatLiteralDecoder::decode(source);
+  switch (f.kind) {
+    case FloatingLiteral::Floating:
+      _out.emit_literal(source, f.type, f.bytes, f.nbytes);
+      return;
+    case FloatingLiteral::UserDefined:
+      _out.emit_user_defined_literal_floating(source, source.substr(f.prefixLength), source.substr(0, f.prefixLength));
+      return;
+    case FloatingLiteral::Invalid:
+      break;
+  }
+  _out.emit_invalid(source);
+}
+
+template <typename OutputStream>
+void PostTokenizer<OutputStream>::_putCharacter(const std::string &source)
+{
+  const CharacterLiteral c = CharacterLiteralDecoder::decode(source);
+  switch (c.kind) {
+    case CharacterLiteral::Character:
+      _out.emit_literal(source, c.type, c.bytes, c.nbytes);
+      break;
+    case CharacterLiteral::UserDefined:
+      _out.emit_user_defined_literal_character(source, source.substr(c.prefixLength), c.type, c.bytes, c.nbytes);
+      break;
+    case CharacterLiteral::Invalid:
+      _out.emit_invalid(source);
+      break;
+  }
+}
+
+template <typename OutputStream>
+void PostTokenizer<OutputStream>::_flushStrings()
+{
+  if (_numStrings == 0)
+    return;
+
+  // The source of a concatenation is the space separated list of the sources.
+  std::string source = _strings[0];
+  for (size_t i = 1; i < _numStrings; i++)
+    source += " " + _strings[i];
+
+  const std::string *first = _strings.data();
+  const std::string *last = first + _numStrings;
+  _numStrings = 0;
+  if (StringLiteralDecoder::decode(first, last, _literal))
+    _out.emit_invalid(source);
+  else if (_literal.udSuffix.empty())
+    _out.emit_literal_array(source, _literal.numElements, _literal.type, _literal.data.data(), _literal.data.size());
+  else
+    _out.emit_user_defined_literal_string_array(source, _literal.udSuffix, _literal.numElements, _literal.type,
+                                                _literal.data.data(), _literal.data.size());
+}
+
+#endif /* end of include guard */
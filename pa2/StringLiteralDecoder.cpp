@@ -0,0 +1,281 @@
+#include "StringLiteralDecoder.h"
+
+#include "LiteralCharacters.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+  enum class Encoding {
+    Ordinary,
+    UTF8,
+    UTF16,
+    UTF32,
+    Wide,
+  };
+
+  // The parts of one string-literal or user-defined-string-literal token.
+  struct Token {
+    Encoding encoding;
+    bool raw;
+    const char *body;
+    const char *bodyEnd;
+    const char *suffix;
+    const char *suffixEnd;
+  };
+
+  const char *parseToken(const std::string &s, Token &t)
+  {
+    const char *p = s.data();
+    const char *const end = p + s.size();
+
+    t.encoding = Encoding::Ordinary;
+    if (end - p >= 2  &&  p[0] == 'u'  &&  p[1] == '8') {
+      t.encoding = Encoding::UTF8;
+      p += 2;
+    } else if (p != end  &&  *p == 'u') {
+      t.encoding = Encoding::UTF16;
+      ++p;
+    } else if (p != end  &&  *p == 'U') {
+      t.encoding = Encoding::UTF32;
+      ++p;
+    } else if (p != end  &&  *p == 'L') {
+      t.encoding = Encoding::Wide;
+      ++p;
+    }
+    t.raw = p != end  &&  *p == 'R';
+    if (t.raw)
+      ++p;
+    if (p == end  ||  *p != '"')
+      return "not a string literal";
+    ++p;
+
+    // A ud-suffix never contains a quote, so the literal ends at the last one.
+    const char *q = end;
+    do {
+      if (q == p)
+        return "unterminated string literal";
+      --q;
+    } while (*q != '"');
+    t.body = p;
+    t.bodyEnd = q;
+    t.suffix = q + 1;
+    t.suffixEnd = end;
+
+    if (t.raw) {
+      // R"delimiter( raw-characters )delimiter"
+      const char *open = static_cast<const char *>(std::memchr(p, '(', q - p));
+      if (!open)
+        return "invalid raw string literal";
+      const size_t delimiterLength = open - p;
+      if (static_cast<size_t>(q - open) < delimiterLength + 2
+          ||  *(q - delimiterLength - 1) != ')'
+          ||  std::memcmp(p, q - delimiterLength, delimiterLength) != 0)
+        return "invalid raw string literal";
+      t.body = open + 1;
+      t.bodyEnd = q - delimiterLength - 1;
+    }
+    return nullptr;
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  // Code unit sinks
+  ////////////////////////////////////////////////////////////////////////////////
+
+  // Each sink writes code units of one width to a buffer that is already large
+  // enough, and refuses the code points its encoding cannot represent.
+
+  class UTF8Sink {
+  public:
+    static const size_t Width = 1;
+    static const EFundamentalType Type = FT_CHAR;
+
+    explicit UTF8Sink(char *p): _begin(p), _p(p) {}
+
+    size_t count() const { return _p - _begin; }
+
+    // The source is UTF-8 already.
+    bool copySource(const char *begin, const char *end)
+    {
+      std::memcpy(_p, begin, end - begin);
+      _p += end - begin;
+      return true;
+    }
+
+    bool put(uint32_t c)
+    {
+      if (c < 0x80) {
+        *_p++ = c;
+      } else if (c < 0x800) {
+        *_p++ = 0xC0 | (c >> 6);
+        *_p++ = 0x80 | (c & 0x3F);
+      } else if (c < 0x10000) {
+        *_p++ = 0xE0 | (c >> 12);
+        *_p++ = 0x80 | ((c >> 6) & 0x3F);
+        *_p++ = 0x80 | (c & 0x3F);
+      } else {
+        *_p++ = 0xF0 | (c >> 18);
+        *_p++ = 0x80 | ((c >> 12) & 0x3F);
+        *_p++ = 0x80 | ((c >> 6) & 0x3F);
+        *_p++ = 0x80 | (c & 0x3F);
+      }
+      return true;
+    }
+
+  private:
+    char *_begin;
+    char *_p;
+  };
+
+  template <typename CodeUnit, EFundamentalType T>
+  class WideSink {
+  public:
+    static const size_t Width = sizeof(CodeUnit);
+    static const EFundamentalType Type = T;
+
+    explicit WideSink(char *p): _begin(p), _p(p) {}
+
+    size_t count() const { return (_p - _begin) / Width; }
+
+    bool copySource(const char *begin, const char *end)
+    {
+      while (begin != end) {
+        if (!put(LiteralCharacters::decodeUTF8(begin)))
+          return false;
+      }
+      return true;
+    }
+
+    bool put(uint32_t c)
+    {
+      if (c >= 0xD800  &&  c < 0xE000)
+        return false;
+      if (Width == 2  &&  c >= 0x10000) {
+        c -= 0x10000;
+        write(0xD800 + (c >> 10));
+        write(0xDC00 + (c & 0x3FF));
+      } else {
+        write(c);
+      }
+      return true;
+    }
+
+  private:
+    void write(uint32_t c)
+    {
+      // x86-64 is little endian, the same layout as emit_literal_array expects.
+      const CodeUnit u = c;
+      std::memcpy(_p, &u, Width);
+      _p += Width;
+    }
+
+    char *_begin;
+    char *_p;
+  };
+
+  typedef WideSink<char16_t, FT_CHAR16_T> UTF16Sink;
+  typedef WideSink<char32_t, FT_CHAR32_T> UTF32Sink;
+  typedef WideSink<char32_t, FT_WCHAR_T> WideCharSink;
+
+  template <typename Sink>
+  const char *transcode(const Token &t, Sink &sink)
+  {
+    const char *p = t.body;
+    const char *const end = t.bodyEnd;
+    if (t.raw)
+      return sink.copySource(p, end) ? nullptr : "invalid code points";
+
+    while (p != end) {
+      const char *backslash = static_cast<const char *>(std::memchr(p, '\\', end - p));
+      if (!backslash)
+        backslash = end;
+      if (!sink.copySource(p, backslash))
+        return "invalid code points";
+      p = backslash;
+      if (p == end)
+        break;
+
+      ++p;
+      uint32_t c;
+      if (const char *error = LiteralCharacters::decodeEscape(p, end, c))
+        return error;
+      if (!sink.put(c))
+        return "invalid code points";
+    }
+    return nullptr;
+  }
+
+  template <typename Sink>
+  const char *encode(const std::string *first, const std::string *last, size_t maxCodeUnits, StringLiteral &out)
+  {
+    out.data.resize(maxCodeUnits * Sink::Width);
+    Sink sink(&out.data[0]);
+    for (const std::string *s = first; s != last; ++s) {
+      Token t;
+      parseToken(*s, t);
+      if (const char *error = transcode(t, sink))
+        return error;
+    }
+    sink.put(0);
+
+    out.type = Sink::Type;
+    out.numElements = sink.count();
+    out.data.resize(out.numElements * Sink::Width);
+    return nullptr;
+  }
+
+} // namespace
+
+const char *StringLiteralDecoder::decode(const std::string *first, const std::string *last, StringLiteral &out)
+{
+  if (first == last)
+    return "empty string literal sequence";
+
+  // Settle the encoding and the ud-suffix, and bound the number of code units.
+  Encoding encoding = Encoding::Ordinary;
+  const char *suffix = nullptr;
+  size_t suffixLength = 0;
+  size_t maxCodeUnits = 1;
+  for (const std::string *s = first; s != last; ++s) {
+    Token t;
+    if (const char *error = parseToken(*s, t))
+      return error;
+
+    if (t.encoding != Encoding::Ordinary) {
+      if (encoding != Encoding::Ordinary  &&  encoding != t.encoding)
+        return "mismatched encoding prefix in string literal sequence";
+      encoding = t.encoding;
+    }
+
+    if (t.suffix != t.suffixEnd) {
+      const size_t length = t.suffixEnd - t.suffix;
+      if (*t.suffix != '_')
+        return "ud_suffix does not start with _";
+      if (suffix  &&  (length != suffixLength  ||  std::memcmp(suffix, t.suffix, length) != 0))
+        return "mismatched ud_suffix in string literal sequence";
+      suffix = t.suffix;
+      suffixLength = length;
+    }
+
+    maxCodeUnits += t.bodyEnd - t.body;
+  }
+
+  if (suffix)
+    out.udSuffix.assign(suffix, suffixLength);
+  else
+    out.udSuffix.clear();
+
+  switch (encoding) {
+    case Encoding::Ordinary:
+    case Encoding::UTF8:
+      return encode<UTF8Sink>(first, last, maxCodeUnits, out);
+    case Encoding::UTF16:
+      return encode<UTF16Sink>(first, last, maxCodeUnits, out);
+    case Encoding::UTF32:
+      return encode<UTF32Sink>(first, last, maxCodeUnits, out);
+    case Encoding::Wide:
+      return encode<WideCharSink>(first, last, maxCodeUnits, out);
+  }
+  return "unknown encoding";
+}
@@ -0,0 +1,45 @@
+#ifndef StringLiteralDecoder_h
+#define StringLiteralDecoder_h
+
+#include "FundamentalType.h"
+
+#include <cstddef>
+#include <string>
+
+// The result of concatenating a maximal sequence of adjacent string-literal
+// and user-defined-string-literal tokens (2.14.5, 2.14.8).
+//
+// `data` holds the object representation of the array: `numElements` code
+// units of `type`, including the terminating 0, little endian. Keep one
+// StringLiteral around and pass it to every decode() to reuse its buffer.
+struct StringLiteral {
+  EFundamentalType type;      // FT_CHAR, FT_CHAR16_T, FT_CHAR32_T or FT_WCHAR_T
+  size_t numElements;
+  std::string data;
+  std::string udSuffix;       // empty unless user-defined
+};
+
+// Concatenates and encodes string literals in one pass.
+//
+// A first pass over the tokens only looks at their encoding-prefix and
+// ud-suffix, which settles the code unit type and gives an upper bound on the
+// number of code units: no source byte ever encodes to more than one code
+// unit. The buffer is sized once, and the second pass decodes escape
+// sequences and UTF-8 source characters and writes the final code units
+// straight into it. Runs without escapes are copied with memcpy when the
+// target is UTF-8.
+//
+// Course-defined rules, as in the reference implementation:
+//
+//   - Different encoding-prefixes or different ud-suffixes in one sequence
+//     are ill-formed. `u8`, ordinary and raw literals are UTF-8.
+//   - Hex escapes above 0x10FFFF are ill-formed. Surrogate code points are
+//     passed through in UTF-8 but are ill-formed in UTF-16 and UTF-32.
+class StringLiteralDecoder {
+public:
+  // Decodes the sequence of token sources [first, last). Returns nullptr on
+  // success, otherwise a description of the error; `out` is then unspecified.
+  static const char *decode(const std::string *first, const std::string *last, StringLiteral &out);
+};
+
+#endif /* end of include guard */
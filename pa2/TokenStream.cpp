@@ -0,0 +1,266 @@
+#include "TokenStream.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+  const char Magic[8] = {'C', 'P', 'P', 'G', 'M', 'T', 'O', 'K'};
+  const uint32_t Version = 2;
+
+  static_assert(sizeof(TokenRecord) == 28, "TokenRecord is part of the file format");
+  static_assert(sizeof(TokenStreamHeader) == 32, "TokenStreamHeader is part of the file format");
+
+  inline size_t align8(size_t n)
+  { return (n + 7) & ~size_t(7); }
+
+  void writePadding(std::ostream &os, size_t n)
+  {
+    static const char zeros[8] = {};
+    os.write(zeros, align8(n) - n);
+  }
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+// TokenStreamWriter
+////////////////////////////////////////////////////////////////////////////////
+
+TokenStreamWriter::TokenStreamWriter(): _file(0), _line(0)
+{
+  intern("");
+}
+
+void TokenStreamWriter::set_location(uint32_t file, uint32_t line)
+{
+  _file = file;
+  _line = line;
+}
+
+uint32_t TokenStreamWriter::intern(const std::string &s)
+{
+  const auto inserted = _ids.emplace(s, _stringEntries.size() / 2);
+  if (inserted.second) {
+    _stringEntries.push_back(_stringBytes.size());
+    _stringEntries.push_back(s.size());
+    _stringBytes += s;
+  }
+  return inserted.first->second;
+}
+
+TokenRecord &TokenStreamWriter::_add(TokenKind kind, const std::string &source)
+{
+  TokenRecord r = {};
+  r.kind = kind;
+  r.source = intern(source);
+  r.file = _file;
+  r.line = _line;
+  _tokens.push_back(r);
+  return _tokens.back();
+}
+
+void TokenStreamWriter::_addData(TokenRecord &r, const void *data, size_t nbytes)
+{
+  // Keep every literal aligned for its widest type.
+  _literalPool.resize(align8(_literalPool.size()));
+  r.dataOffset = _literalPool.size();
+  r.dataSize = nbytes;
+  _literalPool.append(static_cast<const char *>(data), nbytes);
+}
+
+void TokenStreamWriter::emit_invalid(const std::string &source)
+{
+  _add(TokenKind::Invalid, source);
+}
+
+void TokenStreamWriter::emit_simple(const std::string &source, int token_type)
+{
+  _add(TokenKind::Simple, source).type = token_type;
+}
+
+void TokenStreamWriter::emit_identifier(const std::string &source)
+{
+  _add(TokenKind::Identifier, source);
+}
+
+void TokenStreamWriter::emit_literal(const std::string &source, EFundamentalType type, const void *data, size_t nbytes)
+{
+  TokenRecord &r = _add(TokenKind::Literal, source);
+  r.type = type;
+  _addData(r, data, nbytes);
+}
+
+void TokenStreamWriter::emit_literal_array(const std::string &source, size_t, EFundamentalType type, const void *data, size_t nbytes)
+{
+  TokenRecord &r = _add(TokenKind::LiteralArray, source);
+  r.type = type;
+  _addData(r, data, nbytes);
+}
+
+void TokenStreamWriter::emit_user_defined_literal_character(const std::string &source, const std::string &ud_suffix, EFundamentalType type, const void *data, size_t nbytes)
+{
+  TokenRecord &r = _add(TokenKind::UserDefinedCharacter, source);
+  r.type = type;
+  r.udSuffix = intern(ud_suffix);
+  _addData(r, data, nbytes);
+}
+
+void TokenStreamWriter::emit_user_defined_literal_string_array(const std::string &source, const std::string &ud_suffix, size_t, EFundamentalType type, const void *data, size_t nbytes)
+{
+  TokenRecord &r = _add(TokenKind::UserDefinedStringArray, source);
+  r.type = type;
+  r.udSuffix = intern(ud_suffix);
+  _addData(r, data, nbytes);
+}
+
+void TokenStreamWriter::emit_user_defined_literal_integer(const std::string &source, const std::string &ud_suffix, const std::string &)
+{
+  // The prefix is the source without the ud-suffix.
+  _add(TokenKind::UserDefinedInteger, source).udSuffix = intern(ud_suffix);
+}
+
+void TokenStreamWriter::emit_user_defined_literal_floating(const std::string &source, const std::string &ud_suffix, const std::string &)
+{
+  _add(TokenKind::UserDefinedFloating, source).udSuffix = intern(ud_suffix);
+}
+
+void TokenStreamWriter::emit_eof()
+{
+  _add(TokenKind::Eof, "");
+}
+
+void TokenStreamWriter::write(std::ostream &os) const
+{
+  TokenStreamHeader header = {};
+  std::memcpy(header.magic, Magic, sizeof(Magic));
+  header.version = Version;
+  header.numTokens = _tokens.size();
+  header.numStrings = _stringEntries.size() / 2;
+  header.stringBytesSize = _stringBytes.size();
+  header.literalPoolSize = _literalPool.size();
+  os.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+  os.write(reinterpret_cast<const char *>(_tokens.data()), _tokens.size() * sizeof(TokenRecord));
+  writePadding(os, _tokens.size() * sizeof(TokenRecord));
+
+  os.write(reinterpret_cast<const char *>(_stringEntries.data()), _stringEntries.size() * sizeof(uint32_t));
+  writePadding(os, _stringEntries.size() * sizeof(uint32_t));
+
+  os.write(_stringBytes.data(), _stringBytes.size());
+  writePadding(os, _stringBytes.size());
+
+  os.write(_literalPool.data(), _literalPool.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// TokenStreamReader
+////////////////////////////////////////////////////////////////////////////////
+
+TokenStreamReader::TokenStreamReader(const std::string &path): _mapping(nullptr), _mappingSize(0)
+{
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error("cannot open token stream: " + path);
+  struct stat st;
+  if (fstat(fd, &st) != 0  ||  st.st_size == 0) {
+    close(fd);
+    throw std::runtime_error("cannot map token stream: " + path);
+  }
+  _mappingSize = st.st_size;
+  _mapping = mmap(nullptr, _mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (_mapping == MAP_FAILED) {
+    _mapping = nullptr;
+    throw std::runtime_error("cannot map token stream: " + path);
+  }
+  try {
+    _validate(_mapping, _mappingSize);
+  } catch (...) {
+    munmap(_mapping, _mappingSize);
+    throw;
+  }
+}
+
+TokenStreamReader::TokenStreamReader(const void *data, size_t size): _mapping(nullptr), _mappingSize(0)
+{
+  _validate(data, size);
+}
+
+TokenStreamReader::TokenStreamReader(const TokenStreamWriter &writer): _mapping(nullptr), _mappingSize(0), _header()
+{
+  _header.numTokens = writer._tokens.size();
+  _header.numStrings = writer._stringEntries.size() / 2;
+  _header.stringBytesSize = writer._stringBytes.size();
+  _header.literalPoolSize = writer._literalPool.size();
+  _tokens = writer._tokens.data();
+  _stringEntries = writer._stringEntries.data();
+  _stringBytes = writer._stringBytes.data();
+  _literalPool = writer._literalPool.data();
+}
+
+TokenStreamReader::~TokenStreamReader()
+{
+  if (_mapping)
+    munmap(_mapping, _mappingSize);
+}
+
+void TokenStreamReader::_validate(const void *data, size_t size)
+{
+  if (size < sizeof(TokenStreamHeader)  ||  std::memcmp(data, Magic, sizeof(Magic)) != 0)
+    throw std::runtime_error("not a token stream");
+  std::memcpy(&_header, data, sizeof(_header));
+  if (_header.version != Version)
+    throw std::runtime_error("unsupported token stream version");
+
+  const char *base = static_cast<const char *>(data);
+  const size_t tokensOffset = sizeof(TokenStreamHeader);
+  const size_t stringEntriesOffset = tokensOffset + align8(size_t(_header.numTokens) * sizeof(TokenRecord));
+  const size_t stringBytesOffset = stringEntriesOffset + align8(size_t(_header.numStrings) * 2 * sizeof(uint32_t));
+  const size_t literalPoolOffset = stringBytesOffset + align8(_header.stringBytesSize);
+  if (literalPoolOffset + _header.literalPoolSize > size)
+    throw std::runtime_error("truncated token stream");
+
+  _tokens = reinterpret_cast<const TokenRecord *>(base + tokensOffset);
+  _stringEntries = reinterpret_cast<const uint32_t *>(base + stringEntriesOffset);
+  _stringBytes = base + stringBytesOffset;
+  _literalPool = base + literalPoolOffset;
+
+  // Everything the accessors index with is checked once here, so they need
+  // not check again. The sums are 64 bits and cannot overflow.
+  if (_header.numStrings == 0)
+    throw std::runtime_error("token stream without the empty string");
+  for (size_t id = 0; id < _header.numStrings; id++)
+    if (uint64_t(_stringEntries[2 * id]) + _stringEntries[2 * id + 1] > _header.stringBytesSize)
+      throw std::runtime_error("string out of range in token stream");
+  for (const TokenRecord &r: *this) {
+    if (r.kind > TokenKind::Eof)
+      throw std::runtime_error("invalid token kind in token stream");
+    if (r.source >= _header.numStrings  ||  r.udSuffix >= _header.numStrings  ||  r.file >= _header.numStrings)
+      throw std::runtime_error("string id out of range in token stream");
+    if (uint64_t(r.dataOffset) + r.dataSize > _header.literalPoolSize)
+      throw std::runtime_error("literal out of range in token stream");
+  }
+}
+
+TokenString TokenStreamReader::string(uint32_t id) const
+{
+  return TokenString{_stringBytes + _stringEntries[2 * id], _stringEntries[2 * id + 1]};
+}
+
+size_t TokenStreamReader::numElements(const TokenRecord &r)
+{
+  switch (r.type) {
+    case FT_CHAR16_T:
+      return r.dataSize / 2;
+    case FT_CHAR32_T:
+    case FT_WCHAR_T:
+      return r.dataSize / 4;
+    default:
+      return r.dataSize;
+  }
+}
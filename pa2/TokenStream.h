@@ -0,0 +1,208 @@
+#ifndef TokenStream_h
+#define TokenStream_h
+
+#include "FundamentalType.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Binary token stream passed between the pipeline stages, so that a stage
+// reads the post-tokens of the previous one without lexing the PA2 text
+// format again. The text format remains the debug dump: replay() feeds a
+// stream back into DebugPostTokenOutputStream.
+//
+// Layout, all integers little endian, all sections 8-byte aligned:
+//
+//   TokenStreamHeader
+//   TokenRecord[numTokens]
+//   StringEntry[numStrings]      offset and length into the string bytes
+//   string bytes                 sources, identifiers and ud-suffixes
+//   literal pool                 object representations of the literals
+//
+// Strings are interned: equal strings have equal ids in one stream, so
+// identifiers compare by id. Id 0 is the empty string.
+//
+// posttoken -o writes a stream to a file, which recog --tokens maps; recog
+// also reads the stream of each preprocessed srcfile in place.
+
+enum class TokenKind: uint8_t {
+  Invalid,
+  Simple,
+  Identifier,
+  Literal,
+  LiteralArray,
+  UserDefinedCharacter,
+  UserDefinedStringArray,
+  UserDefinedInteger,
+  UserDefinedFloating,
+  Eof,
+};
+
+// One post-token, fixed size.
+struct TokenRecord {
+  TokenKind kind;
+  uint8_t reserved;
+  uint16_t type;          // ETokenType of a Simple, EFundamentalType of a literal
+  uint32_t source;        // string id of the source
+  uint32_t udSuffix;      // string id of the ud-suffix, 0 if none
+  uint32_t dataOffset;    // literal data in the literal pool
+  uint32_t dataSize;
+  uint32_t file;          // string id of the source file, 0 if unknown
+  uint32_t line;          // the source line, from 1, 0 if unknown
+};
+
+struct TokenStreamHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t numTokens;
+  uint32_t numStrings;
+  uint32_t stringBytesSize;
+  uint32_t literalPoolSize;
+  uint32_t reserved;
+};
+
+// A string inside the mapped stream, not terminated.
+struct TokenString {
+  const char *data;
+  size_t size;
+
+  std::string str() const { return std::string(data, size); }
+};
+
+// Collects the post-tokens in memory and writes the stream at the end. Has
+// the emit_* interface of DebugPostTokenOutputStream, so either can be the
+// output of the post-tokenizer.
+class TokenStreamWriter {
+public:
+  TokenStreamWriter();
+
+  // The string id of `s`, e.g. of a file for set_location().
+  uint32_t intern(const std::string &s);
+
+  // The location of the tokens emitted from now on, `file` a string id.
+  void set_location(uint32_t file, uint32_t line);
+
+  void emit_invalid(const std::string &source);
+  void emit_simple(const std::string &source, int token_type);
+  void emit_identifier(const std::string &source);
+  void emit_literal(const std::string &source, EFundamentalType type, const void *data, size_t nbytes);
+  void emit_literal_array(const std::string &source, size_t num_elements, EFundamentalType type, const void *data, size_t nbytes);
+  void emit_user_defined_literal_character(const std::string &source, const std::string &ud_suffix, EFundamentalType type, const void *data, size_t nbytes);
+  void emit_user_defined_literal_string_array(const std::string &source, const std::string &ud_suffix, size_t num_elements, EFundamentalType type, const void *data, size_t nbytes);
+  void emit_user_defined_literal_integer(const std::string &source, const std::string &ud_suffix, const std::string &prefix);
+  void emit_user_defined_literal_floating(const std::string &source, const std::string &ud_suffix, const std::string &prefix);
+  void emit_eof();
+
+  void write(std::ostream &os) const;
+
+private:
+  friend class TokenStreamReader;
+
+  TokenRecord &_add(TokenKind kind, const std::string &source);
+  void _addData(TokenRecord &r, const void *data, size_t nbytes);
+
+  uint32_t _file;
+  uint32_t _line;
+  std::vector<TokenRecord> _tokens;
+  std::unordered_map<std::string, uint32_t> _ids;
+  std::vector<uint32_t> _stringEntries;   // offset and length of each string
+  std::string _stringBytes;
+  std::string _literalPool;
+};
+
+// Maps a token stream file read-only and hands out pointers into it. Throws
+// std::runtime_error if the file cannot be mapped or is not a token stream,
+// including when a string id, string entry or literal of it lies outside its
+// section, so the accessors below never read outside the stream.
+class TokenStreamReader {
+public:
+  explicit TokenStreamReader(const std::string &path);
+
+  // Reads a stream from memory that outlives the reader, e.g. a pipe that
+  // was read into a buffer.
+  TokenStreamReader(const void *data, size_t size);
+
+  // Reads the tokens of a writer in place, without writing the stream, for a
+  // stage that runs in the same process. The writer must outlive the reader
+  // and not be written to while it is read.
+  explicit TokenStreamReader(const TokenStreamWriter &writer);
+
+  ~TokenStreamReader();
+
+  TokenStreamReader(const TokenStreamReader &) = delete;
+  TokenStreamReader &operator=(const TokenStreamReader &) = delete;
+
+  size_t size() const { return _header.numTokens; }
+  const TokenRecord *begin() const { return _tokens; }
+  const TokenRecord *end() const { return _tokens + _header.numTokens; }
+  const TokenRecord &operator[](size_t i) const { return _tokens[i]; }
+
+  size_t numStrings() const { return _header.numStrings; }
+  TokenString string(uint32_t id) const;
+
+  const void *data(const TokenRecord &r) const { return _literalPool + r.dataOffset; }
+
+  // Number of code units of a literal array.
+  static size_t numElements(const TokenRecord &r);
+
+private:
+  void _validate(const void *data, size_t size);
+
+  void *_mapping;
+  size_t _mappingSize;
+  TokenStreamHeader _header;
+  const TokenRecord *_tokens;
+  const uint32_t *_stringEntries;
+  const char *_stringBytes;
+  const char *_literalPool;
+};
+
+// Replays a token stream into an output stream with the emit_* interface,
+// typically DebugPostTokenOutputStream for a text dump.
+template <typename TokenType, typename OutputStream>
+void replay(const TokenStreamReader &in, OutputStream &out)
+{
+  for (const TokenRecord &r: in) {
+    const std::string source = in.string(r.source).str();
+    const std::string udSuffix = in.string(r.udSuffix).str();
+    const EFundamentalType type = static_cast<EFundamentalType>(r.type);
+    switch (r.kind) {
+      case TokenKind::Invalid:
+        out.emit_invalid(source);
+        break;
+      case TokenKind::Simple:
+        out.emit_simple(source, static_cast<TokenType>(r.type));
+        break;
+      case TokenKind::Identifier:
+        out.emit_identifier(source);
+        break;
+      case TokenKind::Literal:
+        out.emit_literal(source, type, in.data(r), r.dataSize);
+        break;
+      case TokenKind::LiteralArray:
+        out.emit_literal_array(source, TokenStreamReader::numElements(r), type, in.data(r), r.dataSize);
+        break;
+      case TokenKind::UserDefinedCharacter:
+        out.emit_user_defined_literal_character(source, udSuffix, type, in.data(r), r.dataSize);
+        break;
+      case TokenKind::UserDefinedStringArray:
+        out.emit_user_defined_literal_string_array(source, udSuffix, TokenStreamReader::numElements(r), type, in.data(r), r.dataSize);
+        break;
+      case TokenKind::UserDefinedInteger:
+        out.emit_user_defined_literal_integer(source, udSuffix, source.substr(0, source.size() - udSuffix.size()));
+        break;
+      case TokenKind::UserDefinedFloating:
+        out.emit_user_defined_literal_floating(source, udSuffix, source.substr(0, source.size() - udSuffix.size()));
+        break;
+      case TokenKind::Eof:
+        out.emit_eof();
+        break;
+    }
+  }
+}
+
+#endif /* end of include guard */
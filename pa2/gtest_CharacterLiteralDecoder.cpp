@@ -0,0 +1,79 @@
+#include "CharacterLiteralDecoder.h"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+
+namespace {
+
+  // Expected outputs are the ones given by posttoken-ref.
+  void expectCharacter(const std::string &s, EFundamentalType type, uint32_t value, size_t nbytes)
+  {
+    const CharacterLiteral r = CharacterLiteralDecoder::decode(s);
+    ASSERT_EQ(CharacterLiteral::Character, r.kind) << s << ": " << (r.error ? r.error : "");
+    EXPECT_EQ(type, r.type) << s;
+    EXPECT_EQ(value, r.value) << s;
+    EXPECT_EQ(nbytes, r.nbytes) << s;
+    uint32_t bytes = 0;
+    std::memcpy(&bytes, r.bytes, r.nbytes);
+    EXPECT_EQ(value, bytes) << s;
+  }
+
+  void expectInvalid(const std::string &s)
+  {
+    const CharacterLiteral r = CharacterLiteralDecoder::decode(s);
+    EXPECT_EQ(CharacterLiteral::Invalid, r.kind) << s;
+    EXPECT_NE(nullptr, r.error) << s;
+  }
+
+} // namespace
+
+TEST(CharacterLiteralDecoder, Simple)
+{
+  expectCharacter("'a'", FT_CHAR, 'a', 1);
+  expectCharacter("'\x7f'", FT_CHAR, 0x7F, 1);
+  expectCharacter("'\xc3\xa9'", FT_INT, 0xE9, 4);
+  expectCharacter("u'\xc3\xa9'", FT_CHAR16_T, 0xE9, 2);
+  expectCharacter("U'\xf0\x90\x80\x80'", FT_CHAR32_T, 0x10000, 4);
+  expectCharacter("L'x'", FT_WCHAR_T, 'x', 4);
+  expectCharacter("'\"'", FT_CHAR, '"', 1);
+}
+
+TEST(CharacterLiteralDecoder, Escapes)
+{
+  expectCharacter("'\\n'", FT_CHAR, '\n', 1);
+  expectCharacter("'\\''", FT_CHAR, '\'', 1);
+  expectCharacter("'\\0'", FT_CHAR, 0, 1);
+  expectCharacter("'\\377'", FT_INT, 0xFF, 4);
+  expectCharacter("'\\777'", FT_INT, 0x1FF, 4);
+  expectCharacter("'\\xff'", FT_INT, 0xFF, 4);
+  expectCharacter("'\\u00e9'", FT_INT, 0xE9, 4);
+  expectCharacter("u'\\xFFFF'", FT_CHAR16_T, 0xFFFF, 2);
+
+  expectInvalid("'\\x110000'");
+  expectInvalid("'\\xD800'");
+  expectInvalid("U'\\xD800'");
+  expectInvalid("u'\\U00010000'");
+  expectInvalid("'\\q'");
+  expectInvalid("'\\1234'");
+}
+
+TEST(CharacterLiteralDecoder, Malformed)
+{
+  expectInvalid("''");
+  expectInvalid("'ab'");
+  expectInvalid("'");
+  expectInvalid("a");
+  expectInvalid("");
+  expectInvalid("u8'a'");
+}
+
+TEST(CharacterLiteralDecoder, UserDefined)
+{
+  const CharacterLiteral r = CharacterLiteralDecoder::decode("u'a'_x");
+  EXPECT_EQ(CharacterLiteral::UserDefined, r.kind);
+  EXPECT_EQ(FT_CHAR16_T, r.type);
+  EXPECT_EQ(uint32_t('a'), r.value);
+  EXPECT_EQ(4u, r.prefixLength);
+
+  expectInvalid("'a'x");
+}
@@ -0,0 +1,160 @@
+#include "FloatLiteralDecoder.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+  // The reference: what PA2Decode_* used to do.
+  template <typename T>
+  T scanWithStream(const std::string &s)
+  {
+    std::istringstream iss(s);
+    T x = 0;
+    iss >> x;
+    return x;
+  }
+
+  // Compare the value bits only, the x87 format has 6 bytes of padding.
+  template <typename T>
+  bool sameBits(T a, T b)
+  {
+    const size_t n = sizeof(T) == sizeof(long double) ? 10 : sizeof(T);
+    return std::memcmp(&a, &b, n) == 0;
+  }
+
+  void expectSameAsStream(const std::string &s)
+  {
+    EXPECT_TRUE(sameBits(scanWithStream<float>(s), FloatLiteralDecoder::decodeFloat(s))) << "float " << s;
+    EXPECT_TRUE(sameBits(scanWithStream<double>(s), FloatLiteralDecoder::decodeDouble(s))) << "double " << s;
+    EXPECT_TRUE(sameBits(scanWithStream<long double>(s), FloatLiteralDecoder::decodeLongDouble(s))) << "long double " << s;
+  }
+
+} // namespace
+
+TEST(FloatLiteralDecoder, Simple)
+{
+  EXPECT_EQ(3.2, FloatLiteralDecoder::decodeDouble("3.2"));
+  EXPECT_EQ(1.5f, FloatLiteralDecoder::decodeFloat("1.5f"));
+  EXPECT_EQ(1.5L, FloatLiteralDecoder::decodeLongDouble("1.5L"));
+  EXPECT_EQ(100000.0, FloatLiteralDecoder::decodeDouble("1.e5"));
+  EXPECT_EQ(0.25, FloatLiteralDecoder::decodeDouble(".25"));
+  EXPECT_EQ(1.25, FloatLiteralDecoder::decodeDouble("00012.5e-0001"));
+}
+
+TEST(FloatLiteralDecoder, Suffixes)
+{
+  const std::vector<std::string> w = {
+    "1.5f", "1.5F", "1.5l", "1.5L", "4.2_bar", "1e+5_x", "12_a", "1..e", "0x1p3",
+  };
+  for (const auto &s: w)
+    expectSameAsStream(s);
+}
+
+TEST(FloatLiteralDecoder, Malformed)
+{
+  const std::vector<std::string> w = {
+    "", ".", "..", "e5", ".e5", "1e", "1e+", "1e-", "1E_x", "_1",
+  };
+  for (const auto &s: w) {
+    expectSameAsStream(s);
+    EXPECT_EQ(0.0, FloatLiteralDecoder::decodeDouble(s)) << s;
+  }
+}
+
+TEST(FloatLiteralDecoder, OverflowAndUnderflow)
+{
+  EXPECT_EQ(std::numeric_limits<float>::max(), FloatLiteralDecoder::decodeFloat("1e39"));
+  EXPECT_EQ(std::numeric_limits<double>::max(), FloatLiteralDecoder::decodeDouble("1e400"));
+  EXPECT_EQ(std::numeric_limits<long double>::max(), FloatLiteralDecoder::decodeLongDouble("1.19e4932"));
+  EXPECT_EQ(0.0f, FloatLiteralDecoder::decodeFloat("1e-50"));
+
+  const std::vector<std::string> w = {
+    "1e400", "1e-400", "1e-50", "1e4932", "1.19e4932", "1.18e-4951",
+    "1e99999999999999999999", "1e-99999999999999999999",
+    "3.4028234663852886e38", "3.4028235677973366e38", "3.4028235677973367e38",
+    "1.7976931348623157e308", "1.7976931348623158e308", "1.7976931348623159e308",
+    "1.18973149535723176502e+4932",
+  };
+  for (const auto &s: w)
+    expectSameAsStream(s);
+}
+
+TEST(FloatLiteralDecoder, Subnormals)
+{
+  const std::vector<std::string> w = {
+    "1.4e-45", "7e-46", "7.006492321624085e-46", "7.1e-46", "1.1754942e-38",
+    "2.2250738585072011e-308", "2.2250738585072012e-308",
+    "4.9406564584124654e-324", "2.4703282292062327e-324", "2.4703282292062328e-324",
+    "3.64519953188247460253e-4951", "1.82259976594123730126e-4951",
+    "1.8225997659412373012e-4951",
+  };
+  for (const auto &s: w)
+    expectSameAsStream(s);
+}
+
+TEST(FloatLiteralDecoder, ManyDigits)
+{
+  const std::vector<std::string> w = {
+    "9007199254740993", "9007199254740992.5", "16777217", "33554435",
+    "123456789012345678901234567890",
+    "3.14159265358979323846264338327950288419716939937510582097494459",
+    "0.000000000000000000000000000000000000000000000000000000000000000001",
+    "100000000000000000000000000000000000000000000000000000000000000000000e-50",
+  };
+  for (const auto &s: w)
+    expectSameAsStream(s);
+}
+
+// Decimal expansions of the exact midpoint between two neighbouring doubles
+// or floats, and strings close to them, decide on round half to even.
+TEST(FloatLiteralDecoder, Halfway)
+{
+  std::mt19937_64 rng(42);
+  char buf[1024];
+  for (int i = 0; i < 2000; i++) {
+    const uint64_t bits = rng() & ~(uint64_t(1) << 63);
+    double d;
+    std::memcpy(&d, &bits, sizeof(d));
+    if (!std::isfinite(d) || !std::isfinite(std::nextafter(d, INFINITY)))
+      continue;
+    const long double mid = (static_cast<long double>(d) + std::nextafter(d, INFINITY)) / 2;
+    std::snprintf(buf, sizeof(buf), "%.*Le", i % 10 == 0 ? 800 : 17 + i % 40, mid);
+    expectSameAsStream(buf);
+
+    const uint32_t fbits = static_cast<uint32_t>(rng()) & ~(uint32_t(1) << 31);
+    float f;
+    std::memcpy(&f, &fbits, sizeof(f));
+    if (!std::isfinite(f) || !std::isfinite(std::nextafter(f, INFINITY)))
+      continue;
+    const double fmid = (static_cast<double>(f) + std::nextafter(f, INFINITY)) / 2;
+    std::snprintf(buf, sizeof(buf), "%.*e", i % 10 == 0 ? 150 : 8 + i % 20, fmid);
+    expectSameAsStream(buf);
+  }
+}
+
+TEST(FloatLiteralDecoder, Random)
+{
+  std::mt19937_64 rng(7);
+  for (int i = 0; i < 20000; i++) {
+    std::string s;
+    const int ndigits = rng() % 25 + 1;
+    for (int j = 0; j < ndigits; j++)
+      s += static_cast<char>('0' + rng() % 10);
+    if (rng() % 2)
+      s.insert(rng() % (s.size() + 1), ".");
+    if (rng() % 3) {
+      s += "eE"[rng() % 2];
+      const int sign = rng() % 3;
+      if (sign)
+        s += sign == 1 ? '-' : '+';
+      s += std::to_string(rng() % 4 ? rng() % 400 : rng() % 5000);
+    }
+    expectSameAsStream(s);
+  }
+}
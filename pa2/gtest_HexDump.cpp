@@ -0,0 +1,68 @@
+#include "HexDump.h"
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+  // The original PA2 starter code implementation.
+  std::string referenceHexDump(const void *data, size_t nbytes)
+  {
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    std::string s;
+    for (size_t i = 0; i < nbytes; i++) {
+      s += "0123456789ABCDEF"[p[i] >> 4];
+      s += "0123456789ABCDEF"[p[i] & 0x0F];
+    }
+    return s;
+  }
+
+  std::string streamed(const void *data, size_t nbytes)
+  {
+    std::ostringstream os;
+    os << HexDump(data, nbytes);
+    return os.str();
+  }
+
+} // namespace
+
+TEST(HexDump, Simple)
+{
+  const uint32_t x = 0x12AB34CD;
+  EXPECT_EQ("CD34AB12", streamed(&x, sizeof(x)));
+  EXPECT_EQ("", streamed(&x, 0));
+
+  std::ostringstream os;
+  os << "literal 1 int " << HexDump(&x, 1) << " end";
+  EXPECT_EQ("literal 1 int CD end", os.str());
+}
+
+TEST(HexDump, AllBytes)
+{
+  std::vector<unsigned char> v(256);
+  for (int i = 0; i < 256; i++)
+    v[i] = i;
+  EXPECT_EQ(referenceHexDump(v.data(), v.size()), streamed(v.data(), v.size()));
+}
+
+// Lengths on both sides of the 16 byte vectors and of the stream chunks.
+TEST(HexDump, Lengths)
+{
+  std::mt19937 rng(5);
+  std::vector<unsigned char> v(3000);
+  for (auto &c: v)
+    c = rng();
+
+  for (size_t n = 0; n < 100; n++)
+    EXPECT_EQ(referenceHexDump(v.data() + n % 7, n), streamed(v.data() + n % 7, n)) << n;
+  for (size_t n: {511, 512, 513, 1024, 1040, 2999}) {
+    EXPECT_EQ(referenceHexDump(v.data(), n), streamed(v.data(), n)) << n;
+
+    std::string out(2 * n, '?');
+    HexDump::write(&out[0], v.data(), n);
+    EXPECT_EQ(referenceHexDump(v.data(), n), out) << n;
+  }
+}
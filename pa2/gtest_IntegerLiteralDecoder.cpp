@@ -0,0 +1,139 @@
+#include "IntegerLiteralDecoder.h"
+#include <gtest/gtest.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+  void expectInteger(const std::string &s, EFundamentalType type, unsigned long long value)
+  {
+    const IntegerLiteral r = IntegerLiteralDecoder::decode(s);
+    ASSERT_EQ(IntegerLiteral::Integer, r.kind) << s;
+    EXPECT_EQ(type, r.type) << s;
+    EXPECT_EQ(value, r.value) << s;
+    const size_t nbytes = type == FT_INT || type == FT_UNSIGNED_INT ? 4 : 8;
+    EXPECT_EQ(nbytes, r.nbytes) << s;
+    EXPECT_EQ(0, std::memcmp(&value, r.bytes, r.nbytes)) << s;
+  }
+
+  void expectUserDefined(const std::string &s, size_t prefixLength)
+  {
+    const IntegerLiteral r = IntegerLiteralDecoder::decode(s);
+    EXPECT_EQ(IntegerLiteral::UserDefined, r.kind) << s;
+    EXPECT_EQ(prefixLength, r.prefixLength) << s;
+  }
+
+  void expectInvalid(const std::string &s, unsigned options = 0)
+  {
+    EXPECT_EQ(IntegerLiteral::Invalid, IntegerLiteralDecoder::decode(s, options).kind) << s;
+  }
+
+} // namespace
+
+TEST(IntegerLiteralDecoder, Simple)
+{
+  expectInteger("0", FT_INT, 0);
+  expectInteger("00", FT_INT, 0);
+  expectInteger("42", FT_INT, 42);
+  expectInteger("0755", FT_INT, 0755);
+  expectInteger("0X1aB", FT_INT, 0x1ab);
+  expectInteger("123456789012", FT_LONG_INT, 123456789012);
+}
+
+// Expected types are the ones given by posttoken-ref.
+TEST(IntegerLiteralDecoder, TypeSelection)
+{
+  expectInteger("2147483647", FT_INT, 2147483647);
+  expectInteger("2147483648", FT_LONG_INT, 2147483648);
+  expectInteger("0x7FFFFFFF", FT_INT, 0x7fffffff);
+  expectInteger("0xFFFFFFFF", FT_UNSIGNED_INT, 0xffffffff);
+  expectInteger("4294967296", FT_LONG_INT, 4294967296);
+  expectInteger("0xFFFFFFFFFFFFFFFF", FT_UNSIGNED_LONG_INT, 0xffffffffffffffff);
+  expectInteger("0777777777777777777777", FT_LONG_INT, 0x7fffffffffffffff);
+  expectInteger("9223372036854775807ll", FT_LONG_LONG_INT, 9223372036854775807);
+  expectInteger("0x8000000000000000ll", FT_UNSIGNED_LONG_LONG_INT, 0x8000000000000000);
+  expectInteger("0u", FT_UNSIGNED_INT, 0);
+  expectInteger("0xffffffffu", FT_UNSIGNED_INT, 0xffffffff);
+  expectInteger("0x100000000u", FT_UNSIGNED_LONG_INT, 0x100000000);
+  expectInteger("123l", FT_LONG_INT, 123);
+  expectInteger("123Ul", FT_UNSIGNED_LONG_INT, 123);
+  expectInteger("0lu", FT_UNSIGNED_LONG_INT, 0);
+  expectInteger("123uLL", FT_UNSIGNED_LONG_LONG_INT, 123);
+  expectInteger("123LLu", FT_UNSIGNED_LONG_LONG_INT, 123);
+  expectInteger("18446744073709551615u", FT_UNSIGNED_LONG_INT, 18446744073709551615u);
+
+  expectInvalid("9223372036854775808");
+  expectInvalid("18446744073709551615");
+  expectInvalid("18446744073709551616u");
+  expectInvalid("99999999999999999999999u");
+  expectInvalid("0x10000000000000000");
+}
+
+TEST(IntegerLiteralDecoder, Malformed)
+{
+  const std::vector<std::string> w = {
+    "", "x", "_1", "0x", "0X_", "0xu", "08", "09u", "12a", "0x1fg", "123lul", "123lL", "123Ll",
+    "0uLl", "1u_", "123lu_x", "08_z", "0x_1", "1.0", "1e5", "1_a.b", "1_ae+5", "0b101", "1'000",
+  };
+  for (const auto &s: w)
+    expectInvalid(s);
+}
+
+TEST(IntegerLiteralDecoder, UserDefined)
+{
+  expectUserDefined("123_x", 3);
+  expectUserDefined("0x1f_y", 4);
+  expectUserDefined("0xabc_", 5);
+  expectUserDefined("1_x_y", 1);
+  expectUserDefined("00_a", 2);
+  expectUserDefined("1_\xc3\xa9", 1);
+  expectUserDefined("99999999999999999999_w", 20);
+}
+
+TEST(IntegerLiteralDecoder, Extensions)
+{
+  const unsigned all = IntegerLiteralDecoder::BinaryLiterals | IntegerLiteralDecoder::DigitSeparators;
+  EXPECT_EQ(5u, IntegerLiteralDecoder::decode("0b101", all).value);
+  EXPECT_EQ(FT_UNSIGNED_INT, IntegerLiteralDecoder::decode("0B11111111111111111111111111111111", all).type);
+  EXPECT_EQ(1000000u, IntegerLiteralDecoder::decode("1'000'000", all).value);
+  EXPECT_EQ(0xdeadbeefcafeull, IntegerLiteralDecoder::decode("0xdead'beef'cafe", all).value);
+  EXPECT_EQ(07u, IntegerLiteralDecoder::decode("0'7", all).value);
+  EXPECT_EQ(3u, IntegerLiteralDecoder::decode("1'1_x", all).prefixLength);
+
+  const std::vector<std::string> w = {
+    "0b", "0b2", "1''0", "1'", "'1", "0x'1", "1'_x", "0b1'", "1'a",
+  };
+  for (const auto &s: w)
+    expectInvalid(s, all);
+}
+
+// Compare the values with strtoull for lengths around the eight digit chunks.
+TEST(IntegerLiteralDecoder, Random)
+{
+  std::mt19937_64 rng(1);
+  const char digits[] = "0123456789abcdefABCDEF";
+  const int bases[] = {8, 10, 16};
+  for (int i = 0; i < 100000; i++) {
+    const int base = bases[i % 3];
+    const int ndigits = rng() % 24 + 1;
+    std::string s = base == 8 ? "0" : base == 16 ? "0x" : "";
+    s += digits[base == 10 ? rng() % 9 + 1 : rng() % base];
+    for (int j = 1; j < ndigits; j++)
+      s += digits[base == 16 ? rng() % 22 : rng() % base];
+    s += "ull";
+
+    errno = 0;
+    const unsigned long long expected = std::strtoull(s.c_str(), nullptr, base);
+    const IntegerLiteral r = IntegerLiteralDecoder::decode(s);
+    if (errno == ERANGE) {
+      EXPECT_EQ(IntegerLiteral::Invalid, r.kind) << s;
+    } else {
+      EXPECT_EQ(IntegerLiteral::Integer, r.kind) << s;
+      EXPECT_EQ(expected, r.value) << s;
+    }
+  }
+}
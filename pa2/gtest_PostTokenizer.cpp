@@ -0,0 +1,125 @@
+#include "PostTokenizer.h"
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+  // Records one line per token: the kind, the source and the type.
+  struct RecordingOutputStream {
+    std::vector<std::string> tokens;
+
+    void emit_invalid(const std::string &source)
+    { tokens.push_back("invalid " + source); }
+    void emit_simple(const std::string &source, ETokenType type)
+    { tokens.push_back("simple " + source + " " + TokenTypeToStringMap.at(type)); }
+    void emit_identifier(const std::string &source)
+    { tokens.push_back("identifier " + source); }
+    void emit_literal(const std::string &source, EFundamentalType type, const void *, size_t nbytes)
+    { tokens.push_back("literal " + source + " " + std::to_string(type) + " " + std::to_string(nbytes)); }
+    void emit_literal_array(const std::string &source, size_t numElements, EFundamentalType type, const void *, size_t)
+    { tokens.push_back("array " + source + " " + std::to_string(numElements) + " " + std::to_string(type)); }
+    void emit_user_defined_literal_character(const std::string &source, const std::string &udSuffix, EFundamentalType, const void *, size_t)
+    { tokens.push_back("udc " + source + " " + udSuffix); }
+    void emit_user_defined_literal_string_array(const std::string &source, const std::string &udSuffix, size_t, EFundamentalType, const void *, size_t)
+    { tokens.push_back("uds " + source + " " + udSuffix); }
+    void emit_user_defined_literal_integer(const std::string &source, const std::string &udSuffix, const std::string &prefix)
+    { tokens.push_back("udi " + source + " " + udSuffix + " " + prefix); }
+    void emit_user_defined_literal_floating(const std::string &source, const std::string &udSuffix, const std::string &prefix)
+    { tokens.push_back("udf " + source + " " + udSuffix + " " + prefix); }
+    void emit_eof()
+    { tokens.push_back("eof"); }
+  };
+
+  // Records the locations too, as a line of their own.
+  struct LocatingOutputStream: RecordingOutputStream {
+    void set_location(uint32_t file, uint32_t line)
+    { tokens.push_back("at " + std::to_string(file) + ":" + std::to_string(line)); }
+  };
+
+} // namespace
+
+TEST(PostTokenizer, Classification)
+{
+  RecordingOutputStream out;
+  PostTokenizer<RecordingOutputStream> p(out);
+  p.put(PPTokenType::Identifier, "int");
+  p.put(PPTokenType::Identifier, "x");
+  p.put(PPTokenType::PreprocessingOpOrPunc, "and");
+  p.put(PPTokenType::PreprocessingOpOrPunc, "%:");
+  p.put(PPTokenType::PPNumber, "42ul");
+  p.put(PPTokenType::PPNumber, "1.5f");
+  p.put(PPTokenType::PPNumber, "1.0L");
+  p.put(PPTokenType::PPNumber, "12_km");
+  p.put(PPTokenType::PPNumber, "1e3_s");
+  p.put(PPTokenType::PPNumber, "1..e");
+  p.put(PPTokenType::CharacterLiteral, "'a'");
+  p.put(PPTokenType::UserDefinedCharacterLiteral, "'a'_c");
+  p.put(PPTokenType::NonWhitespaceChar, "$");
+  p.finish();
+
+  const std::vector<std::string> expected = {
+    "simple int KW_INT",
+    "identifier x",
+    "simple and OP_LAND",
+    "invalid %:",
+    "literal 42ul " + std::to_string(FT_UNSIGNED_LONG_INT) + " 8",
+    "literal 1.5f " + std::to_string(FT_FLOAT) + " 4",
+    "literal 1.0L " + std::to_string(FT_LONG_DOUBLE) + " 16",
+    "udi 12_km _km 12",
+    "udf 1e3_s _s 1e3",
+    "invalid 1..e",
+    "literal 'a' " + std::to_string(FT_CHAR) + " 1",
+    "udc 'a'_c _c",
+    "invalid $",
+    "eof",
+  };
+  EXPECT_EQ(expected, out.tokens);
+}
+
+TEST(PostTokenizer, StringConcatenation)
+{
+  RecordingOutputStream out;
+  PostTokenizer<RecordingOutputStream> p(out);
+  p.put(PPTokenType::StringLiteral, "\"a\"");
+  p.put(PPTokenType::StringLiteral, "u\"b\"");
+  p.put(PPTokenType::PreprocessingOpOrPunc, ";");
+  p.put(PPTokenType::UserDefinedStringLiteral, "\"c\"_s");
+  p.put(PPTokenType::StringLiteral, "\"d\"");
+  p.put(PPTokenType::PreprocessingOpOrPunc, ";");
+  p.put(PPTokenType::StringLiteral, "u\"e\"");
+  p.put(PPTokenType::StringLiteral, "U\"f\"");
+  p.finish();
+
+  const std::vector<std::string> expected = {
+    "array \"a\" u\"b\" 3 " + std::to_string(FT_CHAR16_T),
+    "simple ; OP_SEMICOLON",
+    "uds \"c\"_s \"d\" _s",
+    "simple ; OP_SEMICOLON",
+    "invalid u\"e\" U\"f\"",
+    "eof",
+  };
+  EXPECT_EQ(expected, out.tokens);
+}
+
+TEST(PostTokenizer, Locations)
+{
+  LocatingOutputStream out;
+  PostTokenizer<LocatingOutputStream> p(out);
+  p.put(PPTokenType::Identifier, "x", 1, 1);
+  p.put(PPTokenType::StringLiteral, "\"a\"", 1, 2);
+  p.put(PPTokenType::StringLiteral, "\"b\"", 2, 7);
+  p.put(PPTokenType::PreprocessingOpOrPunc, ";", 2, 8);
+  p.finish();
+
+  const std::vector<std::string> expected = {
+    "at 1:1",
+    "identifier x",
+    "at 1:2",
+    "array \"a\" \"b\" 3 " + std::to_string(FT_CHAR),
+    "at 2:8",
+    "simple ; OP_SEMICOLON",
+    "eof",
+  };
+  EXPECT_EQ(expected, out.tokens);
+}
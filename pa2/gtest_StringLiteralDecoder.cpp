@@ -0,0 +1,120 @@
+#include "StringLiteralDecoder.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+  std::string hexDump(const std::string &data)
+  {
+    std::string s;
+    char buf[3];
+    for (unsigned char c: data) {
+      std::snprintf(buf, sizeof(buf), "%02X", c);
+      s += buf;
+    }
+    return s;
+  }
+
+  // Expected outputs are the ones given by posttoken-ref.
+  void expectArray(const std::vector<std::string> &tokens, EFundamentalType type, size_t numElements,
+                   const std::string &hex, const std::string &udSuffix = "")
+  {
+    StringLiteral out;
+    const char *error = StringLiteralDecoder::decode(tokens.data(), tokens.data() + tokens.size(), out);
+    ASSERT_EQ(nullptr, error) << tokens[0];
+    EXPECT_EQ(type, out.type) << tokens[0];
+    EXPECT_EQ(numElements, out.numElements) << tokens[0];
+    EXPECT_EQ(hex, hexDump(out.data)) << tokens[0];
+    EXPECT_EQ(udSuffix, out.udSuffix) << tokens[0];
+  }
+
+  void expectInvalid(const std::vector<std::string> &tokens)
+  {
+    StringLiteral out;
+    EXPECT_NE(nullptr, StringLiteralDecoder::decode(tokens.data(), tokens.data() + tokens.size(), out)) << tokens[0];
+  }
+
+} // namespace
+
+TEST(StringLiteralDecoder, Simple)
+{
+  expectArray({"\"\""}, FT_CHAR, 1, "00");
+  expectArray({"\"a\""}, FT_CHAR, 2, "6100");
+  expectArray({"\"\xc3\xa9\""}, FT_CHAR, 3, "C3A900");
+  expectArray({"L\"\xc3\xa9\""}, FT_WCHAR_T, 2, "E900000000000000");
+  expectArray({"u\"\xf0\x9f\x98\x80\""}, FT_CHAR16_T, 3, "3DD800DE0000");
+  expectArray({"U\"\xf0\x9f\x98\x80\""}, FT_CHAR32_T, 2, "00F6010000000000");
+}
+
+TEST(StringLiteralDecoder, Concatenation)
+{
+  expectArray({"\"a\"", "\"b\""}, FT_CHAR, 3, "616200");
+  expectArray({"u8\"x\"", "\"y\""}, FT_CHAR, 3, "787900");
+  expectArray({"\"a\"", "u8\"b\""}, FT_CHAR, 3, "616200");
+  expectArray({"\"a\"", "u\"\xc3\xa9\"", "\"b\""}, FT_CHAR16_T, 4, "6100E90062000000");
+  expectArray({"UR\"(b)\"_q", "\"c\""}, FT_CHAR32_T, 3, "620000006300000000000000", "_q");
+  expectArray({"\"a\"_x", "\"b\""}, FT_CHAR, 3, "616200", "_x");
+  expectArray({"\"a\"_x", "\"b\"_x"}, FT_CHAR, 3, "616200", "_x");
+
+  expectInvalid({"u\"a\"", "\"b\"", "U\"c\""});
+  expectInvalid({"U\"a\"", "L\"z\""});
+  expectInvalid({"\"a\"_x", "\"b\"_y"});
+  expectInvalid({"\"a\"x"});
+  expectInvalid({"\"a\"_x", "\"b\"y"});
+}
+
+TEST(StringLiteralDecoder, Escapes)
+{
+  expectArray({"\"\\a\\b\\f\\r\\t\\v\\?\\\\\\\"\\x27\""}, FT_CHAR, 11, "07080C0D090B3F5C222700");
+  expectArray({"\"\\'\""}, FT_CHAR, 2, "2700");
+  expectArray({"\"\\0\""}, FT_CHAR, 2, "0000");
+  expectArray({"\"\\x41\\101\\n\""}, FT_CHAR, 4, "41410A00");
+  expectArray({"\"\\400\""}, FT_CHAR, 3, "C48000");
+  expectArray({"\"\\777\""}, FT_CHAR, 3, "C7BF00");
+  expectArray({"\"\\1234\""}, FT_CHAR, 3, "533400");
+  expectArray({"\"\\xFF\""}, FT_CHAR, 3, "C3BF00");
+  expectArray({"\"\\x10FFFF\""}, FT_CHAR, 5, "F48FBFBF00");
+  expectArray({"\"\\xD800\""}, FT_CHAR, 4, "EDA08000");
+  expectArray({"u\"\\xFFFF\""}, FT_CHAR16_T, 2, "FFFF0000");
+  expectArray({"u\"\\x10000\""}, FT_CHAR16_T, 3, "00D800DC0000");
+  expectArray({"u\"\\U0010FFFF\""}, FT_CHAR16_T, 3, "FFDBFFDF0000");
+  expectArray({"U\"\\u00e9\""}, FT_CHAR32_T, 2, "E900000000000000");
+
+  expectInvalid({"\"\\x110000\""});
+  expectInvalid({"U\"\\xFFFFFFFFF\""});
+  expectInvalid({"u\"\\xD800\""});
+  expectInvalid({"U\"\\xD800\""});
+  expectInvalid({"L\"\\xDFFF\""});
+  expectInvalid({"\"\\x\""});
+  expectInvalid({"\"\\q\""});
+  expectInvalid({"\"\\u12\""});
+}
+
+TEST(StringLiteralDecoder, Raw)
+{
+  expectArray({"R\"(a\\nb)\""}, FT_CHAR, 5, "615C6E6200");
+  expectArray({"u8R\"x(y)x\"", "\"z\""}, FT_CHAR, 3, "797A00");
+  expectArray({"R\"a(x)a\"_s"}, FT_CHAR, 2, "7800", "_s");
+  expectArray({"R\"(\")\""}, FT_CHAR, 2, "2200");
+  expectArray({"R\"xyz()xyz\""}, FT_CHAR, 1, "00");
+  expectArray({"LR\"(a)\""}, FT_WCHAR_T, 2, "6100000000000000");
+
+  expectInvalid({"R\"x(y)z\""});
+  expectInvalid({"R\"xy)\""});
+}
+
+// Reusing one StringLiteral must not leak bytes of the previous result.
+TEST(StringLiteralDecoder, ReuseBuffer)
+{
+  StringLiteral out;
+  const std::vector<std::string> big = {"U\"0123456789\"", "\"abcdef\"_x"};
+  const std::vector<std::string> small = {"\"a\""};
+  ASSERT_EQ(nullptr, StringLiteralDecoder::decode(big.data(), big.data() + big.size(), out));
+  EXPECT_EQ(17u, out.numElements);
+  ASSERT_EQ(nullptr, StringLiteralDecoder::decode(small.data(), small.data() + small.size(), out));
+  EXPECT_EQ(FT_CHAR, out.type);
+  EXPECT_EQ("6100", hexDump(out.data));
+  EXPECT_EQ("", out.udSuffix);
+}
@@ -0,0 +1,221 @@
+#include "TokenStream.h"
+#include "HexDump.h"
+#include <gtest/gtest.h>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+namespace {
+
+  enum ETokenType { KW_AUTO = 3, OP_PLUS = 130 };
+
+  // Same output as DebugPostTokenOutputStream, with the enums as numbers.
+  struct TextOutputStream {
+    std::ostringstream os;
+
+    void emit_invalid(const std::string &source)
+    { os << "invalid " << source << "\n"; }
+    void emit_simple(const std::string &source, ETokenType token_type)
+    { os << "simple " << source << " " << token_type << "\n"; }
+    void emit_identifier(const std::string &source)
+    { os << "identifier " << source << "\n"; }
+    void emit_literal(const std::string &source, EFundamentalType type, const void *data, size_t nbytes)
+    { os << "literal " << source << " " << type << " " << HexDump(data, nbytes) << "\n"; }
+    void emit_literal_array(const std::string &source, size_t num_elements, EFundamentalType type, const void *data, size_t nbytes)
+    { os << "literal " << source << " array of " << num_elements << " " << type << " " << HexDump(data, nbytes) << "\n"; }
+    void emit_user_defined_literal_character(const std::string &source, const std::string &ud_suffix, EFundamentalType type, const void *data, size_t nbytes)
+    { os << "user-defined-literal " << source << " " << ud_suffix << " character " << type << " " << HexDump(data, nbytes) << "\n"; }
+    void emit_user_defined_literal_string_array(const std::string &source, const std::string &ud_suffix, size_t num_elements, EFundamentalType type, const void *data, size_t nbytes)
+    { os << "user-defined-literal " << source << " " << ud_suffix << " string array of " << num_elements << " " << type << " " << HexDump(data, nbytes) << "\n"; }
+    void emit_user_defined_literal_integer(const std::string &source, const std::string &ud_suffix, const std::string &prefix)
+    { os << "user-defined-literal " << source << " " << ud_suffix << " integer " << prefix << "\n"; }
+    void emit_user_defined_literal_floating(const std::string &source, const std::string &ud_suffix, const std::string &prefix)
+    { os << "user-defined-literal " << source << " " << ud_suffix << " floating " << prefix << "\n"; }
+    void emit_eof()
+    { os << "eof\n"; }
+  };
+
+  template <typename OutputStream>
+  void emitSample(OutputStream &out)
+  {
+    const int i = 42;
+    const double d = 1.5;
+    const char16_t s[] = u"bar";
+    const char32_t c = U'x';
+    out.emit_invalid("#");
+    out.emit_simple("auto", KW_AUTO);
+    out.emit_simple("+", OP_PLUS);
+    out.emit_identifier("foo");
+    out.emit_identifier("bar");
+    out.emit_identifier("foo");
+    out.emit_literal("42", FT_INT, &i, sizeof(i));
+    out.emit_literal("1.5", FT_DOUBLE, &d, sizeof(d));
+    out.emit_literal_array("u\"bar\"", 4, FT_CHAR16_T, s, sizeof(s));
+    out.emit_user_defined_literal_character("U'x'_c", "_c", FT_CHAR32_T, &c, sizeof(c));
+    out.emit_user_defined_literal_string_array("u\"bar\"_s", "_s", 4, FT_CHAR16_T, s, sizeof(s));
+    out.emit_user_defined_literal_integer("123_ud1", "_ud1", "123");
+    out.emit_user_defined_literal_floating("1.5e3_f", "_f", "1.5e3");
+    out.emit_eof();
+  }
+
+  std::string serialize(const TokenStreamWriter &w)
+  {
+    std::ostringstream os;
+    w.write(os);
+    return os.str();
+  }
+
+} // namespace
+
+TEST(TokenStream, RoundTripMatchesText)
+{
+  TextOutputStream direct;
+  emitSample(direct);
+
+  TokenStreamWriter w;
+  emitSample(w);
+  const std::string bytes = serialize(w);
+  TokenStreamReader in(bytes.data(), bytes.size());
+  EXPECT_EQ(14u, in.size());
+
+  TextOutputStream replayed;
+  replay<ETokenType>(in, replayed);
+  EXPECT_EQ(direct.os.str(), replayed.os.str());
+}
+
+TEST(TokenStream, InternedIdentifiers)
+{
+  TokenStreamWriter w;
+  emitSample(w);
+  const std::string bytes = serialize(w);
+  TokenStreamReader in(bytes.data(), bytes.size());
+
+  EXPECT_EQ(TokenKind::Identifier, in[3].kind);
+  EXPECT_EQ(in[3].source, in[5].source);
+  EXPECT_NE(in[3].source, in[4].source);
+  EXPECT_EQ("foo", in.string(in[3].source).str());
+  EXPECT_EQ(0u, in[13].source);
+  EXPECT_EQ("", in.string(0).str());
+}
+
+TEST(TokenStream, Literals)
+{
+  TokenStreamWriter w;
+  emitSample(w);
+  const std::string bytes = serialize(w);
+  TokenStreamReader in(bytes.data(), bytes.size());
+
+  EXPECT_EQ(FT_DOUBLE, in[7].type);
+  EXPECT_EQ(1.5, *static_cast<const double *>(in.data(in[7])));
+  EXPECT_EQ(4u, TokenStreamReader::numElements(in[8]));
+  EXPECT_EQ(0, reinterpret_cast<uintptr_t>(in.data(in[8])) % 8);
+}
+
+TEST(TokenStream, Locations)
+{
+  TokenStreamWriter w;
+  const uint32_t a = w.intern("a.cpp");
+  w.set_location(a, 10);
+  w.emit_identifier("x");
+  w.set_location(w.intern("b.h"), 1);
+  w.emit_identifier("y");
+  w.emit_eof();
+  const std::string bytes = serialize(w);
+  TokenStreamReader in(bytes.data(), bytes.size());
+  EXPECT_EQ("a.cpp", in.string(in[0].file).str());
+  EXPECT_EQ(10u, in[0].line);
+  EXPECT_EQ("b.h", in.string(in[1].file).str());
+  EXPECT_EQ(1u, in[2].line);
+  EXPECT_EQ(a, w.intern("a.cpp"));
+}
+
+TEST(TokenStream, MapFile)
+{
+  TokenStreamWriter w;
+  emitSample(w);
+  char path[] = "/tmp/gtest_TokenStreamXXXXXX";
+  const int fd = mkstemp(path);
+  ASSERT_GE(fd, 0);
+  close(fd);
+  {
+    std::ofstream f(path, std::ios::binary);
+    w.write(f);
+  }
+
+  {
+    TokenStreamReader in(path);
+    TextOutputStream direct, replayed;
+    emitSample(direct);
+    replay<ETokenType>(in, replayed);
+    EXPECT_EQ(direct.os.str(), replayed.os.str());
+  }
+  std::remove(path);
+}
+
+TEST(TokenStream, ReadWriterInPlace)
+{
+  TokenStreamWriter w;
+  emitSample(w);
+  const std::string bytes = serialize(w);
+  TokenStreamReader written(bytes.data(), bytes.size());
+  TokenStreamReader inPlace(w);
+  ASSERT_EQ(written.size(), inPlace.size());
+  ASSERT_EQ(written.numStrings(), inPlace.numStrings());
+  for (size_t i = 0; i < written.size(); i++)
+    EXPECT_EQ(0, std::memcmp(&written[i], &inPlace[i], sizeof(TokenRecord)));
+
+  TextOutputStream a, b;
+  replay<ETokenType>(written, a);
+  replay<ETokenType>(inPlace, b);
+  EXPECT_EQ(a.os.str(), b.os.str());
+}
+
+TEST(TokenStream, Errors)
+{
+  EXPECT_THROW(TokenStreamReader("/nonexistent/tokens"), std::runtime_error);
+
+  const std::string garbage(64, 'x');
+  EXPECT_THROW(TokenStreamReader(garbage.data(), garbage.size()), std::runtime_error);
+
+  TokenStreamWriter w;
+  emitSample(w);
+  const std::string bytes = serialize(w);
+  EXPECT_THROW(TokenStreamReader(bytes.data(), bytes.size() - 1), std::runtime_error);
+}
+
+TEST(TokenStream, OutOfRange)
+{
+  TokenStreamWriter w;
+  emitSample(w);
+  const std::string bytes = serialize(w);
+  const TokenStreamHeader &header = *reinterpret_cast<const TokenStreamHeader *>(bytes.data());
+  const size_t tokens = sizeof(TokenStreamHeader);
+  const size_t entries = tokens + ((header.numTokens * sizeof(TokenRecord) + 7) & ~size_t(7));
+
+  // Overwrites the 32-bit field at `offset` of a copy and reads it.
+  auto corrupt = [&](size_t offset, uint32_t value) {
+    std::string copy = bytes;
+    std::memcpy(&copy[offset], &value, sizeof(value));
+    TokenStreamReader in(copy.data(), copy.size());
+  };
+  EXPECT_NO_THROW(corrupt(entries, 0));
+
+  // The string id of the source of the first token.
+  EXPECT_THROW(corrupt(tokens + offsetof(TokenRecord, source), header.numStrings), std::runtime_error);
+  EXPECT_THROW(corrupt(tokens + offsetof(TokenRecord, udSuffix), 0xffffffff), std::runtime_error);
+  EXPECT_THROW(corrupt(tokens + offsetof(TokenRecord, file), header.numStrings), std::runtime_error);
+  // The offset and length of the last string.
+  const size_t last = entries + (header.numStrings - 1) * 2 * sizeof(uint32_t);
+  EXPECT_THROW(corrupt(last, header.stringBytesSize), std::runtime_error);
+  EXPECT_THROW(corrupt(last + sizeof(uint32_t), 0xffffffff), std::runtime_error);
+  // The literal of the `42` token.
+  const size_t literal = tokens + 6 * sizeof(TokenRecord);
+  EXPECT_THROW(corrupt(literal + offsetof(TokenRecord, dataOffset), header.literalPoolSize), std::runtime_error);
+  EXPECT_THROW(corrupt(literal + offsetof(TokenRecord, dataSize), 0xffffffff), std::runtime_error);
+}
@@ -0,0 +1,8 @@
+??=define ??( ??) ??< ??> ??- ??! ??' ???= ??? ?? ?
+"a??/"b" '??/'' "??=??(??)" u8"??<??>"
+x ??/
+y ab??/
+cd
+??/u00E9 ??/U000000E9
+R"(??= ??/
+)" R"a(x??)a" R"??=(y)??=" R"#(z)??=)#"
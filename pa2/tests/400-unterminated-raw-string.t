@@ -0,0 +1,4 @@
+int a;
+R"x( not
+ended )"
+int b;
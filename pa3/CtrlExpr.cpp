@@ -0,0 +1,497 @@
+#include "CtrlExpr.h"
+
+#include <cstring>
+
+namespace {
+
+  typedef CtrlExprOpcode Op;
+
+  const char *const DivisionByZero = "division by zero in controlling expression";
+  const char *const ShiftOutOfRange = "shift out of range in controlling expression";
+
+  // The semantics of the operators, shared by constant folding and
+  // evaluation. Values are the bits of intmax_t or uintmax_t; arithmetic
+  // wraps, as in the reference implementation.
+
+  void applyUnary(Op op, uint64_t &a)
+  {
+    switch (op) {
+      case Op::Neg: a = 0 - a; break;
+      case Op::Compl: a = ~a; break;
+      case Op::LNot: a = a == 0; break;
+      case Op::ToBool: a = a != 0; break;
+      default: break;
+    }
+  }
+
+  const char *applyBinary(Op op, uint64_t &a, uint64_t b)
+  {
+    const int64_t sa = a;
+    const int64_t sb = b;
+    switch (op) {
+      case Op::Mul: a *= b; break;
+      case Op::DivS:
+      case Op::ModS:
+        if (b == 0)
+          return DivisionByZero;
+        // INTMAX_MIN / -1 overflows the division instruction.
+        if (sb == -1)
+          a = op == Op::DivS ? 0 - a : 0;
+        else
+          a = op == Op::DivS ? sa / sb : sa % sb;
+        break;
+      case Op::DivU:
+        if (b == 0)
+          return DivisionByZero;
+        a /= b;
+        break;
+      case Op::ModU:
+        if (b == 0)
+          return DivisionByZero;
+        a %= b;
+        break;
+      case Op::Add: a += b; break;
+      case Op::Sub: a -= b; break;
+      case Op::Shl:
+      case Op::ShrS:
+      case Op::ShrU:
+        // Negative shift counts are huge as unsigned.
+        if (b >= 64)
+          return ShiftOutOfRange;
+        if (op == Op::Shl)
+          a <<= b;
+        else if (op == Op::ShrS)
+          a = sa >> b;
+        else
+          a >>= b;
+        break;
+      case Op::LtS: a = sa < sb; break;
+      case Op::LtU: a = a < b; break;
+      case Op::GtS: a = sa > sb; break;
+      case Op::GtU: a = a > b; break;
+      case Op::LeS: a = sa <= sb; break;
+      case Op::LeU: a = a <= b; break;
+      case Op::GeS: a = sa >= sb; break;
+      case Op::GeU: a = a >= b; break;
+      case Op::Eq: a = a == b; break;
+      case Op::Ne: a = a != b; break;
+      case Op::BAnd: a &= b; break;
+      case Op::BXor: a ^= b; break;
+      case Op::BOr: a |= b; break;
+      default: break;
+    }
+    return nullptr;
+  }
+
+  // Binding power of the binary operators, 0 if `op` is not one.
+  int precedence(uint16_t op)
+  {
+    switch (op) {
+      case OP_LOR: return 1;
+      case OP_LAND: return 2;
+      case OP_BOR: return 3;
+      case OP_XOR: return 4;
+      case OP_AMP: return 5;
+      case OP_EQ: case OP_NE: return 6;
+      case OP_LT: case OP_GT: case OP_LE: case OP_GE: return 7;
+      case OP_LSHIFT: case OP_RSHIFT: return 8;
+      case OP_PLUS: case OP_MINUS: return 9;
+      case OP_STAR: case OP_DIV: case OP_MOD: return 10;
+      default: return 0;
+    }
+  }
+
+  // Pratt parser emitting into a program. Every parse function leaves the
+  // value of its subexpression on the stack, returns false on error, and sets
+  // `isUnsigned` to the type of the subexpression.
+  class Compiler {
+  public:
+    Compiler(const CtrlExprToken *first, const CtrlExprToken *last, CtrlExprProgram &program):
+      _p(first), _last(last), _program(program), _label(0), _depth(0) {}
+
+    void compile()
+    {
+      _program.error = nullptr;
+      _program.isUnsigned = false;
+      _program.maxStack = 0;
+      _program.code.clear();
+      _program.constants.clear();
+
+      bool isUnsigned;
+      if (_conditional(isUnsigned)  &&  _p != _last)
+        _fail("unexpected token in controlling expression");
+      if (_program.error) {
+        _program.code.clear();
+        _program.constants.clear();
+        return;
+      }
+      _program.isUnsigned = isUnsigned;
+    }
+
+  private:
+    bool _isOp(ETokenType op) const
+    { return _p != _last  &&  _p->kind == CtrlExprToken::Operator  &&  _p->op == op; }
+
+    bool _fail(const char *error)
+    {
+      if (!_program.error)
+        _program.error = error;
+      return false;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Emission
+    ////////////////////////////////////////////////////////////////////////////
+
+    void _push(int n)
+    {
+      _depth += n;
+      if (_depth > _program.maxStack)
+        _program.maxStack = _depth;
+    }
+
+    void _emit(Op op, uint32_t operand = 0)
+    { _program.code.push_back(CtrlExprInstruction{op, operand}); }
+
+    void _emitConst(uint64_t value)
+    {
+      _emit(Op::PushConst, _program.constants.size());
+      _program.constants.push_back(value);
+      _push(1);
+    }
+
+    // Whether the last n instructions are constants that no jump lands
+    // between, so that they can be folded.
+    bool _lastAreConstants(size_t n) const
+    {
+      const std::vector<CtrlExprInstruction> &code = _program.code;
+      if (code.size() < _label + n)
+        return false;
+      for (size_t i = code.size() - n; i < code.size(); i++) {
+        if (code[i].op != Op::PushConst)
+          return false;
+      }
+      return true;
+    }
+
+    void _emitUnary(Op op)
+    {
+      if (_lastAreConstants(1)) {
+        applyUnary(op, _program.constants.back());
+        return;
+      }
+      _emit(op);
+    }
+
+    void _emitBinary(Op op)
+    {
+      _push(-1);
+      if (_lastAreConstants(2)) {
+        std::vector<uint64_t> &constants = _program.constants;
+        uint64_t a = constants[constants.size() - 2];
+        // Errors are left to the evaluation, the operation may be skipped.
+        if (!applyBinary(op, a, constants.back())) {
+          constants.pop_back();
+          constants.back() = a;
+          _program.code.pop_back();
+          return;
+        }
+      }
+      _emit(op);
+    }
+
+    size_t _emitJump(Op op)
+    {
+      _emit(op);
+      return _program.code.size() - 1;
+    }
+
+    // Points the jump at the next instruction.
+    void _placeLabel(size_t jump)
+    {
+      _label = _program.code.size();
+      _program.code[jump].operand = _label;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // Parsing
+    ////////////////////////////////////////////////////////////////////////////
+
+    // conditional-expression:
+    //   logical-or-expression
+    //   logical-or-expression ? conditional-expression : conditional-expression
+    //
+    // The comma operator is not supported, as in the reference implementation.
+    bool _conditional(bool &isUnsigned)
+    {
+      if (!_binary(1, isUnsigned))
+        return false;
+      if (!_isOp(OP_QMARK))
+        return true;
+      ++_p;
+
+      const size_t toElse = _emitJump(Op::JumpIfFalse);
+      _push(-1);
+      bool thenUnsigned;
+      if (!_conditional(thenUnsigned))
+        return false;
+      if (!_isOp(OP_COLON))
+        return _fail("expected colon in controlling expression");
+      ++_p;
+
+      const size_t toEnd = _emitJump(Op::Jump);
+      _placeLabel(toElse);
+      // The value of the then branch is not on the stack on this path.
+      _push(-1);
+      bool elseUnsigned;
+      if (!_conditional(elseUnsigned))
+        return false;
+      _placeLabel(toEnd);
+
+      // The usual arithmetic conversions only change the type, not the bits.
+      isUnsigned = thenUnsigned || elseUnsigned;
+      return true;
+    }
+
+    bool _binary(int minPrecedence, bool &isUnsigned)
+    {
+      if (!_unary(isUnsigned))
+        return false;
+      for (;;) {
+        const int prec = _p != _last  &&  _p->kind == CtrlExprToken::Operator ? precedence(_p->op) : 0;
+        if (prec == 0  ||  prec < minPrecedence)
+          return true;
+        const uint16_t op = _p->op;
+        ++_p;
+
+        if (op == OP_LAND  ||  op == OP_LOR) {
+          const size_t toEnd = _emitJump(op == OP_LAND ? Op::AndJump : Op::OrJump);
+          _push(-1);
+          bool rightUnsigned;
+          if (!_binary(prec + 1, rightUnsigned))
+            return false;
+          _emitUnary(Op::ToBool);
+          _placeLabel(toEnd);
+          isUnsigned = false;
+          continue;
+        }
+
+        bool rightUnsigned;
+        if (!_binary(prec + 1, rightUnsigned))
+          return false;
+        const bool u = isUnsigned || rightUnsigned;
+        switch (op) {
+          case OP_STAR: _emitBinary(Op::Mul); isUnsigned = u; break;
+          case OP_DIV: _emitBinary(u ? Op::DivU : Op::DivS); isUnsigned = u; break;
+          case OP_MOD: _emitBinary(u ? Op::ModU : Op::ModS); isUnsigned = u; break;
+          case OP_PLUS: _emitBinary(Op::Add); isUnsigned = u; break;
+          case OP_MINUS: _emitBinary(Op::Sub); isUnsigned = u; break;
+          // The type of a shift is the type of its left operand.
+          case OP_LSHIFT: _emitBinary(Op::Shl); break;
+          case OP_RSHIFT: _emitBinary(isUnsigned ? Op::ShrU : Op::ShrS); break;
+          case OP_LT: _emitBinary(u ? Op::LtU : Op::LtS); isUnsigned = false; break;
+          case OP_GT: _emitBinary(u ? Op::GtU : Op::GtS); isUnsigned = false; break;
+          case OP_LE: _emitBinary(u ? Op::LeU : Op::LeS); isUnsigned = false; break;
+          case OP_GE: _emitBinary(u ? Op::GeU : Op::GeS); isUnsigned = false; break;
+          case OP_EQ: _emitBinary(Op::Eq); isUnsigned = false; break;
+          case OP_NE: _emitBinary(Op::Ne); isUnsigned = false; break;
+          case OP_AMP: _emitBinary(Op::BAnd); isUnsigned = u; break;
+          case OP_XOR: _emitBinary(Op::BXor); isUnsigned = u; break;
+          case OP_BOR: _emitBinary(Op::BOr); isUnsigned = u; break;
+        }
+      }
+    }
+
+    bool _unary(bool &isUnsigned)
+    {
+      if (_isOp(OP_PLUS)) {
+        ++_p;
+        return _unary(isUnsigned);
+      }
+      if (_isOp(OP_MINUS)  ||  _isOp(OP_COMPL)) {
+        const Op op = _p->op == OP_MINUS ? Op::Neg : Op::Compl;
+        ++_p;
+        if (!_unary(isUnsigned))
+          return false;
+        _emitUnary(op);
+        return true;
+      }
+      if (_isOp(OP_LNOT)) {
+        ++_p;
+        if (!_unary(isUnsigned))
+          return false;
+        _emitUnary(Op::LNot);
+        isUnsigned = false;
+        return true;
+      }
+      return _primary(isUnsigned);
+    }
+
+    bool _primary(bool &isUnsigned)
+    {
+      if (_p == _last)
+        return _fail("unexpected end of controlling expression");
+
+      isUnsigned = false;
+      switch (_p->kind) {
+        case CtrlExprToken::Literal:
+          isUnsigned = _p->isUnsigned;
+          // fall through
+        case CtrlExprToken::Identifier:
+          // Identifiers left after macro replacement are 0, except `true`.
+          _emitConst(_p->value);
+          ++_p;
+          return true;
+
+        case CtrlExprToken::Defined: {
+          ++_p;
+          const bool parenthesized = _isOp(OP_LPAREN);
+          if (parenthesized)
+            ++_p;
+          if (_p == _last  ||  (_p->kind != CtrlExprToken::Identifier  &&  _p->kind != CtrlExprToken::Defined))
+            return _fail("expected identifier after defined");
+          _emit(Op::PushDefined, _p->id);
+          _push(1);
+          ++_p;
+          if (parenthesized) {
+            if (!_isOp(OP_RPAREN))
+              return _fail("expected closing bracket after defined");
+            ++_p;
+          }
+          return true;
+        }
+
+        case CtrlExprToken::Operator:
+          if (_isOp(OP_LPAREN)) {
+            ++_p;
+            if (!_conditional(isUnsigned))
+              return false;
+            if (!_isOp(OP_RPAREN))
+              return _fail("closing bracket expected in controlling expression");
+            ++_p;
+            return true;
+          }
+          return _fail("unexpected operator in controlling expression");
+
+        case CtrlExprToken::Invalid:
+          break;
+      }
+      return _fail("invalid token in controlling expression");
+    }
+
+    const CtrlExprToken *_p;
+    const CtrlExprToken *const _last;
+    CtrlExprProgram &_program;
+    size_t _label;        // no folding across this instruction, a jump lands here
+    uint32_t _depth;
+  };
+
+  inline void appendBytes(std::string &s, const void *data, size_t n)
+  { s.append(static_cast<const char *>(data), n); }
+
+} // namespace
+
+CtrlExprEvaluator::CtrlExprEvaluator(size_t maxCacheSize):
+  _maxCacheSize(maxCacheSize == 0 ? 1 : maxCacheSize), _hits(0), _misses(0)
+{
+}
+
+void CtrlExprEvaluator::compile(const CtrlExprToken *first, const CtrlExprToken *last, CtrlExprProgram &program)
+{
+  Compiler(first, last, program).compile();
+}
+
+CtrlExprResult CtrlExprEvaluator::evaluate(const CtrlExprToken *first, const CtrlExprToken *last, const CtrlExprDefinedIfc &defined)
+{
+  // The key holds exactly the fields the compiler looks at.
+  _key.clear();
+  for (const CtrlExprToken *p = first; p != last; ++p) {
+    _key.push_back(p->kind);
+    switch (p->kind) {
+      case CtrlExprToken::Literal:
+        _key.push_back(p->isUnsigned);
+        appendBytes(_key, &p->value, sizeof(p->value));
+        break;
+      case CtrlExprToken::Identifier:
+        _key.push_back(p->value != 0);
+        appendBytes(_key, &p->id, sizeof(p->id));
+        break;
+      case CtrlExprToken::Defined:
+        appendBytes(_key, &p->id, sizeof(p->id));
+        break;
+      case CtrlExprToken::Operator:
+        appendBytes(_key, &p->op, sizeof(p->op));
+        break;
+      case CtrlExprToken::Invalid:
+        break;
+    }
+  }
+
+  auto it = _cache.find(_key);
+  if (it != _cache.end()) {
+    _hits++;
+  } else {
+    _misses++;
+    if (_cache.size() == _maxCacheSize)
+      _cache.clear();
+    it = _cache.emplace(_key, CtrlExprProgram()).first;
+    compile(first, last, it->second);
+  }
+  return _run(it->second, defined);
+}
+
+CtrlExprResult CtrlExprEvaluator::_run(const CtrlExprProgram &program, const CtrlExprDefinedIfc &defined)
+{
+  if (program.error)
+    return CtrlExprResult{program.error, 0, false};
+  if (_stack.size() < program.maxStack)
+    _stack.resize(program.maxStack);
+
+  const CtrlExprInstruction *const code = program.code.data();
+  const size_t size = program.code.size();
+  uint64_t *sp = _stack.data();   // the next free slot
+  for (size_t pc = 0; pc < size; ) {
+    const CtrlExprInstruction &i = code[pc++];
+    switch (i.op) {
+      case Op::PushConst:
+        *sp++ = program.constants[i.operand];
+        break;
+      case Op::PushDefined:
+        *sp++ = defined.isDefined(i.operand);
+        break;
+      case Op::Neg:
+      case Op::Compl:
+      case Op::LNot:
+      case Op::ToBool:
+        applyUnary(i.op, sp[-1]);
+        break;
+      case Op::AndJump:
+        if (sp[-1] == 0)
+          pc = i.operand;
+        else
+          --sp;
+        break;
+      case Op::OrJump:
+        if (sp[-1] != 0) {
+          sp[-1] = 1;
+          pc = i.operand;
+        } else {
+          --sp;
+        }
+        break;
+      case Op::JumpIfFalse:
+        if (*--sp == 0)
+          pc = i.operand;
+        break;
+      case Op::Jump:
+        pc = i.operand;
+        break;
+      default:
+        --sp;
+        if (const char *error = applyBinary(i.op, sp[-1], *sp))
+          return CtrlExprResult{error, 0, false};
+        break;
+    }
+  }
+  return CtrlExprResult{nullptr, sp[-1], program.isUnsigned};
+}
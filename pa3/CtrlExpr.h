@@ -0,0 +1,146 @@
+#ifndef CtrlExpr_h
+#define CtrlExpr_h
+
+#include "pa2/TokenType.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Controlling expressions of #if and #elif (16.1), compiled to a small stack
+// bytecode over intmax_t/uintmax_t and cached.
+//
+// The expression is seen after macro replacement, as a sequence of
+// CtrlExprTokens. Parsing is a Pratt parser that tracks the type of every
+// subexpression, so the usual arithmetic conversions are settled at compile
+// time and each opcode is already signed or unsigned. Compiled programs are
+// cached keyed by the token sequence; the result of `defined` is looked up at
+// evaluation time, so a cached program stays valid when macros change. The
+// cache holds at most maxCacheSize programs and is emptied when it is full.
+
+// One token of a controlling expression.
+struct CtrlExprToken {
+  enum Kind: uint8_t {
+    Invalid,      // anything that cannot appear in a controlling expression
+    Literal,      // integer or character literal
+    Identifier,   // any identifier left after macro replacement
+    Defined,      // the `defined` operator
+    Operator,     // a preprocessing-op-or-punc, `op` says which
+  };
+
+  Kind kind;
+  bool isUnsigned;        // Literal
+  uint16_t op;            // Operator: an ETokenType
+  uint32_t id;            // Identifier, Defined: the caller's id of the name
+  uint64_t value;         // Literal; Identifier: 1 for `true`, else 0
+
+  static CtrlExprToken invalid()
+  { return CtrlExprToken{Invalid, false, 0, 0, 0}; }
+  static CtrlExprToken literal(uint64_t value, bool isUnsigned)
+  { return CtrlExprToken{Literal, isUnsigned, 0, 0, value}; }
+  static CtrlExprToken identifier(uint32_t id, bool isTrue)
+  { return CtrlExprToken{Identifier, false, 0, id, isTrue}; }
+  static CtrlExprToken defined(uint32_t id)
+  { return CtrlExprToken{Defined, false, 0, id, 0}; }
+  static CtrlExprToken punctuator(ETokenType op)
+  { return CtrlExprToken{Operator, false, static_cast<uint16_t>(op), 0, 0}; }
+};
+
+// Answers `defined` for the ids of the tokens.
+class CtrlExprDefinedIfc {
+public:
+  virtual ~CtrlExprDefinedIfc() {}
+  virtual bool isDefined(uint32_t id) const = 0;
+};
+
+struct CtrlExprResult {
+  const char *error;      // nullptr on success
+  uint64_t value;         // the bits of the intmax_t or uintmax_t
+  bool isUnsigned;
+};
+
+enum class CtrlExprOpcode: uint8_t {
+  PushConst,      // operand: index into the constants
+  PushDefined,    // operand: id
+  Neg,
+  Compl,
+  LNot,
+  Mul,
+  DivS,
+  DivU,
+  ModS,
+  ModU,
+  Add,
+  Sub,
+  Shl,
+  ShrS,
+  ShrU,
+  LtS,
+  LtU,
+  GtS,
+  GtU,
+  LeS,
+  LeU,
+  GeS,
+  GeU,
+  Eq,
+  Ne,
+  BAnd,
+  BXor,
+  BOr,
+  ToBool,
+  AndJump,        // if the top is 0 jump to operand, else pop
+  OrJump,         // if the top is not 0 make it 1 and jump to operand, else pop
+  JumpIfFalse,    // pop, jump to operand if 0
+  Jump,
+};
+
+struct CtrlExprInstruction {
+  CtrlExprOpcode op;
+  uint32_t operand;
+};
+
+struct CtrlExprProgram {
+  const char *error;      // a parse error, the program is then empty
+  bool isUnsigned;
+  uint32_t maxStack;
+  std::vector<CtrlExprInstruction> code;
+  std::vector<uint64_t> constants;
+};
+
+// Compiles and evaluates controlling expressions.
+//
+// In steady state, i.e. once every distinct expression has been seen and the
+// stack has grown to the deepest program, evaluate() does not allocate: the
+// cache key and the stack are buffers owned by the evaluator. An input with
+// more distinct expressions than the cache holds recompiles them instead of
+// growing the cache without bound.
+class CtrlExprEvaluator {
+public:
+  static const size_t DefaultMaxCacheSize = 4096;
+
+  explicit CtrlExprEvaluator(size_t maxCacheSize = DefaultMaxCacheSize);
+
+  // Evaluates the tokens [first, last) of one controlling expression.
+  CtrlExprResult evaluate(const CtrlExprToken *first, const CtrlExprToken *last, const CtrlExprDefinedIfc &defined);
+
+  static void compile(const CtrlExprToken *first, const CtrlExprToken *last, CtrlExprProgram &program);
+
+  size_t cacheHits() const { return _hits; }
+  size_t cacheMisses() const { return _misses; }
+  size_t cacheSize() const { return _cache.size(); }
+
+private:
+  CtrlExprResult _run(const CtrlExprProgram &program, const CtrlExprDefinedIfc &defined);
+
+  std::unordered_map<std::string, CtrlExprProgram> _cache;
+  size_t _maxCacheSize;
+  std::string _key;
+  std::vector<uint64_t> _stack;
+  size_t _hits;
+  size_t _misses;
+};
+
+#endif /* end of include guard */
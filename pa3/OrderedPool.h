@@ -0,0 +1,168 @@
+#ifndef OrderedPool_h
+#define OrderedPool_h
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs jobs on a pool of threads and hands them over, done, to a sink in the
+// order they were submitted, so the output of a run is the same on any
+// number of threads.
+//
+// Each thread runs its jobs with a Worker of its own, by worker.run(job), so
+// a worker keeps its state from job to job, an evaluator or a recognizer,
+// without locking. run() must not throw: a job keeps its error for the sink.
+// The workers are made on the calling thread and outlive the threads, for
+// what they gathered to be read at the end.
+//
+// The sink is called on the calling thread, by submit() and finish(). At
+// most `window` jobs are submitted and not handed over: submit() waits for
+// the first of them to be done, which bounds the jobs waiting with their
+// output. Without threads, submit() runs the job and hands it over at once.
+template <typename Job, typename Worker>
+class OrderedPool {
+public:
+  typedef std::function<std::unique_ptr<Worker>()> MakeWorker;
+  typedef std::function<void(Job &)> Sink;
+
+  // Starts `nthreads` threads, each with a worker of `makeWorker`; with none,
+  // makes one worker for the calling thread. `window` is at least 1.
+  OrderedPool(size_t nthreads, size_t window, const MakeWorker &makeWorker, Sink sink):
+    _window(window), _sink(std::move(sink)), _failed(false), _stopping(false)
+  {
+    for (size_t i = 0; i < std::max<size_t>(nthreads, 1); i++)
+      _workers.push_back(makeWorker());
+    for (size_t i = 0; i < nthreads; i++)
+      _threads.emplace_back(&OrderedPool::_run, this, std::ref(*_workers[i]));
+  }
+
+  // Hands the jobs submitted over, unless the sink threw, and stops the
+  // threads. Jobs not handed over are dropped.
+  ~OrderedPool()
+  {
+    try {
+      if (!_failed)
+        finish();
+    } catch (...) {
+    }
+    _stop();
+  }
+
+  OrderedPool(const OrderedPool &) = delete;
+  OrderedPool &operator=(const OrderedPool &) = delete;
+
+  // Throws what the sink throws; the pool is then to be destroyed.
+  void submit(std::unique_ptr<Job> job)
+  {
+    if (_threads.empty()) {
+      _workers[0]->run(*job);
+      _handOver(*job);
+      return;
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _drain(lock, _window - 1);
+    _jobs.push_back(Entry{std::move(job), false});
+    _pending.push_back(&_jobs.back());
+    _queued.notify_one();
+  }
+
+  // Hands every job over and stops the threads. Not to submit after.
+  void finish()
+  {
+    if (!_threads.empty()) {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _drain(lock, 0);
+    }
+    _stop();
+  }
+
+  const std::vector<std::unique_ptr<Worker>> &workers() const { return _workers; }
+
+private:
+  struct Entry {
+    std::unique_ptr<Job> job;
+    bool done;
+  };
+
+  void _handOver(Job &job)
+  {
+    try {
+      _sink(job);
+    } catch (...) {
+      _failed = true;
+      throw;
+    }
+  }
+
+  // Hands the done jobs at the head of `_jobs` over until at most `limit`
+  // remain.
+  void _drain(std::unique_lock<std::mutex> &lock, size_t limit)
+  {
+    for (;;) {
+      while (!_jobs.empty()  &&  _jobs.front().done) {
+        std::unique_ptr<Job> job = std::move(_jobs.front().job);
+        _jobs.pop_front();
+        lock.unlock();
+        _handOver(*job);
+        lock.lock();
+      }
+      if (_jobs.size() <= limit)
+        return;
+      _finished.wait(lock);
+    }
+  }
+
+  void _stop()
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _stopping = true;
+      _pending.clear();
+    }
+    _queued.notify_all();
+    for (std::thread &t: _threads)
+      t.join();
+    _threads.clear();
+  }
+
+  void _run(Worker &worker)
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    for (;;) {
+      _queued.wait(lock, [this] { return _stopping  ||  !_pending.empty(); });
+      if (_pending.empty())
+        return;
+      Entry *entry = _pending.front();
+      _pending.pop_front();
+
+      lock.unlock();
+      worker.run(*entry->job);
+      lock.lock();
+
+      entry->done = true;
+      _finished.notify_one();
+    }
+  }
+
+  size_t _window;
+  Sink _sink;
+  bool _failed;                         // the sink threw
+  std::vector<std::unique_ptr<Worker>> _workers;
+  std::vector<std::thread> _threads;
+
+  std::mutex _mutex;
+  std::condition_variable _queued;      // signalled when a job is submitted
+  std::condition_variable _finished;    // signalled when a job is done
+  std::deque<Entry> _jobs;              // not handed over, in submission order
+  std::deque<Entry *> _pending;         // not taken by a thread
+  bool _stopping;
+};
+
+#endif /* end of include guard */
@@ -1,6 +1,24 @@
 // (C) 2013 CPPGM Foundation www.cppgm.org.  All rights reserved.
 
+#include "pa1/PPCodeUnitStream.h"
+#include "pa1/PPTokenizerDFA.h"
+#include "pa1/PPUTF32Stream.h"
+#include "pa2/CharacterLiteralDecoder.h"
+#include "pa2/IntegerLiteralDecoder.h"
+#include "pa2/TokenType.h"
+#include "CtrlExpr.h"
+#include "OrderedPool.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 using namespace std;
 
@@ -14,8 +32,246 @@ bool PA3Mock_IsDefinedIdentifier(const string& identifier)
 		return identifier[0] % 2;
 }
 
-int main()
+// interns identifiers, so that controlling expressions are cached by identifier ids
+//
+// the low bit of an id is the answer of PA3Mock_IsDefinedIdentifier, so the
+// evaluation threads answer `defined` without looking at this table
+class PA3IdentifierTable
+{
+public:
+	uint32_t id(const string& identifier)
+	{
+		auto inserted = ids.emplace(identifier, 2 * ids.size() + PA3Mock_IsDefinedIdentifier(identifier));
+		return inserted.first->second;
+	}
+
+private:
+	unordered_map<string, uint32_t> ids;
+};
+
+class PA3MockDefined : public CtrlExprDefinedIfc
+{
+public:
+	bool isDefined(uint32_t id) const override
+	{
+		return id & 1;
+	}
+};
+
+// post-tokenizes one preprocessing-token of a controlling expression (see PA2)
+CtrlExprToken PA3PostTokenize(const PPToken& token, PA3IdentifierTable& identifiers)
+{
+	const string& source = token.getRawText();
+	switch (token.getType())
+	{
+	case PPTokenType::Identifier:
+		if (source == "defined")
+			return CtrlExprToken::defined(identifiers.id(source));
+		return CtrlExprToken::identifier(identifiers.id(source), source == "true");
+
+	case PPTokenType::PPNumber:
+	{
+		// floating literals and user-defined literals are not allowed
+		const IntegerLiteral r = IntegerLiteralDecoder::decode(source);
+		if (r.kind != IntegerLiteral::Integer)
+			return CtrlExprToken::invalid();
+		// all integral types act as intmax_t or uintmax_t (16.1/4)
+		return CtrlExprToken::literal(r.value, !r.isSigned());
+	}
+
+	case PPTokenType::CharacterLiteral:
+	{
+		const CharacterLiteral r = CharacterLiteralDecoder::decode(source);
+		if (r.kind != CharacterLiteral::Character)
+			return CtrlExprToken::invalid();
+		return CtrlExprToken::literal(r.value, !r.isSigned());
+	}
+
+	case PPTokenType::PreprocessingOpOrPunc:
+	{
+		auto it = StringToTokenTypeMap.find(source);
+		if (it == StringToTokenTypeMap.end())
+			return CtrlExprToken::invalid();
+		return CtrlExprToken::punctuator(it->second);
+	}
+
+	default:
+		return CtrlExprToken::invalid();
+	}
+}
+
+// a batch of consecutive logical lines
+struct PA3Batch
+{
+	vector<CtrlExprToken> tokens; // the tokens of all lines, back to back
+	vector<size_t> lineEnds; // the end of each line in `tokens`
+	string output;
+};
+
+// evaluates the controlling expressions of a batch into its output
+void PA3EvaluateBatch(CtrlExprEvaluator& evaluator, PA3Batch& batch)
+{
+	static const PA3MockDefined defined;
+
+	size_t begin = 0;
+	for (size_t end : batch.lineEnds)
+	{
+		if (begin != end)
+		{
+			const CtrlExprResult result = evaluator.evaluate(batch.tokens.data() + begin, batch.tokens.data() + end, defined);
+			char buf[32];
+			if (result.error)
+				batch.output += "error\n";
+			else if (result.isUnsigned)
+				batch.output.append(buf, snprintf(buf, sizeof(buf), "%" PRIu64 "u\n", result.value));
+			else
+				batch.output.append(buf, snprintf(buf, sizeof(buf), "%" PRId64 "\n", static_cast<int64_t>(result.value)));
+		}
+		begin = end;
+	}
+}
+
+// evaluates the batches of a thread, with an evaluator and cache of its own
+struct PA3Worker
 {
-	// TODO: Implement ctrlexpr as per PA3 assignment description
+	void run(PA3Batch& batch)
+	{
+		PA3EvaluateBatch(evaluator, batch);
+	}
+
+	CtrlExprEvaluator evaluator;
+};
+
+// number of logical lines per batch
+const size_t PA3BatchSize = 1024;
+
+// bytes of standard input tokenized at a time
+const size_t PA3ChunkSize = 1 << 20;
+
+// the end of the last whole physical line in `input`, which does not end in a line splice, or 0 if
+// there is none
+size_t PA3LineBoundary(const string& input)
+{
+	for (size_t end = input.size(); end > 0; end--)
+		if (input[end - 1] == '\n' && (end == 1 || input[end - 2] != '\\'))
+			return end;
+	return 0;
 }
 
+// tokenizes a chunk of input (see PA1) up to the first error, if any, and returns false if it ends
+// inside a multi-line comment or raw string, which the error says then
+bool PA3Tokenize(const string& chunk, vector<shared_ptr<PPToken>>& tokens, string& error)
+{
+	// translation phases 1, 2 and 3 (see PA1)
+	auto u32s = make_shared<PPUTF32Stream>(chunk);
+	auto cus = make_shared<PPCodeUnitStream>(u32s);
+	auto dfa = make_shared<PPTokenizerDFA>(cus);
+
+	tokens.clear();
+	error.clear();
+	while (!dfa->isEmpty())
+	{
+		error = dfa->getErrorMessage();
+		if (!error.empty())
+			return !dfa->isUnterminated();
+		tokens.push_back(dfa->getPPToken());
+		dfa->toNext();
+	}
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	try
+	{
+		vector<string> args;
+
+		for (int i = 1; i < argc; i++)
+			args.emplace_back(argv[i]);
+
+		// ctrlexpr [-j <threads>]
+		size_t nthreads = thread::hardware_concurrency();
+		if (args.size() == 2 && args[0] == "-j" && !args[1].empty() &&
+			args[1].find_first_not_of("0123456789") == string::npos)
+			nthreads = stoul(args[1]);
+		else if (!args.empty())
+			throw logic_error("usage: " + string(argv[0]) + " [-j <threads>]");
+		if (nthreads <= 1)
+			nthreads = 0;
+
+		ios_base::sync_with_stdio(false);
+
+		PA3IdentifierTable identifiers;
+		// batches are evaluated on a pool of threads, or as they are submitted without threads, and
+		// written in input order
+		OrderedPool<PA3Batch, PA3Worker> pipeline(nthreads, 2 * nthreads + 1,
+			[] { return unique_ptr<PA3Worker>(new PA3Worker); },
+			[](PA3Batch& batch) { cout << batch.output; });
+		unique_ptr<PA3Batch> batch(new PA3Batch);
+
+		// standard input is read and tokenized a chunk of whole lines at a time, so it never has to fit
+		// in memory; a chunk that ends inside a comment or raw string is retried twice as large
+		string input;
+		size_t chunkSize = PA3ChunkSize;
+		bool eof = false;
+		vector<shared_ptr<PPToken>> tokens;
+		string error;
+		do
+		{
+			while (!eof && input.size() < chunkSize)
+			{
+				const size_t size = input.size();
+				input.resize(chunkSize);
+				cin.read(&input[size], chunkSize - size);
+				input.resize(size + cin.gcount());
+				eof = !cin;
+			}
+
+			const size_t end = eof ? input.size() : PA3LineBoundary(input);
+			if (end == 0 && !eof)
+			{
+				chunkSize *= 2;
+				continue;
+			}
+			if (!PA3Tokenize(input.substr(0, end), tokens, error) && !eof)
+			{
+				chunkSize *= 2;
+				continue;
+			}
+			input.erase(0, end);
+			chunkSize = PA3ChunkSize;
+
+			for (const shared_ptr<PPToken>& token : tokens)
+			{
+				switch (token->getType())
+				{
+				case PPTokenType::NewLine:
+					batch->lineEnds.push_back(batch->tokens.size());
+					if (batch->lineEnds.size() == PA3BatchSize)
+					{
+						pipeline.submit(move(batch));
+						batch.reset(new PA3Batch);
+					}
+					break;
+				case PPTokenType::WhitespaceSequence:
+					break;
+				default:
+					batch->tokens.push_back(PA3PostTokenize(*token, identifiers));
+					break;
+				}
+			}
+			if (!error.empty())
+				throw runtime_error(error);
+		} while (!eof);
+		batch->lineEnds.push_back(batch->tokens.size());
+		pipeline.submit(move(batch));
+		pipeline.finish();
+
+		cout << "eof" << endl;
+	}
+	catch (exception& e)
+	{
+		cerr << "ERROR: " << e.what() << endl;
+		return EXIT_FAILURE;
+	}
+}
@@ -0,0 +1,196 @@
+#include "CtrlExpr.h"
+#include <gtest/gtest.h>
+#include <cctype>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+  // Identifiers `a`..`z` have the ids 0..25 and are defined iff the id is
+  // even; every other name has id 100.
+  class Defined: public CtrlExprDefinedIfc {
+  public:
+    bool isDefined(uint32_t id) const override { return id % 2 == 0; }
+  };
+
+  // Splits at whitespace: numbers with an optional `u`, operators and
+  // identifiers.
+  std::vector<CtrlExprToken> tokens(const std::string &s)
+  {
+    std::vector<CtrlExprToken> v;
+    std::istringstream in(s);
+    std::string t;
+    while (in >> t) {
+      if (std::isdigit(t[0])) {
+        v.push_back(CtrlExprToken::literal(std::strtoull(t.c_str(), nullptr, 0), t.back() == 'u'));
+      } else if (t == "defined") {
+        v.push_back(CtrlExprToken::defined(100));
+      } else if (StringToTokenTypeMap.count(t)  &&  StringToTokenTypeMap.at(t) >= OP_LBRACE) {
+        v.push_back(CtrlExprToken::punctuator(StringToTokenTypeMap.at(t)));
+      } else if (std::isalpha(t[0])) {
+        const uint32_t id = t.size() == 1 ? t[0] - 'a' : 100;
+        v.push_back(CtrlExprToken::identifier(id, t == "true"));
+      } else {
+        v.push_back(CtrlExprToken::invalid());
+      }
+    }
+    return v;
+  }
+
+  CtrlExprResult evaluate(CtrlExprEvaluator &evaluator, const std::string &s)
+  {
+    const std::vector<CtrlExprToken> v = tokens(s);
+    return evaluator.evaluate(v.data(), v.data() + v.size(), Defined());
+  }
+
+  void expectValue(const std::string &s, int64_t value)
+  {
+    CtrlExprEvaluator evaluator;
+    const CtrlExprResult r = evaluate(evaluator, s);
+    ASSERT_EQ(nullptr, r.error) << s;
+    EXPECT_FALSE(r.isUnsigned) << s;
+    EXPECT_EQ(value, static_cast<int64_t>(r.value)) << s;
+  }
+
+  void expectUnsigned(const std::string &s, uint64_t value)
+  {
+    CtrlExprEvaluator evaluator;
+    const CtrlExprResult r = evaluate(evaluator, s);
+    ASSERT_EQ(nullptr, r.error) << s;
+    EXPECT_TRUE(r.isUnsigned) << s;
+    EXPECT_EQ(value, r.value) << s;
+  }
+
+  void expectError(const std::string &s)
+  {
+    CtrlExprEvaluator evaluator;
+    EXPECT_NE(nullptr, evaluate(evaluator, s).error) << s;
+  }
+
+  size_t codeSize(const std::string &s)
+  {
+    const std::vector<CtrlExprToken> v = tokens(s);
+    CtrlExprProgram program;
+    CtrlExprEvaluator::compile(v.data(), v.data() + v.size(), program);
+    EXPECT_EQ(nullptr, program.error) << s;
+    return program.code.size();
+  }
+
+} // namespace
+
+// Expected values are the ones given by ctrlexpr-ref.
+TEST(CtrlExpr, Arithmetic)
+{
+  expectValue("2 + 3", 5);
+  expectUnsigned("2u + 3", 5);
+  expectValue("2 + 3 * 4", 14);
+  expectValue("( 2 + 3 ) * 4", 20);
+  expectValue("- - 3", 3);
+  expectValue("+ 3", 3);
+  expectValue("7 / - 2", -3);
+  expectValue("7 % - 2", 1);
+  expectValue("9223372036854775807 + 1", INT64_MIN);
+  expectValue("1 << 63", INT64_MIN);
+  expectValue("- 3 >> 1u", -2);
+  expectUnsigned("- 1u", UINT64_MAX);
+  expectUnsigned("~ 0u", UINT64_MAX);
+  expectUnsigned("( 0 ? 1u : 2 ) - 3", UINT64_MAX);
+}
+
+TEST(CtrlExpr, Comparisons)
+{
+  expectValue("- 1 < 0u", 0);
+  expectValue("- 1 < 0", 1);
+  expectValue("1 == 1 == 1", 1);
+  expectValue("! 0u", 1);
+  expectValue("0 || - 1", 1);
+  expectValue("1 && 1u", 1);
+  expectUnsigned("1 ? 2 : 3u", 2);
+  expectValue("1 ? 2 : 3 ? 4 : 5", 2);
+}
+
+TEST(CtrlExpr, ShortCircuit)
+{
+  expectValue("0 && 1 / 0", 0);
+  expectValue("1 || 1 / 0", 1);
+  expectValue("0 ? 1 / 0 : 2", 2);
+  expectError("0 ? 1 : 1 / 0");
+  expectError("1 && 1 % 0");
+}
+
+TEST(CtrlExpr, Defined)
+{
+  expectValue("defined a", 1);
+  expectValue("defined ( b )", 0);
+  expectValue("defined defined", 1);
+  expectValue("true", 1);
+  expectValue("false", 0);
+  expectValue("x", 0);
+  expectError("defined");
+  expectError("defined ( )");
+  expectError("defined ( a");
+  expectError("defined 1");
+  expectError("defined and");
+}
+
+TEST(CtrlExpr, Errors)
+{
+  expectError("");
+  expectError("1 +");
+  expectError("( )");
+  expectError(")");
+  expectError("1 2");
+  expectError("1 , 2");
+  expectError("1 ? 2");
+  expectError("1 ?: 2");
+  expectError("x = 1");
+  expectError("#");
+  expectError("1 / 0");
+  expectError("1u << 64");
+  expectError("1 >> - 1");
+}
+
+TEST(CtrlExpr, ConstantFolding)
+{
+  EXPECT_EQ(1u, codeSize("1 + 2 * 3 - ( 4 << 2 )"));
+  EXPECT_EQ(1u, codeSize("- ~ 5"));
+  EXPECT_EQ(3u, codeSize("defined a + 2 * 3"));
+  // A division by zero is left to the evaluation.
+  EXPECT_EQ(3u, codeSize("1 / 0"));
+  // No folding across the target of a jump.
+  EXPECT_EQ(7u, codeSize("( 0 ? 1 : 2 ) + 3"));
+}
+
+TEST(CtrlExpr, Cache)
+{
+  CtrlExprEvaluator evaluator;
+  EXPECT_EQ(1u, evaluate(evaluator, "defined a && 1").value);
+  EXPECT_EQ(0u, evaluate(evaluator, "defined b && 1").value);
+  EXPECT_EQ(1u, evaluate(evaluator, "defined a && 1").value);
+  EXPECT_NE(nullptr, evaluate(evaluator, "1 +").error);
+  EXPECT_NE(nullptr, evaluate(evaluator, "1 +").error);
+  EXPECT_EQ(2u, evaluator.cacheHits());
+  EXPECT_EQ(3u, evaluator.cacheMisses());
+  EXPECT_EQ(3u, evaluator.cacheSize());
+
+  // Equal tokens but a different signedness are different programs.
+  EXPECT_FALSE(evaluate(evaluator, "1").isUnsigned);
+  EXPECT_TRUE(evaluate(evaluator, "1u").isUnsigned);
+}
+
+TEST(CtrlExpr, CacheIsBounded)
+{
+  CtrlExprEvaluator evaluator(2);
+  EXPECT_EQ(1, static_cast<int64_t>(evaluate(evaluator, "1").value));
+  EXPECT_EQ(2, static_cast<int64_t>(evaluate(evaluator, "2").value));
+  EXPECT_EQ(2u, evaluator.cacheSize());
+  // A third program empties the full cache.
+  EXPECT_EQ(3, static_cast<int64_t>(evaluate(evaluator, "3").value));
+  EXPECT_EQ(1u, evaluator.cacheSize());
+  EXPECT_EQ(1, static_cast<int64_t>(evaluate(evaluator, "1").value));
+  EXPECT_EQ(0u, evaluator.cacheHits());
+  EXPECT_EQ(4u, evaluator.cacheMisses());
+  EXPECT_EQ(2u, evaluator.cacheSize());
+}
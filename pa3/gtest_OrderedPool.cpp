@@ -0,0 +1,129 @@
+#include "OrderedPool.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+  struct Job {
+    int n;
+    int result;
+    std::thread::id thread;
+  };
+
+  // Squares, the later jobs faster, so they finish out of order.
+  struct Worker {
+    void run(Job &job)
+    {
+      std::this_thread::sleep_for(std::chrono::microseconds(100 * (50 - job.n % 50)));
+      job.result = job.n * job.n;
+      job.thread = std::this_thread::get_id();
+      jobs++;
+    }
+
+    size_t jobs = 0;
+  };
+
+  typedef OrderedPool<Job, Worker> Pool;
+
+  std::unique_ptr<Job> job(int n)
+  {
+    return std::unique_ptr<Job>(new Job{n, 0, std::thread::id()});
+  }
+
+  Pool::MakeWorker makeWorker()
+  {
+    return [] { return std::unique_ptr<Worker>(new Worker); };
+  }
+
+} // namespace
+
+TEST(OrderedPool, InOrder)
+{
+  std::vector<int> results;
+  size_t jobs = 0;
+  {
+    Pool pool(4, 8, makeWorker(), [&](Job &j) { results.push_back(j.result); });
+    for (int n = 0; n < 200; n++)
+      pool.submit(job(n));
+    pool.finish();
+    ASSERT_EQ(4u, pool.workers().size());
+    for (const auto &w: pool.workers())
+      jobs += w->jobs;
+  }
+  ASSERT_EQ(200u, results.size());
+  for (int n = 0; n < 200; n++)
+    EXPECT_EQ(n * n, results[n]);
+  EXPECT_EQ(200u, jobs);
+}
+
+TEST(OrderedPool, Window)
+{
+  // A job submitted waits for the first of `window` to be handed over.
+  std::atomic<int> started(0);
+  struct Counting: Worker {
+    explicit Counting(std::atomic<int> &started): started(started) {}
+    void run(Job &job) { started++; Worker::run(job); }
+    std::atomic<int> &started;
+  };
+  std::vector<int> handed;
+  OrderedPool<Job, Counting> pool(2, 3,
+    [&] { return std::unique_ptr<Counting>(new Counting(started)); },
+    [&](Job &j) { handed.push_back(j.n); EXPECT_LE(started.load(), j.n + 3); });
+  for (int n = 0; n < 20; n++)
+    pool.submit(job(n));
+  pool.finish();
+  EXPECT_EQ(20u, handed.size());
+}
+
+TEST(OrderedPool, WithoutThreads)
+{
+  std::vector<int> results;
+  Pool pool(0, 1, makeWorker(), [&](Job &j) {
+    EXPECT_EQ(std::this_thread::get_id(), j.thread);
+    results.push_back(j.result);
+  });
+  pool.submit(job(3));
+  EXPECT_EQ(std::vector<int>{9}, results);
+  pool.submit(job(4));
+  pool.finish();
+  EXPECT_EQ((std::vector<int>{9, 16}), results);
+  EXPECT_EQ(1u, pool.workers().size());
+}
+
+TEST(OrderedPool, SinkThrows)
+{
+  // The jobs after the one the sink throws for are dropped.
+  std::vector<int> handed;
+  try {
+    Pool pool(3, 4, makeWorker(), [&](Job &j) {
+      if (j.n == 5)
+        throw std::runtime_error("stop");
+      handed.push_back(j.n);
+    });
+    for (int n = 0; n < 100; n++)
+      pool.submit(job(n));
+    pool.finish();
+    FAIL();
+  } catch (const std::runtime_error &) {
+  }
+  EXPECT_EQ((std::vector<int>{0, 1, 2, 3, 4}), handed);
+}
+
+TEST(OrderedPool, DestroyedEarly)
+{
+  // An exception from elsewhere: the jobs submitted are still handed over.
+  std::vector<int> handed;
+  try {
+    Pool pool(2, 4, makeWorker(), [&](Job &j) { handed.push_back(j.n); });
+    for (int n = 0; n < 10; n++)
+      pool.submit(job(n));
+    throw std::runtime_error("input error");
+  } catch (const std::runtime_error &) {
+  }
+  EXPECT_EQ(10u, handed.size());
+}
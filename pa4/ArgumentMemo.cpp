@@ -0,0 +1,90 @@
+#include "ArgumentMemo.h"
+
+#include <algorithm>
+
+namespace {
+
+  bool equalTokens(const MacroToken &a, const MacroToken &b)
+  {
+    return a.spelling == b.spelling  &&  a.hideSet == b.hideSet  &&  a.type == b.type
+        &&  a.precededBySpace == b.precededBySpace;
+  }
+
+  // Bytes of an entry, the hash table node included.
+  size_t entryBytes(size_t numTokens)
+  {
+    return numTokens * sizeof(MacroToken) + 64;
+  }
+
+} // namespace
+
+const size_t ArgumentMemo::DefaultMaxBytes;
+
+ArgumentMemo::ArgumentMemo(size_t maxBytes):
+  _generation(0), _maxBytes(maxBytes), _bytes(0), _hits(0), _misses(0)
+{
+}
+
+uint64_t ArgumentMemo::hash(const MacroToken *first, const MacroToken *last)
+{
+  // FNV-1a over the fields equalTokens() compares.
+  uint64_t h = 14695981039346656037ull;
+  for (; first != last; ++first) {
+    h ^= static_cast<uint64_t>(first->spelling) << 32 | first->hideSet;
+    h *= 1099511628211ull;
+    h ^= static_cast<uint64_t>(first->type) << 1 | first->precededBySpace;
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+bool ArgumentMemo::find(uint64_t generation, uint64_t h, const MacroToken *first, const MacroToken *last,
+                        const MacroToken *&expandedFirst, const MacroToken *&expandedLast)
+{
+  if (generation != _generation) {
+    _clear();
+    _generation = generation;
+  }
+
+  const size_t n = last - first;
+  const auto range = _entries.equal_range(h);
+  for (auto it = range.first; it != range.second; ++it) {
+    const Entry &e = it->second;
+    if (e.keyLength == n  &&  std::equal(first, last, e.tokens.begin(), equalTokens)) {
+      expandedFirst = e.tokens.data() + n;
+      expandedLast = e.tokens.data() + e.tokens.size();
+      _hits++;
+      return true;
+    }
+  }
+  _misses++;
+  return false;
+}
+
+void ArgumentMemo::insert(uint64_t generation, uint64_t h, const MacroToken *first, const MacroToken *last,
+                          const MacroToken *expandedFirst, const MacroToken *expandedLast)
+{
+  if (generation != _generation) {
+    _clear();
+    _generation = generation;
+  }
+
+  const size_t n = (last - first) + (expandedLast - expandedFirst);
+  if (entryBytes(n) > _maxBytes)
+    return;
+  if (_bytes + entryBytes(n) > _maxBytes)
+    _clear();
+
+  Entry &e = _entries.emplace(h, Entry())->second;
+  e.keyLength = last - first;
+  e.tokens.reserve(n);
+  e.tokens.insert(e.tokens.end(), first, last);
+  e.tokens.insert(e.tokens.end(), expandedFirst, expandedLast);
+  _bytes += entryBytes(n);
+}
+
+void ArgumentMemo::_clear()
+{
+  _entries.clear();
+  _bytes = 0;
+}
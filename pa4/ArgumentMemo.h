@@ -0,0 +1,58 @@
+#ifndef ArgumentMemo_h
+#define ArgumentMemo_h
+
+#include "MacroToken.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Memoized pre-expansions of macro arguments.
+//
+// The full macro replacement of an argument depends only on its tokens, hide
+// sets included, and on the macros defined, so it is keyed by the argument
+// tokens and the generation of the MacroTable. X-macro tables pass the same
+// arguments to macro after macro, and each is then expanded once.
+//
+// Entries of an older generation never hit again and are dropped when the
+// generation changes. When the entries reach the memory bound they are all
+// dropped, which keeps the bound without any bookkeeping per hit.
+class ArgumentMemo {
+public:
+  static const size_t DefaultMaxBytes = 64 << 20;
+
+  explicit ArgumentMemo(size_t maxBytes = DefaultMaxBytes);
+
+  static uint64_t hash(const MacroToken *first, const MacroToken *last);
+
+  // Finds the expansion of the argument [first, last) with hash `h`. The span
+  // is valid until the next insert().
+  bool find(uint64_t generation, uint64_t h, const MacroToken *first, const MacroToken *last,
+            const MacroToken *&expandedFirst, const MacroToken *&expandedLast);
+  void insert(uint64_t generation, uint64_t h, const MacroToken *first, const MacroToken *last,
+              const MacroToken *expandedFirst, const MacroToken *expandedLast);
+
+  size_t hits() const { return _hits; }
+  size_t misses() const { return _misses; }
+  size_t size() const { return _entries.size(); }
+  size_t bytes() const { return _bytes; }
+  size_t maxBytes() const { return _maxBytes; }
+
+private:
+  struct Entry {
+    size_t keyLength;
+    std::vector<MacroToken> tokens;     // the argument, then its expansion
+  };
+
+  void _clear();
+
+  std::unordered_multimap<uint64_t, Entry> _entries;
+  uint64_t _generation;
+  size_t _maxBytes;
+  size_t _bytes;
+  size_t _hits;
+  size_t _misses;
+};
+
+#endif /* end of include guard */
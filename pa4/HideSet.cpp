@@ -0,0 +1,93 @@
+#include "HideSet.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+  uint64_t pairKey(uint32_t a, uint32_t b)
+  {
+    return static_cast<uint64_t>(a) << 32 | b;
+  }
+
+  // FNV-1a over the elements.
+  uint64_t hashElements(const uint32_t *first, const uint32_t *last)
+  {
+    uint64_t h = 14695981039346656037ull;
+    for (; first != last; ++first) {
+      h ^= *first;
+      h *= 1099511628211ull;
+    }
+    return h;
+  }
+
+} // namespace
+
+const uint32_t HideSetTable::Empty;
+
+HideSetTable::HideSetTable()
+{
+  _offsets.push_back(0);
+  _offsets.push_back(0);
+  _index.emplace(hashElements(nullptr, nullptr), Empty);
+}
+
+uint32_t HideSetTable::insert(uint32_t set, uint32_t name)
+{
+  const auto memo = _inserts.find(pairKey(set, name));
+  if (memo != _inserts.end())
+    return memo->second;
+
+  uint32_t result = set;
+  if (!contains(set, name)) {
+    _scratch.assign(begin(set), end(set));
+    _scratch.insert(std::lower_bound(_scratch.begin(), _scratch.end(), name), name);
+    result = _intern(_scratch.data(), _scratch.data() + _scratch.size());
+  }
+  _inserts.emplace(pairKey(set, name), result);
+  return result;
+}
+
+uint32_t HideSetTable::unite(uint32_t a, uint32_t b)
+{
+  if (a == b  ||  b == Empty)
+    return a;
+  if (a == Empty)
+    return b;
+  if (a > b)
+    std::swap(a, b);
+
+  const auto memo = _unions.find(pairKey(a, b));
+  if (memo != _unions.end())
+    return memo->second;
+
+  _scratch.clear();
+  std::set_union(begin(a), end(a), begin(b), end(b), std::back_inserter(_scratch));
+  const uint32_t result = _intern(_scratch.data(), _scratch.data() + _scratch.size());
+  _unions.emplace(pairKey(a, b), result);
+  return result;
+}
+
+bool HideSetTable::contains(uint32_t set, uint32_t name) const
+{
+  return std::binary_search(begin(set), end(set), name);
+}
+
+uint32_t HideSetTable::_intern(const uint32_t *first, const uint32_t *last)
+{
+  const size_t n = last - first;
+  const uint64_t h = hashElements(first, last);
+  const auto range = _index.equal_range(h);
+  for (auto it = range.first; it != range.second; ++it) {
+    const uint32_t set = it->second;
+    if (static_cast<size_t>(end(set) - begin(set)) == n  &&  std::equal(first, last, begin(set)))
+      return set;
+  }
+
+  // `first` may point into _scratch but never into _elements.
+  const uint32_t set = size();
+  _elements.insert(_elements.end(), first, last);
+  _offsets.push_back(_elements.size());
+  _index.emplace(h, set);
+  return set;
+}
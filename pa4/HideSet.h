@@ -0,0 +1,45 @@
+#ifndef HideSet_h
+#define HideSet_h
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Interned hide sets ("blacklists" in the PA4 notes): the names of the macros
+// a token must not invoke.
+//
+// Each distinct set is stored once as a sorted vector of spelling ids and
+// referred to by a 32-bit id, id 0 being the empty set. Tokens carry the id,
+// so copying a token copies no set, equal sets compare by id, and unions are
+// memoized: an expansion unites the same few sets with every token it reads.
+class HideSetTable {
+public:
+  static const uint32_t Empty = 0;
+
+  HideSetTable();
+
+  // The set `set` plus `name`.
+  uint32_t insert(uint32_t set, uint32_t name);
+  uint32_t unite(uint32_t a, uint32_t b);
+  bool contains(uint32_t set, uint32_t name) const;
+
+  // The elements of `set`, sorted.
+  const uint32_t *begin(uint32_t set) const { return _elements.data() + _offsets[set]; }
+  const uint32_t *end(uint32_t set) const { return _elements.data() + _offsets[set + 1]; }
+
+  size_t size() const { return _offsets.size() - 1; }
+
+private:
+  // The id of the set [first, last), which is sorted and has no duplicates.
+  uint32_t _intern(const uint32_t *first, const uint32_t *last);
+
+  std::vector<uint32_t> _elements;              // all sets back to back
+  std::vector<uint32_t> _offsets;               // set i is [_offsets[i], _offsets[i + 1])
+  std::unordered_multimap<uint64_t, uint32_t> _index;   // hash of the elements -> set
+  std::unordered_map<uint64_t, uint32_t> _inserts;      // (set, name) -> set
+  std::unordered_map<uint64_t, uint32_t> _unions;       // (a, b) with a < b -> set
+  std::vector<uint32_t> _scratch;
+};
+
+#endif /* end of include guard */
@@ -0,0 +1,428 @@
+#include "MacroExpander.h"
+
+#include "PasteLexer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+  bool isQuoted(PPTokenType type)
+  {
+    return type == PPTokenType::CharacterLiteral  ||  type == PPTokenType::UserDefinedCharacterLiteral
+        ||  type == PPTokenType::StringLiteral  ||  type == PPTokenType::UserDefinedStringLiteral;
+  }
+
+} // namespace
+
+MacroExpander::MacroExpander(SpellingTable &spellings, const MacroTable &macros, HideSetTable &hideSets):
+  _spellings(spellings), _macros(macros), _hideSets(hideSets), _numInvocations(0), _profiler(nullptr), _dynamic(nullptr),
+  _dynamicInvocations(0)
+{
+}
+
+void MacroExpander::expand(const MacroToken *first, const MacroToken *last, std::vector<MacroToken> &out)
+{
+  for (const MacroToken *p = first; p != last; ++p) {
+    if (p->spelling == SpellingTable::VaArgs)
+      throw std::runtime_error("__VA_ARGS__ token in text-lines: __VA_ARGS__");
+  }
+
+  // Nothing is left over from a text-sequence that failed.
+  _contexts.clear();
+  _numInvocations = 0;
+  if (_profiler)
+    _profiler->abandon();
+
+  _push(first, last, HideSetTable::Empty, 0, -1, false);
+  _expand(0, out);
+}
+
+void MacroExpander::_expand(size_t base, std::vector<MacroToken> &out)
+{
+  MacroToken token;
+  while (_next(base, token)) {
+    if (token.type == PPTokenType::Identifier) {
+      const MacroDefinition *m = _macros.find(token.spelling);
+      if (m  &&  !_hideSets.contains(token.hideSet, token.spelling)) {
+        if (!m->functionLike) {
+          _invokeObjectLike(*m, token);
+          continue;
+        }
+        if (_peekLParen(base)) {
+          _invokeFunctionLike(*m, token, base);
+          continue;
+        }
+      }
+    }
+    out.push_back(token);
+  }
+}
+
+bool MacroExpander::_next(size_t base, MacroToken &token)
+{
+  while (_contexts.size() > base) {
+    Context &c = _contexts.back();
+    if (c.p == c.end) {
+      if (c.releases)
+        _numInvocations--;
+      _contexts.pop_back();
+      if (_profiler)
+        _profiler->popped(_contexts.size());
+      continue;
+    }
+
+    token = *c.p++;
+    if (c.hideSet != HideSetTable::Empty) {
+      token.hideSet = _hideSets.unite(token.hideSet, c.hideSet);
+      token.line = c.line;
+    }
+    if (c.space >= 0) {
+      token.precededBySpace = c.space;
+      c.space = -1;
+    }
+    return true;
+  }
+  return false;
+}
+
+bool MacroExpander::_peekLParen(size_t base) const
+{
+  for (size_t i = _contexts.size(); i > base; i--) {
+    const Context &c = _contexts[i - 1];
+    if (c.p != c.end)
+      return c.p->spelling == SpellingTable::LParen;
+  }
+  return false;
+}
+
+void MacroExpander::_push(const MacroToken *first, const MacroToken *last, uint32_t hideSet, uint32_t line, int space, bool releases)
+{
+  _contexts.push_back(Context{first, last, hideSet, line, static_cast<int8_t>(space), releases});
+}
+
+MacroExpander::Invocation &MacroExpander::_allocateInvocation()
+{
+  if (_numInvocations == _invocations.size())
+    _invocations.emplace_back(new Invocation);
+  return *_invocations[_numInvocations++];
+}
+
+void MacroExpander::_invokeObjectLike(const MacroDefinition &m, const MacroToken &head)
+{
+  if (_profiler)
+    _profiler->begin(m.name);
+
+  const size_t depth = _contexts.size();
+  const uint32_t hideSet = _hideSets.insert(head.hideSet, m.name);
+  if (!m.hasOperators  &&  !m.dynamic) {
+    _push(m.body, m.body + m.bodyLength, hideSet, head.line, head.precededBySpace, false);
+  } else {
+    Invocation &inv = _allocateInvocation();
+    if (m.dynamic) {
+      if (!_dynamic)
+        throw std::runtime_error("no replacement for " + _spellings.spelling(m.name));
+      inv.body.assign(1, _dynamic->replace(head));
+      _dynamicInvocations++;
+    } else {
+      _copyReplacement(m, inv);
+    }
+    _push(inv.body.data(), inv.body.data() + inv.body.size(), hideSet, head.line, head.precededBySpace, true);
+  }
+
+  if (_profiler)
+    _profileOpen(depth);
+}
+
+void MacroExpander::_invokeFunctionLike(const MacroDefinition &m, const MacroToken &head, size_t base)
+{
+  // The arguments are read before the invocation is allocated: reading them
+  // may pop the last context of an invocation, which then must be on top.
+  _collectArguments(m, base);
+  Invocation &inv = _allocateInvocation();
+  inv.raw.assign(_arguments.begin(), _arguments.end());
+  inv.args.resize(m.numParams);
+  for (size_t i = 0; i < m.numParams; i++) {
+    inv.args[i].rawBegin = _argumentBounds[i];
+    inv.args[i].rawEnd = _argumentBounds[i + 1];
+  }
+
+  if (_profiler)
+    _profiler->begin(m.name);
+
+  _expandArguments(m, inv);
+  const size_t depth = _contexts.size();
+  _substitute(m, head, inv);
+
+  if (_profiler)
+    _profileOpen(depth);
+}
+
+void MacroExpander::_collectArguments(const MacroDefinition &m, size_t base)
+{
+  MacroToken token;
+  _next(base, token);   // (
+
+  _arguments.clear();
+  _argumentBounds.assign(1, 0);
+  size_t depth = 0;
+  for (;;) {
+    if (!_next(base, token))
+      throw std::runtime_error("could not terminate function-like macro invocation");
+
+    if (token.spelling == SpellingTable::LParen) {
+      depth++;
+    } else if (token.spelling == SpellingTable::RParen) {
+      if (depth == 0)
+        break;
+      depth--;
+    } else if (token.spelling == SpellingTable::Comma  &&  depth == 0) {
+      // The commas of the variable arguments are part of __VA_ARGS__.
+      if (!m.variadic  ||  _argumentBounds.size() < m.numParams) {
+        _argumentBounds.push_back(_arguments.size());
+        continue;
+      }
+    }
+    _arguments.push_back(token);
+  }
+  _argumentBounds.push_back(_arguments.size());
+
+  // A macro without parameters takes a single empty argument.
+  const size_t numArguments = _argumentBounds.size() - 1;
+  const bool ok = m.numParams == 0 ? _arguments.empty() : numArguments == m.numParams;
+  if (!ok)
+    throw std::runtime_error("macro function-like invocation wrong num of params: " + _spellings.spelling(m.name));
+}
+
+void MacroExpander::_expandArguments(const MacroDefinition &m, Invocation &inv)
+{
+  // The parameters used other than as operands of # and ##.
+  for (Argument &arg: inv.args) {
+    arg.used = false;
+    arg.unchanged = true;
+  }
+  for (size_t i = 0; i < m.bodyLength; i++) {
+    const MacroToken &t = m.body[i];
+    if (t.role != MacroTokenRole::Parameter)
+      continue;
+    const bool operand = (i > 0  &&  (m.body[i - 1].role == MacroTokenRole::Stringize
+                                       ||  m.body[i - 1].role == MacroTokenRole::Paste))
+        ||  (i + 1 < m.bodyLength  &&  m.body[i + 1].role == MacroTokenRole::Paste);
+    if (!operand)
+      inv.args[t.param].used = true;
+  }
+
+  inv.expanded.clear();
+  for (size_t i = 0; i < m.numParams; i++) {
+    if (inv.args[i].used)
+      _expandArgument(inv, i);
+  }
+}
+
+void MacroExpander::_expandArgument(Invocation &inv, size_t i)
+{
+  const MacroToken *first = inv.rawBegin(i);
+  const MacroToken *last = inv.rawEnd(i);
+  if (!_mayExpand(first, last))
+    return;
+
+  Argument &arg = inv.args[i];
+  arg.unchanged = false;
+  arg.expandedBegin = inv.expanded.size();
+
+  const uint64_t generation = _macros.generation();
+  const uint64_t h = ArgumentMemo::hash(first, last);
+  const MacroToken *memoFirst;
+  const MacroToken *memoLast;
+  if (_memo.find(generation, h, first, last, memoFirst, memoLast)) {
+    inv.expanded.insert(inv.expanded.end(), memoFirst, memoLast);
+    if (_profiler)
+      _profiler->memoHit();
+  } else {
+    // The argument is fully macro replaced on its own, as if it were the
+    // rest of the text-sequence.
+    const uint64_t dynamicInvocations = _dynamicInvocations;
+    const size_t argBase = _contexts.size();
+    _push(first, last, HideSetTable::Empty, 0, -1, false);
+    _expand(argBase, inv.expanded);
+    // The lines of the tokens do not matter, the substitution sets them, but
+    // the replacement of a dynamic macro does.
+    if (dynamicInvocations == _dynamicInvocations)
+      _memo.insert(generation, h, first, last, inv.expanded.data() + arg.expandedBegin,
+                   inv.expanded.data() + inv.expanded.size());
+  }
+  arg.expandedEnd = inv.expanded.size();
+}
+
+bool MacroExpander::_mayExpand(const MacroToken *first, const MacroToken *last) const
+{
+  for (const MacroToken *p = first; p != last; ++p) {
+    if (p->type == PPTokenType::Identifier  &&  _macros.find(p->spelling)
+        &&  !_hideSets.contains(p->hideSet, p->spelling))
+      return true;
+  }
+  return false;
+}
+
+void MacroExpander::_substitute(const MacroDefinition &m, const MacroToken &head, Invocation &inv)
+{
+  const uint32_t hideSet = _hideSets.insert(head.hideSet, m.name);
+  if (m.hasOperators) {
+    _copyReplacement(m, inv);
+    _push(inv.body.data(), inv.body.data() + inv.body.size(), hideSet, head.line, head.precededBySpace, true);
+    return;
+  }
+
+  // The runs of the replacement list and the arguments in between, in order.
+  _segments.clear();
+  for (size_t i = 0; i < m.bodyLength; ) {
+    const MacroToken &t = m.body[i];
+    if (t.role == MacroTokenRole::Parameter) {
+      _segments.push_back(Context{inv.expandedBegin(t.param), inv.expandedEnd(t.param),
+                                  hideSet, head.line, static_cast<int8_t>(t.precededBySpace), false});
+      i++;
+    } else {
+      size_t j = i + 1;
+      while (j < m.bodyLength  &&  m.body[j].role != MacroTokenRole::Parameter)
+        j++;
+      _segments.push_back(Context{m.body + i, m.body + j, hideSet, head.line, -1, false});
+      i = j;
+    }
+  }
+  if (_segments.empty()) {
+    _numInvocations--;
+    return;
+  }
+
+  _segments.front().space = head.precededBySpace;
+  _segments.back().releases = true;
+  _contexts.insert(_contexts.end(), _segments.rbegin(), _segments.rend());
+}
+
+void MacroExpander::_profileOpen(size_t depth)
+{
+  size_t tokens = 0;
+  for (size_t i = depth; i < _contexts.size(); i++)
+    tokens += _contexts[i].end - _contexts[i].p;
+  _profiler->open(depth, tokens);
+}
+
+void MacroExpander::_copyReplacement(const MacroDefinition &m, Invocation &inv)
+{
+  std::vector<MacroToken> &out = inv.body;
+  out.clear();
+
+  bool paste = false;
+  for (size_t i = 0; i < m.bodyLength; i++) {
+    const MacroToken &t = m.body[i];
+    switch (t.role) {
+      case MacroTokenRole::Paste:
+        paste = true;
+        continue;
+
+      case MacroTokenRole::Stringize: {
+        const size_t param = m.body[++i].param;
+        MacroToken s = _stringize(inv.rawBegin(param), inv.rawEnd(param));
+        _append(out, &s, &s + 1, paste, t.precededBySpace);
+        break;
+      }
+
+      case MacroTokenRole::Parameter: {
+        // An operand of ## is the argument as written, an empty one being a
+        // placemarker.
+        const bool operand = paste  ||  (i + 1 < m.bodyLength  &&  m.body[i + 1].role == MacroTokenRole::Paste);
+        const MacroToken *first = operand ? inv.rawBegin(t.param) : inv.expandedBegin(t.param);
+        const MacroToken *last = operand ? inv.rawEnd(t.param) : inv.expandedEnd(t.param);
+        if (operand  &&  first == last) {
+          const MacroToken placemarker = MacroToken::make(PPTokenType::NonWhitespaceChar, SpellingTable::Placemarker, false);
+          _append(out, &placemarker, &placemarker + 1, paste, t.precededBySpace);
+        } else {
+          _append(out, first, last, paste, t.precededBySpace);
+        }
+        break;
+      }
+
+      case MacroTokenRole::Plain:
+        _append(out, &t, &t + 1, paste, t.precededBySpace);
+        break;
+    }
+    paste = false;
+  }
+
+  out.erase(std::remove_if(out.begin(), out.end(), [](const MacroToken &t) {
+    return t.spelling == SpellingTable::Placemarker;
+  }), out.end());
+}
+
+void MacroExpander::_append(std::vector<MacroToken> &out, const MacroToken *first, const MacroToken *last, bool paste, bool space)
+{
+  if (first == last)
+    return;
+  if (paste) {
+    out.back() = _paste(out.back(), *first);
+    ++first;
+  } else {
+    out.push_back(*first);
+    out.back().precededBySpace = space;
+    ++first;
+  }
+  out.insert(out.end(), first, last);
+}
+
+MacroToken MacroExpander::_stringize(const MacroToken *first, const MacroToken *last)
+{
+  // Whitespace between tokens becomes one space; " and \ are escaped inside
+  // character and string literals. The spelling is written to the arena of
+  // the SpellingTable in one pass, into room for the worst case.
+  size_t length = 2;
+  for (const MacroToken *p = first; p != last; ++p)
+    length += 1 + (isQuoted(p->type) ? 2 : 1) * _spellings.length(p->spelling);
+
+  char *const begin = _spellings.reserve(length);
+  char *q = begin;
+  *q++ = '"';
+  for (const MacroToken *p = first; p != last; ++p) {
+    if (p != first  &&  p->precededBySpace)
+      *q++ = ' ';
+    const char *s = _spellings.data(p->spelling);
+    const char *const end = s + _spellings.length(p->spelling);
+    if (!isQuoted(p->type)) {
+      q = std::copy(s, end, q);
+      continue;
+    }
+    for (; s != end; ++s) {
+      if (*s == '"'  ||  *s == '\\')
+        *q++ = '\\';
+      *q++ = *s;
+    }
+  }
+  *q++ = '"';
+  return MacroToken::make(PPTokenType::StringLiteral, _spellings.commit(q - begin), false);
+}
+
+MacroToken MacroExpander::_paste(const MacroToken &lhs, const MacroToken &rhs)
+{
+  if (rhs.spelling == SpellingTable::Placemarker)
+    return lhs;
+  if (lhs.spelling == SpellingTable::Placemarker) {
+    MacroToken t = rhs;
+    t.precededBySpace = lhs.precededBySpace;
+    return t;
+  }
+
+  // The operands are concatenated in the arena and lexed there.
+  const size_t lhsLength = _spellings.length(lhs.spelling);
+  const size_t length = lhsLength + _spellings.length(rhs.spelling);
+  char *const p = _spellings.reserve(length);
+  std::memcpy(p, _spellings.data(lhs.spelling), lhsLength);
+  std::memcpy(p + lhsLength, _spellings.data(rhs.spelling), length - lhsLength);
+
+  PPTokenType type;
+  if (!PasteLexer::lex(p, length, type))
+    throw std::runtime_error("pasting does not give a valid preprocessing token: " + std::string(p, length));
+
+  MacroToken t = MacroToken::make(type, _spellings.commit(length), lhs.precededBySpace);
+  t.hideSet = _hideSets.unite(lhs.hideSet, rhs.hideSet);
+  return t;
+}
@@ -0,0 +1,140 @@
+#ifndef MacroExpander_h
+#define MacroExpander_h
+
+#include "ArgumentMemo.h"
+#include "HideSet.h"
+#include "MacroProfiler.h"
+#include "MacroTable.h"
+#include "MacroToken.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Gives the replacement of the dynamic macros of a MacroTable, those whose
+// replacement depends on where they are invoked, such as __LINE__.
+class DynamicMacroIfc {
+public:
+  virtual ~DynamicMacroIfc() {}
+  // The single token replacing the dynamic macro named by `head`.
+  virtual MacroToken replace(const MacroToken &head) = 0;
+};
+
+// Macro replacement of text-sequences (16.3), with the nesting rules of PA4:
+// every token an invocation of macro M with head token H produces, the
+// substituted arguments included, gets its hide set united with the hide set
+// of H plus M, and an identifier naming a macro in its own hide set is never
+// invoked. These tokens also take the line of H.
+//
+// Rescanning works on a stack of contexts, each a span of tokens still to be
+// read and a hide set to apply to them on the way out. Invoking an
+// object-like macro pushes its replacement list from the MacroTable arena as
+// it is; invoking a function-like macro pushes the runs of the replacement
+// list between parameters and the spans of the pre-expanded arguments, in
+// reverse. Only a replacement list with # or ## is copied, to be stringized
+// and pasted into; the spellings these make are written straight into the
+// SpellingTable. The argument buffers of an invocation are kept in a pool
+// and reused once the last of its contexts is popped.
+//
+// An argument is pre-expanded only if its parameter appears outside the
+// operands of # and ##, and only if it names a macro that may be invoked;
+// otherwise the argument as written is its expansion. Pre-expansions are
+// memoized in an ArgumentMemo, unless they invoke a dynamic macro.
+//
+// With a MacroProfiler set, every invocation is reported to it; without one
+// the hooks are a null test per invocation and per popped context.
+class MacroExpander {
+public:
+  MacroExpander(SpellingTable &spellings, const MacroTable &macros, HideSetTable &hideSets);
+
+  // Macro-replaces the text-sequence [first, last) and appends the result to
+  // `out`. Throws std::runtime_error on errors.
+  void expand(const MacroToken *first, const MacroToken *last, std::vector<MacroToken> &out);
+
+  ArgumentMemo &memo() { return _memo; }
+  const ArgumentMemo &memo() const { return _memo; }
+
+  // Profiles the next expansions with `profiler`, or stops if null.
+  void setProfiler(MacroProfiler *profiler) { _profiler = profiler; }
+
+  // Replaces the dynamic macros; required if the MacroTable has any.
+  void setDynamicMacros(DynamicMacroIfc *dynamic) { _dynamic = dynamic; }
+
+private:
+  struct Context {
+    const MacroToken *p;
+    const MacroToken *end;
+    uint32_t hideSet;       // united into the hide set of every token read
+    uint32_t line;          // the line of every token read, unless hideSet is empty
+    int8_t space;           // unless -1, precededBySpace of the next token read
+    bool releases;          // popping it ends the innermost live invocation
+  };
+
+  // An argument as written is [rawBegin, rawEnd) of Invocation::raw; its
+  // pre-expansion is [expandedBegin, expandedEnd) of Invocation::expanded,
+  // unless it is the argument as written.
+  struct Argument {
+    size_t rawBegin;
+    size_t rawEnd;
+    size_t expandedBegin;
+    size_t expandedEnd;
+    bool used;              // the parameter appears outside # and ##
+    bool unchanged;
+  };
+
+  // The buffers of one invocation.
+  struct Invocation {
+    std::vector<MacroToken> raw;
+    std::vector<MacroToken> expanded;
+    std::vector<Argument> args;
+    std::vector<MacroToken> body;           // a copied replacement list
+
+    const MacroToken *rawBegin(size_t i) const { return raw.data() + args[i].rawBegin; }
+    const MacroToken *rawEnd(size_t i) const { return raw.data() + args[i].rawEnd; }
+    const MacroToken *expandedBegin(size_t i) const
+    { return args[i].unchanged ? rawBegin(i) : expanded.data() + args[i].expandedBegin; }
+    const MacroToken *expandedEnd(size_t i) const
+    { return args[i].unchanged ? rawEnd(i) : expanded.data() + args[i].expandedEnd; }
+  };
+
+  void _expand(size_t base, std::vector<MacroToken> &out);
+
+  // Reads the next token of the contexts above `base`, popping the exhausted
+  // ones; false when there is none.
+  bool _next(size_t base, MacroToken &token);
+  bool _peekLParen(size_t base) const;
+  void _push(const MacroToken *first, const MacroToken *last, uint32_t hideSet, uint32_t line, int space, bool releases);
+
+  Invocation &_allocateInvocation();
+  void _invokeObjectLike(const MacroDefinition &m, const MacroToken &head);
+  void _invokeFunctionLike(const MacroDefinition &m, const MacroToken &head, size_t base);
+  void _collectArguments(const MacroDefinition &m, size_t base);
+  void _expandArguments(const MacroDefinition &m, Invocation &inv);
+  void _expandArgument(Invocation &inv, size_t i);
+  bool _mayExpand(const MacroToken *first, const MacroToken *last) const;
+  void _substitute(const MacroDefinition &m, const MacroToken &head, Invocation &inv);
+  void _profileOpen(size_t depth);
+  void _copyReplacement(const MacroDefinition &m, Invocation &inv);
+  void _append(std::vector<MacroToken> &out, const MacroToken *first, const MacroToken *last, bool paste, bool space);
+  MacroToken _stringize(const MacroToken *first, const MacroToken *last);
+  MacroToken _paste(const MacroToken &lhs, const MacroToken &rhs);
+
+  SpellingTable &_spellings;
+  const MacroTable &_macros;
+  HideSetTable &_hideSets;
+
+  std::vector<Context> _contexts;
+  std::vector<Context> _segments;                         // scratch of _substitute()
+  std::vector<std::unique_ptr<Invocation>> _invocations;  // [0, _numInvocations) are live
+  size_t _numInvocations;
+  std::vector<MacroToken> _arguments;                     // scratch of _collectArguments()
+  std::vector<size_t> _argumentBounds;
+  ArgumentMemo _memo;
+  MacroProfiler *_profiler;
+  DynamicMacroIfc *_dynamic;
+  uint64_t _dynamicInvocations;
+};
+
+#endif /* end of include guard */
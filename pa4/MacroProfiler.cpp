@@ -0,0 +1,188 @@
+#include "MacroProfiler.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+
+namespace {
+
+  uint64_t nanoseconds(std::chrono::steady_clock::duration d)
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+  }
+
+  uint64_t sortValue(const MacroProfiler::Stats &s, MacroProfiler::SortKey key)
+  {
+    switch (key) {
+      case MacroProfiler::SortKey::Time:        return s.nanoseconds;
+      case MacroProfiler::SortKey::SelfTime:    return s.selfNanoseconds;
+      case MacroProfiler::SortKey::Invocations: return s.invocations;
+      case MacroProfiler::SortKey::Tokens:      return s.tokens;
+      case MacroProfiler::SortKey::Depth:       return s.maxDepth;
+      case MacroProfiler::SortKey::MemoHits:    return s.memoHits;
+    }
+    return 0;
+  }
+
+  void writeJSONString(std::ostream &out, const std::string &s)
+  {
+    out << '"';
+    for (const char c: s) {
+      if (c == '"'  ||  c == '\\') {
+        out << '\\' << c;
+      } else if (static_cast<unsigned char>(c) < 0x20) {
+        char buf[8];
+        std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+        out << buf;
+      } else {
+        out << c;
+      }
+    }
+    out << '"';
+  }
+
+} // namespace
+
+const size_t MacroProfiler::DefaultMaxEvents;
+const size_t MacroProfiler::NotOpen;
+
+MacroProfiler::MacroProfiler(size_t maxEvents):
+  _maxEvents(maxEvents), _droppedEvents(0), _epoch(Clock::now())
+{
+}
+
+void MacroProfiler::begin(uint32_t name)
+{
+  Stats &s = _stats(name);
+  s.invocations++;
+  s.maxDepth = std::max(s.maxDepth, static_cast<uint32_t>(_frames.size() + 1));
+  _active[name]++;
+  _frames.push_back(Frame{name, NotOpen, Clock::now(), 0, 0});
+}
+
+void MacroProfiler::open(size_t depth, size_t tokens)
+{
+  Frame &f = _frames.back();
+  f.tokens = tokens;
+  _stats(f.name).tokens += tokens;
+  if (tokens == 0)
+    _end();
+  else
+    f.depth = depth;
+}
+
+void MacroProfiler::memoHit()
+{
+  if (!_frames.empty())
+    _stats(_frames.back().name).memoHits++;
+}
+
+void MacroProfiler::popped(size_t depth)
+{
+  while (!_frames.empty()  &&  _frames.back().depth != NotOpen  &&  _frames.back().depth >= depth)
+    _end();
+}
+
+void MacroProfiler::abandon()
+{
+  for (const Frame &f: _frames)
+    _active[f.name]--;
+  _frames.clear();
+}
+
+void MacroProfiler::_end()
+{
+  const Frame f = _frames.back();
+  _frames.pop_back();
+
+  const uint64_t duration = nanoseconds(Clock::now() - f.start);
+  Stats &s = _stats(f.name);
+  // A macro invoked within its own frame, from an argument, is timed once.
+  if (--_active[f.name] == 0)
+    s.nanoseconds += duration;
+  s.selfNanoseconds += duration - std::min(duration, f.childNanoseconds);
+  if (!_frames.empty())
+    _frames.back().childNanoseconds += duration;
+
+  if (_events.size() < _maxEvents)
+    _events.push_back(Event{f.name, static_cast<uint32_t>(_frames.size()), nanoseconds(f.start - _epoch), duration, f.tokens});
+  else
+    _droppedEvents++;
+}
+
+MacroProfiler::Stats &MacroProfiler::_stats(uint32_t name)
+{
+  if (name >= _byName.size()) {
+    const size_t n = _byName.size();
+    _byName.resize(name + 1);
+    _active.resize(name + 1);
+    for (size_t i = n; i <= name; i++)
+      _byName[i] = Stats{static_cast<uint32_t>(i), 0, 0, 0, 0, 0, 0};
+  }
+  return _byName[name];
+}
+
+std::vector<MacroProfiler::Stats> MacroProfiler::stats(SortKey key) const
+{
+  std::vector<Stats> v;
+  for (const Stats &s: _byName) {
+    if (s.invocations)
+      v.push_back(s);
+  }
+  std::stable_sort(v.begin(), v.end(), [key](const Stats &a, const Stats &b) {
+    return sortValue(a, key) > sortValue(b, key);
+  });
+  return v;
+}
+
+void MacroProfiler::writeReport(std::ostream &out, const SpellingTable &spellings, SortKey key) const
+{
+  char buf[128];
+  std::snprintf(buf, sizeof(buf), "%12s %12s %8s %10s %12s %12s  %s\n",
+                "calls", "tokens", "depth", "memo-hits", "total-us", "self-us", "macro");
+  out << buf;
+  for (const Stats &s: stats(key)) {
+    std::snprintf(buf, sizeof(buf), "%12" PRIu64 " %12" PRIu64 " %8" PRIu32 " %10" PRIu64 " %12.1f %12.1f  ",
+                  s.invocations, s.tokens, s.maxDepth, s.memoHits, s.nanoseconds / 1e3, s.selfNanoseconds / 1e3);
+    out << buf << spellings.spelling(s.name) << '\n';
+  }
+  if (_droppedEvents)
+    out << "(" << _droppedEvents << " invocations left out of the trace)\n";
+}
+
+void MacroProfiler::writeTrace(std::ostream &out, const SpellingTable &spellings) const
+{
+  char buf[128];
+  out << "{\"traceEvents\":[";
+  for (size_t i = 0; i < _events.size(); i++) {
+    const Event &e = _events[i];
+    out << (i ? ",\n" : "\n") << "{\"name\":";
+    writeJSONString(out, spellings.spelling(e.name));
+    std::snprintf(buf, sizeof(buf), ",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f",
+                  e.start / 1e3, e.duration / 1e3);
+    out << buf << ",\"args\":{\"tokens\":" << e.tokens << ",\"depth\":" << e.depth + 1 << "}}";
+  }
+  out << "\n],\"displayTimeUnit\":\"ns\",\"otherData\":{\"droppedEvents\":" << _droppedEvents << "}}\n";
+}
+
+bool MacroProfiler::parseSortKey(const std::string &name, SortKey &key)
+{
+  static const struct {
+    const char *name;
+    SortKey key;
+  } keys[] = {
+    {"time", SortKey::Time},
+    {"self", SortKey::SelfTime},
+    {"calls", SortKey::Invocations},
+    {"tokens", SortKey::Tokens},
+    {"depth", SortKey::Depth},
+    {"memo", SortKey::MemoHits},
+  };
+  for (const auto &k: keys) {
+    if (name == k.name) {
+      key = k.key;
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,112 @@
+#ifndef MacroProfiler_h
+#define MacroProfiler_h
+
+#include "MacroToken.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Cost of every macro, gathered by a MacroExpander that has one set.
+//
+// An invocation is a frame that begins when the macro is invoked, its
+// arguments collected, and ends when the last context of its replacement is
+// popped, i.e. when the replacement has been rescanned. Frames nest the way
+// rescanning does, so the time of a frame includes the macros invoked by its
+// arguments and its replacement; the self time does not. The tokens of a
+// frame are the ones its replacement list gives after substitution, before
+// rescanning.
+//
+// The expander calls the profiler once per invocation and once per popped
+// context, never per token, and not at all when no profiler is set.
+class MacroProfiler {
+public:
+  struct Stats {
+    uint32_t name;              // id in the SpellingTable
+    uint64_t invocations;
+    uint64_t tokens;
+    uint64_t memoHits;          // arguments found in the ArgumentMemo
+    uint32_t maxDepth;          // 1 for an invocation in the text-sequence itself
+    uint64_t nanoseconds;       // of the outermost frames of the macro only
+    uint64_t selfNanoseconds;
+  };
+
+  enum class SortKey {
+    Time,
+    SelfTime,
+    Invocations,
+    Tokens,
+    Depth,
+    MemoHits,
+  };
+
+  static const size_t DefaultMaxEvents = 1 << 20;
+
+  // At most `maxEvents` frames are kept for the trace, the others are only
+  // counted.
+  explicit MacroProfiler(size_t maxEvents = DefaultMaxEvents);
+
+  // Hooks of the MacroExpander.
+  void begin(uint32_t name);
+  // The frame begun last pushed `tokens` tokens in contexts from `depth` up,
+  // or none, which ends it.
+  void open(size_t depth, size_t tokens);
+  void memoHit();
+  // The context stack is down to `depth` contexts.
+  void popped(size_t depth);
+  // Drops the frames of a text-sequence that failed.
+  void abandon();
+
+  // The macros invoked at least once, in decreasing order of `key`, ties in
+  // order of the name ids.
+  std::vector<Stats> stats(SortKey key) const;
+
+  // A table with a line per macro.
+  void writeReport(std::ostream &out, const SpellingTable &spellings, SortKey key) const;
+  // The frames as Chrome trace-event JSON, for chrome://tracing or Perfetto.
+  void writeTrace(std::ostream &out, const SpellingTable &spellings) const;
+
+  size_t events() const { return _events.size(); }
+  size_t droppedEvents() const { return _droppedEvents; }
+
+  // The SortKey named `name` (time, self, calls, tokens, depth, memo); false
+  // if there is none.
+  static bool parseSortKey(const std::string &name, SortKey &key);
+
+private:
+  typedef std::chrono::steady_clock Clock;
+
+  static const size_t NotOpen = SIZE_MAX;
+
+  struct Frame {
+    uint32_t name;
+    size_t depth;               // of the first context, NotOpen until open()
+    Clock::time_point start;
+    uint64_t tokens;
+    uint64_t childNanoseconds;
+  };
+
+  struct Event {
+    uint32_t name;
+    uint32_t depth;
+    uint64_t start;             // nanoseconds since the profiler was made
+    uint64_t duration;
+    uint64_t tokens;
+  };
+
+  Stats &_stats(uint32_t name);
+  void _end();
+
+  size_t _maxEvents;
+  size_t _droppedEvents;
+  Clock::time_point _epoch;
+  std::vector<Stats> _byName;           // indexed by the name
+  std::vector<uint32_t> _active;        // open frames per name, for `nanoseconds`
+  std::vector<Frame> _frames;
+  std::vector<Event> _events;
+};
+
+#endif /* end of include guard */
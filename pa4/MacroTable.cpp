@@ -0,0 +1,208 @@
+#include "MacroTable.h"
+
+#include <stdexcept>
+
+namespace {
+
+  bool isIdentifier(const MacroToken *p, const MacroToken *last)
+  {
+    return p != last  &&  p->type == PPTokenType::Identifier;
+  }
+
+  bool is(const MacroToken *p, const MacroToken *last, uint32_t spelling)
+  {
+    return p != last  &&  p->spelling == spelling;
+  }
+
+} // namespace
+
+const uint32_t MacroTable::EmptySlot;
+const uint32_t MacroTable::DeletedSlot;
+
+MacroTable::MacroTable(SpellingTable &spellings):
+  _spellings(spellings), _size(0), _deleted(0), _generation(0)
+{
+  _slots.resize(64, Slot{EmptySlot, MacroDefinition()});
+}
+
+void MacroTable::define(const MacroToken *first, const MacroToken *last)
+{
+  const MacroToken *p = first;
+  if (!isIdentifier(p, last))
+    throw std::runtime_error("expected identifier");
+  if (p->spelling == SpellingTable::VaArgs)
+    throw std::runtime_error("invalid __VA_ARGS__ use");
+
+  MacroDefinition d = MacroDefinition();
+  d.name = p->spelling;
+  ++p;
+
+  // identifier no-whitespace ( identifier-list[opt] [, ...] )
+  _params.clear();
+  d.functionLike = is(p, last, SpellingTable::LParen)  &&  !p->precededBySpace;
+  if (d.functionLike) {
+    ++p;
+    if (is(p, last, SpellingTable::RParen)) {
+      ++p;
+    } else {
+      for (;;) {
+        if (is(p, last, SpellingTable::Ellipsis)) {
+          d.variadic = true;
+          ++p;
+          if (!is(p, last, SpellingTable::RParen))
+            throw std::runtime_error("expected rparen");
+          ++p;
+          break;
+        }
+        if (!isIdentifier(p, last))
+          throw std::runtime_error("expected identifier");
+        if (p->spelling == SpellingTable::VaArgs)
+          throw std::runtime_error("invalid __VA_ARGS__ use");
+        for (const MacroToken &param: _params) {
+          if (param.spelling == p->spelling)
+            throw std::runtime_error("duplicate parameter " + _spellings.spelling(p->spelling) + " in macro definition");
+        }
+        _params.push_back(MacroToken::make(p->type, p->spelling, false));
+        ++p;
+        if (is(p, last, SpellingTable::RParen)) {
+          ++p;
+          break;
+        }
+        if (!is(p, last, SpellingTable::Comma))
+          throw std::runtime_error("expected rparen");
+        ++p;
+      }
+    }
+    if (d.variadic)
+      _params.push_back(MacroToken::make(PPTokenType::Identifier, SpellingTable::VaArgs, false));
+  } else if (p != last  &&  !p->precededBySpace) {
+    throw std::runtime_error("invalid macro definition");
+  }
+
+  // The replacement list, with the roles of its tokens. Leading whitespace is
+  // not part of it.
+  _body.assign(p, last);
+  for (size_t i = 0; i < _body.size(); i++) {
+    MacroToken &t = _body[i];
+    t.hideSet = 0;
+    t.role = MacroTokenRole::Plain;
+    t.param = 0;
+    t.line = 0;
+    if (i == 0)
+      t.precededBySpace = false;
+
+    if (t.type == PPTokenType::Identifier) {
+      for (size_t j = 0; j < _params.size(); j++) {
+        if (_params[j].spelling == t.spelling) {
+          t.role = MacroTokenRole::Parameter;
+          t.param = j;
+        }
+      }
+      if (t.spelling == SpellingTable::VaArgs  &&  t.role != MacroTokenRole::Parameter)
+        throw std::runtime_error("invalid __VA_ARGS__ use");
+    } else if (SpellingTable::isHashHash(t.spelling)) {
+      if (i == 0  ||  i + 1 == _body.size())
+        throw std::runtime_error("## at edge of replacement list");
+      t.role = MacroTokenRole::Paste;
+      d.hasOperators = true;
+    } else if (d.functionLike  &&  SpellingTable::isHash(t.spelling)) {
+      if (i + 1 == _body.size())
+        throw std::runtime_error("# at end of function-like macro replacement list");
+      t.role = MacroTokenRole::Stringize;
+      d.hasOperators = true;
+    }
+  }
+  for (size_t i = 0; i < _body.size(); i++) {
+    if (_body[i].role == MacroTokenRole::Stringize  &&  _body[i + 1].role != MacroTokenRole::Parameter)
+      throw std::runtime_error("# must be followed by parameter in function-like macro");
+  }
+
+  d.numParams = _params.size();
+  d.params = _arena.intern(_params.data(), _params.data() + _params.size());
+  d.body = _arena.intern(_body.data(), _body.data() + _body.size());
+  d.bodyLength = _body.size();
+  _define(d);
+}
+
+void MacroTable::define(const MacroDefinition &definition)
+{
+  MacroDefinition d = definition;
+  d.params = _arena.intern(d.params, d.params + d.numParams);
+  d.body = _arena.intern(d.body, d.body + d.bodyLength);
+  _define(d);
+}
+
+std::vector<MacroDefinition> MacroTable::definitions() const
+{
+  std::vector<MacroDefinition> definitions;
+  for (const Slot &slot: _slots) {
+    if (slot.name != EmptySlot  &&  slot.name != DeletedSlot)
+      definitions.push_back(slot.definition);
+  }
+  return definitions;
+}
+
+void MacroTable::_define(const MacroDefinition &d)
+{
+  if (const MacroDefinition *old = find(d.name)) {
+    if (old->dynamic  ||  old->functionLike != d.functionLike  ||  old->variadic != d.variadic  ||  old->numParams != d.numParams
+        ||  old->params != d.params  ||  old->body != d.body)
+      throw std::runtime_error("macro redefined");
+    return;
+  }
+  _insert(d);
+  _generation++;
+}
+
+void MacroTable::defineDynamic(uint32_t name)
+{
+  MacroDefinition d = MacroDefinition();
+  d.name = name;
+  d.dynamic = true;
+  if (find(name))
+    throw std::runtime_error("macro redefined");
+  _insert(d);
+  _generation++;
+}
+
+void MacroTable::undef(const MacroToken *first, const MacroToken *last)
+{
+  const MacroToken *p = first;
+  if (!isIdentifier(p, last))
+    throw std::runtime_error("expected identifier");
+  if (p->spelling == SpellingTable::VaArgs)
+    throw std::runtime_error("invalid __VA_ARGS__ use");
+  if (p + 1 != last)
+    throw std::runtime_error("expected new line");
+
+  Slot &slot = _slots[_probe(p->spelling)];
+  if (slot.name == p->spelling) {
+    slot.name = DeletedSlot;
+    _size--;
+    _deleted++;
+    _generation++;
+  }
+}
+
+void MacroTable::_insert(const MacroDefinition &definition)
+{
+  if (2 * (_size + _deleted + 1) > _slots.size())
+    _rehash(4 * (_size + 1) > _slots.size() ? 2 * _slots.size() : _slots.size());
+
+  Slot &slot = _slots[_probe(definition.name)];
+  slot.name = definition.name;
+  slot.definition = definition;
+  _size++;
+}
+
+void MacroTable::_rehash(size_t capacity)
+{
+  std::vector<Slot> slots(capacity, Slot{EmptySlot, MacroDefinition()});
+  slots.swap(_slots);
+  _size = 0;
+  _deleted = 0;
+  for (const Slot &slot: slots) {
+    if (slot.name != EmptySlot  &&  slot.name != DeletedSlot)
+      _insert(slot.definition);
+  }
+}
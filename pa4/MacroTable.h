@@ -0,0 +1,98 @@
+#ifndef MacroTable_h
+#define MacroTable_h
+
+#include "MacroToken.h"
+#include "TokenArena.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct MacroDefinition {
+  uint32_t name;                // spelling id
+  bool functionLike;
+  bool variadic;
+  bool hasOperators;            // a # or ## in the replacement list
+  bool dynamic;                 // replaced by a DynamicMacroIfc, such as __LINE__
+  uint16_t numParams;           // __VA_ARGS__ included
+  const MacroToken *params;     // interned in the arena
+  const MacroToken *body;       // interned in the arena, roles set
+  uint32_t bodyLength;
+};
+
+// The currently defined macros.
+//
+// An open-addressing table with linear probing, keyed by the spelling id of
+// the name; #undef leaves a tombstone. The parameter and replacement lists of
+// a definition are interned in a TokenArena, so a redefinition is checked by
+// comparing two pointers per list, and redefining a macro identically, as
+// every header included twice does, stores nothing.
+class MacroTable {
+public:
+  explicit MacroTable(SpellingTable &spellings);
+
+  // Parses and applies the rest of a #define or #undef directive, the tokens
+  // after `define` or `undef`. Throws std::runtime_error on errors, and when a
+  // macro is redefined differently.
+  void define(const MacroToken *first, const MacroToken *last);
+  void undef(const MacroToken *first, const MacroToken *last);
+
+  // Defines a macro already parsed, by this table or another one; its lists
+  // are interned in this table's arena. Throws like define().
+  void define(const MacroDefinition &definition);
+
+  // Defines `name` as an object-like macro whose replacement is given by the
+  // DynamicMacroIfc of the expander when it is invoked.
+  void defineDynamic(uint32_t name);
+
+  // nullptr if `name` is not a macro.
+  const MacroDefinition *find(uint32_t name) const
+  {
+    const Slot &slot = _slots[_probe(name)];
+    return slot.name == name ? &slot.definition : nullptr;
+  }
+
+  // The defined macros, in no particular order.
+  std::vector<MacroDefinition> definitions() const;
+
+  size_t size() const { return _size; }
+  const TokenArena &arena() const { return _arena; }
+
+  // Changes whenever a macro is defined or undefined, but not when one is
+  // redefined identically.
+  uint64_t generation() const { return _generation; }
+
+private:
+  static const uint32_t EmptySlot = 0xFFFFFFFF;
+  static const uint32_t DeletedSlot = 0xFFFFFFFE;
+
+  struct Slot {
+    uint32_t name;
+    MacroDefinition definition;
+  };
+
+  // The slot holding `name`, or else the empty slot ending its probe sequence.
+  size_t _probe(uint32_t name) const
+  {
+    const size_t mask = _slots.size() - 1;
+    for (size_t i = (name * 0x9E3779B1u) & mask; ; i = (i + 1) & mask) {
+      if (_slots[i].name == name  ||  _slots[i].name == EmptySlot)
+        return i;
+    }
+  }
+
+  void _define(const MacroDefinition &definition);
+  void _insert(const MacroDefinition &definition);
+  void _rehash(size_t capacity);
+
+  SpellingTable &_spellings;
+  std::vector<Slot> _slots;     // a power of 2, at most half full with tombstones
+  size_t _size;
+  size_t _deleted;
+  uint64_t _generation;
+  TokenArena _arena;
+  std::vector<MacroToken> _params;      // scratch of define()
+  std::vector<MacroToken> _body;
+};
+
+#endif /* end of include guard */
@@ -0,0 +1,136 @@
+#include "MacroToken.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+  // FNV-1a
+  uint32_t hashBytes(const char *p, size_t length)
+  {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+      h ^= static_cast<unsigned char>(p[i]);
+      h *= 16777619u;
+    }
+    return h;
+  }
+
+  // The room of reserve(), one per thread for all tables.
+  thread_local std::vector<char> reserved;
+
+} // namespace
+
+const size_t SpellingTable::BlockSize;
+const uint32_t SpellingTable::EmptySlot;
+const size_t SpellingTable::NumShards;
+const size_t SpellingTable::FirstChunk;
+const size_t SpellingTable::NumChunks;
+
+SpellingTable::SpellingTable():
+  _size(0)
+{
+  for (Shard &shard: _shards) {
+    shard.slots.assign(64, EmptySlot);
+    shard.size = 0;
+    shard.free = nullptr;
+    shard.freeEnd = nullptr;
+  }
+  for (std::atomic<Entry *> &chunk: _chunks)
+    chunk.store(nullptr, std::memory_order_relaxed);
+
+  for (const char *s: {"", "(", ")", ",", "...", "#", "%:", "##", "%:%:", "__VA_ARGS__", "define", "undef"})
+    intern(s);
+}
+
+SpellingTable::~SpellingTable()
+{
+  for (std::atomic<Entry *> &chunk: _chunks)
+    delete[] chunk.load(std::memory_order_relaxed);
+}
+
+uint32_t SpellingTable::intern(const char *p, size_t length)
+{
+  const uint32_t h = hashBytes(p, length);
+  // The high bits pick the shard, the low bits the slot.
+  Shard &shard = _shards[h >> 28];
+  std::lock_guard<std::mutex> lock(shard.mutex);
+
+  const size_t mask = shard.slots.size() - 1;
+  size_t i = h & mask;
+  for (; shard.slots[i] != EmptySlot; i = (i + 1) & mask) {
+    const Entry &e = _entry(shard.slots[i]);
+    if (e.hash == h  &&  e.length == length  &&  std::memcmp(e.data, p, length) == 0)
+      return shard.slots[i];
+  }
+
+  const uint32_t id = _size.fetch_add(1, std::memory_order_acq_rel);
+  _set(id, Entry{_store(shard, p, length), static_cast<uint32_t>(length), h});
+  shard.slots[i] = id;
+  if (2 * ++shard.size > shard.slots.size())
+    _rehash(shard);
+  return id;
+}
+
+char *SpellingTable::reserve(size_t length)
+{
+  if (reserved.size() < length)
+    reserved.resize(std::max(length, 2 * reserved.size()));
+  return reserved.data();
+}
+
+uint32_t SpellingTable::commit(size_t length)
+{
+  return intern(reserved.data(), length);
+}
+
+const char *SpellingTable::_store(Shard &shard, const char *p, size_t length)
+{
+  char *q;
+  // A spelling larger than a quarter block gets a block of its own.
+  if (length > BlockSize / 4) {
+    shard.large.emplace_back(new char[length]);
+    q = shard.large.back().get();
+  } else {
+    if (!shard.free  ||  static_cast<size_t>(shard.freeEnd - shard.free) < length) {
+      shard.blocks.emplace_back(new char[BlockSize]);
+      shard.free = shard.blocks.back().get();
+      shard.freeEnd = shard.free + BlockSize;
+    }
+    q = shard.free;
+    shard.free += length;
+  }
+  std::memcpy(q, p, length);
+  return q;
+}
+
+void SpellingTable::_set(uint32_t id, const Entry &entry)
+{
+  size_t offset;
+  const size_t k = _chunk(id, offset);
+  Entry *chunk = _chunks[k].load(std::memory_order_acquire);
+  if (!chunk) {
+    std::lock_guard<std::mutex> lock(_chunkMutex);
+    chunk = _chunks[k].load(std::memory_order_acquire);
+    if (!chunk) {
+      chunk = new Entry[FirstChunk << k];
+      _chunks[k].store(chunk, std::memory_order_release);
+    }
+  }
+  chunk[offset] = entry;
+}
+
+void SpellingTable::_rehash(Shard &shard)
+{
+  std::vector<uint32_t> old(2 * shard.slots.size(), EmptySlot);
+  old.swap(shard.slots);
+  const size_t mask = shard.slots.size() - 1;
+  for (const uint32_t id: old) {
+    if (id == EmptySlot)
+      continue;
+    size_t i = _entry(id).hash & mask;
+    while (shard.slots[i] != EmptySlot)
+      i = (i + 1) & mask;
+    shard.slots[i] = id;
+  }
+}
@@ -0,0 +1,147 @@
+#ifndef MacroToken_h
+#define MacroToken_h
+
+#include "pa1/PPToken.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// The preprocessing-token of the macro engine: a small value with the
+// spelling and the hide set interned, so tokens are copied, compared and
+// hashed as integers. Whitespace and new-lines are not tokens, they only set
+// `precededBySpace` of the next token.
+
+// What a token of a replacement list stands for, settled by #define.
+enum class MacroTokenRole: uint8_t {
+  Plain,        // every token outside replacement lists
+  Parameter,    // `param` is the index of the parameter, __VA_ARGS__ is last
+  Stringize,    // the `#` before a parameter of a function-like macro
+  Paste,        // `##`
+};
+
+struct MacroToken {
+  uint32_t spelling;      // id in the SpellingTable
+  uint32_t hideSet;       // id in the HideSetTable, 0 is the empty set
+  PPTokenType type;
+  MacroTokenRole role;
+  bool precededBySpace;
+  uint16_t param;
+  uint32_t line;          // the source line, that of the head for the tokens an invocation produces
+
+  static MacroToken make(PPTokenType type, uint32_t spelling, bool precededBySpace, uint32_t line = 0)
+  { return MacroToken{spelling, 0, type, MacroTokenRole::Plain, precededBySpace, 0, line}; }
+};
+
+// Interns spellings.
+//
+// The bytes of all spellings live in arenas of blocks that never move. Besides
+// interning a finished string, a spelling can be built in place: reserve()
+// returns room of the calling thread, and commit() interns the bytes written
+// there, copying them to an arena only if the spelling is new. Stringizing
+// and pasting build their spellings this way, without a temporary string.
+//
+// One table may be shared by threads, all members are safe to call
+// concurrently. The index is split into shards by hash, each an
+// open-addressing table of ids with its own lock and arena, so threads
+// interning different spellings rarely wait for each other. Entries are kept
+// in chunks that never move, so data() and length() take no lock; an id may
+// be looked up on any thread that got it from intern() or commit(), or from
+// such a thread through a lock or a join.
+//
+// The ids below are interned first, in this order, so the engine compares
+// against them directly.
+class SpellingTable {
+public:
+  enum WellKnown: uint32_t {
+    Placemarker,      // the empty spelling
+    LParen,
+    RParen,
+    Comma,
+    Ellipsis,
+    Hash,
+    HashAlt,          // %:
+    HashHash,
+    HashHashAlt,      // %:%:
+    VaArgs,
+    Define,
+    Undef,
+  };
+
+  SpellingTable();
+  ~SpellingTable();
+
+  SpellingTable(const SpellingTable &) = delete;
+  SpellingTable &operator=(const SpellingTable &) = delete;
+
+  uint32_t intern(const char *p, size_t length);
+  uint32_t intern(const std::string &spelling) { return intern(spelling.data(), spelling.size()); }
+
+  // Room for `length` bytes, private to the calling thread and valid until
+  // its next reserve() or commit().
+  char *reserve(size_t length);
+  // Interns the first `length` bytes written to the room of reserve().
+  uint32_t commit(size_t length);
+
+  const char *data(uint32_t id) const { return _entry(id).data; }
+  size_t length(uint32_t id) const { return _entry(id).length; }
+  std::string spelling(uint32_t id) const { return std::string(data(id), length(id)); }
+  size_t size() const { return _size.load(std::memory_order_acquire); }
+
+  static bool isHash(uint32_t id) { return id == Hash  ||  id == HashAlt; }
+  static bool isHashHash(uint32_t id) { return id == HashHash  ||  id == HashHashAlt; }
+
+private:
+  static const size_t BlockSize = 64 << 10;
+  static const uint32_t EmptySlot = 0xFFFFFFFF;
+  static const size_t NumShards = 16;
+  // Chunk k holds FirstChunk << k entries, enough chunks for every uint32_t.
+  static const size_t FirstChunk = 1024;
+  static const size_t NumChunks = 23;
+
+  struct Entry {
+    const char *data;
+    uint32_t length;
+    uint32_t hash;
+  };
+
+  struct Shard {
+    std::mutex mutex;
+    std::vector<uint32_t> slots;                  // ids, a power of 2, at most half full
+    size_t size;
+    std::vector<std::unique_ptr<char[]>> blocks;  // of BlockSize bytes
+    std::vector<std::unique_ptr<char[]>> large;   // one spelling each
+    char *free;                                   // the unused end of the last block
+    char *freeEnd;
+  };
+
+  static size_t _chunk(uint32_t id, size_t &offset)
+  {
+    const uint64_t n = id / FirstChunk + 1;
+    const size_t k = 63 - __builtin_clzll(n);
+    offset = id - FirstChunk * ((uint64_t(1) << k) - 1);
+    return k;
+  }
+
+  const Entry &_entry(uint32_t id) const
+  {
+    size_t offset;
+    const size_t k = _chunk(id, offset);
+    return _chunks[k].load(std::memory_order_acquire)[offset];
+  }
+
+  const char *_store(Shard &shard, const char *p, size_t length);
+  void _set(uint32_t id, const Entry &entry);
+  void _rehash(Shard &shard);
+
+  Shard _shards[NumShards];
+  std::atomic<Entry *> _chunks[NumChunks];
+  std::atomic<uint32_t> _size;
+  std::mutex _chunkMutex;
+};
+
+#endif /* end of include guard */
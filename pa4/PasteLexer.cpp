@@ -0,0 +1,179 @@
+#include "PasteLexer.h"
+
+#include "pa1/PPCodeUnitStream.h"
+#include "pa1/PPTokenizerDFA.h"
+#include "pa1/PPUTF32Stream.h"
+
+#include <cstring>
+#include <memory>
+#include <string>
+
+namespace {
+
+  enum CharClass: uint8_t {
+    Other,
+    Digit,
+    Nondigit,       // A-Z a-z _
+    Dot,
+    Punctuation,    // the other characters of preprocessing-op-or-puncs
+    Slow,           // quotes, backslash and non-ASCII bytes
+  };
+
+  struct CharClassTable {
+    CharClass c[256];
+
+    CharClassTable()
+    {
+      for (int i = 0; i < 256; i++)
+        c[i] = i >= 0x80 ? Slow : Other;
+      for (int i = '0'; i <= '9'; i++)
+        c[i] = Digit;
+      for (int i = 'a'; i <= 'z'; i++)
+        c[i] = c[i - 'a' + 'A'] = Nondigit;
+      c[static_cast<unsigned char>('_')] = Nondigit;
+      c[static_cast<unsigned char>('.')] = Dot;
+      for (const char *p = "{}[]#()<>%:;?*+-/^&|~!=,"; *p; ++p)
+        c[static_cast<unsigned char>(*p)] = Punctuation;
+      for (const char *p = "'\"\\"; *p; ++p)
+        c[static_cast<unsigned char>(*p)] = Slow;
+    }
+  };
+
+  const CharClassTable charClasses;
+
+  CharClass charClass(char c)
+  {
+    return charClasses.c[static_cast<unsigned char>(c)];
+  }
+
+  // The preprocessing-op-or-puncs (2.13); the ones spelled like identifiers
+  // are listed separately.
+  const char *const Punctuators[] = {
+    "{", "}", "[", "]", "#", "##", "(", ")", "<:", ":>", "<%", "%>", "%:", "%:%:", ";", ":", "...",
+    "?", "::", ".", ".*", "+", "-", "*", "/", "%", "^", "&", "|", "~", "!", "=", "<", ">", "+=",
+    "-=", "*=", "/=", "%=", "^=", "&=", "|=", "<<", ">>", ">>=", "<<=", "==", "!=", "<=", ">=",
+    "&&", "||", "++", "--", ",", "->*", "->",
+  };
+
+  const char *const IdentifierPunctuators[] = {
+    "new", "delete", "and", "and_eq", "bitand", "bitor", "compl", "not", "not_eq", "or", "or_eq",
+    "xor", "xor_eq",
+  };
+
+  template <size_t N>
+  bool isOneOf(const char *const (&table)[N], const char *p, size_t length)
+  {
+    for (const char *s: table) {
+      if (s[0] == p[0]  &&  std::strlen(s) == length  &&  std::memcmp(s, p, length) == 0)
+        return true;
+    }
+    return false;
+  }
+
+  enum class Result {
+    Token,
+    NotOneToken,
+    Slow,
+  };
+
+  Result lexIdentifier(const char *p, size_t length, PPTokenType &type)
+  {
+    for (size_t i = 1; i < length; i++) {
+      const CharClass c = charClass(p[i]);
+      if (c == Slow)
+        return Result::Slow;
+      if (c != Digit  &&  c != Nondigit)
+        return Result::NotOneToken;
+    }
+    type = isOneOf(IdentifierPunctuators, p, length) ? PPTokenType::PreprocessingOpOrPunc : PPTokenType::Identifier;
+    return Result::Token;
+  }
+
+  // pp-number: digit or . digit, then digits, identifier-nondigits, dots and
+  // the signs after e or E.
+  Result lexNumber(const char *p, size_t length, PPTokenType &type)
+  {
+    for (size_t i = 1; i < length; i++) {
+      const CharClass c = charClass(p[i]);
+      if (c == Digit  ||  c == Dot)
+        continue;
+      if (c == Nondigit) {
+        if ((p[i] == 'e'  ||  p[i] == 'E')  &&  i + 1 < length  &&  (p[i + 1] == '+'  ||  p[i + 1] == '-'))
+          i++;
+        continue;
+      }
+      return c == Slow ? Result::Slow : Result::NotOneToken;
+    }
+    type = PPTokenType::PPNumber;
+    return Result::Token;
+  }
+
+  Result lexPunctuator(const char *p, size_t length, PPTokenType &type)
+  {
+    for (size_t i = 0; i < length; i++) {
+      if (charClass(p[i]) == Slow)
+        return Result::Slow;
+    }
+    if (isOneOf(Punctuators, p, length)) {
+      type = PPTokenType::PreprocessingOpOrPunc;
+      return Result::Token;
+    }
+    // Any other single character, such as @ or $.
+    if (length == 1  &&  charClass(p[0]) == Other  &&  p[0] > ' ') {
+      type = PPTokenType::NonWhitespaceChar;
+      return Result::Token;
+    }
+    return Result::NotOneToken;
+  }
+
+} // namespace
+
+bool PasteLexer::lex(const char *p, size_t length, PPTokenType &type)
+{
+  if (length == 0)
+    return false;
+
+  Result r;
+  switch (charClass(p[0])) {
+    case Nondigit:
+      r = lexIdentifier(p, length, type);
+      break;
+    case Digit:
+      r = lexNumber(p, length, type);
+      break;
+    case Dot:
+      r = length > 1  &&  charClass(p[1]) == Digit ? lexNumber(p, length, type) : lexPunctuator(p, length, type);
+      break;
+    case Punctuation:
+    case Other:
+      r = lexPunctuator(p, length, type);
+      break;
+    default:
+      r = Result::Slow;
+      break;
+  }
+
+  if (r == Result::Slow)
+    return lexWithDFA(p, length, type);
+  return r == Result::Token;
+}
+
+bool PasteLexer::lexWithDFA(const char *p, size_t length, PPTokenType &type)
+{
+  auto u32s = std::make_shared<PPUTF32Stream>(std::string(p, length));
+  auto cus = std::make_shared<PPCodeUnitStream>(u32s);
+  PPTokenizerDFA dfa(cus);
+
+  size_t n = 0;
+  for (; !dfa.isEmpty(); dfa.toNext()) {
+    if (!dfa.getErrorMessage().empty())
+      return false;
+    const std::shared_ptr<PPToken> token = dfa.getPPToken();
+    if (token->getType() == PPTokenType::NewLine)
+      continue;
+    if (token->getType() == PPTokenType::WhitespaceSequence  ||  n++ != 0)
+      return false;
+    type = token->getType();
+  }
+  return n == 1;
+}
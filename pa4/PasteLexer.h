@@ -0,0 +1,25 @@
+#ifndef PasteLexer_h
+#define PasteLexer_h
+
+#include "pa1/PPToken.h"
+
+#include <cstddef>
+
+// Lexes the spelling made by the ## operator, which must be exactly one
+// preprocessing-token (16.3.3/3).
+//
+// Identifiers, pp-numbers and preprocessing-op-or-puncs, which are nearly all
+// pastes, are classified with a table of ASCII character classes and a table
+// of punctuators. Spellings with quotes or non-ASCII bytes, i.e. literals and
+// identifiers with extended characters, are left to PPTokenizerDFA, so the
+// result is always the one of the PA1 tokenizer.
+class PasteLexer {
+public:
+  // False unless [p, p + length) is a single preprocessing-token.
+  static bool lex(const char *p, size_t length, PPTokenType &type);
+
+  // The same with PPTokenizerDFA only.
+  static bool lexWithDFA(const char *p, size_t length, PPTokenType &type);
+};
+
+#endif /* end of include guard */
@@ -0,0 +1,68 @@
+#include "TokenArena.h"
+
+#include <algorithm>
+
+namespace {
+
+  bool equalTokens(const MacroToken &a, const MacroToken &b)
+  {
+    return a.spelling == b.spelling  &&  a.type == b.type  &&  a.role == b.role
+        &&  a.param == b.param  &&  a.precededBySpace == b.precededBySpace;
+  }
+
+  // FNV-1a over the fields equalTokens() compares.
+  uint64_t hashTokens(const MacroToken *first, const MacroToken *last)
+  {
+    uint64_t h = 14695981039346656037ull;
+    auto mix = [&h](uint64_t v) {
+      h ^= v;
+      h *= 1099511628211ull;
+    };
+    for (; first != last; ++first) {
+      mix(first->spelling);
+      mix(static_cast<uint64_t>(first->type) << 24 | static_cast<uint64_t>(first->role) << 16 | first->param);
+      mix(first->precededBySpace);
+    }
+    return h;
+  }
+
+} // namespace
+
+const size_t TokenArena::BlockSize;
+
+const MacroToken *TokenArena::intern(const MacroToken *first, const MacroToken *last)
+{
+  const size_t n = last - first;
+  const uint64_t h = hashTokens(first, last);
+  const auto range = _index.equal_range(h);
+  for (auto it = range.first; it != range.second; ++it) {
+    const MacroToken *span = it->second.first;
+    if (it->second.second == n  &&  std::equal(first, last, span, equalTokens))
+      return span;
+  }
+
+  MacroToken *span = _allocate(n);
+  std::copy(first, last, span);
+  _index.emplace(h, std::make_pair(span, n));
+  return span;
+}
+
+MacroToken *TokenArena::_allocate(size_t n)
+{
+  // A span larger than a quarter block gets a block of its own, so that the
+  // rest of the current block is not wasted.
+  if (n > BlockSize / 4) {
+    _large.emplace_back(new MacroToken[n]);
+    _bytes += n * sizeof(MacroToken);
+    return _large.back().get();
+  }
+
+  if (_blocks.empty()  ||  _used + n > BlockSize) {
+    _blocks.emplace_back(new MacroToken[BlockSize]);
+    _bytes += BlockSize * sizeof(MacroToken);
+    _used = 0;
+  }
+  MacroToken *span = _blocks.back().get() + _used;
+  _used += n;
+  return span;
+}
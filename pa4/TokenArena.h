@@ -0,0 +1,42 @@
+#ifndef TokenArena_h
+#define TokenArena_h
+
+#include "MacroToken.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Append-only storage of immutable token spans, such as the parameter and
+// replacement lists of macro definitions.
+//
+// Tokens live in blocks that never move, so a span is a plain pointer that
+// stays valid for the life of the arena. Spans are hash-consed: interning a
+// token sequence equal to one already stored returns the stored span, so two
+// spans are equal iff their pointers are. Equality covers the spelling, the
+// type, the role, the parameter index and `precededBySpace`.
+class TokenArena {
+public:
+  TokenArena(): _used(0), _bytes(0) {}
+
+  // The stored span equal to [first, last). Empty sequences share one span.
+  const MacroToken *intern(const MacroToken *first, const MacroToken *last);
+
+  // Bytes of token storage allocated.
+  size_t bytes() const { return _bytes; }
+
+private:
+  static const size_t BlockSize = 4096;
+
+  MacroToken *_allocate(size_t n);
+
+  std::vector<std::unique_ptr<MacroToken[]>> _blocks;   // of BlockSize tokens
+  std::vector<std::unique_ptr<MacroToken[]>> _large;    // one span each
+  size_t _used;                   // tokens used in the last block
+  size_t _bytes;
+  std::unordered_multimap<uint64_t, std::pair<const MacroToken *, size_t>> _index;
+};
+
+#endif /* end of include guard */
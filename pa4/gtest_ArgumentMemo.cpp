@@ -0,0 +1,85 @@
+#include "ArgumentMemo.h"
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace {
+
+  std::vector<MacroToken> tokens(std::initializer_list<uint32_t> spellings)
+  {
+    std::vector<MacroToken> v;
+    for (uint32_t s: spellings)
+      v.push_back(MacroToken::make(PPTokenType::Identifier, s, false));
+    return v;
+  }
+
+  bool find(ArgumentMemo &memo, uint64_t generation, const std::vector<MacroToken> &arg, std::vector<MacroToken> &expanded)
+  {
+    const MacroToken *first;
+    const MacroToken *last;
+    if (!memo.find(generation, ArgumentMemo::hash(arg.data(), arg.data() + arg.size()), arg.data(), arg.data() + arg.size(), first, last))
+      return false;
+    expanded.assign(first, last);
+    return true;
+  }
+
+  void insert(ArgumentMemo &memo, uint64_t generation, const std::vector<MacroToken> &arg, const std::vector<MacroToken> &expanded)
+  {
+    memo.insert(generation, ArgumentMemo::hash(arg.data(), arg.data() + arg.size()), arg.data(), arg.data() + arg.size(),
+                expanded.data(), expanded.data() + expanded.size());
+  }
+
+} // namespace
+
+TEST(ArgumentMemo, FindInsert)
+{
+  ArgumentMemo memo;
+  const std::vector<MacroToken> arg = tokens({20, 21});
+  const std::vector<MacroToken> expanded = tokens({30, 31, 32});
+  std::vector<MacroToken> out;
+
+  EXPECT_FALSE(find(memo, 1, arg, out));
+  insert(memo, 1, arg, expanded);
+  ASSERT_TRUE(find(memo, 1, arg, out));
+  EXPECT_EQ(3u, out.size());
+  EXPECT_EQ(32u, out[2].spelling);
+  EXPECT_EQ(1u, memo.hits());
+  EXPECT_EQ(1u, memo.misses());
+
+  // Equal spellings with another hide set or spacing are another argument.
+  std::vector<MacroToken> other = arg;
+  other[0].hideSet = 1;
+  EXPECT_FALSE(find(memo, 1, other, out));
+  other = arg;
+  other[1].precededBySpace = true;
+  EXPECT_FALSE(find(memo, 1, other, out));
+}
+
+TEST(ArgumentMemo, Generation)
+{
+  ArgumentMemo memo;
+  const std::vector<MacroToken> arg = tokens({20});
+  std::vector<MacroToken> out;
+  insert(memo, 1, arg, tokens({30}));
+  EXPECT_EQ(1u, memo.size());
+
+  // Another generation drops the entries of the old one.
+  EXPECT_FALSE(find(memo, 2, arg, out));
+  EXPECT_EQ(0u, memo.size());
+  EXPECT_EQ(0u, memo.bytes());
+}
+
+TEST(ArgumentMemo, MemoryBound)
+{
+  ArgumentMemo memo(1024);
+  std::vector<MacroToken> out;
+  for (uint32_t i = 0; i < 100; i++) {
+    insert(memo, 1, tokens({i}), tokens({i, i}));
+    EXPECT_LE(memo.bytes(), memo.maxBytes());
+  }
+  EXPECT_LT(memo.size(), 100u);
+  EXPECT_TRUE(find(memo, 1, tokens({99}), out));
+
+  // An entry larger than the bound is not kept.
+  insert(memo, 1, tokens({200}), std::vector<MacroToken>(100, tokens({1})[0]));
+  EXPECT_FALSE(find(memo, 1, tokens({200}), out));
+}
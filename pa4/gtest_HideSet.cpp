@@ -0,0 +1,53 @@
+#include "HideSet.h"
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace {
+
+  std::vector<uint32_t> elements(const HideSetTable &t, uint32_t set)
+  {
+    return std::vector<uint32_t>(t.begin(set), t.end(set));
+  }
+
+} // namespace
+
+TEST(HideSet, Insert)
+{
+  HideSetTable t;
+  EXPECT_EQ(1u, t.size());
+  EXPECT_FALSE(t.contains(HideSetTable::Empty, 7));
+
+  const uint32_t a = t.insert(HideSetTable::Empty, 7);
+  const uint32_t ab = t.insert(a, 3);
+  EXPECT_NE(HideSetTable::Empty, a);
+  EXPECT_TRUE(t.contains(ab, 3));
+  EXPECT_TRUE(t.contains(ab, 7));
+  EXPECT_FALSE(t.contains(ab, 5));
+  EXPECT_EQ((std::vector<uint32_t>{3, 7}), elements(t, ab));
+
+  // Inserting an element already there gives the same set.
+  EXPECT_EQ(ab, t.insert(ab, 7));
+}
+
+TEST(HideSet, Interned)
+{
+  HideSetTable t;
+  const uint32_t ab = t.insert(t.insert(HideSetTable::Empty, 1), 2);
+  const uint32_t ba = t.insert(t.insert(HideSetTable::Empty, 2), 1);
+  EXPECT_EQ(ab, ba);
+  EXPECT_EQ(4u, t.size());    // {}, {1}, {2}, {1, 2}
+}
+
+TEST(HideSet, Unite)
+{
+  HideSetTable t;
+  const uint32_t a = t.insert(t.insert(HideSetTable::Empty, 1), 5);
+  const uint32_t b = t.insert(t.insert(HideSetTable::Empty, 3), 5);
+  const uint32_t ab = t.unite(a, b);
+  EXPECT_EQ((std::vector<uint32_t>{1, 3, 5}), elements(t, ab));
+  EXPECT_EQ(ab, t.unite(b, a));
+  EXPECT_EQ(a, t.unite(a, HideSetTable::Empty));
+  EXPECT_EQ(a, t.unite(HideSetTable::Empty, a));
+  EXPECT_EQ(a, t.unite(a, a));
+  EXPECT_EQ(ab, t.unite(ab, a));
+}
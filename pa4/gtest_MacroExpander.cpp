@@ -0,0 +1,199 @@
+#include "MacroExpander.h"
+#include "pa1/PPCodeUnitStream.h"
+#include "pa1/PPTokenizerDFA.h"
+#include "pa1/PPUTF32Stream.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+  // Applies the #define and #undef lines of `source`, expands the rest as
+  // one text-sequence and returns the spellings of the result, each preceded
+  // by a space if precededBySpace is set.
+  class Expansion {
+  public:
+    Expansion(): _macros(_spellings), expander(_spellings, _macros, _hideSets) {}
+
+    std::string operator()(const std::string &source)
+    {
+      PPTokenizerDFA dfa(std::make_shared<PPCodeUnitStream>(std::make_shared<PPUTF32Stream>(source)));
+      std::vector<MacroToken> line;
+      std::vector<MacroToken> text;
+      bool space = false;
+      for (; !dfa.isEmpty(); dfa.toNext()) {
+        const std::shared_ptr<PPToken> t = dfa.getPPToken();
+        if (t->getType() == PPTokenType::NewLine) {
+          if (line.size() >= 2  &&  SpellingTable::isHash(line[0].spelling)  &&  line[1].spelling == SpellingTable::Undef)
+            _macros.undef(line.data() + 2, line.data() + line.size());
+          else if (line.size() >= 2  &&  SpellingTable::isHash(line[0].spelling))
+            _macros.define(line.data() + 2, line.data() + line.size());
+          else
+            text.insert(text.end(), line.begin(), line.end());
+          line.clear();
+          space = true;
+        } else if (t->getType() == PPTokenType::WhitespaceSequence) {
+          space = true;
+        } else {
+          line.push_back(MacroToken::make(t->getType(), _spellings.intern(t->getRawText()), space));
+          space = false;
+        }
+      }
+
+      std::vector<MacroToken> out;
+      expander.expand(text.data(), text.data() + text.size(), out);
+      std::string s;
+      for (const MacroToken &t: out)
+        s += (t.precededBySpace && !s.empty() ? " " : "") + _spellings.spelling(t.spelling);
+      return s;
+    }
+
+    uint32_t id(const std::string &spelling) { return _spellings.intern(spelling); }
+
+  private:
+    SpellingTable _spellings;
+    HideSetTable _hideSets;
+    MacroTable _macros;
+
+  public:
+    MacroExpander expander;
+  };
+
+  std::string expand(const std::string &source)
+  {
+    return Expansion()(source);
+  }
+
+} // namespace
+
+TEST(MacroExpander, ObjectLike)
+{
+  EXPECT_EQ("x", expand("x\n"));
+  EXPECT_EQ("int table[100];", expand("#define TABSIZE 100\nint table[TABSIZE];\n"));
+  EXPECT_EQ("1 + 2 + 2", expand("#define a 1 + b\n#define b 2\na + b\n"));
+  EXPECT_EQ("x", expand("#define empty\nempty x empty\n"));
+}
+
+TEST(MacroExpander, FunctionLike)
+{
+  EXPECT_EQ("((2) > (3) ? (2) : (3))", expand("#define max(a, b) ((a) > (b) ? (a) : (b))\nmax(2,3)\n"));
+  EXPECT_EQ("(a,b) c", expand("#define f(x,y) x y\nf((a,b),c)\n"));
+  EXPECT_EQ("f", expand("#define f(x) x\nf\n"));
+  EXPECT_EQ("1", expand("#define f(x) x\nf\n(1)\n"));
+  // The ( may come from the replacement of a macro, and the ) from the rest.
+  EXPECT_EQ("1", expand("#define f(x) x\n#define g f(\ng 1)\n"));
+  EXPECT_EQ("1 2 b", expand("#define f(x) 1 x (\n#define g(x) 2 x\nf(g)b)\n"));
+  EXPECT_EQ("[[[1]]]", expand("#define e(x) [x]\ne(e(e(1)))\n"));
+}
+
+// The traces of the PA4 notes.
+TEST(MacroExpander, Nesting)
+{
+  EXPECT_EQ("1 2 f(1 2 f(x))", expand("#define f(x) 1 g(x)\n#define g(x) 2 f(x)\nf(f(x))\n"));
+  EXPECT_EQ("1 z[0]", expand("#define z z[0]\n#define f(x) 1 x\nf(z)\n"));
+  EXPECT_EQ("2 1 g(3)", expand("#define f(x) 1 x\n#define g(x) 2 x\ng(f)(g)(3)\n"));
+  EXPECT_EQ("a", expand("#define a b\n#define b a\na\n"));
+  EXPECT_EQ("1 2 3 g", expand("#define g 1 h\n#define h 2 i\n#define i 3 g\ng\n"));
+}
+
+TEST(MacroExpander, Stringize)
+{
+  EXPECT_EQ("\"a \\\"b\\\\n\\\" 'c'\"", expand("#define f(x) #x\nf( a  \"b\\n\" 'c'  )\n"));
+  EXPECT_EQ("\"\"", expand("#define f(x) #x\nf(  )\n"));
+  EXPECT_EQ("\"2, 3 ,4\"", expand("#define f(x,...) #__VA_ARGS__\nf(1,2, 3 ,4)\n"));
+  EXPECT_EQ("\"[a]\"", expand("#define f(x) [x]\n#define g(x) #x\n#define h(x) g(x)\nh(f( a ))\n"));
+  // # is an operator only in function-like macros.
+  EXPECT_EQ("a#x", expand("#define f a#x\nf\n"));
+}
+
+TEST(MacroExpander, Paste)
+{
+  EXPECT_EQ("23, 4, 5,", expand("#define r(x,y) x ## y\nr(2,3), r(4,), r(,5), r(,)\n"));
+  EXPECT_EQ("\"x ## y\"", expand("#define hash_hash # ## #\n#define mkstr(a) # a\n#define in_between(a) mkstr(a)\n"
+                                 "#define join(c, d) in_between(c hash_hash d)\njoin(x, y)\n"));
+  EXPECT_EQ("aba", expand("#define f(x, y) x ## y ## x\nf(a,b) f(,)\n"));
+  EXPECT_EQ("1e3 ->", expand("#define cat(a,b) a##b\ncat(1,e3) cat(-,>)\n"));
+  // A pasted token keeps the hide sets of its operands.
+  EXPECT_EQ("z w", expand("#define z z w\n#define cat(a,b) a ## b\n#define id(x) cat(,x)\nid(z)\n"));
+  EXPECT_THROW(expand("#define cat(a,b) a##b\ncat(+,-)\n"), std::runtime_error);
+}
+
+TEST(MacroExpander, VariableArguments)
+{
+  EXPECT_EQ("fprintf(stderr, \"X = %d\\n\", x);",
+            expand("#define debug(...) fprintf(stderr, __VA_ARGS__)\ndebug(\"X = %d\\n\", x);\n"));
+  EXPECT_EQ("", expand("#define f(...) __VA_ARGS__\nf()\n"));
+}
+
+TEST(MacroExpander, Errors)
+{
+  EXPECT_THROW(expand("#define f(x) x\nf(\n"), std::runtime_error);
+  EXPECT_THROW(expand("#define f(x,y) x\nf(1)\n"), std::runtime_error);
+  EXPECT_THROW(expand("#define f() x\nf(1)\n"), std::runtime_error);
+  EXPECT_THROW(expand("#define g(x,...) x __VA_ARGS__\ng(1)\n"), std::runtime_error);
+  EXPECT_THROW(expand("__VA_ARGS__\n"), std::runtime_error);
+
+  // The expander recovers from an error.
+  Expansion e;
+  EXPECT_THROW(e("#define f(x) x\nf(\n"), std::runtime_error);
+  EXPECT_EQ("1", e("f(1)\n"));
+}
+
+TEST(MacroExpander, ArgumentMemo)
+{
+  Expansion e;
+  EXPECT_EQ("[1] [1] [1]", e("#define one 1\n#define f(x) [x]\nf(one) f(one) f( one)\n"));
+  // The second f(one) hits; the third has other spacing.
+  EXPECT_EQ(1u, e.expander.memo().hits());
+  EXPECT_EQ(2u, e.expander.memo().misses());
+
+  // Arguments naming no macro, and operands of # and ##, are not expanded.
+  EXPECT_EQ("[x] \"one\" one2", e("#define s(x) #x\n#define c(x) x ## 2\nf(x) s(one) c(one)\n"));
+  EXPECT_EQ(1u, e.expander.memo().hits());
+  EXPECT_EQ(2u, e.expander.memo().misses());
+
+  // A new definition is a new generation.
+  EXPECT_EQ("[2]", e("#undef one\n#define one 2\nf(one)\n"));
+  EXPECT_EQ(3u, e.expander.memo().misses());
+}
+
+TEST(MacroExpander, Profiler)
+{
+  Expansion e;
+  MacroProfiler profiler;
+  e.expander.setProfiler(&profiler);
+  EXPECT_EQ("[1] [1] x", e("#define one 1\n#define f(x) [x]\n#define g f(one) f(one)\n#define empty\ng empty x\n"));
+
+  const std::vector<MacroProfiler::Stats> stats = profiler.stats(MacroProfiler::SortKey::Depth);
+  ASSERT_EQ(4u, stats.size());
+
+  // `one` is expanded as the argument of the first f only.
+  EXPECT_EQ(e.id("one"), stats[0].name);
+  EXPECT_EQ(1u, stats[0].invocations);
+  EXPECT_EQ(1u, stats[0].tokens);
+  EXPECT_EQ(3u, stats[0].maxDepth);
+
+  EXPECT_EQ(e.id("f"), stats[1].name);
+  EXPECT_EQ(2u, stats[1].invocations);
+  EXPECT_EQ(6u, stats[1].tokens);
+  EXPECT_EQ(2u, stats[1].maxDepth);
+  EXPECT_EQ(1u, stats[1].memoHits);
+
+  EXPECT_EQ(e.id("g"), stats[2].name);
+  EXPECT_EQ(8u, stats[2].tokens);
+  EXPECT_LE(stats[1].nanoseconds, stats[2].nanoseconds);
+
+  EXPECT_EQ(e.id("empty"), stats[3].name);
+  EXPECT_EQ(0u, stats[3].tokens);
+
+  // Every frame has ended.
+  EXPECT_EQ(5u, profiler.events());
+
+  // Frames left open by an error are dropped.
+  EXPECT_THROW(e("#define k (f(1, 2))\nk\n"), std::runtime_error);
+  EXPECT_EQ("[1]", e("f(1)\n"));
+  EXPECT_EQ(6u, profiler.events());
+  EXPECT_EQ(1u, profiler.stats(MacroProfiler::SortKey::Depth)[4].invocations);
+}
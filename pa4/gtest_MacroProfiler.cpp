@@ -0,0 +1,106 @@
+#include "MacroProfiler.h"
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+TEST(MacroProfiler, Frames)
+{
+  SpellingTable spellings;
+  const uint32_t a = spellings.intern("a");
+  const uint32_t b = spellings.intern("b");
+
+  // a pushes 3 tokens and invokes b, which pushes 2 tokens in a context
+  // above them.
+  MacroProfiler p;
+  p.begin(a);
+  p.open(0, 3);
+  p.begin(b);
+  p.memoHit();
+  p.open(1, 2);
+  p.popped(1);
+  EXPECT_EQ(1u, p.events());
+  p.popped(0);
+  EXPECT_EQ(2u, p.events());
+
+  // b again, invoked in the text-sequence, pushing nothing.
+  p.begin(b);
+  p.open(0, 0);
+  EXPECT_EQ(3u, p.events());
+
+  const std::vector<MacroProfiler::Stats> byCalls = p.stats(MacroProfiler::SortKey::Invocations);
+  ASSERT_EQ(2u, byCalls.size());
+  EXPECT_EQ(b, byCalls[0].name);
+  EXPECT_EQ(2u, byCalls[0].invocations);
+  EXPECT_EQ(2u, byCalls[0].tokens);
+  EXPECT_EQ(2u, byCalls[0].maxDepth);
+  EXPECT_EQ(1u, byCalls[0].memoHits);
+  EXPECT_EQ(a, byCalls[1].name);
+  EXPECT_EQ(1u, byCalls[1].maxDepth);
+  EXPECT_LE(byCalls[1].selfNanoseconds, byCalls[1].nanoseconds);
+
+  EXPECT_EQ(a, p.stats(MacroProfiler::SortKey::Tokens)[0].name);
+
+  std::ostringstream report;
+  p.writeReport(report, spellings, MacroProfiler::SortKey::Tokens);
+  EXPECT_NE(std::string::npos, report.str().find("calls"));
+  EXPECT_LT(report.str().find("  a\n"), report.str().find("  b\n"));
+
+  std::ostringstream trace;
+  p.writeTrace(trace, spellings);
+  EXPECT_EQ(0u, trace.str().find("{\"traceEvents\":["));
+  EXPECT_NE(std::string::npos, trace.str().find("{\"name\":\"b\",\"ph\":\"X\""));
+  EXPECT_NE(std::string::npos, trace.str().find("\"args\":{\"tokens\":2,\"depth\":2}"));
+}
+
+TEST(MacroProfiler, NestedSameMacro)
+{
+  // The argument of a invokes a again, as in a(a(1)).
+  MacroProfiler p;
+  p.begin(1);
+  p.begin(1);
+  p.open(0, 1);
+  p.popped(0);
+  p.open(0, 4);
+  p.popped(0);
+  const MacroProfiler::Stats s = p.stats(MacroProfiler::SortKey::Time)[0];
+  EXPECT_EQ(2u, s.invocations);
+  EXPECT_EQ(5u, s.tokens);
+  EXPECT_EQ(2u, s.maxDepth);
+  // Counted once in the total, as the outer frame contains the inner one.
+  EXPECT_EQ(s.nanoseconds, s.selfNanoseconds);
+}
+
+TEST(MacroProfiler, Limits)
+{
+  MacroProfiler p(1);
+  for (int i = 0; i < 3; i++) {
+    p.begin(0);
+    p.open(0, 0);
+  }
+  EXPECT_EQ(1u, p.events());
+  EXPECT_EQ(2u, p.droppedEvents());
+
+  // Abandoned frames are neither timed nor traced.
+  p.begin(0);
+  p.abandon();
+  p.popped(0);
+  EXPECT_EQ(4u, p.stats(MacroProfiler::SortKey::Time)[0].invocations);
+  EXPECT_EQ(2u, p.droppedEvents());
+
+  SpellingTable spellings;
+  std::ostringstream trace;
+  p.writeTrace(trace, spellings);
+  EXPECT_NE(std::string::npos, trace.str().find("\"droppedEvents\":2"));
+}
+
+TEST(MacroProfiler, SortKeys)
+{
+  MacroProfiler::SortKey key = MacroProfiler::SortKey::Time;
+  EXPECT_TRUE(MacroProfiler::parseSortKey("memo", key));
+  EXPECT_EQ(MacroProfiler::SortKey::MemoHits, key);
+  EXPECT_TRUE(MacroProfiler::parseSortKey("self", key));
+  EXPECT_EQ(MacroProfiler::SortKey::SelfTime, key);
+  EXPECT_FALSE(MacroProfiler::parseSortKey("size", key));
+  EXPECT_EQ(MacroProfiler::SortKey::SelfTime, key);
+}
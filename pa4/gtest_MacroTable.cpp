@@ -0,0 +1,179 @@
+#include "MacroTable.h"
+#include "pa1/PPCodeUnitStream.h"
+#include "pa1/PPTokenizerDFA.h"
+#include "pa1/PPUTF32Stream.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+  // The tokens of one line, with the whitespace flags set.
+  std::vector<MacroToken> lex(SpellingTable &spellings, const std::string &s)
+  {
+    PPTokenizerDFA dfa(std::make_shared<PPCodeUnitStream>(std::make_shared<PPUTF32Stream>(s)));
+    std::vector<MacroToken> tokens;
+    bool space = false;
+    for (; !dfa.isEmpty(); dfa.toNext()) {
+      const std::shared_ptr<PPToken> t = dfa.getPPToken();
+      if (t->getType() == PPTokenType::WhitespaceSequence  ||  t->getType() == PPTokenType::NewLine) {
+        space = true;
+        continue;
+      }
+      tokens.push_back(MacroToken::make(t->getType(), spellings.intern(t->getRawText()), space));
+      space = false;
+    }
+    return tokens;
+  }
+
+  // Defines the macro of `directive`, the text after `#define`.
+  void define(MacroTable &table, SpellingTable &spellings, const std::string &directive)
+  {
+    const std::vector<MacroToken> tokens = lex(spellings, directive);
+    table.define(tokens.data(), tokens.data() + tokens.size());
+  }
+
+  void expectError(const std::string &directive)
+  {
+    SpellingTable spellings;
+    MacroTable table(spellings);
+    EXPECT_THROW(define(table, spellings, directive), std::runtime_error) << directive;
+  }
+
+} // namespace
+
+TEST(MacroTable, Define)
+{
+  SpellingTable spellings;
+  MacroTable table(spellings);
+  define(table, spellings, "obj (1 + 2)");
+  define(table, spellings, "fn(a, b, ...) a # b ## __VA_ARGS__");
+
+  const MacroDefinition *obj = table.find(spellings.intern("obj"));
+  ASSERT_NE(nullptr, obj);
+  EXPECT_FALSE(obj->functionLike);
+  EXPECT_FALSE(obj->hasOperators);
+  EXPECT_EQ(5u, obj->bodyLength);
+  EXPECT_FALSE(obj->body[0].precededBySpace);
+
+  const MacroDefinition *fn = table.find(spellings.intern("fn"));
+  ASSERT_NE(nullptr, fn);
+  EXPECT_TRUE(fn->functionLike);
+  EXPECT_TRUE(fn->variadic);
+  EXPECT_TRUE(fn->hasOperators);
+  EXPECT_EQ(3u, fn->numParams);
+  ASSERT_EQ(5u, fn->bodyLength);
+  EXPECT_EQ(MacroTokenRole::Parameter, fn->body[0].role);
+  EXPECT_EQ(MacroTokenRole::Stringize, fn->body[1].role);
+  EXPECT_EQ(1u, fn->body[2].param);
+  EXPECT_EQ(MacroTokenRole::Paste, fn->body[3].role);
+  EXPECT_EQ(2u, fn->body[4].param);
+
+  EXPECT_EQ(nullptr, table.find(spellings.intern("a")));
+  EXPECT_EQ(2u, table.size());
+}
+
+TEST(MacroTable, Redefine)
+{
+  SpellingTable spellings;
+  MacroTable table(spellings);
+  define(table, spellings, "obj (1 - 1)");
+  const MacroToken *body = table.find(spellings.intern("obj"))->body;
+  const size_t bytes = table.arena().bytes();
+
+  // An identical redefinition, up to the amount of whitespace, stores nothing.
+  define(table, spellings, "obj   (1  -  1)  ");
+  EXPECT_EQ(body, table.find(spellings.intern("obj"))->body);
+  EXPECT_EQ(bytes, table.arena().bytes());
+
+  EXPECT_THROW(define(table, spellings, "obj (1-1)"), std::runtime_error);
+  EXPECT_THROW(define(table, spellings, "obj (0)"), std::runtime_error);
+
+  define(table, spellings, "fn(a) ( a )");
+  define(table, spellings, "fn( a ) ( a )");
+  EXPECT_THROW(define(table, spellings, "fn(b) ( b )"), std::runtime_error);
+  EXPECT_THROW(define(table, spellings, "fn(a, ...) ( a )"), std::runtime_error);
+
+  // Equal replacement lists are stored once, whatever the macro.
+  define(table, spellings, "other (1 - 1)");
+  EXPECT_EQ(body, table.find(spellings.intern("other"))->body);
+}
+
+TEST(MacroTable, Undef)
+{
+  SpellingTable spellings;
+  MacroTable table(spellings);
+
+  // Enough to grow the table and to probe past tombstones.
+  for (int i = 0; i < 200; i++)
+    define(table, spellings, "m" + std::to_string(i) + " " + std::to_string(i));
+  for (int i = 0; i < 200; i += 2) {
+    const std::vector<MacroToken> tokens = lex(spellings, "m" + std::to_string(i));
+    table.undef(tokens.data(), tokens.data() + tokens.size());
+  }
+  EXPECT_EQ(100u, table.size());
+  for (int i = 0; i < 200; i++) {
+    const MacroDefinition *m = table.find(spellings.intern("m" + std::to_string(i)));
+    ASSERT_EQ(i % 2 == 1, m != nullptr) << i;
+    if (m) {
+      EXPECT_EQ(std::to_string(i), spellings.spelling(m->body[0].spelling));
+    }
+  }
+
+  const std::vector<MacroToken> extra = lex(spellings, "m1 2");
+  EXPECT_THROW(table.undef(extra.data(), extra.data() + extra.size()), std::runtime_error);
+}
+
+TEST(MacroTable, Copy)
+{
+  SpellingTable spellings;
+  MacroTable table(spellings);
+  define(table, spellings, "obj (1 - 1)");
+  define(table, spellings, "fn(a, ...) #a __VA_ARGS__");
+  define(table, spellings, "gone 1");
+  const std::vector<MacroToken> gone = lex(spellings, "gone");
+  table.undef(gone.data(), gone.data() + gone.size());
+
+  MacroTable copy(spellings);
+  const std::vector<MacroDefinition> definitions = table.definitions();
+  ASSERT_EQ(2u, definitions.size());
+  for (const MacroDefinition &d: definitions)
+    copy.define(d);
+  EXPECT_EQ(2u, copy.size());
+  EXPECT_EQ(nullptr, copy.find(spellings.intern("gone")));
+
+  const MacroDefinition *fn = copy.find(spellings.intern("fn"));
+  ASSERT_NE(nullptr, fn);
+  EXPECT_TRUE(fn->functionLike  &&  fn->variadic  &&  fn->hasOperators);
+  EXPECT_EQ(2u, fn->numParams);
+  EXPECT_EQ(3u, fn->bodyLength);
+  EXPECT_EQ(MacroTokenRole::Stringize, fn->body[0].role);
+  EXPECT_NE(table.find(spellings.intern("fn"))->body, fn->body);
+
+  // The copy is interned in its own arena, so redefinitions compare as usual.
+  define(copy, spellings, "fn(a, ...) #a __VA_ARGS__");
+  EXPECT_THROW(define(copy, spellings, "obj (1-1)"), std::runtime_error);
+}
+
+// Errors as given by macro-ref.
+TEST(MacroTable, Errors)
+{
+  expectError("");
+  expectError("1");
+  expectError("A+");
+  expectError("__VA_ARGS__ C");
+  expectError("A __VA_ARGS__");
+  expectError("B() __VA_ARGS__");
+  expectError("X(a,) A");
+  expectError("X(a");
+  expectError("X(a b)");
+  expectError("X(... , a)");
+  expectError("X(x, x) x");
+  expectError("test(a) #b");
+  expectError("test(a) #");
+  expectError("x ## a");
+  expectError("x a ##");
+  expectError("f(x) ## x");
+}
@@ -0,0 +1,96 @@
+#include "MacroToken.h"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(SpellingTable, Intern)
+{
+  SpellingTable t;
+  EXPECT_EQ(uint32_t(SpellingTable::Placemarker), t.intern(""));
+  EXPECT_EQ(uint32_t(SpellingTable::HashHashAlt), t.intern("%:%:"));
+  EXPECT_EQ(uint32_t(SpellingTable::VaArgs), t.intern("__VA_ARGS__"));
+
+  const uint32_t a = t.intern("abc");
+  EXPECT_EQ(a, t.intern(std::string("abc")));
+  EXPECT_NE(a, t.intern("abd"));
+  EXPECT_EQ("abc", t.spelling(a));
+  EXPECT_EQ(3u, t.length(a));
+}
+
+TEST(SpellingTable, ReserveCommit)
+{
+  SpellingTable t;
+  const uint32_t a = t.intern("xy");
+  const size_t n = t.size();
+
+  // Only the committed prefix counts, and a known spelling gives its id.
+  char *p = t.reserve(10);
+  std::memcpy(p, "xyz", 3);
+  EXPECT_EQ(a, t.commit(2));
+  EXPECT_EQ(n, t.size());
+
+  p = t.reserve(10);
+  std::memcpy(p, "xyz", 3);
+  const uint32_t b = t.commit(3);
+  EXPECT_EQ(n + 1, t.size());
+  EXPECT_EQ("xyz", t.spelling(b));
+  EXPECT_EQ("xy", t.spelling(a));
+}
+
+// Large spellings and enough spellings to rehash and fill several blocks.
+TEST(SpellingTable, Growth)
+{
+  SpellingTable t;
+  const std::string large(100000, 'q');
+  char *p = t.reserve(large.size());
+  std::memcpy(p, large.data(), large.size());
+  const uint32_t l = t.commit(large.size());
+
+  // An uncommitted large reserve is dropped.
+  t.reserve(200000);
+
+  std::vector<uint32_t> ids;
+  for (int i = 0; i < 20000; i++)
+    ids.push_back(t.intern("spelling" + std::to_string(i)));
+  for (int i = 0; i < 20000; i++) {
+    ASSERT_EQ(ids[i], t.intern("spelling" + std::to_string(i)));
+    ASSERT_EQ("spelling" + std::to_string(i), t.spelling(ids[i]));
+  }
+  EXPECT_EQ(l, t.intern(large));
+  EXPECT_EQ(large, t.spelling(l));
+}
+
+// Threads interning overlapping spellings agree on every id.
+TEST(SpellingTable, Concurrent)
+{
+  SpellingTable t;
+  const int numThreads = 8;
+  const int numSpellings = 5000;
+  std::vector<std::vector<uint32_t>> ids(numThreads);
+  std::vector<std::thread> threads;
+  for (int k = 0; k < numThreads; k++) {
+    threads.emplace_back([&t, &ids, k]() {
+      for (int i = 0; i < numSpellings; i++) {
+        // Half the threads build the spelling in place.
+        const std::string s = "s" + std::to_string((i * 7 + k) % numSpellings);
+        if (k % 2) {
+          std::memcpy(t.reserve(s.size()), s.data(), s.size());
+          ids[k].push_back(t.commit(s.size()));
+        } else {
+          ids[k].push_back(t.intern(s));
+        }
+        ASSERT_EQ(s, t.spelling(ids[k].back()));
+      }
+    });
+  }
+  for (std::thread &thread: threads)
+    thread.join();
+
+  EXPECT_EQ(12u + numSpellings, t.size());
+  for (int k = 0; k < numThreads; k++) {
+    for (int i = 0; i < numSpellings; i++)
+      ASSERT_EQ(t.intern("s" + std::to_string((i * 7 + k) % numSpellings)), ids[k][i]);
+  }
+}
@@ -0,0 +1,89 @@
+#include "PasteLexer.h"
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+  bool lex(const std::string &s, PPTokenType &type)
+  {
+    return PasteLexer::lex(s.data(), s.size(), type);
+  }
+
+  void expectToken(const std::string &s, PPTokenType expected)
+  {
+    PPTokenType type;
+    ASSERT_TRUE(lex(s, type)) << s;
+    EXPECT_EQ(expected, type) << s;
+  }
+
+  void expectInvalid(const std::string &s)
+  {
+    PPTokenType type;
+    EXPECT_FALSE(lex(s, type)) << s;
+  }
+
+} // namespace
+
+TEST(PasteLexer, Tokens)
+{
+  expectToken("ab_1", PPTokenType::Identifier);
+  expectToken("_", PPTokenType::Identifier);
+  expectToken("12", PPTokenType::PPNumber);
+  expectToken(".5", PPTokenType::PPNumber);
+  expectToken("1e+5", PPTokenType::PPNumber);
+  expectToken("0x1p", PPTokenType::PPNumber);
+  expectToken("1.2.3a", PPTokenType::PPNumber);
+  expectToken("##", PPTokenType::PreprocessingOpOrPunc);
+  expectToken("%:%:", PPTokenType::PreprocessingOpOrPunc);
+  expectToken("->*", PPTokenType::PreprocessingOpOrPunc);
+  expectToken("<<=", PPTokenType::PreprocessingOpOrPunc);
+  expectToken("...", PPTokenType::PreprocessingOpOrPunc);
+  expectToken("and", PPTokenType::PreprocessingOpOrPunc);
+  expectToken("new", PPTokenType::PreprocessingOpOrPunc);
+  expectToken("@", PPTokenType::NonWhitespaceChar);
+  expectToken("$", PPTokenType::NonWhitespaceChar);
+
+  // Left to the DFA.
+  expectToken("L'a'", PPTokenType::CharacterLiteral);
+  expectToken("\"a\"s", PPTokenType::UserDefinedStringLiteral);
+  expectToken("u8\"a\"", PPTokenType::StringLiteral);
+}
+
+TEST(PasteLexer, Invalid)
+{
+  expectInvalid("a+");
+  expectInvalid("+a");
+  expectInvalid("1+");
+  expectInvalid("0x1p-3");     // only e and E take a sign in C++11
+  expectInvalid("..");
+  expectInvalid("//");
+  expectInvalid("/*");
+  expectInvalid("a b");
+  expectInvalid("@@");
+  expectInvalid("'a");
+  expectInvalid("\"a\"\"b\"");
+}
+
+// Every paste of two tokens from the list gives what PPTokenizerDFA gives.
+TEST(PasteLexer, SameAsDFA)
+{
+  const std::vector<std::string> tokens = {
+    "", "a", "Z9", "_", "u8", "L", "e", "E", "p", "x", "0", "1", "0x", "1e", "1.", ".",
+    "+", "-", "<", ">", "=", "!", "&", "|", "%", ":", "#", "##", "%:", "%:%", "/",
+    "*", "->", "<<", ">>", "...", ".*", "and", "or", "not", "xor", "new", "delete",
+    "@", "$", "`", "\\", "'a'", "\"s\"", "'", "\"", " ", "\xc3\xa9",
+  };
+
+  for (const std::string &a : tokens) {
+    for (const std::string &b : tokens) {
+      const std::string s = a + b;
+      PPTokenType fast, slow;
+      const bool ok = PasteLexer::lexWithDFA(s.data(), s.size(), slow);
+      ASSERT_EQ(ok, PasteLexer::lex(s.data(), s.size(), fast)) << s;
+      if (ok) {
+        EXPECT_EQ(slow, fast) << s;
+      }
+    }
+  }
+}
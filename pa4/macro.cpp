@@ -1,7 +1,209 @@
 // (C) 2013 CPPGM Foundation www.cppgm.org.  All rights reserved.
 
-int main()
+#include "pa1/PPCodeUnitStream.h"
+#include "pa1/PPTokenizerDFA.h"
+#include "pa1/PPUTF32Stream.h"
+#include "pa2/DebugPostTokenOutputStream.h"
+#include "pa2/PostTokenizer.h"
+#include "HideSet.h"
+#include "MacroExpander.h"
+#include "MacroProfiler.h"
+#include "MacroTable.h"
+#include "MacroToken.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// splits the preprocessing-tokens into directives and text-sequences, applies
+// the directives and macro replaces the text-sequences
+class PA4Preprocessor
 {
-	// TODO: Implement macro as per PA4 assignment description
+public:
+	PA4Preprocessor()
+		: macros(spellings), expander(spellings, macros, hideSets), output(), posttokenizer(output)
+	{}
+
+	void setProfiler(MacroProfiler* profiler)
+	{
+		expander.setProfiler(profiler);
+	}
+
+	const SpellingTable& getSpellings() const
+	{
+		return spellings;
+	}
+
+	void run(PPTokenizerDFA& dfa)
+	{
+		bool lineStart = true; // start-of-file or new-line, then maybe whitespace
+		bool space = false;
+		bool directive = false;
+
+		while (!dfa.isEmpty())
+		{
+			if (!dfa.getErrorMessage().empty())
+				throw runtime_error(dfa.getErrorMessage());
+
+			const shared_ptr<PPToken> token = dfa.getPPToken();
+			dfa.toNext();
+
+			switch (token->getType())
+			{
+			case PPTokenType::NewLine:
+				if (directive)
+					runDirective();
+				directive = false;
+				lineStart = true;
+				space = true;
+				break;
+
+			case PPTokenType::WhitespaceSequence:
+				space = true;
+				break;
+
+			default:
+			{
+				const MacroToken t = MacroToken::make(token->getType(), spellings.intern(token->getRawText()), space);
+				if (lineStart && SpellingTable::isHash(t.spelling))
+				{
+					flushText();
+					directive = true;
+				}
+				else
+				{
+					(directive ? directiveTokens : text).push_back(t);
+				}
+				lineStart = false;
+				space = false;
+				break;
+			}
+			}
+		}
+		if (directive)
+			runDirective();
+		flushText();
+		posttokenizer.finish();
+	}
+
+private:
+	// macro replaces the text-sequence and post-tokenizes the result (see PA2)
+	void flushText()
+	{
+		if (text.empty())
+			return;
+		expanded.clear();
+		expander.expand(text.data(), text.data() + text.size(), expanded);
+		text.clear();
+		for (const MacroToken& t : expanded)
+		{
+			source.assign(spellings.data(t.spelling), spellings.length(t.spelling));
+			posttokenizer.put(t.type, source);
+		}
+	}
+
+	void runDirective()
+	{
+		if (directiveTokens.empty())
+			throw runtime_error("empty preprocessing directive");
+
+		const MacroToken* first = directiveTokens.data() + 1;
+		const MacroToken* last = directiveTokens.data() + directiveTokens.size();
+		if (directiveTokens[0].spelling == SpellingTable::Define)
+			macros.define(first, last);
+		else if (directiveTokens[0].spelling == SpellingTable::Undef)
+			macros.undef(first, last);
+		else
+			throw runtime_error("unknown preprocessing directive");
+		directiveTokens.clear();
+	}
+
+	SpellingTable spellings;
+	HideSetTable hideSets;
+	MacroTable macros;
+	MacroExpander expander;
+	DebugPostTokenOutputStream output;
+	PostTokenizer<DebugPostTokenOutputStream> posttokenizer;
+
+	vector<MacroToken> text;
+	vector<MacroToken> directiveTokens;
+	vector<MacroToken> expanded;
+	string source;
+};
+
+// opens `path` for writing, unless it is empty
+void PA4OpenOutput(const string& path, ofstream& out)
+{
+	if (path.empty())
+		return;
+	out.open(path);
+	if (!out)
+		throw runtime_error("cannot open " + path);
 }
 
+int main(int argc, char** argv)
+{
+	try
+	{
+		vector<string> args;
+
+		for (int i = 1; i < argc; i++)
+			args.emplace_back(argv[i]);
+
+		// macro [--profile <report>] [--trace <trace.json>] [--sort time|self|calls|tokens|depth|memo]
+		string reportPath, tracePath;
+		MacroProfiler::SortKey sortKey = MacroProfiler::SortKey::Time;
+		for (size_t i = 0; i < args.size(); i += 2)
+		{
+			if (i + 1 == args.size())
+				throw logic_error("invalid usage");
+			if (args[i] == "--profile")
+				reportPath = args[i + 1];
+			else if (args[i] == "--trace")
+				tracePath = args[i + 1];
+			else if (args[i] != "--sort" || !MacroProfiler::parseSortKey(args[i + 1], sortKey))
+				throw logic_error("invalid usage");
+		}
+
+		ofstream report, trace;
+		PA4OpenOutput(reportPath, report);
+		PA4OpenOutput(tracePath, trace);
+
+		ios_base::sync_with_stdio(false);
+
+		// read all of standard input into a string
+		const string input((istreambuf_iterator<char>(cin)), istreambuf_iterator<char>());
+
+		// translation phases 1, 2 and 3 (see PA1)
+		auto u32s = make_shared<PPUTF32Stream>(input);
+		auto cus = make_shared<PPCodeUnitStream>(u32s);
+		PPTokenizerDFA dfa(cus);
+
+		PA4Preprocessor preprocessor;
+		unique_ptr<MacroProfiler> profiler;
+		if (!reportPath.empty() || !tracePath.empty())
+		{
+			profiler.reset(new MacroProfiler);
+			preprocessor.setProfiler(profiler.get());
+		}
+
+		preprocessor.run(dfa);
+
+		if (report.is_open())
+			profiler->writeReport(report, preprocessor.getSpellings(), sortKey);
+		if (trace.is_open())
+			profiler->writeTrace(trace, preprocessor.getSpellings());
+	}
+	catch (exception& e)
+	{
+		cerr << "ERROR: " << e.what() << endl;
+		return EXIT_FAILURE;
+	}
+}
@@ -0,0 +1,128 @@
+#include "AsyncFileWriter.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <unistd.h>
+
+const size_t AsyncFileWriter::DefaultBlockSize;
+
+AsyncFileWriter::AsyncFileWriter(const std::string &path, size_t blockSize, size_t numBlocks):
+  _path(path), _fd(-1), _blockSize(blockSize), _current(0), _closing(false), _blocksWritten(0), _waits(0)
+{
+  _fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+  if (_fd < 0)
+    throw std::runtime_error("cannot open " + path + ": " + std::strerror(errno));
+  for (size_t i = 0; i < numBlocks; i++) {
+    _blocks.emplace_back(new char[blockSize]);
+    if (i != _current)
+      _freeBlocks.push_back(i);
+  }
+  setp(_blocks[_current].get(), _blocks[_current].get() + _blockSize);
+  _thread = std::thread(&AsyncFileWriter::_work, this);
+}
+
+AsyncFileWriter::~AsyncFileWriter()
+{
+  _finish();
+}
+
+void AsyncFileWriter::close()
+{
+  _finish();
+  if (!_error.empty())
+    throw std::runtime_error(_error);
+}
+
+AsyncFileWriter::int_type AsyncFileWriter::overflow(int_type c)
+{
+  if (_fd < 0)
+    return traits_type::eof();
+  _submit();
+  std::unique_lock<std::mutex> lock(_mutex);
+  if (_freeBlocks.empty()) {
+    _waits++;
+    _free.wait(lock, [this] { return !_freeBlocks.empty(); });
+  }
+  if (!_error.empty())
+    return traits_type::eof();
+  _current = _freeBlocks.back();
+  _freeBlocks.pop_back();
+  lock.unlock();
+
+  setp(_blocks[_current].get(), _blocks[_current].get() + _blockSize);
+  if (!traits_type::eq_int_type(c, traits_type::eof())) {
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+  }
+  return traits_type::not_eof(c);
+}
+
+// Hands the current block, if not empty, to the thread.
+void AsyncFileWriter::_submit()
+{
+  const size_t size = pptr() - pbase();
+  setp(nullptr, nullptr);
+  if (size == 0) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _freeBlocks.push_back(_current);
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _queue.emplace_back(_current, size);
+  }
+  _full.notify_one();
+}
+
+void AsyncFileWriter::_work()
+{
+  std::unique_lock<std::mutex> lock(_mutex);
+  for (;;) {
+    _full.wait(lock, [this] { return _closing  ||  !_queue.empty(); });
+    if (_queue.empty())
+      break;
+    const std::pair<size_t, size_t> block = _queue.front();
+    _queue.pop_front();
+    const bool failed = !_error.empty();
+    lock.unlock();
+
+    // After a failed write, blocks are only given back.
+    std::string error;
+    const char *data = _blocks[block.first].get();
+    for (size_t done = 0; !failed  &&  done < block.second; ) {
+      const ssize_t n = write(_fd, data + done, block.second - done);
+      if (n < 0  &&  errno == EINTR)
+        continue;
+      if (n <= 0) {
+        error = "cannot write " + _path + ": " + std::strerror(n < 0 ? errno : EIO);
+        break;
+      }
+      done += n;
+    }
+
+    lock.lock();
+    if (_error.empty())
+      _error = error;
+    _blocksWritten += !failed  &&  error.empty();
+    _freeBlocks.push_back(block.first);
+    _free.notify_one();
+  }
+}
+
+void AsyncFileWriter::_finish()
+{
+  if (_fd < 0)
+    return;
+  _submit();
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _closing = true;
+  }
+  _full.notify_one();
+  _thread.join();
+  if (::close(_fd) != 0  &&  _error.empty())
+    _error = "cannot write " + _path + ": " + std::strerror(errno);
+  _fd = -1;
+}
@@ -0,0 +1,68 @@
+#ifndef AsyncFileWriter_h
+#define AsyncFileWriter_h
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// An output file written by a thread of its own, as a std::streambuf for an
+// std::ostream to format into.
+//
+// The buffer is one of a few fixed-size blocks. A full block goes to the
+// thread, and formatting goes on in the next one while the thread writes it;
+// if every block is waiting to be written, formatting waits for the first.
+// Memory stays the blocks, whatever the size of the output. Flushing the
+// stream writes nothing: blocks are written when full, and the last one by
+// close().
+class AsyncFileWriter: public std::streambuf {
+public:
+  static const size_t DefaultBlockSize = 1 << 20;
+
+  // Creates or truncates the file at `path`. Throws std::runtime_error if it
+  // cannot be opened.
+  explicit AsyncFileWriter(const std::string &path, size_t blockSize = DefaultBlockSize, size_t numBlocks = 2);
+  // Closes the file, if not closed, ignoring errors.
+  ~AsyncFileWriter();
+
+  // Writes the rest of the output and closes the file. Throws
+  // std::runtime_error if a write failed, now or before.
+  void close();
+
+  // Blocks written, and the times formatting waited for a block.
+  size_t blocksWritten() const { return _blocksWritten; }
+  size_t waits() const { return _waits; }
+
+protected:
+  int_type overflow(int_type c) override;
+
+private:
+  void _submit();
+  void _work();
+  void _finish();
+
+  std::string _path;
+  int _fd;
+  size_t _blockSize;
+  std::vector<std::unique_ptr<char[]>> _blocks;
+  size_t _current;              // the block being formatted into
+
+  std::mutex _mutex;
+  std::condition_variable _full;      // signalled when a block is submitted
+  std::condition_variable _free;      // signalled when a block is written
+  std::deque<std::pair<size_t, size_t>> _queue;       // blocks and their sizes, to write
+  std::vector<size_t> _freeBlocks;
+  bool _closing;
+  std::string _error;           // of the first failed write
+  size_t _blocksWritten;
+  size_t _waits;
+  std::thread _thread;
+};
+
+#endif /* end of include guard */
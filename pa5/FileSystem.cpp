@@ -0,0 +1,185 @@
+#include "FileSystem.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+  // A file mapped read-only.
+  class MappedContents: public FileContents {
+  public:
+    MappedContents(const char *data, size_t size)
+    {
+      _data = data;
+      _size = size;
+    }
+
+    ~MappedContents()
+    {
+      if (_size)
+        munmap(const_cast<char *>(_data), _size);
+    }
+  };
+
+  // A string shared with a MemoryFileSystem.
+  class SharedContents: public FileContents {
+  public:
+    explicit SharedContents(const std::shared_ptr<const std::string> &contents): _contents(contents)
+    {
+      _data = _contents->data();
+      _size = _contents->size();
+    }
+
+  private:
+    std::shared_ptr<const std::string> _contents;
+  };
+
+} // namespace
+
+bool DiskFileSystem::status(const std::string &path, uint64_t &size, int64_t &mtime)
+{
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0)
+    return false;
+  size = st.st_size;
+  mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+  return true;
+}
+
+std::unique_ptr<FileContents> DiskFileSystem::read(const std::string &path)
+{
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error("cannot open " + path);
+
+  struct stat st;
+  void *p = MAP_FAILED;
+  if (fstat(fd, &st) == 0  &&  S_ISREG(st.st_mode)) {
+    if (st.st_size == 0)
+      p = nullptr;
+    else
+      p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  if (p == MAP_FAILED)
+    throw std::runtime_error("cannot read " + path);
+  return std::unique_ptr<FileContents>(new MappedContents(static_cast<const char *>(p), p ? st.st_size : 0));
+}
+
+bool DiskFileSystem::list(const std::string &directory, std::vector<std::string> &names)
+{
+  DIR *dir = opendir(directory.c_str());
+  if (!dir)
+    return false;
+  while (const dirent *entry = readdir(dir))
+    names.push_back(entry->d_name);
+  closedir(dir);
+  return true;
+}
+
+const unsigned long int MemoryFileSystem::Device;
+
+MemoryFileSystem::MemoryFileSystem(FileSystemIfc *lower): _lower(lower), _adds(0)
+{
+}
+
+void MemoryFileSystem::add(const std::string &path, const std::string &contents)
+{
+  const std::string normal = _normal(path);
+  std::lock_guard<std::mutex> lock(_mutex);
+  _adds++;
+  _files[normal] = File{std::make_shared<const std::string>(contents), SourceFileId(Device, _adds), _adds};
+
+  // Every directory on the way lists the next component.
+  for (std::string name = normal; name != "/"  &&  name != "."; ) {
+    const size_t slash = name.rfind('/');
+    const std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : name.substr(0, slash);
+    _directories[directory].insert(name.substr(slash + 1));
+    name = directory;
+  }
+}
+
+bool MemoryFileSystem::fileId(const std::string &path, SourceFileId &id)
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (const File *f = _find(path)) {
+      id = f->id;
+      return true;
+    }
+  }
+  return _lower  &&  _lower->fileId(path, id);
+}
+
+bool MemoryFileSystem::status(const std::string &path, uint64_t &size, int64_t &mtime)
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (const File *f = _find(path)) {
+      size = f->contents->size();
+      mtime = f->mtime;
+      return true;
+    }
+  }
+  return _lower  &&  _lower->status(path, size, mtime);
+}
+
+std::unique_ptr<FileContents> MemoryFileSystem::read(const std::string &path)
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (const File *f = _find(path))
+      return std::unique_ptr<FileContents>(new SharedContents(f->contents));
+  }
+  if (!_lower)
+    throw std::runtime_error("cannot open " + path);
+  return _lower->read(path);
+}
+
+bool MemoryFileSystem::list(const std::string &directory, std::vector<std::string> &names)
+{
+  bool found = _lower  &&  _lower->list(directory, names);
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto it = _directories.find(_normal(directory));
+  if (it == _directories.end())
+    return found;
+  names.insert(names.end(), it->second.begin(), it->second.end());
+  return true;
+}
+
+std::string MemoryFileSystem::_normal(const std::string &path)
+{
+  const bool absolute = !path.empty()  &&  path[0] == '/';
+  std::vector<std::string> components;
+  for (size_t begin = 0; begin <= path.size(); ) {
+    size_t end = path.find('/', begin);
+    if (end == std::string::npos)
+      end = path.size();
+    const std::string c = path.substr(begin, end - begin);
+    if (c == "..") {
+      // Above the root is the root.
+      if (!components.empty()  &&  components.back() != "..")
+        components.pop_back();
+      else if (!absolute)
+        components.push_back(c);
+    } else if (!c.empty()  &&  c != ".") {
+      components.push_back(c);
+    }
+    begin = end + 1;
+  }
+
+  std::string normal = absolute ? "/" : "";
+  for (size_t i = 0; i < components.size(); i++)
+    normal += (i ? "/" : "") + components[i];
+  return normal.empty() ? "." : normal;
+}
+
+const MemoryFileSystem::File *MemoryFileSystem::_find(const std::string &path) const
+{
+  const auto it = _files.find(_normal(path));
+  return it == _files.end() ? nullptr : &it->second;
+}
@@ -0,0 +1,110 @@
+#ifndef FileSystem_h
+#define FileSystem_h
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+// A system-wide unique file id, the (device, inode) pair of PA5GetFileId on
+// disk.
+typedef std::pair<unsigned long int, unsigned long int> SourceFileId;
+
+// The bytes of a file, valid while the object lives.
+class FileContents {
+public:
+  virtual ~FileContents() {}
+
+  const char *data() const { return _data; }
+  size_t size() const { return _size; }
+
+protected:
+  FileContents(): _data(nullptr), _size(0) {}
+
+  const char *_data;
+  size_t _size;
+};
+
+// The files the preprocessor reads: source files and headers, and the
+// directories they are searched in. An implementation may be used by
+// threads at once.
+class FileSystemIfc {
+public:
+  virtual ~FileSystemIfc() {}
+  // The id of the file at `path`; false if there is none.
+  virtual bool fileId(const std::string &path, SourceFileId &id) = 0;
+  // The size of the file at `path`, and its modification time in
+  // nanoseconds; false if there is none.
+  virtual bool status(const std::string &path, uint64_t &size, int64_t &mtime) = 0;
+  // The bytes of the file at `path`. Throws std::runtime_error if it cannot
+  // be read.
+  virtual std::unique_ptr<FileContents> read(const std::string &path) = 0;
+  // Appends the names in `directory` to `names`; false if it cannot be
+  // listed.
+  virtual bool list(const std::string &directory, std::vector<std::string> &names) = 0;
+};
+
+// The files of the operating system, mapped to be read. File ids come from
+// the function given, which preproc has do its own stat system call.
+class DiskFileSystem: public FileSystemIfc {
+public:
+  typedef bool (*FileIdFunction)(const std::string &path, SourceFileId &id);
+
+  explicit DiskFileSystem(FileIdFunction fileId): _fileId(fileId) {}
+
+  bool fileId(const std::string &path, SourceFileId &id) override { return _fileId(path, id); }
+  bool status(const std::string &path, uint64_t &size, int64_t &mtime) override;
+  std::unique_ptr<FileContents> read(const std::string &path) override;
+  bool list(const std::string &directory, std::vector<std::string> &names) override;
+
+private:
+  FileIdFunction _fileId;
+};
+
+// Files kept in memory, over another file system: a file added hides the
+// one at its path below, and a directory lists the names of both. Tests run
+// on it without touching the disk.
+//
+// Paths are compared with `.` components, `..` ones and the components they
+// cancel, and repeated slashes removed. The files in memory have ids of a
+// device of their own; adding a file at a path already added gives it a new
+// id, while the contents read before stay valid.
+class MemoryFileSystem: public FileSystemIfc {
+public:
+  // Over `lower`, if not nullptr.
+  explicit MemoryFileSystem(FileSystemIfc *lower = nullptr);
+
+  void add(const std::string &path, const std::string &contents);
+
+  bool fileId(const std::string &path, SourceFileId &id) override;
+  bool status(const std::string &path, uint64_t &size, int64_t &mtime) override;
+  std::unique_ptr<FileContents> read(const std::string &path) override;
+  bool list(const std::string &directory, std::vector<std::string> &names) override;
+
+  // The device of the ids of the files in memory.
+  static const unsigned long int Device = ~0ul;
+
+private:
+  struct File {
+    std::shared_ptr<const std::string> contents;
+    SourceFileId id;
+    int64_t mtime;              // the number of the add()
+  };
+
+  static std::string _normal(const std::string &path);
+  // The file at `path`, nullptr if it is not in memory. Called locked.
+  const File *_find(const std::string &path) const;
+
+  FileSystemIfc *_lower;
+  std::mutex _mutex;
+  std::map<std::string, File> _files;                           // by normal path
+  std::map<std::string, std::set<std::string>> _directories;    // names, by normal path
+  int64_t _adds;
+};
+
+#endif /* end of include guard */
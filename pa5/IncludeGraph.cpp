@@ -0,0 +1,186 @@
+#include "IncludeGraph.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <tuple>
+
+namespace {
+
+  // `path` as a word of a make rule.
+  std::string makeWord(const std::string &path)
+  {
+    std::string word;
+    for (char c: path) {
+      if (c == ' '  ||  c == '\t'  ||  c == '#')
+        word += '\\';
+      else if (c == '$')
+        word += '$';
+      word += c;
+    }
+    return word;
+  }
+
+  // `s` as a string of DOT or JSON, quotes included.
+  std::string quote(const std::string &s)
+  {
+    std::string quoted = "\"";
+    for (unsigned char c: s) {
+      if (c == '"'  ||  c == '\\') {
+        quoted += '\\';
+        quoted += c;
+      } else if (c == '\n') {
+        quoted += "\\n";
+      } else if (c < 0x20) {
+        char escape[8];
+        std::snprintf(escape, sizeof escape, "\\u%04x", c);
+        quoted += escape;
+      } else {
+        quoted += c;
+      }
+    }
+    return quoted + '"';
+  }
+
+  std::string milliseconds(uint64_t nanoseconds)
+  {
+    char s[32];
+    std::snprintf(s, sizeof s, "%.3f ms", nanoseconds / 1e6);
+    return s;
+  }
+
+} // namespace
+
+void IncludeGraph::enter(const std::string &path, const SourceFile &file)
+{
+  Node &node = _node(path, file.id);
+  node.entered++;
+  if (_stack.empty())
+    node.source = true;
+  else
+    _edges[Edge(_stack.back().id, file.id)]++;
+  _stack.push_back(Entry{file.id, Clock::now(), 0});
+}
+
+void IncludeGraph::leave()
+{
+  const Entry entry = _stack.back();
+  _stack.pop_back();
+  const uint64_t time = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - entry.start).count();
+  Node &node = _nodes[entry.id];
+  node.time += time;
+  node.selfTime += time - std::min(time, entry.children);
+  if (!_stack.empty())
+    _stack.back().children += time;
+}
+
+void IncludeGraph::skip(const std::string &path, const SourceFileId &id)
+{
+  _node(path, id);
+  if (!_stack.empty())
+    _edges[Edge(_stack.back().id, id)]++;
+}
+
+void IncludeGraph::output(size_t n)
+{
+  if (!_stack.empty())
+    _nodes[_stack.back().id].tokens += n;
+}
+
+void IncludeGraph::merge(const IncludeGraph &other)
+{
+  for (const auto &entry: other._nodes) {
+    const Node &from = entry.second;
+    Node &node = _node(from.path, entry.first);
+    node.source = node.source  ||  from.source;
+    node.entered += from.entered;
+    node.tokens += from.tokens;
+    node.time += from.time;
+    node.selfTime += from.selfTime;
+  }
+  for (const auto &entry: other._edges)
+    _edges[entry.first] += entry.second;
+}
+
+void IncludeGraph::writeDependencies(std::ostream &out, const std::string &target) const
+{
+  const std::vector<const Node *> nodes = _sorted();
+  out << makeWord(target) << ':';
+  for (const Node *node: nodes)
+    out << " \\\n  " << makeWord(node->path);
+  out << '\n';
+  for (const Node *node: nodes) {
+    if (!node->source)
+      out << '\n' << makeWord(node->path) << ":\n";
+  }
+}
+
+void IncludeGraph::writeDot(std::ostream &out) const
+{
+  out << "digraph includes {\n";
+  out << "  node [shape=box];\n";
+  for (const Node *node: _sorted()) {
+    out << "  " << quote(node->path) << " [label="
+        << quote(node->path + "\n" + std::to_string(node->tokens) + " tokens, " + milliseconds(node->time)
+                 + " (self " + milliseconds(node->selfTime) + ")");
+    if (node->source)
+      out << ", style=bold";
+    out << "];\n";
+  }
+  for (const PathEdge &edge: _sortedEdges()) {
+    out << "  " << quote(std::get<0>(edge)) << " -> " << quote(std::get<1>(edge));
+    if (std::get<2>(edge) > 1)
+      out << " [label=" << quote(std::to_string(std::get<2>(edge))) << "]";
+    out << ";\n";
+  }
+  out << "}\n";
+}
+
+void IncludeGraph::writeJson(std::ostream &out) const
+{
+  out << "{\n  \"files\": [";
+  const char *separator = "\n";
+  for (const Node *node: _sorted()) {
+    out << separator << "    {\"path\": " << quote(node->path) << ", \"source\": " << (node->source ? "true" : "false")
+        << ", \"entered\": " << node->entered << ", \"tokens\": " << node->tokens
+        << ", \"time_us\": " << node->time / 1000 << ", \"self_time_us\": " << node->selfTime / 1000 << "}";
+    separator = ",\n";
+  }
+  out << "\n  ],\n  \"includes\": [";
+  separator = "\n";
+  for (const PathEdge &edge: _sortedEdges()) {
+    out << separator << "    {\"from\": " << quote(std::get<0>(edge)) << ", \"to\": " << quote(std::get<1>(edge))
+        << ", \"count\": " << std::get<2>(edge) << "}";
+    separator = ",\n";
+  }
+  out << "\n  ]\n}\n";
+}
+
+IncludeGraph::Node &IncludeGraph::_node(const std::string &path, const SourceFileId &id)
+{
+  const auto it = _nodes.find(id);
+  if (it == _nodes.end())
+    return _nodes[id] = Node{path, false, 0, 0, 0, 0};
+  if (path < it->second.path)
+    it->second.path = path;
+  return it->second;
+}
+
+std::vector<const IncludeGraph::Node *> IncludeGraph::_sorted() const
+{
+  std::vector<const Node *> nodes;
+  for (const auto &entry: _nodes)
+    nodes.push_back(&entry.second);
+  std::sort(nodes.begin(), nodes.end(), [](const Node *a, const Node *b) {
+    return std::make_tuple(!a->source, a->path) < std::make_tuple(!b->source, b->path);
+  });
+  return nodes;
+}
+
+std::vector<IncludeGraph::PathEdge> IncludeGraph::_sortedEdges() const
+{
+  std::vector<PathEdge> edges;
+  for (const auto &entry: _edges)
+    edges.emplace_back(_nodes.at(entry.first.first).path, _nodes.at(entry.first.second).path, entry.second);
+  std::sort(edges.begin(), edges.end());
+  return edges;
+}
@@ -0,0 +1,85 @@
+#ifndef IncludeGraph_h
+#define IncludeGraph_h
+
+#include "Preprocessor.h"
+#include "SourceManager.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// The files of Preprocessor runs and the #include edges between them,
+// recorded while preprocessing, with the tokens each file output and the
+// time spent in it. Written as a make rule, for skipping source files whose
+// dependencies did not change, or as a graph in DOT or JSON, for finding the
+// headers that cost the most.
+//
+// Files are keyed by the file id of the SourceManager, the one #pragma once
+// goes by, so a header reached by different paths is one file; it is named
+// by the least of them, whichever run saw which first. A skipped #include is
+// an edge all the same. The files of a prefix restored from a snapshot are
+// included by the source file, as far as the graph knows, and the output of
+// the prefix is the source file's.
+//
+// A graph follows one Preprocessor; the graphs of several are merged.
+class IncludeGraph: public PreprocessorIncludeIfc {
+public:
+  struct Node {
+    std::string path;
+    bool source;                // preprocessed as a source file
+    size_t entered;             // times
+    size_t tokens;              // output while the file was the current one
+    uint64_t time;              // in nanoseconds, with the files it included
+    uint64_t selfTime;          // without them
+  };
+
+  typedef std::pair<SourceFileId, SourceFileId> Edge;   // includer, included
+
+  void enter(const std::string &path, const SourceFile &file) override;
+  void leave() override;
+  void skip(const std::string &path, const SourceFileId &id) override;
+  void output(size_t n) override;
+
+  // Adds the files and edges of `other`.
+  void merge(const IncludeGraph &other);
+
+  const std::map<SourceFileId, Node> &nodes() const { return _nodes; }
+  // The #include directives of each edge.
+  const std::map<Edge, size_t> &edges() const { return _edges; }
+
+  // A make rule for `target` depending on every file, and an empty rule for
+  // every header, so a removed header does not stop make.
+  void writeDependencies(std::ostream &out, const std::string &target) const;
+  void writeDot(std::ostream &out) const;
+  void writeJson(std::ostream &out) const;
+
+private:
+  typedef std::chrono::steady_clock Clock;
+
+  // A file being preprocessed.
+  struct Entry {
+    SourceFileId id;
+    Clock::time_point start;
+    uint64_t children;          // the time of the files it included
+  };
+
+  // An edge by the paths of its files, and its count.
+  typedef std::tuple<std::string, std::string, size_t> PathEdge;
+
+  Node &_node(const std::string &path, const SourceFileId &id);
+  // The nodes, the source files first, each by path.
+  std::vector<const Node *> _sorted() const;
+  std::vector<PathEdge> _sortedEdges() const;
+
+  std::map<SourceFileId, Node> _nodes;
+  std::map<Edge, size_t> _edges;
+  std::vector<Entry> _stack;
+};
+
+#endif /* end of include guard */
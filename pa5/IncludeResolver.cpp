@@ -0,0 +1,85 @@
+#include "IncludeResolver.h"
+
+IncludeResolver::IncludeResolver(SourceManager &sources, const std::vector<std::string> &searchPaths):
+  _sources(sources), _listings(0), _stats(0), _naiveStats(0)
+{
+  for (std::string path: searchPaths) {
+    if (path.empty()  ||  path.back() != '/')
+      path += '/';
+    _searchPaths.push_back(path);
+  }
+}
+
+bool IncludeResolver::resolve(const std::string &includer, const std::string &name, std::string &path, SourceFileId &id,
+                              std::vector<std::string> *missed)
+{
+  const size_t slash = includer.rfind('/');
+  const std::string directory = slash == std::string::npos ? std::string() : includer.substr(0, slash + 1);
+  std::string key = directory;
+  key += '\0';
+  key += name;
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto it = _results.find(key);
+  if (it == _results.end())
+    it = _results.emplace(key, _resolve(directory, name)).first;
+  const Result &r = it->second;
+  _naiveStats += r.candidates;
+  path = r.path;
+  id = r.id;
+  if (missed) {
+    const std::vector<std::string> candidates = _candidates(directory, name);
+    missed->insert(missed->end(), candidates.begin(), candidates.begin() + (r.found ? r.candidates - 1 : r.candidates));
+  }
+  return r.found;
+}
+
+std::vector<std::string> IncludeResolver::_candidates(const std::string &directory, const std::string &name) const
+{
+  std::vector<std::string> candidates;
+  if (!directory.empty())
+    candidates.push_back(directory + name);
+  candidates.push_back(name);
+  for (const std::string &searchPath: _searchPaths)
+    candidates.push_back(searchPath + name);
+  return candidates;
+}
+
+IncludeResolver::Result IncludeResolver::_resolve(const std::string &directory, const std::string &name)
+{
+  const std::vector<std::string> candidates = _candidates(directory, name);
+  Result r{false, std::string(), SourceFileId(), 0};
+  for (const std::string &candidate: candidates) {
+    r.candidates++;
+    if (_exists(candidate, r.id)) {
+      r.found = true;
+      r.path = candidate;
+      break;
+    }
+  }
+  return r;
+}
+
+bool IncludeResolver::_exists(const std::string &path, SourceFileId &id)
+{
+  const size_t slash = path.rfind('/');
+  const std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+  if (!_list(directory).count(path.substr(slash + 1)))
+    return false;
+  _stats++;
+  return _sources.fileId(path, id);
+}
+
+const std::unordered_set<std::string> &IncludeResolver::_list(const std::string &directory)
+{
+  std::unique_ptr<std::unordered_set<std::string>> &names = _directories[directory];
+  if (!names) {
+    names.reset(new std::unordered_set<std::string>());
+    _listings++;
+    // A directory that cannot be read lists nothing.
+    std::vector<std::string> listed;
+    _sources.fileSystem().list(directory, listed);
+    names->insert(listed.begin(), listed.end());
+  }
+  return *names;
+}
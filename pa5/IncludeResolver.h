@@ -0,0 +1,73 @@
+#ifndef IncludeResolver_h
+#define IncludeResolver_h
+
+#include "SourceManager.h"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Finds the file an #include names.
+//
+// The candidates are, in order: the name relative to the directory of the
+// includer's __FILE__, if that has a `/`; the name itself, relative to the
+// working directory; the name in each of the search directories, given by
+// -I and --stdinc. Both forms of header-name search the same way (PA5).
+//
+// Each directory a candidate is in is listed once, by the file system of the
+// SourceManager, into a set of names, and a candidate whose name is not
+// listed is rejected without a stat. Results, negative ones included, are memoized by the directory of
+// the includer and the name, so an #include seen before costs no system
+// call at all. Files and directories are assumed not to appear or disappear
+// while the process runs. One resolver may be shared by threads.
+class IncludeResolver {
+public:
+  IncludeResolver(SourceManager &sources, const std::vector<std::string> &searchPaths);
+
+  // The path and id of the file that `name`, included from the file whose
+  // __FILE__ is `includer`, refers to; false if there is none. The
+  // candidates tried before it, or all of them, are appended to `missed` if
+  // given.
+  bool resolve(const std::string &includer, const std::string &name, std::string &path, SourceFileId &id,
+               std::vector<std::string> *missed = nullptr);
+
+  // Each ending with `/`.
+  const std::vector<std::string> &searchPaths() const { return _searchPaths; }
+
+  // Directories listed, and stat calls made. `naiveStats` is what a search
+  // that stats every candidate until one exists would have made, counting
+  // every #include resolved.
+  size_t listings() const { return _listings; }
+  size_t stats() const { return _stats; }
+  size_t naiveStats() const { return _naiveStats; }
+
+private:
+  struct Result {
+    bool found;
+    std::string path;
+    SourceFileId id;
+    size_t candidates;        // tried until found, or all
+  };
+
+  Result _resolve(const std::string &directory, const std::string &name);
+  std::vector<std::string> _candidates(const std::string &directory, const std::string &name) const;
+  bool _exists(const std::string &path, SourceFileId &id);
+  const std::unordered_set<std::string> &_list(const std::string &directory);
+
+  SourceManager &_sources;
+  std::vector<std::string> _searchPaths;     // each ending with `/`
+
+  std::mutex _mutex;
+  std::unordered_map<std::string, Result> _results;     // by directory, '\0', name
+  std::unordered_map<std::string, std::unique_ptr<std::unordered_set<std::string>>> _directories;
+  std::atomic<size_t> _listings;
+  std::atomic<size_t> _stats;
+  std::atomic<size_t> _naiveStats;
+};
+
+#endif /* end of include guard */
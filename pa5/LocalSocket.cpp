@@ -0,0 +1,170 @@
+#include "LocalSocket.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+  // The address of `path`, or throws if it does not fit.
+  sockaddr_un address(const std::string &path)
+  {
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof addr);
+    addr.sun_family = AF_UNIX;
+    if (path.empty()  ||  path.size() >= sizeof addr.sun_path)
+      throw std::runtime_error("invalid socket path " + path);
+    memcpy(addr.sun_path, path.data(), path.size());
+    return addr;
+  }
+
+  uint32_t decode(const char *bytes)
+  {
+    uint32_t n = 0;
+    for (int i = 0; i < 4; i++)
+      n |= static_cast<uint32_t>(static_cast<unsigned char>(bytes[i])) << 8 * i;
+    return n;
+  }
+
+  std::runtime_error error(const std::string &what, const std::string &path)
+  {
+    return std::runtime_error(what + " " + path + ": " + strerror(errno));
+  }
+
+} // namespace
+
+std::unique_ptr<LocalSocket> LocalSocket::listen(const std::string &path)
+{
+  const sockaddr_un addr = address(path);
+  // A socket no one listens at any more is left by a server that was
+  // killed; one someone does is not taken over.
+  {
+    LocalSocket probe(socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0));
+    if (probe._fd >= 0  &&  ::connect(probe._fd, reinterpret_cast<const sockaddr *>(&addr), sizeof addr) == 0)
+      throw std::runtime_error("a server is listening at " + path);
+  }
+
+  const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0)
+    throw error("cannot create socket", path);
+  std::unique_ptr<LocalSocket> s(new LocalSocket(fd));
+  unlink(path.c_str());
+  if (bind(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof addr) != 0)
+    throw error("cannot bind", path);
+  s->_path = path;
+  if (::listen(fd, SOMAXCONN) != 0)
+    throw error("cannot listen at", path);
+  return s;
+}
+
+std::unique_ptr<LocalSocket> LocalSocket::connect(const std::string &path)
+{
+  const sockaddr_un addr = address(path);
+  const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0)
+    throw error("cannot create socket", path);
+  std::unique_ptr<LocalSocket> s(new LocalSocket(fd));
+  if (::connect(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof addr) != 0)
+    throw error("cannot connect to", path);
+  return s;
+}
+
+LocalSocket::~LocalSocket()
+{
+  if (_fd >= 0)
+    close(_fd);
+  if (!_path.empty())
+    unlink(_path.c_str());
+}
+
+std::unique_ptr<LocalSocket> LocalSocket::accept()
+{
+  int fd;
+  do
+    fd = ::accept4(_fd, nullptr, nullptr, SOCK_CLOEXEC);
+  while (fd < 0  &&  errno == EINTR);
+  if (fd < 0)
+    throw error("cannot accept at", _path);
+  return std::unique_ptr<LocalSocket>(new LocalSocket(fd));
+}
+
+void LocalSocket::send(const std::vector<std::string> &message)
+{
+  std::string bytes;
+  auto number = [&](size_t n) {
+    if (n > MaxMessageSize)
+      throw std::runtime_error("message too large");
+    for (int i = 0; i < 4; i++)
+      bytes += static_cast<char>(n >> 8 * i);
+  };
+  number(message.size());
+  for (const std::string &s : message) {
+    number(s.size());
+    bytes += s;
+  }
+  if (bytes.size() > MaxMessageSize)
+    throw std::runtime_error("message too large");
+  _write(bytes.data(), bytes.size());
+}
+
+bool LocalSocket::receive(std::vector<std::string> &message)
+{
+  char count[4];
+  if (!_read(count, sizeof count, true))
+    return false;
+  const uint32_t n = decode(count);
+  if (n > MaxMessageSize / 4)
+    throw std::runtime_error("message too large");
+
+  message.clear();
+  size_t total = 4;
+  for (uint32_t i = 0; i < n; i++) {
+    char length[4];
+    _read(length, sizeof length, false);
+    const uint32_t size = decode(length);
+    total += 4 + size;
+    if (total > MaxMessageSize)
+      throw std::runtime_error("message too large");
+    message.emplace_back(size, '\0');
+    if (size)
+      _read(&message.back()[0], size, false);
+  }
+  return true;
+}
+
+void LocalSocket::_write(const char *data, size_t size)
+{
+  while (size) {
+    // No SIGPIPE if the other end went away, only an error.
+    const ssize_t n = ::send(_fd, data, size, MSG_NOSIGNAL);
+    if (n < 0  &&  errno == EINTR)
+      continue;
+    if (n < 0)
+      throw error("cannot write to socket", _path);
+    data += n;
+    size -= n;
+  }
+}
+
+bool LocalSocket::_read(char *data, size_t size, bool begin)
+{
+  const size_t wanted = size;
+  while (size) {
+    const ssize_t n = ::recv(_fd, data, size, 0);
+    if (n < 0  &&  errno == EINTR)
+      continue;
+    if (n < 0)
+      throw error("cannot read from socket", _path);
+    if (n == 0) {
+      if (begin  &&  size == wanted)
+        return false;
+      throw std::runtime_error("connection closed within a message");
+    }
+    data += n;
+    size -= n;
+  }
+  return true;
+}
@@ -0,0 +1,47 @@
+#ifndef LocalSocket_h
+#define LocalSocket_h
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// A Unix domain stream socket carrying messages, each a list of strings: a
+// count, then each string as a length and its bytes, in 32-bit little-endian
+// numbers.
+class LocalSocket {
+public:
+  // Listens at `path`, replacing a socket left there. Throws
+  // std::runtime_error on errors, like every member below.
+  static std::unique_ptr<LocalSocket> listen(const std::string &path);
+  // Connects to the socket listening at `path`.
+  static std::unique_ptr<LocalSocket> connect(const std::string &path);
+
+  ~LocalSocket();
+
+  LocalSocket(const LocalSocket &) = delete;
+  LocalSocket &operator=(const LocalSocket &) = delete;
+
+  // The next connection to a listening socket.
+  std::unique_ptr<LocalSocket> accept();
+
+  void send(const std::vector<std::string> &message);
+  // The next message; false if the other end closed the connection.
+  bool receive(std::vector<std::string> &message);
+
+  // Messages larger are refused.
+  static const size_t MaxMessageSize = 1 << 26;
+
+private:
+  explicit LocalSocket(int fd, const std::string &path = ""): _fd(fd), _path(path) {}
+
+  void _write(const char *data, size_t size);
+  // False if the connection ends before the first byte and `begin`.
+  bool _read(char *data, size_t size, bool begin);
+
+  int _fd;
+  std::string _path;            // of a listening socket, removed with it
+};
+
+#endif /* end of include guard */
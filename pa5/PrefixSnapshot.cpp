@@ -0,0 +1,444 @@
+#include "PrefixSnapshot.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace {
+
+  const char Magic[8] = {'P', 'A', '5', 'P', 'R', 'E', 'F', '3'};
+  const uint32_t NoSpelling = 0xFFFFFFFF;
+
+  // The layout of a snapshot file: a Header, the records of the files,
+  // absent paths, spellings, macros and tokens, the parameter and
+  // replacement lists first, then the string pool, which starts with the key.
+  struct Header {
+    char magic[8];
+    uint32_t numFiles;
+    uint32_t numAbsent;
+    uint32_t numSpellings;
+    uint32_t numMacros;
+    uint32_t numListTokens;
+    uint32_t numTokens;
+    uint32_t keyLength;
+    uint32_t unused;
+    uint64_t poolSize;
+  };
+
+  struct FileRecord {
+    uint64_t size;
+    int64_t mtime;
+    uint64_t hash;
+    uint32_t path;              // in the pool
+    uint32_t pathLength;
+    uint32_t guard;             // a spelling, NoSpelling if none
+    uint32_t once;
+  };
+
+  struct PathRecord {
+    uint32_t offset;            // in the pool
+    uint32_t length;
+  };
+
+  struct SpellingRecord {
+    uint32_t offset;            // in the pool
+    uint32_t length;
+  };
+
+  struct MacroRecord {
+    uint32_t name;              // a spelling
+    uint32_t lists;             // the first parameter, the body follows
+    uint32_t bodyLength;
+    uint16_t numParams;
+    uint8_t functionLike;
+    uint8_t variadic;
+    uint8_t hasOperators;
+    uint8_t unused[3];
+  };
+
+  struct TokenRecord {
+    uint32_t spelling;
+    uint16_t param;
+    uint8_t type;
+    uint8_t role;
+    uint8_t precededBySpace;
+    uint8_t unused[3];
+  };
+
+  // Builds the bytes of a snapshot file.
+  class Writer {
+  public:
+    Writer(const SpellingTable &spellings, const std::string &key):
+      _spellings(spellings), _pool(key), _keyLength(key.size())
+    {}
+
+    void write(const PrefixSnapshot &snapshot, std::vector<char> &out)
+    {
+      std::vector<FileRecord> files;
+      for (const PrefixSnapshot::File &f: snapshot.files) {
+        FileRecord r = FileRecord();
+        r.size = f.size;
+        r.mtime = f.mtime;
+        r.hash = f.hash;
+        r.path = _string(f.path.data(), f.path.size());
+        r.pathLength = f.path.size();
+        r.guard = f.guard == SpellingTable::Placemarker ? NoSpelling : _spelling(f.guard);
+        r.once = f.once;
+        files.push_back(r);
+      }
+
+      std::vector<PathRecord> absent;
+      for (const std::string &path: snapshot.absent)
+        absent.push_back(PathRecord{_string(path.data(), path.size()), static_cast<uint32_t>(path.size())});
+
+      std::vector<MacroRecord> macros;
+      std::vector<TokenRecord> tokens;
+      for (const PrefixSnapshot::Macro &m: snapshot.macros) {
+        const MacroDefinition &d = m.definition;
+        MacroRecord r = MacroRecord();
+        r.name = _spelling(d.name);
+        r.lists = tokens.size();
+        r.bodyLength = m.body.size();
+        r.numParams = m.params.size();
+        r.functionLike = d.functionLike;
+        r.variadic = d.variadic;
+        r.hasOperators = d.hasOperators;
+        macros.push_back(r);
+        _tokens(m.params, tokens);
+        _tokens(m.body, tokens);
+      }
+      const size_t numListTokens = tokens.size();
+      _tokens(snapshot.tokens, tokens);
+
+      Header h = Header();
+      std::memcpy(h.magic, Magic, sizeof Magic);
+      h.numFiles = files.size();
+      h.numAbsent = absent.size();
+      h.numSpellings = _records.size();
+      h.numMacros = macros.size();
+      h.numListTokens = numListTokens;
+      h.numTokens = snapshot.tokens.size();
+      h.keyLength = _keyLength;
+      h.poolSize = _pool.size();
+
+      out.clear();
+      _append(out, &h, 1);
+      _append(out, files.data(), files.size());
+      _append(out, absent.data(), absent.size());
+      _append(out, _records.data(), _records.size());
+      _append(out, macros.data(), macros.size());
+      _append(out, tokens.data(), tokens.size());
+      out.insert(out.end(), _pool.begin(), _pool.end());
+    }
+
+  private:
+    template <typename T>
+    static void _append(std::vector<char> &out, const T *records, size_t n)
+    {
+      const char *p = reinterpret_cast<const char *>(records);
+      out.insert(out.end(), p, p + n * sizeof(T));
+    }
+
+    uint32_t _string(const char *data, size_t length)
+    {
+      if (_pool.size() + length > NoSpelling)
+        throw std::runtime_error("prefix snapshot too large");
+      const uint32_t offset = _pool.size();
+      _pool.append(data, length);
+      return offset;
+    }
+
+    uint32_t _spelling(uint32_t id)
+    {
+      const auto it = _indices.find(id);
+      if (it != _indices.end())
+        return it->second;
+      const uint32_t index = _records.size();
+      _records.push_back(SpellingRecord{_string(_spellings.data(id), _spellings.length(id)),
+                                        static_cast<uint32_t>(_spellings.length(id))});
+      _indices.emplace(id, index);
+      return index;
+    }
+
+    void _tokens(const std::vector<MacroToken> &tokens, std::vector<TokenRecord> &out)
+    {
+      for (const MacroToken &t: tokens) {
+        TokenRecord r = TokenRecord();
+        r.spelling = _spelling(t.spelling);
+        r.param = t.param;
+        r.type = static_cast<uint8_t>(t.type);
+        r.role = static_cast<uint8_t>(t.role);
+        r.precededBySpace = t.precededBySpace;
+        out.push_back(r);
+      }
+    }
+
+    const SpellingTable &_spellings;
+    std::string _pool;
+    uint32_t _keyLength;
+    std::vector<SpellingRecord> _records;
+    std::unordered_map<uint32_t, uint32_t> _indices;   // by spelling id
+  };
+
+  // A file mapped read-only.
+  class Mapping {
+  public:
+    explicit Mapping(const std::string &path): data(nullptr), size(0)
+    {
+      const int fd = open(path.c_str(), O_RDONLY);
+      if (fd < 0)
+        return;
+      struct stat st;
+      if (fstat(fd, &st) == 0  &&  st.st_size > 0) {
+        void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+          data = static_cast<const char *>(p);
+          size = st.st_size;
+        }
+      }
+      close(fd);
+    }
+
+    ~Mapping()
+    {
+      if (data)
+        munmap(const_cast<char *>(data), size);
+    }
+
+    Mapping(const Mapping &) = delete;
+    Mapping &operator=(const Mapping &) = delete;
+
+    const char *data;
+    size_t size;
+  };
+
+  bool sameBytes(FileSystemIfc &files, const std::string &path, uint64_t size, uint64_t hash)
+  {
+    if (size == 0)
+      return true;
+    try {
+      const std::unique_ptr<FileContents> contents = files.read(path);
+      return contents->size() == size  &&  PrefixSnapshot::hash(contents->data(), contents->size()) == hash;
+    } catch (const std::runtime_error &) {
+      return false;
+    }
+  }
+
+} // namespace
+
+uint64_t PrefixSnapshot::hash(const char *data, size_t size)
+{
+  uint64_t h = 14695981039346656037u;
+  for (size_t i = 0; i < size; i++) {
+    h ^= static_cast<unsigned char>(data[i]);
+    h *= 1099511628211u;
+  }
+  return h;
+}
+
+PrefixSnapshotStore::PrefixSnapshotStore(SourceManager &sources, const std::string &directory):
+  _sources(sources), _spellings(sources.spellings()), _directory(directory), _found(0), _loaded(0), _written(0),
+  _stale(0)
+{
+  if (_directory.empty()  ||  _directory.back() != '/')
+    _directory += '/';
+  char cwd[4096];
+  if (getcwd(cwd, sizeof cwd))
+    _cwd = cwd;
+}
+
+std::shared_ptr<const PrefixSnapshot> PrefixSnapshotStore::find(const std::string &key)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto it = _snapshots.find(key);
+  if (it == _snapshots.end())
+    it = _snapshots.emplace(key, _load(key)).first;
+  if (it->second)
+    _found++;
+  return it->second;
+}
+
+void PrefixSnapshotStore::store(const std::string &key, std::shared_ptr<PrefixSnapshot> snapshot)
+{
+  // The bytes preprocessed must still be those on disk, or the times taken
+  // now would vouch for other contents.
+  FileSystemIfc &files = _sources.fileSystem();
+  for (PrefixSnapshot::File &f: snapshot->files) {
+    uint64_t size;
+    if (!files.status(f.path, size, f.mtime)  ||  size != f.size  ||  !sameBytes(files, f.path, f.size, f.hash))
+      return;
+  }
+  for (const std::string &path: snapshot->absent) {
+    uint64_t size;
+    int64_t mtime;
+    if (files.status(path, size, mtime))
+      return;
+  }
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  _write(key, *snapshot);
+  _snapshots[key] = snapshot;
+  _written++;
+}
+
+std::string PrefixSnapshotStore::_path(const std::string &key) const
+{
+  static const char digits[] = "0123456789abcdef";
+  std::string name;
+  for (uint64_t h = PrefixSnapshot::hash(key.data(), key.size()), i = 0; i < 16; i++, h >>= 4)
+    name += digits[h & 15];
+  return _directory + name + ".pch";
+}
+
+std::shared_ptr<const PrefixSnapshot> PrefixSnapshotStore::_load(const std::string &key)
+{
+  const std::string fullKey = _cwd + '\0' + key;
+  const Mapping m(_path(fullKey));
+  if (!m.data)
+    return nullptr;
+
+  // Anything but a whole file of this key, whose records point into it, is
+  // ignored like a stale one.
+  Header h;
+  if (m.size < sizeof h) {
+    _stale++;
+    return nullptr;
+  }
+  std::memcpy(&h, m.data, sizeof h);
+  const uint64_t poolStart = sizeof h + uint64_t(h.numFiles) * sizeof(FileRecord)
+    + uint64_t(h.numAbsent) * sizeof(PathRecord) + uint64_t(h.numSpellings) * sizeof(SpellingRecord) + uint64_t(h.numMacros) * sizeof(MacroRecord)
+    + (uint64_t(h.numListTokens) + h.numTokens) * sizeof(TokenRecord);
+  if (std::memcmp(h.magic, Magic, sizeof Magic) != 0  ||  poolStart + h.poolSize != m.size
+      ||  h.keyLength != fullKey.size()  ||  h.keyLength > h.poolSize
+      ||  std::memcmp(m.data + poolStart, fullKey.data(), fullKey.size()) != 0) {
+    _stale++;
+    return nullptr;
+  }
+
+  const FileRecord *files = reinterpret_cast<const FileRecord *>(m.data + sizeof h);
+  const PathRecord *absent = reinterpret_cast<const PathRecord *>(files + h.numFiles);
+  const SpellingRecord *records = reinterpret_cast<const SpellingRecord *>(absent + h.numAbsent);
+  const MacroRecord *macros = reinterpret_cast<const MacroRecord *>(records + h.numSpellings);
+  const TokenRecord *tokens = reinterpret_cast<const TokenRecord *>(macros + h.numMacros);
+  const char *pool = m.data + poolStart;
+
+  std::vector<uint32_t> spellings;
+  for (uint32_t i = 0; i < h.numSpellings; i++) {
+    const SpellingRecord &r = records[i];
+    if (uint64_t(r.offset) + r.length > h.poolSize) {
+      _stale++;
+      return nullptr;
+    }
+    spellings.push_back(_spellings.intern(pool + r.offset, r.length));
+  }
+  auto spelling = [&](uint32_t index, uint32_t &id) {
+    if (index >= spellings.size())
+      return false;
+    id = spellings[index];
+    return true;
+  };
+  auto token = [&](const TokenRecord &r, MacroToken &t) {
+    t = MacroToken::make(static_cast<PPTokenType>(r.type), 0, r.precededBySpace);
+    t.role = static_cast<MacroTokenRole>(r.role);
+    t.param = r.param;
+    return spelling(r.spelling, t.spelling);
+  };
+
+  std::shared_ptr<PrefixSnapshot> s(new PrefixSnapshot());
+  bool ok = true;
+  for (uint32_t i = 0; ok  &&  i < h.numFiles; i++) {
+    const FileRecord &r = files[i];
+    PrefixSnapshot::File f;
+    f.size = r.size;
+    f.mtime = r.mtime;
+    f.hash = r.hash;
+    f.guard = SpellingTable::Placemarker;
+    f.once = r.once;
+    ok = uint64_t(r.path) + r.pathLength <= h.poolSize  &&  (r.guard == NoSpelling  ||  spelling(r.guard, f.guard));
+    if (ok)
+      f.path.assign(pool + r.path, r.pathLength);
+    s->files.push_back(f);
+  }
+  for (uint32_t i = 0; ok  &&  i < h.numAbsent; i++) {
+    const PathRecord &r = absent[i];
+    ok = uint64_t(r.offset) + r.length <= h.poolSize;
+    if (ok)
+      s->absent.emplace_back(pool + r.offset, r.length);
+  }
+  for (uint32_t i = 0; ok  &&  i < h.numMacros; i++) {
+    const MacroRecord &r = macros[i];
+    PrefixSnapshot::Macro m;
+    m.definition = MacroDefinition();
+    m.definition.functionLike = r.functionLike;
+    m.definition.variadic = r.variadic;
+    m.definition.hasOperators = r.hasOperators;
+    m.definition.numParams = r.numParams;
+    m.definition.bodyLength = r.bodyLength;
+    ok = spelling(r.name, m.definition.name)  &&  uint64_t(r.lists) + r.numParams + r.bodyLength <= h.numListTokens;
+    for (uint32_t j = 0; ok  &&  j < uint32_t(r.numParams) + r.bodyLength; j++) {
+      MacroToken t;
+      ok = token(tokens[r.lists + j], t);
+      (j < r.numParams ? m.params : m.body).push_back(t);
+    }
+    s->macros.push_back(std::move(m));
+  }
+  for (uint32_t i = 0; ok  &&  i < h.numTokens; i++) {
+    MacroToken t;
+    ok = token(tokens[h.numListTokens + i], t);
+    s->tokens.push_back(t);
+  }
+
+  if (!ok  ||  !_valid(*s)) {
+    _stale++;
+    return nullptr;
+  }
+  _loaded++;
+  return s;
+}
+
+bool PrefixSnapshotStore::_valid(PrefixSnapshot &snapshot)
+{
+  FileSystemIfc &files = _sources.fileSystem();
+  for (PrefixSnapshot::File &f: snapshot.files) {
+    uint64_t size;
+    int64_t mtime;
+    if (!files.status(f.path, size, mtime)  ||  size != f.size)
+      return false;
+    if (mtime != f.mtime  &&  !sameBytes(files, f.path, f.size, f.hash))
+      return false;
+    if (!_sources.fileId(f.path, f.id))
+      return false;
+  }
+  for (const std::string &path: snapshot.absent) {
+    uint64_t size;
+    int64_t mtime;
+    if (files.status(path, size, mtime))
+      return false;
+  }
+  return true;
+}
+
+void PrefixSnapshotStore::_write(const std::string &key, const PrefixSnapshot &snapshot)
+{
+  const std::string fullKey = _cwd + '\0' + key;
+  std::vector<char> bytes;
+  Writer(_spellings, fullKey).write(snapshot, bytes);
+
+  const std::string path = _path(fullKey);
+  const std::string temporary = path + "." + std::to_string(getpid());
+  {
+    std::ofstream out(temporary, std::ios::binary);
+    out.write(bytes.data(), bytes.size());
+    if (!out.flush())
+      throw std::runtime_error("cannot write " + temporary);
+  }
+  if (rename(temporary.c_str(), path.c_str()) != 0) {
+    unlink(temporary.c_str());
+    throw std::runtime_error("cannot write " + path);
+  }
+}
@@ -0,0 +1,106 @@
+#ifndef PrefixSnapshot_h
+#define PrefixSnapshot_h
+
+#include "SourceManager.h"
+#include "pa4/MacroTable.h"
+#include "pa4/MacroToken.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// The state of a Preprocessor after the prefix of a source file: the
+// #include lines it starts with, header-names only, and nothing else but
+// empty lines. Spelling ids are those of the process.
+struct PrefixSnapshot {
+  // A file the prefix entered, or skipped by its include guard.
+  struct File {
+    std::string path;           // as resolved, relative to the working directory
+    SourceFileId id;            // set when loaded
+    uint64_t size;
+    int64_t mtime;              // in nanoseconds
+    uint64_t hash;              // FNV-1a of the bytes
+    uint32_t guard;             // the include guard, Placemarker if none
+    bool once;                  // in the #pragma once set
+  };
+
+  // A macro defined at the end of the prefix; dynamic ones are left out.
+  struct Macro {
+    MacroDefinition definition; // without its lists
+    std::vector<MacroToken> params;
+    std::vector<MacroToken> body;
+  };
+
+  std::vector<File> files;
+  std::vector<std::string> absent;      // paths the #includes tried before the file they found
+  std::vector<Macro> macros;
+  std::vector<MacroToken> tokens;       // the output of the prefix
+
+  // FNV-1a, 64 bits.
+  static uint64_t hash(const char *data, size_t size);
+};
+
+// Snapshots of prefixes, kept in files of a directory across runs and in
+// memory for the rest of the process.
+//
+// A snapshot is found by a key, the Preprocessor's description of the prefix
+// (the search directories and the paths its #include lines resolve to); the
+// store adds the working directory. On the first find() of a key in the
+// process, its file is mapped and checked: every file of the snapshot must
+// still have the size it had, and either the same modification time or the
+// same bytes, and every absent path must still be absent, so that no
+// #include of the prefix would find another file now. A stale or unreadable
+// file is ignored, and replaced by the next store() of the key. Files are
+// assumed not to change afterwards.
+// The snapshot files are on disk, while the files they check are those of the
+// SourceManager's file system.
+//
+// The file is a header, arrays of fixed-size records and a string pool, so
+// loading one is a single mapping and a pass that interns its spellings. A
+// new file is written beside its final name and renamed over it, so
+// processes sharing the directory see whole files only.
+//
+// One store may be shared by threads.
+class PrefixSnapshotStore {
+public:
+  PrefixSnapshotStore(SourceManager &sources, const std::string &directory);
+
+  // The valid snapshot of `key`, nullptr if there is none.
+  std::shared_ptr<const PrefixSnapshot> find(const std::string &key);
+
+  // Sets the modification times of the files of `snapshot` and writes it as
+  // the snapshot of `key`, unless a file changed since it was read or an
+  // absent path appeared. Throws std::runtime_error if the snapshot cannot
+  // be written.
+  void store(const std::string &key, std::shared_ptr<PrefixSnapshot> snapshot);
+
+  // Snapshots found, read from files, written, and files found stale.
+  size_t found() const { return _found; }
+  size_t loaded() const { return _loaded; }
+  size_t written() const { return _written; }
+  size_t stale() const { return _stale; }
+
+private:
+  std::string _path(const std::string &key) const;
+  std::shared_ptr<const PrefixSnapshot> _load(const std::string &key);
+  bool _valid(PrefixSnapshot &snapshot);
+  void _write(const std::string &key, const PrefixSnapshot &snapshot);
+
+  SourceManager &_sources;
+  SpellingTable &_spellings;
+  std::string _directory;       // ending with `/`
+  std::string _cwd;
+
+  std::mutex _mutex;
+  std::map<std::string, std::shared_ptr<const PrefixSnapshot>> _snapshots;    // by key
+  size_t _found;
+  size_t _loaded;
+  size_t _written;
+  size_t _stale;
+};
+
+#endif /* end of include guard */
@@ -0,0 +1,655 @@
+#include "Preprocessor.h"
+
+#include "pa2/CharacterLiteralDecoder.h"
+#include "pa2/IntegerLiteralDecoder.h"
+#include "pa2/TokenType.h"
+
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+namespace {
+
+  // The contents of a string-literal spelled `data`, as _Pragma destringizes
+  // it (16.9): the prefix and the quotes go, \" and \\ become " and \.
+  std::string destringize(const char *data, size_t length)
+  {
+    const char *p = data;
+    const char *end = data + length;
+    while (p != end  &&  *p != '"')
+      p++;
+    std::string s;
+    if (p == end)
+      return s;
+    for (p++, end--; p < end; p++) {
+      if (*p == '\\'  &&  p + 1 < end  &&  (p[1] == '"'  ||  p[1] == '\\'))
+        p++;
+      s += *p;
+    }
+    return s;
+  }
+
+  // The first identifier-like word of a pragma.
+  std::string pragmaName(const std::string &pragma)
+  {
+    size_t i = pragma.find_first_not_of(" \t\v\f\n");
+    if (i == std::string::npos)
+      return std::string();
+    size_t j = i;
+    while (j < pragma.size()  &&  (isalnum(static_cast<unsigned char>(pragma[j]))  ||  pragma[j] == '_'))
+      j++;
+    return pragma.substr(i, j - i);
+  }
+
+  // `s` as an ordinary string-literal.
+  std::string quote(const std::string &s)
+  {
+    std::string q = "\"";
+    for (const char c: s) {
+      if (c == '"'  ||  c == '\\')
+        q += '\\';
+      q += c;
+    }
+    return q + '"';
+  }
+
+} // namespace
+
+const size_t Preprocessor::MaxIncludeDepth;
+
+Preprocessor::Preprocessor(SourceManager &sources, IncludeResolver &resolver, const std::string &date,
+                           const std::string &time):
+  _sources(sources), _resolver(resolver), _spellings(sources.spellings()), _includes(0), _guardedIncludes(0),
+  _out(nullptr), _includeIfc(nullptr), _snapshots(nullptr), _prefixEnd(0)
+{
+  _ifName = _spellings.intern("if");
+  _ifdefName = _spellings.intern("ifdef");
+  _ifndefName = _spellings.intern("ifndef");
+  _elifName = _spellings.intern("elif");
+  _elseName = _spellings.intern("else");
+  _endifName = _spellings.intern("endif");
+  _includeName = _spellings.intern("include");
+  _lineName = _spellings.intern("line");
+  _errorName = _spellings.intern("error");
+  _pragmaName = _spellings.intern("pragma");
+  _onceName = _spellings.intern("once");
+  _definedName = _spellings.intern("defined");
+  _trueName = _spellings.intern("true");
+  _pragmaOperator = _spellings.intern("_Pragma");
+  _fileMacro = _spellings.intern("__FILE__");
+  _lineMacro = _spellings.intern("__LINE__");
+  _dateMacro = _spellings.intern("__DATE__");
+  _timeMacro = _spellings.intern("__TIME__");
+  setClock(date, time);
+}
+
+void Preprocessor::setClock(const std::string &date, const std::string &time)
+{
+  _date = date;
+  _time = time;
+  _dateSpelling = _spellings.intern(quote(_date));
+  _timeSpelling = _spellings.intern(quote(_time));
+}
+
+void Preprocessor::run(const std::string &path, PreprocessorOutputIfc &out)
+{
+  _reset();
+  _out = &out;
+
+  const SourceFile *file = _sources.open(path);
+  if (!file)
+    throw std::runtime_error("cannot open " + path);
+  _enter(file, path);
+  if (_snapshots)
+    _startPrefix();
+
+  while (!_frames.empty()) {
+    if (_recording  &&  _frames.size() == 1  &&  _frames[0].pos >= _prefixEnd)
+      _finishPrefix();
+
+    Frame &f = _frames.back();
+    const SourceFile &file = *f.file;
+
+    if (f.pos == file.segments.size()) {
+      _flushText();
+      if (!file.error.empty())
+        throw std::runtime_error(file.error);
+      if (_conditionals.size() != f.conditionals)
+        throw std::runtime_error("unterminated conditional in " + f.presumedName);
+      _frames.pop_back();
+      if (_includeIfc)
+        _includeIfc->leave();
+      continue;
+    }
+
+    // A directive line, or lines of text; those of a skipped group are not
+    // even lexed.
+    const SourceSegment &segment = file.segments[f.pos++];
+    if (segment.directive) {
+      const std::vector<MacroToken> &tokens = segment.tokens;
+      const MacroToken *first = tokens.data();
+      const MacroToken *last = first + tokens.size();
+      if (last[-1].type == PPTokenType::NewLine)
+        last--;
+      _flushText();
+      _directive(first + 1, last, last == first + tokens.size() ? last[-1].line : last->line);
+    } else if (_active()) {
+      for (const MacroToken &t: _sources.tokens(file, segment)) {
+        if (t.type != PPTokenType::NewLine)
+          _text.push_back(t);
+      }
+    }
+  }
+  _out = nullptr;
+}
+
+void Preprocessor::_reset()
+{
+  _hideSets.reset(new HideSetTable());
+  _resetMacros();
+  _onceFiles.clear();
+  _frames.clear();
+  _conditionals.clear();
+  _text.clear();
+  _recording.reset();
+  _prefixFiles.clear();
+  _prefixFileIds.clear();
+  _prefixGuards.clear();
+
+  _definePredefined("__CPPGM__", PPTokenType::PPNumber, "201303L");
+  _definePredefined("__cplusplus", PPTokenType::PPNumber, "201103L");
+  _definePredefined("__STDC_HOSTED__", PPTokenType::PPNumber, "1");
+  _definePredefined("__CPPGM_AUTHOR__", PPTokenType::StringLiteral, "\"John Smith\"");
+  _defineClock();
+}
+
+// A table with the dynamic macros only.
+void Preprocessor::_resetMacros()
+{
+  _macros.reset(new MacroTable(_spellings));
+  _expander.reset(new MacroExpander(_spellings, *_macros, *_hideSets));
+  _expander->setDynamicMacros(this);
+  _macros->defineDynamic(_fileMacro);
+  _macros->defineDynamic(_lineMacro);
+}
+
+void Preprocessor::_definePredefined(const char *name, PPTokenType type, const std::string &value)
+{
+  const MacroToken tokens[] = {
+    MacroToken::make(PPTokenType::Identifier, _spellings.intern(name), false),
+    MacroToken::make(type, _spellings.intern(value), true),
+  };
+  _macros->define(tokens, tokens + 2);
+}
+
+// __DATE__ and __TIME__, which a snapshot leaves to the run restoring it.
+void Preprocessor::_defineClock()
+{
+  _definePredefined("__DATE__", PPTokenType::StringLiteral, quote(_date));
+  _definePredefined("__TIME__", PPTokenType::StringLiteral, quote(_time));
+}
+
+void Preprocessor::_enter(const SourceFile *file, const std::string &presumedName)
+{
+  if (_frames.size() == MaxIncludeDepth)
+    throw std::runtime_error("#include nested too deeply");
+  _frames.push_back(Frame{file, 0, presumedName, 0, 0, _conditionals.size()});
+  if (_includeIfc)
+    _includeIfc->enter(presumedName, *file);
+  if (_recording)
+    _recordFile(presumedName, file);
+}
+
+MacroToken Preprocessor::replace(const MacroToken &head)
+{
+  Frame &f = _frames.back();
+  if (head.spelling == _lineMacro) {
+    const std::string line = std::to_string(head.line + f.lineDelta);
+    return MacroToken::make(PPTokenType::PPNumber, _spellings.intern(line), head.precededBySpace, head.line);
+  }
+  if (!f.nameSpelling)
+    f.nameSpelling = _spellings.intern(quote(f.presumedName));
+  return MacroToken::make(PPTokenType::StringLiteral, f.nameSpelling, head.precededBySpace, head.line);
+}
+
+void Preprocessor::_directive(const MacroToken *first, const MacroToken *last, uint32_t endLine)
+{
+  // The null directive.
+  if (first == last)
+    return;
+
+  const uint32_t name = first->type == PPTokenType::Identifier ? first->spelling : SpellingTable::Placemarker;
+  if (name == _ifName  ||  name == _ifdefName  ||  name == _ifndefName)
+    _if(name, first + 1, last);
+  else if (name == _elifName)
+    _elif(first + 1, last);
+  else if (name == _elseName)
+    _else(first + 1, last);
+  else if (name == _endifName)
+    _endif(first + 1, last);
+  else if (!_active())
+    return;
+  else if (name == SpellingTable::Define)
+    _macros->define(first + 1, last);
+  else if (name == SpellingTable::Undef)
+    _macros->undef(first + 1, last);
+  else if (name == _includeName)
+    _include(first + 1, last);
+  else if (name == _lineName)
+    _line(first + 1, last, endLine);
+  else if (name == _errorName)
+    throw std::runtime_error("#error" + _join(first + 1, last));
+  else if (name == _pragmaName)
+    _pragma(first + 1, last);
+  else
+    throw std::runtime_error("non-directive #" + _spellings.spelling(first->spelling));
+}
+
+void Preprocessor::_if(uint32_t name, const MacroToken *first, const MacroToken *last)
+{
+  // Within a skipped group nothing is evaluated, and no group is kept.
+  if (!_active()) {
+    _conditionals.push_back(Conditional{false, true, false});
+    return;
+  }
+
+  bool value;
+  if (name == _ifName)
+    value = _evaluate(first, last);
+  else
+    value = _defined(first, last) == (name == _ifdefName);
+  _conditionals.push_back(Conditional{value, value, false});
+}
+
+void Preprocessor::_elif(const MacroToken *first, const MacroToken *last)
+{
+  if (_conditionals.size() == _frameConditionals())
+    throw std::runtime_error("#elif without #if");
+  Conditional &c = _conditionals.back();
+  if (c.sawElse)
+    throw std::runtime_error("#elif after #else");
+  if (c.taken) {
+    c.active = false;
+  } else {
+    c.active = _evaluate(first, last);
+    c.taken = c.active;
+  }
+}
+
+void Preprocessor::_else(const MacroToken *first, const MacroToken *last)
+{
+  if (_conditionals.size() == _frameConditionals())
+    throw std::runtime_error("#else without #if");
+  Conditional &c = _conditionals.back();
+  if (c.sawElse)
+    throw std::runtime_error("#else after #else");
+  // As the reference implementation, not within a skipped group.
+  if (first != last  &&  _outerActive())
+    throw std::runtime_error("#else with tokens after it");
+  c.sawElse = true;
+  c.active = !c.taken;
+  c.taken = true;
+}
+
+void Preprocessor::_endif(const MacroToken *first, const MacroToken *last)
+{
+  if (_conditionals.size() == _frameConditionals())
+    throw std::runtime_error("#endif without #if");
+  if (first != last  &&  _outerActive())
+    throw std::runtime_error("#endif with tokens after it");
+  _conditionals.pop_back();
+}
+
+bool Preprocessor::_defined(const MacroToken *first, const MacroToken *last)
+{
+  if (first == last  ||  first->type != PPTokenType::Identifier)
+    throw std::runtime_error("#ifdef or #ifndef without a macro name");
+  return isDefined(first->spelling);
+}
+
+bool Preprocessor::_evaluate(const MacroToken *first, const MacroToken *last)
+{
+  // The operand of `defined` is put in its own hide set, so macro
+  // replacement leaves it alone.
+  _directiveTokens.assign(first, last);
+  const size_t n = _directiveTokens.size();
+  for (size_t i = 0; i < n; i++) {
+    if (_directiveTokens[i].type != PPTokenType::Identifier  ||  _directiveTokens[i].spelling != _definedName)
+      continue;
+    size_t j = i + 1;
+    if (j < n  &&  _directiveTokens[j].spelling == SpellingTable::LParen)
+      j++;
+    if (j < n  &&  _directiveTokens[j].type == PPTokenType::Identifier) {
+      MacroToken &t = _directiveTokens[j];
+      t.hideSet = _hideSets->insert(t.hideSet, t.spelling);
+    }
+  }
+  _expandDirective(_directiveTokens.data(), _directiveTokens.data() + n);
+
+  // Post-tokenized as in PA3.
+  _ctrlExpr.clear();
+  for (const MacroToken &t: _expanded) {
+    const char *begin = _spellings.data(t.spelling);
+    const char *end = begin + _spellings.length(t.spelling);
+    switch (t.type) {
+      case PPTokenType::Identifier:
+        if (t.spelling == _definedName)
+          _ctrlExpr.push_back(CtrlExprToken::defined(t.spelling));
+        else
+          _ctrlExpr.push_back(CtrlExprToken::identifier(t.spelling, t.spelling == _trueName));
+        break;
+      case PPTokenType::PPNumber: {
+        const IntegerLiteral r = IntegerLiteralDecoder::decode(begin, end);
+        if (r.kind == IntegerLiteral::Integer)
+          _ctrlExpr.push_back(CtrlExprToken::literal(r.value, !r.isSigned()));
+        else
+          _ctrlExpr.push_back(CtrlExprToken::invalid());
+        break;
+      }
+      case PPTokenType::CharacterLiteral: {
+        const CharacterLiteral r = CharacterLiteralDecoder::decode(begin, end);
+        if (r.kind == CharacterLiteral::Character)
+          _ctrlExpr.push_back(CtrlExprToken::literal(r.value, !r.isSigned()));
+        else
+          _ctrlExpr.push_back(CtrlExprToken::invalid());
+        break;
+      }
+      case PPTokenType::PreprocessingOpOrPunc: {
+        _source.assign(begin, end);
+        const auto it = StringToTokenTypeMap.find(_source);
+        if (it == StringToTokenTypeMap.end())
+          _ctrlExpr.push_back(CtrlExprToken::invalid());
+        else
+          _ctrlExpr.push_back(CtrlExprToken::punctuator(it->second));
+        break;
+      }
+      default:
+        _ctrlExpr.push_back(CtrlExprToken::invalid());
+        break;
+    }
+  }
+
+  const CtrlExprResult result = _evaluator.evaluate(_ctrlExpr.data(), _ctrlExpr.data() + _ctrlExpr.size(), *this);
+  if (result.error)
+    throw std::runtime_error(std::string("#if: ") + result.error);
+  return result.value != 0;
+}
+
+void Preprocessor::_include(const MacroToken *first, const MacroToken *last)
+{
+  std::string nextf;
+  if (first != last  &&  first->type == PPTokenType::HeaderName) {
+    const char *data = _spellings.data(first->spelling);
+    nextf.assign(data + 1, _spellings.length(first->spelling) - 2);
+  } else {
+    _expandDirective(first, last);
+    if (_expanded.size() != 1  ||  !_decodeString(_expanded[0], nextf))
+      throw std::runtime_error("#include expects a header-name or a string-literal");
+  }
+
+  std::string path;
+  SourceFileId id;
+  // The prefix is only valid while the files tried before this one stay
+  // absent.
+  if (!_resolver.resolve(_frames.back().presumedName, nextf, path, id, _recording ? &_recording->absent : nullptr))
+    throw std::runtime_error("cannot find include file " + nextf);
+
+  _includes++;
+  if (_onceFiles.count(id)) {
+    if (_includeIfc)
+      _includeIfc->skip(path, id);
+    return;
+  }
+  const SourceFile *guarded = _sources.find(id);
+  uint32_t guard = guarded ? guarded->guard : SpellingTable::Placemarker;
+  if (!guarded) {
+    const auto it = _prefixGuards.find(id);
+    if (it != _prefixGuards.end())
+      guard = it->second;
+  }
+  if (guard != SpellingTable::Placemarker  &&  isDefined(guard)) {
+    _guardedIncludes++;
+    if (_includeIfc)
+      _includeIfc->skip(path, id);
+    // The file is part of the prefix as well: it must keep its guard.
+    if (_recording)
+      _recordFile(path, guarded);
+    return;
+  }
+  const SourceFile *file = _sources.open(path);
+  if (!file)
+    throw std::runtime_error("cannot open " + path);
+  _enter(file, path);
+}
+
+void Preprocessor::_line(const MacroToken *first, const MacroToken *last, uint32_t endLine)
+{
+  _expandDirective(first, last);
+
+  IntegerLiteral number;
+  number.kind = IntegerLiteral::Invalid;
+  if (!_expanded.empty()  &&  _expanded[0].type == PPTokenType::PPNumber) {
+    const char *data = _spellings.data(_expanded[0].spelling);
+    number = IntegerLiteralDecoder::decode(data, data + _spellings.length(_expanded[0].spelling));
+  }
+  if (number.kind != IntegerLiteral::Integer  ||  number.value == 0  ||  _expanded.size() > 2)
+    throw std::runtime_error("#line expects a positive integer and an optional string-literal");
+
+  Frame &f = _frames.back();
+  if (_expanded.size() == 2) {
+    if (!_decodeString(_expanded[1], f.presumedName))
+      throw std::runtime_error("#line expects a positive integer and an optional string-literal");
+    f.nameSpelling = 0;
+  }
+  // The line after the directive is the number given.
+  f.lineDelta = static_cast<int64_t>(number.value) - (static_cast<int64_t>(endLine) + 1);
+}
+
+void Preprocessor::_pragma(const MacroToken *first, const MacroToken *last)
+{
+  if (first != last  &&  first->type == PPTokenType::Identifier  &&  first->spelling == _onceName)
+    _pragmaOnce();
+}
+
+void Preprocessor::_pragmaOnce()
+{
+  SourceFileId id;
+  if (!_sources.fileId(_frames.back().presumedName, id))
+    throw std::runtime_error("#pragma once: cannot find " + _frames.back().presumedName);
+  _onceFiles.insert(id);
+}
+
+void Preprocessor::_startPrefix()
+{
+  // The #include lines the file starts with. The key is the search
+  // directories and the paths the lines resolve to.
+  Frame &f = _frames.back();
+  const std::deque<SourceSegment> &segments = f.file->segments;
+  std::string key;
+  for (const std::string &searchPath: _resolver.searchPaths())
+    key += searchPath + '\0';
+  size_t end = 0;
+  for (size_t i = 0; i < segments.size(); i++) {
+    if (segments[i].blank)
+      continue;
+    const std::vector<MacroToken> &tokens = segments[i].tokens;
+    if (!segments[i].directive  ||  tokens.size() < 3
+        ||  tokens[1].type != PPTokenType::Identifier  ||  tokens[1].spelling != _includeName
+        ||  tokens[2].type != PPTokenType::HeaderName
+        ||  (tokens.size() > 3  &&  tokens[3].type != PPTokenType::NewLine))
+      break;
+
+    const uint32_t s = tokens[2].spelling;
+    std::string path;
+    SourceFileId id;
+    // The error is left to the #include.
+    if (!_resolver.resolve(f.presumedName, std::string(_spellings.data(s) + 1, _spellings.length(s) - 2), path, id))
+      return;
+    key += '\0' + path;
+    end = i + 1;
+  }
+  if (end == 0)
+    return;
+
+  if (std::shared_ptr<const PrefixSnapshot> snapshot = _snapshots->find(key)) {
+    _restorePrefix(*snapshot);
+    f.pos = end;
+    return;
+  }
+  _recording.reset(new PrefixSnapshot());
+  _prefixKey = key;
+  _prefixEnd = end;
+}
+
+void Preprocessor::_restorePrefix(const PrefixSnapshot &snapshot)
+{
+  _resetMacros();
+  _defineClock();
+  for (const PrefixSnapshot::Macro &m: snapshot.macros) {
+    MacroDefinition d = m.definition;
+    d.params = m.params.data();
+    d.body = m.body.data();
+    _macros->define(d);
+  }
+  for (const PrefixSnapshot::File &file: snapshot.files) {
+    if (_includeIfc)
+      _includeIfc->skip(file.path, file.id);
+    if (file.once)
+      _onceFiles.insert(file.id);
+    if (file.guard != SpellingTable::Placemarker)
+      _prefixGuards[file.id] = file.guard;
+  }
+  if (!snapshot.tokens.empty()) {
+    _out->put(snapshot.tokens.data(), snapshot.tokens.data() + snapshot.tokens.size());
+    if (_includeIfc)
+      _includeIfc->output(snapshot.tokens.size());
+  }
+}
+
+void Preprocessor::_recordFile(const std::string &path, const SourceFile *file)
+{
+  if (_prefixFileIds.insert(file->id).second)
+    _prefixFiles.emplace_back(path, file);
+}
+
+void Preprocessor::_finishPrefix()
+{
+  std::shared_ptr<PrefixSnapshot> snapshot = std::move(_recording);
+  _recording.reset();
+
+  // The clock would be replayed, and a #pragma once after a #line may name
+  // a file the snapshot does not check.
+  for (MacroToken &t: snapshot->tokens) {
+    if (t.spelling == _dateSpelling  ||  t.spelling == _timeSpelling)
+      return;
+    t.hideSet = 0;
+    t.line = 0;
+  }
+  for (const SourceFileId &id: _onceFiles) {
+    if (!_prefixFileIds.count(id))
+      return;
+  }
+  // Nor would the clock be left to the restoring run if the prefix changed
+  // __DATE__ or __TIME__.
+  const MacroDefinition *date = _macros->find(_dateMacro);
+  const MacroDefinition *time = _macros->find(_timeMacro);
+  if (!date  ||  date->bodyLength != 1  ||  date->body[0].spelling != _dateSpelling
+      ||  !time  ||  time->bodyLength != 1  ||  time->body[0].spelling != _timeSpelling)
+    return;
+
+  for (const auto &entry: _prefixFiles) {
+    const SourceFile *file = entry.second;
+    PrefixSnapshot::File f;
+    f.path = entry.first;
+    f.id = file->id;
+    f.size = file->size;
+    f.mtime = 0;
+    f.hash = PrefixSnapshot::hash(file->data, file->size);
+    f.guard = file->guard;
+    f.once = _onceFiles.count(file->id) != 0;
+    snapshot->files.push_back(f);
+  }
+  std::vector<std::string> &absent = snapshot->absent;
+  std::sort(absent.begin(), absent.end());
+  absent.erase(std::unique(absent.begin(), absent.end()), absent.end());
+  for (const MacroDefinition &d: _macros->definitions()) {
+    if (d.dynamic  ||  d.name == _dateMacro  ||  d.name == _timeMacro)
+      continue;
+    PrefixSnapshot::Macro m;
+    m.definition = d;
+    m.definition.params = nullptr;
+    m.definition.body = nullptr;
+    m.params.assign(d.params, d.params + d.numParams);
+    m.body.assign(d.body, d.body + d.bodyLength);
+    snapshot->macros.push_back(std::move(m));
+  }
+  _snapshots->store(_prefixKey, snapshot);
+}
+
+void Preprocessor::_flushText()
+{
+  if (_text.empty())
+    return;
+  _expanded.clear();
+  _expander->expand(_text.data(), _text.data() + _text.size(), _expanded);
+  _text.clear();
+  _executePragmaOperators();
+  if (_recording)
+    _recording->tokens.insert(_recording->tokens.end(), _expanded.begin(), _expanded.end());
+  if (!_expanded.empty()) {
+    _out->put(_expanded.data(), _expanded.data() + _expanded.size());
+    if (_includeIfc)
+      _includeIfc->output(_expanded.size());
+  }
+}
+
+void Preprocessor::_executePragmaOperators()
+{
+  const size_t n = _expanded.size();
+  size_t o = 0;
+  for (size_t i = 0; i < n; ) {
+    if (_expanded[i].type != PPTokenType::Identifier  ||  _expanded[i].spelling != _pragmaOperator) {
+      _expanded[o++] = _expanded[i++];
+      continue;
+    }
+    if (i + 3 >= n  ||  _expanded[i + 1].spelling != SpellingTable::LParen
+        ||  _expanded[i + 2].type != PPTokenType::StringLiteral  ||  _expanded[i + 3].spelling != SpellingTable::RParen)
+      throw std::runtime_error("_Pragma expects ( string-literal )");
+
+    const uint32_t s = _expanded[i + 2].spelling;
+    if (pragmaName(destringize(_spellings.data(s), _spellings.length(s))) == "once")
+      _pragmaOnce();
+    i += 4;
+  }
+  _expanded.resize(o);
+}
+
+void Preprocessor::_expandDirective(const MacroToken *first, const MacroToken *last)
+{
+  _expanded.clear();
+  _expander->expand(first, last, _expanded);
+}
+
+bool Preprocessor::_decodeString(const MacroToken &token, std::string &out)
+{
+  if (token.type != PPTokenType::StringLiteral)
+    return false;
+  _source = _spellings.spelling(token.spelling);
+  if (_source[0] != '"'  &&  _source.compare(0, 2, "R\"") != 0)
+    return false;
+  if (StringLiteralDecoder::decode(&_source, &_source + 1, _literal))
+    return false;
+  // Without the terminating 0.
+  out.assign(_literal.data, 0, _literal.data.size() - 1);
+  return true;
+}
+
+std::string Preprocessor::_join(const MacroToken *first, const MacroToken *last) const
+{
+  std::string s;
+  for (; first != last; first++) {
+    s += ' ';
+    s.append(_spellings.data(first->spelling), _spellings.length(first->spelling));
+  }
+  return s;
+}
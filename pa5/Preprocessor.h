@@ -0,0 +1,202 @@
+#ifndef Preprocessor_h
+#define Preprocessor_h
+
+#include "IncludeResolver.h"
+#include "PrefixSnapshot.h"
+#include "SourceManager.h"
+#include "pa2/StringLiteralDecoder.h"
+#include "pa3/CtrlExpr.h"
+#include "pa4/HideSet.h"
+#include "pa4/MacroExpander.h"
+#include "pa4/MacroTable.h"
+#include "pa4/MacroToken.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+// Receives the preprocessed tokens of a source file.
+class PreprocessorOutputIfc {
+public:
+  virtual ~PreprocessorOutputIfc() {}
+  // The tokens of a text-sequence, after macro replacement and _Pragma.
+  virtual void put(const MacroToken *first, const MacroToken *last) = 0;
+};
+
+// Follows the files a Preprocessor goes through.
+class PreprocessorIncludeIfc {
+public:
+  virtual ~PreprocessorIncludeIfc() {}
+  // `file` is entered at `path`: the source file, or an #include of the
+  // current file.
+  virtual void enter(const std::string &path, const SourceFile &file) = 0;
+  // The current file is left.
+  virtual void leave() = 0;
+  // An #include of the current file that did not enter `path`: it has
+  // #pragma once, or its include guard is defined, or it is part of a prefix
+  // restored from a snapshot.
+  virtual void skip(const std::string &path, const SourceFileId &id) = 0;
+  // The current file output `n` tokens.
+  virtual void output(size_t n) = 0;
+};
+
+// Phase 4 as in PA5: executes the preprocessing directives of a source file
+// and of the files it includes, and macro replaces the text-sequences.
+//
+// Files come from a SourceManager, already lexed, so including a header again,
+// from this source file or a later one, costs no I/O and no lexing; text is
+// lexed the first time a group keeps it. Each source file is preprocessed on
+// its own: macros, #pragma once and the conditional and include stacks start
+// anew, while spellings, lexed files and compiled #if expressions are shared.
+//
+// Course-defined rules, as in the reference implementation:
+//
+//   - #include looks up its file with an IncludeResolver: relative to the
+//     directory of __FILE__, then relative to the working directory, then in
+//     the search directories, if any.
+//   - #pragma once and _Pragma("once") are the only pragmas, others are
+//     ignored.
+//   - A conditional started in a file must end in that file.
+//
+// An #include of a file already lexed whose include guard is defined is
+// skipped without entering the file.
+//
+// With a PreprocessorIncludeIfc, the files entered and the #include
+// directives executed are told as they go, for dependency lists and the like.
+//
+// With a PrefixSnapshotStore, a source file starting with #include lines of
+// header-names takes the state after them from the snapshot of those lines,
+// if there is a valid one, instead of preprocessing them: the macros, the
+// #pragma once set, the include guards of the files and the output. Else
+// the state after them is stored as the snapshot, unless the output has
+// __DATE__ or __TIME__ in it.
+class Preprocessor: private DynamicMacroIfc, private CtrlExprDefinedIfc {
+public:
+  // `date` and `time` are the values of __DATE__ and __TIME__, without quotes.
+  Preprocessor(SourceManager &sources, IncludeResolver &resolver, const std::string &date, const std::string &time);
+
+  // Preprocesses the source file at `path`. Throws std::runtime_error on
+  // errors.
+  void run(const std::string &path, PreprocessorOutputIfc &out);
+
+  // Restores and stores the prefixes of source files in `snapshots`, if not
+  // nullptr.
+  void setSnapshots(PrefixSnapshotStore *snapshots) { _snapshots = snapshots; }
+
+  // The values of __DATE__ and __TIME__ from the next run on.
+  void setClock(const std::string &date, const std::string &time);
+
+  // Tells `includes`, if not nullptr, of the files of every run.
+  void setIncludes(PreprocessorIncludeIfc *includes) { _includeIfc = includes; }
+
+  // Over all runs: the #include directives executed, and those of them
+  // skipped because the file's include guard was defined.
+  size_t includes() const { return _includes; }
+  size_t guardedIncludes() const { return _guardedIncludes; }
+
+  static const size_t MaxIncludeDepth = 200;
+
+private:
+  // A file being preprocessed.
+  struct Frame {
+    const SourceFile *file;
+    size_t pos;                 // of the next segment in file->segments
+    std::string presumedName;   // __FILE__
+    int64_t lineDelta;          // __LINE__ minus the physical line, set by #line
+    uint32_t nameSpelling;      // __FILE__ as a string-literal, 0 until needed
+    size_t conditionals;        // the depth of the conditional stack on entry
+  };
+
+  // A conditional, #if to #endif.
+  struct Conditional {
+    bool active;                // the current group is kept
+    bool taken;                 // a group was or is kept, or none may be
+    bool sawElse;
+  };
+
+  MacroToken replace(const MacroToken &head) override;
+  bool isDefined(uint32_t name) const override { return _macros->find(name) != nullptr; }
+
+  void _reset();
+  void _resetMacros();
+  void _definePredefined(const char *name, PPTokenType type, const std::string &value);
+  void _defineClock();
+  void _enter(const SourceFile *file, const std::string &presumedName);
+  size_t _frameConditionals() const { return _frames.back().conditionals; }
+  bool _active() const { return _conditionals.empty()  ||  _conditionals.back().active; }
+  // Whether the group the innermost conditional is in is kept.
+  bool _outerActive() const
+  { return _conditionals.size() < 2  ||  _conditionals[_conditionals.size() - 2].active; }
+
+  void _directive(const MacroToken *first, const MacroToken *last, uint32_t endLine);
+  void _if(uint32_t name, const MacroToken *first, const MacroToken *last);
+  void _elif(const MacroToken *first, const MacroToken *last);
+  void _else(const MacroToken *first, const MacroToken *last);
+  void _endif(const MacroToken *first, const MacroToken *last);
+  bool _evaluate(const MacroToken *first, const MacroToken *last);
+  bool _defined(const MacroToken *first, const MacroToken *last);
+  void _include(const MacroToken *first, const MacroToken *last);
+  void _line(const MacroToken *first, const MacroToken *last, uint32_t endLine);
+  void _pragma(const MacroToken *first, const MacroToken *last);
+  void _pragmaOnce();
+
+  void _startPrefix();
+  void _restorePrefix(const PrefixSnapshot &snapshot);
+  void _recordFile(const std::string &path, const SourceFile *file);
+  void _finishPrefix();
+
+  void _flushText();
+  void _executePragmaOperators();
+  void _expandDirective(const MacroToken *first, const MacroToken *last);
+  bool _decodeString(const MacroToken &token, std::string &out);
+  std::string _join(const MacroToken *first, const MacroToken *last) const;
+
+  SourceManager &_sources;
+  IncludeResolver &_resolver;
+  SpellingTable &_spellings;
+  std::string _date;
+  std::string _time;
+  CtrlExprEvaluator _evaluator;
+  size_t _includes;
+  size_t _guardedIncludes;
+
+  // Ids of the names the directives are compared against.
+  uint32_t _ifName, _ifdefName, _ifndefName, _elifName, _elseName, _endifName, _includeName, _lineName, _errorName, _pragmaName, _onceName;
+  uint32_t _definedName, _trueName, _pragmaOperator, _fileMacro, _lineMacro, _dateMacro, _timeMacro;
+  // The replacements of __DATE__ and __TIME__.
+  uint32_t _dateSpelling, _timeSpelling;
+
+  // Per source file.
+  std::unique_ptr<HideSetTable> _hideSets;
+  std::unique_ptr<MacroTable> _macros;
+  std::unique_ptr<MacroExpander> _expander;
+  std::set<SourceFileId> _onceFiles;
+  std::vector<Frame> _frames;
+  std::vector<Conditional> _conditionals;
+  PreprocessorOutputIfc *_out;
+  PreprocessorIncludeIfc *_includeIfc;
+
+  // The prefix of the source file, while it is being recorded.
+  PrefixSnapshotStore *_snapshots;
+  std::shared_ptr<PrefixSnapshot> _recording;
+  std::string _prefixKey;
+  size_t _prefixEnd;            // in the segments of the source file
+  std::vector<std::pair<std::string, const SourceFile *>> _prefixFiles;
+  std::set<SourceFileId> _prefixFileIds;
+  // The include guards of the files of a restored prefix, not lexed maybe.
+  std::map<SourceFileId, uint32_t> _prefixGuards;
+
+  // Scratch.
+  std::vector<MacroToken> _text;
+  std::vector<MacroToken> _expanded;
+  std::vector<MacroToken> _directiveTokens;
+  std::string _source;
+  StringLiteral _literal;
+  std::vector<CtrlExprToken> _ctrlExpr;
+};
+
+#endif /* end of include guard */
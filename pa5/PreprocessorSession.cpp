@@ -0,0 +1,68 @@
+#include "PreprocessorSession.h"
+
+#include <exception>
+
+PreprocessorSession::PreprocessorSession(FileSystemIfc &files):
+  _sources(_spellings, files), _runs(0), _includes(0), _guardedIncludes(0)
+{
+}
+
+void PreprocessorSession::setSnapshotDirectory(const std::string &directory)
+{
+  _snapshots.reset(new PrefixSnapshotStore(_sources, directory));
+}
+
+void PreprocessorSession::run(const Request &request, PreprocessorOutputIfc &out)
+{
+  Search *search;
+  std::unique_ptr<Preprocessor> preprocessor;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    search = &_search(request.searchPaths);
+    if (!search->idle.empty()) {
+      preprocessor = std::move(search->idle.back());
+      search->idle.pop_back();
+    }
+  }
+  if (preprocessor)
+    preprocessor->setClock(request.date, request.time);
+  else
+    preprocessor.reset(new Preprocessor(_sources, *search->resolver, request.date, request.time));
+  preprocessor->setSnapshots(_snapshots.get());
+  preprocessor->setIncludes(request.includes);
+
+  // The Preprocessor starts anew on every run, whether the last one failed
+  // or not.
+  const size_t includes = preprocessor->includes();
+  const size_t guardedIncludes = preprocessor->guardedIncludes();
+  std::exception_ptr error;
+  try {
+    preprocessor->run(request.path, out);
+  } catch (...) {
+    error = std::current_exception();
+  }
+  _runs++;
+  _includes += preprocessor->includes() - includes;
+  _guardedIncludes += preprocessor->guardedIncludes() - guardedIncludes;
+  preprocessor->setIncludes(nullptr);
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    search->idle.push_back(std::move(preprocessor));
+  }
+  if (error)
+    std::rethrow_exception(error);
+}
+
+IncludeResolver &PreprocessorSession::resolver(const std::vector<std::string> &searchPaths)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return *_search(searchPaths).resolver;
+}
+
+PreprocessorSession::Search &PreprocessorSession::_search(const std::vector<std::string> &searchPaths)
+{
+  Search &search = _searches[searchPaths];
+  if (!search.resolver)
+    search.resolver.reset(new IncludeResolver(_sources, searchPaths));
+  return search;
+}
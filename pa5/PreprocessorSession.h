@@ -0,0 +1,88 @@
+#ifndef PreprocessorSession_h
+#define PreprocessorSession_h
+
+#include "FileSystem.h"
+#include "IncludeResolver.h"
+#include "PrefixSnapshot.h"
+#include "Preprocessor.h"
+#include "SourceManager.h"
+
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// What preprocessing keeps from one request to the next, for a process that
+// serves many: the spellings, the files read with their tokens and include
+// guards, the file ids of paths, the directory listings and #include
+// results of each set of search directories, snapshots of prefixes, and
+// idle Preprocessors with their compiled #if expressions. Everything is
+// read through a FileSystemIfc, so a session may run on files in memory.
+//
+// The files are assumed not to change while the session lives; one that
+// sees them change starts a new session.
+//
+// A session may be used by threads at once; each run has a Preprocessor of
+// its own.
+class PreprocessorSession {
+public:
+  // A source file to preprocess.
+  struct Request {
+    std::string path;
+    std::vector<std::string> searchPaths;       // -I and --stdinc
+    std::string date;                           // __DATE__ and __TIME__, without quotes
+    std::string time;
+    PreprocessorIncludeIfc *includes = nullptr; // told of the files of the run, if not nullptr
+  };
+
+  // Reads through `files`, which must outlive the session.
+  explicit PreprocessorSession(FileSystemIfc &files);
+
+  PreprocessorSession(const PreprocessorSession &) = delete;
+  PreprocessorSession &operator=(const PreprocessorSession &) = delete;
+
+  // Restores and stores the prefixes of source files in `directory`. Not
+  // while a run is going on.
+  void setSnapshotDirectory(const std::string &directory);
+
+  // Preprocesses the source file of `request` into `out`. Throws
+  // std::runtime_error on errors.
+  void run(const Request &request, PreprocessorOutputIfc &out);
+
+  SpellingTable &spellings() { return _spellings; }
+  SourceManager &sources() { return _sources; }
+  // The resolver of `searchPaths`, made by the first call.
+  IncludeResolver &resolver(const std::vector<std::string> &searchPaths);
+  PrefixSnapshotStore *snapshots() { return _snapshots.get(); }
+
+  // Over all runs: the runs, the #include directives executed, and those of
+  // them skipped because the file's include guard was defined.
+  size_t runs() const { return _runs; }
+  size_t includes() const { return _includes; }
+  size_t guardedIncludes() const { return _guardedIncludes; }
+
+private:
+  // The resolver of a set of search directories, and the Preprocessors
+  // using it that are not running.
+  struct Search {
+    std::unique_ptr<IncludeResolver> resolver;
+    std::vector<std::unique_ptr<Preprocessor>> idle;
+  };
+
+  Search &_search(const std::vector<std::string> &searchPaths);
+
+  SpellingTable _spellings;
+  SourceManager _sources;
+  std::unique_ptr<PrefixSnapshotStore> _snapshots;
+
+  std::mutex _mutex;                            // of _searches
+  std::map<std::vector<std::string>, Search> _searches;
+  std::atomic<size_t> _runs;
+  std::atomic<size_t> _includes;
+  std::atomic<size_t> _guardedIncludes;
+};
+
+#endif /* end of include guard */
@@ -0,0 +1,268 @@
+#include "SourceManager.h"
+
+#include "SourceScanner.h"
+#include "pa1/PPCodeUnitStream.h"
+#include "pa1/PPTokenizerDFA.h"
+#include "pa1/PPUTF32Stream.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+SourceManager::SourceManager(SpellingTable &spellings, FileSystemIfc &files):
+  _spellings(spellings), _fileSystem(&files), _hits(0), _misses(0), _fileIdHits(0), _fileIdMisses(0),
+  _bytesRead(0), _bytesLexed(0)
+{
+  _ifName = _spellings.intern("if");
+  _ifdefName = _spellings.intern("ifdef");
+  _ifndefName = _spellings.intern("ifndef");
+  _elifName = _spellings.intern("elif");
+  _elseName = _spellings.intern("else");
+  _endifName = _spellings.intern("endif");
+  _definedName = _spellings.intern("defined");
+  _notName = _spellings.intern("!");
+}
+
+SourceManager::SourceManager(SpellingTable &spellings, FileIdFunction fileId):
+  SourceManager(spellings, *new DiskFileSystem(fileId))
+{
+  _disk.reset(_fileSystem);
+}
+
+const SourceFile *SourceManager::open(const std::string &path)
+{
+  SourceFileId id;
+  if (!fileId(path, id))
+    return nullptr;
+
+  Slot *slot;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::unique_ptr<Slot> &s = _files[id];
+    if (!s) {
+      s.reset(new Slot());
+      s->ready.store(nullptr, std::memory_order_relaxed);
+    }
+    slot = s.get();
+  }
+
+  const SourceFile *file = slot->ready.load(std::memory_order_acquire);
+  if (!file) {
+    std::lock_guard<std::mutex> lock(slot->mutex);
+    file = slot->ready.load(std::memory_order_acquire);
+    if (!file) {
+      slot->file = _read(id, path);
+      file = slot->file.get();
+      slot->ready.store(file, std::memory_order_release);
+      _misses++;
+      return file;
+    }
+  }
+  _hits++;
+  return file;
+}
+
+const SourceFile *SourceManager::find(const SourceFileId &id) const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto it = _files.find(id);
+  return it == _files.end() ? nullptr : it->second->ready.load(std::memory_order_acquire);
+}
+
+bool SourceManager::fileId(const std::string &path, SourceFileId &id)
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const auto it = _paths.find(path);
+    if (it != _paths.end()) {
+      _fileIdHits++;
+      id = it->second.id;
+      return it->second.found;
+    }
+  }
+
+  PathId p;
+  p.found = _fileSystem->fileId(path, p.id);
+  _fileIdMisses++;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _paths.emplace(path, p);
+  }
+  id = p.id;
+  return p.found;
+}
+
+const std::vector<MacroToken> &SourceManager::tokens(const SourceFile &file, const SourceSegment &segment)
+{
+  if (!segment.lexed.load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> lock(file.mutex);
+    if (!segment.lexed.load(std::memory_order_relaxed)) {
+      // The scanner has made sure the lines lex without error.
+      std::string error;
+      _lex(file.data + segment.begin, segment.end - segment.begin, segment.line, segment.tokens, error);
+      if (!error.empty())
+        throw std::runtime_error(error);
+      segment.lexed.store(true, std::memory_order_release);
+    }
+  }
+  return segment.tokens;
+}
+
+std::unique_ptr<SourceFile> SourceManager::_read(const SourceFileId &id, const std::string &path)
+{
+  std::unique_ptr<SourceFile> f(new SourceFile());
+  f->id = id;
+  f->path = path;
+  f->guard = SpellingTable::Placemarker;
+  f->contents = _fileSystem->read(path);
+  f->data = f->contents->data();
+  f->size = f->contents->size();
+  _bytesRead += f->size;
+  _split(*f);
+  if (f->error.empty())
+    _findGuard(*f);
+  return f;
+}
+
+void SourceManager::_split(SourceFile &file)
+{
+  std::vector<SourceScanner::Segment> scanned;
+  const size_t end = SourceScanner::scan(file.data, file.size, scanned);
+  for (const SourceScanner::Segment &s: scanned) {
+    file.segments.emplace_back(s.begin, s.end, s.line, s.directive, s.blank, s.directive);
+    if (s.directive) {
+      SourceSegment &segment = file.segments.back();
+      _lex(file.data + s.begin, s.end - s.begin, s.line, segment.tokens, file.error);
+    }
+  }
+  if (end == file.size)
+    return;
+
+  // The rest is lexed whole and split by its NewLine tokens.
+  std::vector<MacroToken> tokens;
+  const uint32_t line = 1 + std::count(file.data, file.data + end, '\n');
+  _lex(file.data + end, file.size - end, line, tokens, file.error);
+  const size_t numScanned = file.segments.size();
+  for (size_t i = 0; i != tokens.size(); ) {
+    size_t j = i;
+    while (j != tokens.size()  &&  tokens[j++].type != PPTokenType::NewLine)
+      ;
+    const bool directive = SpellingTable::isHash(tokens[i].spelling);
+    const bool blank = tokens[i].type == PPTokenType::NewLine;
+    if (directive  ||  file.segments.size() == numScanned  ||  file.segments.back().directive)
+      file.segments.emplace_back(end, file.size, tokens[i].line, directive, blank, true);
+    SourceSegment &segment = file.segments.back();
+    segment.blank = segment.blank  &&  blank;
+    segment.tokens.insert(segment.tokens.end(), tokens.begin() + i, tokens.begin() + j);
+    i = j;
+  }
+}
+
+void SourceManager::_lex(const char *data, size_t size, uint32_t line, std::vector<MacroToken> &tokens, std::string &error)
+{
+  _bytesLexed += size;
+  auto u32s = std::make_shared<PPUTF32Stream>(data, size);
+  auto cus = std::make_shared<PPCodeUnitStream>(u32s);
+  PPTokenizerDFA dfa(cus);
+
+  // Only the first line of the file follows no new-line.
+  bool space = line != 1;
+  for (; !dfa.isEmpty(); dfa.toNext()) {
+    if (!dfa.getErrorMessage().empty()) {
+      error = dfa.getErrorMessage();
+      return;
+    }
+
+    const std::shared_ptr<PPToken> token = dfa.getPPToken();
+    const uint32_t tokenLine = line - 1 + dfa.getLine();
+    switch (token->getType()) {
+      case PPTokenType::NewLine:
+        tokens.push_back(MacroToken::make(PPTokenType::NewLine, SpellingTable::Placemarker, space, tokenLine));
+        space = true;
+        break;
+      case PPTokenType::WhitespaceSequence:
+        space = true;
+        break;
+      default:
+        tokens.push_back(MacroToken::make(token->getType(), _spellings.intern(token->getRawText()), space, tokenLine));
+        space = false;
+        break;
+    }
+  }
+}
+
+void SourceManager::_findGuard(SourceFile &file) const
+{
+  // The segments of the file, skipping the blank ones.
+  size_t i = 0;
+  auto next = [&]() -> const SourceSegment * {
+    while (i != file.segments.size()  &&  file.segments[i].blank)
+      i++;
+    return i == file.segments.size() ? nullptr : &file.segments[i++];
+  };
+  // The tokens of a directive line, without its new-line.
+  const MacroToken *first;
+  const MacroToken *last;
+  auto line = [&](const SourceSegment &s) {
+    first = s.tokens.data();
+    last = first + s.tokens.size();
+    if (last != first  &&  last[-1].type == PPTokenType::NewLine)
+      last--;
+  };
+
+  const SourceSegment *s = next();
+  if (!s  ||  !s->directive)
+    return;
+  line(*s);
+  const uint32_t guard = _ifndefGuard(first, last);
+  if (guard == SpellingTable::Placemarker)
+    return;
+
+  // Whether each open group has seen #else; the guard's own group may have
+  // neither #elif nor #else.
+  std::vector<bool> sawElse(1, true);
+  while ((s = next())) {
+    if (!s->directive)
+      continue;
+    line(*s);
+    const uint32_t name = _directiveName(first, last);
+    if (name == _ifName  ||  name == _ifdefName  ||  name == _ifndefName) {
+      sawElse.push_back(false);
+    } else if (name == _elifName  ||  name == _elseName) {
+      if (sawElse.back())
+        return;
+      sawElse.back() = name == _elseName;
+    } else if (name == _endifName) {
+      sawElse.pop_back();
+      if (sawElse.empty())
+        break;
+    }
+  }
+  if (sawElse.empty()  &&  !next())
+    file.guard = guard;
+}
+
+uint32_t SourceManager::_directiveName(const MacroToken *first, const MacroToken *last) const
+{
+  if (last - first < 2  ||  !SpellingTable::isHash(first[0].spelling)  ||  first[1].type != PPTokenType::Identifier)
+    return SpellingTable::Placemarker;
+  return first[1].spelling;
+}
+
+uint32_t SourceManager::_ifndefGuard(const MacroToken *first, const MacroToken *last) const
+{
+  const uint32_t name = _directiveName(first, last);
+  const size_t n = last - first;
+  // # ifndef X
+  if (name == _ifndefName  &&  n == 3  &&  first[2].type == PPTokenType::Identifier)
+    return first[2].spelling;
+  if (name != _ifName  ||  n < 5  ||  first[2].spelling != _notName  ||  first[3].spelling != _definedName)
+    return SpellingTable::Placemarker;
+  // # if ! defined X
+  if (n == 5  &&  first[4].type == PPTokenType::Identifier)
+    return first[4].spelling;
+  // # if ! defined ( X )
+  if (n == 7  &&  first[4].spelling == SpellingTable::LParen  &&  first[5].type == PPTokenType::Identifier
+      &&  first[6].spelling == SpellingTable::RParen)
+    return first[5].spelling;
+  return SpellingTable::Placemarker;
+}
@@ -0,0 +1,151 @@
+#ifndef SourceManager_h
+#define SourceManager_h
+
+#include "FileSystem.h"
+#include "pa4/MacroToken.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// A directive line of a source file, or the run of other lines between two
+// directive lines.
+//
+// `tokens` are the preprocessing-tokens of phase 3 with the new-lines kept,
+// as NewLine tokens; whitespace only sets precededBySpace. Every token has
+// the physical line it starts on. Directive lines are lexed with the file,
+// other lines only when SourceManager::tokens() is first asked for them.
+struct SourceSegment {
+  SourceSegment(size_t begin, size_t end, uint32_t line, bool directive, bool blank, bool lexed):
+    begin(begin), end(end), line(line), directive(directive), blank(blank), lexed(lexed)
+  {}
+
+  size_t begin;                 // offsets in the bytes of the file
+  size_t end;
+  uint32_t line;                // the physical line of `begin`
+  bool directive;
+  bool blank;                   // no tokens but new-lines
+  mutable std::atomic<bool> lexed;
+  mutable std::vector<MacroToken> tokens;
+};
+
+// A source file, read and split into segments once.
+struct SourceFile {
+  SourceFileId id;
+  std::string path;             // the path it was first opened by
+  std::unique_ptr<FileContents> contents;
+  const char *data;             // those of `contents`
+  size_t size;
+  std::deque<SourceSegment> segments;
+  std::string error;            // of PPTokenizerDFA; `segments` stop there
+  uint32_t guard;               // the include guard macro, Placemarker if none
+  mutable std::mutex mutex;     // held while a segment is lexed
+};
+
+// Reads every source file once per process, through a FileSystemIfc, and
+// keeps its tokens.
+//
+// Files are keyed by their file id, so a header reached by different paths,
+// or included by many source files, is read and lexed only the first time.
+// A SourceScanner finds the lines of a file without lexing it; the text
+// between directives is lexed the first time it is asked for, so a group
+// skipped by every #if costs a scan, not PPTokenizerDFA. The lines the
+// scanner stops at and those after are lexed with the file, and keep its
+// errors.
+// The spellings of the tokens are interned in the SpellingTable given, which
+// must outlive the SourceManager and be the one of every MacroTable the
+// tokens are used with.
+//
+// Reading a file also looks for an include guard: the file is a single
+// #ifndef X / #if !defined X group, with no #elif or #else at its level and
+// nothing but new-lines around it, and lexes without error. Once X is
+// defined, including the file again yields nothing, whatever it contains.
+//
+// A SourceManager may be shared by the threads preprocessing different
+// source files. Looking up the file id of a path is cached as well, files
+// are assumed not to appear or disappear meanwhile. Threads opening the same
+// new file wait for the one that reads it, and files already read are found
+// under a short lock.
+class SourceManager {
+public:
+  typedef DiskFileSystem::FileIdFunction FileIdFunction;
+
+  // Reads through `files`, which must outlive the SourceManager.
+  SourceManager(SpellingTable &spellings, FileSystemIfc &files);
+  // Reads from disk.
+  SourceManager(SpellingTable &spellings, FileIdFunction fileId);
+
+  SourceManager(const SourceManager &) = delete;
+  SourceManager &operator=(const SourceManager &) = delete;
+
+  // The file at `path`, or nullptr if there is none. Throws
+  // std::runtime_error if it exists but cannot be read.
+  const SourceFile *open(const std::string &path);
+
+  // The file with `id` if it has been read, else nullptr; no I/O at all.
+  const SourceFile *find(const SourceFileId &id) const;
+
+  // false if there is no file at `path`.
+  bool fileId(const std::string &path, SourceFileId &id);
+
+  // The tokens of `segment` of `file`, lexed by the first call.
+  const std::vector<MacroToken> &tokens(const SourceFile &file, const SourceSegment &segment);
+
+  SpellingTable &spellings() { return _spellings; }
+  FileSystemIfc &fileSystem() { return *_fileSystem; }
+
+  // Files found already read by open(), and read by it.
+  size_t hits() const { return _hits; }
+  size_t misses() const { return _misses; }
+  size_t size() const { return _misses; }
+  // Paths looked up by fileId(), and looked up by the FileIdFunction.
+  size_t fileIdHits() const { return _fileIdHits; }
+  size_t fileIdMisses() const { return _fileIdMisses; }
+  // Bytes of the files read, and of them lexed.
+  size_t bytesRead() const { return _bytesRead; }
+  size_t bytesLexed() const { return _bytesLexed; }
+
+private:
+  struct Slot {
+    std::mutex mutex;                           // held while the file is read
+    std::unique_ptr<SourceFile> file;
+    std::atomic<const SourceFile *> ready;      // `file` once read
+  };
+
+  struct PathId {
+    bool found;
+    SourceFileId id;
+  };
+
+  std::unique_ptr<SourceFile> _read(const SourceFileId &id, const std::string &path);
+  void _split(SourceFile &file);
+  void _lex(const char *data, size_t size, uint32_t line, std::vector<MacroToken> &tokens, std::string &error);
+  void _findGuard(SourceFile &file) const;
+  uint32_t _directiveName(const MacroToken *first, const MacroToken *last) const;
+  uint32_t _ifndefGuard(const MacroToken *first, const MacroToken *last) const;
+
+  SpellingTable &_spellings;
+  uint32_t _ifName, _ifdefName, _ifndefName, _elifName, _elseName, _endifName, _definedName, _notName;
+  std::unique_ptr<FileSystemIfc> _disk;         // if reading from disk
+  FileSystemIfc *_fileSystem;
+
+  mutable std::mutex _mutex;                    // of _files and _paths
+  std::map<SourceFileId, std::unique_ptr<Slot>> _files;
+  std::unordered_map<std::string, PathId> _paths;
+  std::atomic<size_t> _hits;
+  std::atomic<size_t> _misses;
+  std::atomic<size_t> _fileIdHits;
+  std::atomic<size_t> _fileIdMisses;
+  std::atomic<size_t> _bytesRead;
+  std::atomic<size_t> _bytesLexed;
+};
+
+#endif /* end of include guard */
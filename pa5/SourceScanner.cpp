@@ -0,0 +1,466 @@
+#include "SourceScanner.h"
+
+#include <cstring>
+#include <string>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+  bool isDigit(char c)
+  {
+    return c >= '0'  &&  c <= '9';
+  }
+
+  bool isHexDigit(char c)
+  {
+    return isDigit(c)  ||  (c >= 'a'  &&  c <= 'f')  ||  (c >= 'A'  &&  c <= 'F');
+  }
+
+  // A digit or an identifier-nondigit of the basic source character set.
+  bool isIdentifierChar(char c)
+  {
+    return isDigit(c)  ||  (c >= 'a'  &&  c <= 'z')  ||  (c >= 'A'  &&  c <= 'Z')  ||  c == '_';
+  }
+
+  bool isHorizontalSpace(char c)
+  {
+    return c == ' '  ||  c == '\t'  ||  c == '\v'  ||  c == '\f';
+  }
+
+  bool isRawPrefix(const char *p, size_t n)
+  {
+    return (n == 1  &&  p[0] == 'R')
+      ||  (n == 2  &&  (p[0] == 'u'  ||  p[0] == 'U'  ||  p[0] == 'L')  &&  p[1] == 'R')
+      ||  (n == 3  &&  memcmp(p, "u8R", 3) == 0);
+  }
+
+  // Whether the \ at `p` starts a universal-character-name. PPCodeUnitStream
+  // turns one into the character it names, which may be a quote or a
+  // new-line as well.
+  bool isUniversalCharacterName(const char *p, const char *end)
+  {
+    const int n = p[1] == 'u' ? 4 : p[1] == 'U' ? 8 : 0;
+    if (n == 0  ||  end - (p + 2) < n)
+      return false;
+    for (int i = 0; i < n; i++) {
+      if (!isHexDigit(p[2 + i]))
+        return false;
+    }
+    return true;
+  }
+
+  // Whether the ?? at `p` starts a trigraph, which PPCodeUnitStream replaces
+  // by the character it stands for.
+  bool isTrigraph(const char *p, const char *end)
+  {
+    return end - p > 2  &&  p[2] != 0  &&  strchr("=/'()!<>-", p[2]);
+  }
+
+  // The first new-line, quote or slash of [p, end), `end` if there is none.
+  const char *findSpecial(const char *p, const char *end)
+  {
+#ifdef __SSE2__
+    const __m128i newLine = _mm_set1_epi8('\n');
+    const __m128i doubleQuote = _mm_set1_epi8('"');
+    const __m128i singleQuote = _mm_set1_epi8('\'');
+    const __m128i slash = _mm_set1_epi8('/');
+    for (; end - p >= 16; p += 16) {
+      const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+      const __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, newLine), _mm_cmpeq_epi8(v, doubleQuote)),
+                                     _mm_or_si128(_mm_cmpeq_epi8(v, singleQuote), _mm_cmpeq_epi8(v, slash)));
+      if (const int mask = _mm_movemask_epi8(m))
+        return p + __builtin_ctz(mask);
+    }
+#endif
+    for (; p != end; p++) {
+      if (*p == '\n'  ||  *p == '"'  ||  *p == '\''  ||  *p == '/')
+        return p;
+    }
+    return end;
+  }
+
+  // Whether `include` is one of the words of [p, end).
+  bool hasInclude(const char *p, const char *end)
+  {
+    const char *begin = p;
+    while ((p = static_cast<const char *>(memmem(p, end - p, "include", 7)))) {
+      if ((p == begin  ||  !isIdentifierChar(p[-1]))  &&  (p + 7 == end  ||  !isIdentifierChar(p[7])))
+        return true;
+      p++;
+    }
+    return false;
+  }
+
+  // Where PPTokenizerDFA is in the run of identifier characters, dots and
+  // signs before a quote; it decides what the quote starts.
+  enum class Run {
+    None,
+    Dot,
+    DotDot,
+    Identifier,
+    Literal,            // right after a literal, where a ud-suffix may follow
+    Suffix,
+    Number,
+    NumberE,
+  };
+
+  class Scanner {
+  public:
+    Scanner(const char *data, size_t size, std::vector<SourceScanner::Segment> &segments):
+      _data(data), _end(data + size), _segments(segments), _line(1), _counted(data), _resume(nullptr),
+      _resumeAt(nullptr), _resumeState(Run::None)
+    {}
+
+    size_t run();
+
+  private:
+    const char *_space(const char *p);
+    const char *_directive(const char *line, const char *p);
+    const char *_text(const char *p);
+    const char *_lineComment(const char *p);
+    const char *_blockComment(const char *p);
+    const char *_literal(const char *p);
+    const char *_quoted(const char *p);
+    const char *_raw(const char *p);
+    void _add(const char *begin, const char *end, bool directive, bool blank);
+
+    const char *const _data;
+    const char *const _end;
+    std::vector<SourceScanner::Segment> &_segments;
+    uint32_t _line;             // of _counted
+    const char *_counted;
+
+    // A run of identifier characters starting at _resume continues what
+    // ended there, in _resumeState as of _resumeAt.
+    const char *_resume;
+    const char *_resumeAt;
+    Run _resumeState;
+  };
+
+  // Every function scanning a part of a line returns where the part ends,
+  // or nullptr if the line cannot be scanned. The file ends with a new-line,
+  // so looking one byte past anything but a new-line stays in it.
+  size_t Scanner::run()
+  {
+    if (_data == _end  ||  _end[-1] != '\n')
+      return 0;
+    for (const char *p = _data; (p = static_cast<const char *>(memchr(p, '\\', _end - p))); p++) {
+      if (isUniversalCharacterName(p, _end))
+        return 0;
+    }
+    for (const char *p = _data; (p = static_cast<const char *>(memmem(p, _end - p, "??", 2))); p++) {
+      if (isTrigraph(p, _end))
+        return 0;
+    }
+
+    const char *p = _data;
+    while (p != _end) {
+      const char *q = _space(p);
+      const char *next = nullptr;
+      bool directive = false;
+      bool blank = false;
+      if (!q) {
+        break;
+      } else if (*q == '\n') {
+        next = q + 1;
+        blank = true;
+      } else if (q[0] == '/'  &&  q[1] == '/') {
+        next = _lineComment(q);
+        blank = true;
+      } else if (q[0] == '#'  &&  q[1] != '#') {
+        next = _directive(p, q + 1);
+        directive = true;
+      } else if (q[0] != '%'  ||  q[1] != ':') {
+        // A # before the first identifier makes PPTokenizerDFA take what
+        // follows an `include` as a header-name, even on a text line.
+        next = _text(q);
+        if (next  &&  memchr(q, '#', next - q)  &&  hasInclude(q, next))
+          next = nullptr;
+      }
+      if (!next)
+        break;
+      _add(p, next, directive, blank);
+      p = next;
+    }
+    return p - _data;
+  }
+
+  // Skips the whitespace, line-splices and block comments starting a line.
+  const char *Scanner::_space(const char *p)
+  {
+    for (;;) {
+      if (isHorizontalSpace(*p)) {
+        p++;
+      } else if (p[0] == '\\'  &&  p[1] == '\n') {
+        p += 2;
+        if (p == _end)
+          return nullptr;
+      } else if (p[0] == '/'  &&  p[1] == '*') {
+        if (!(p = _blockComment(p)))
+          return nullptr;
+      } else {
+        return p;
+      }
+    }
+  }
+
+  // A directive line, `p` after its #. Whether a < or a " starts a
+  // header-name depends on more than PPTokenizerDFA's rules for #include, so
+  // only the plain forms are scanned.
+  const char *Scanner::_directive(const char *line, const char *p)
+  {
+    while (isHorizontalSpace(*p))
+      p++;
+    if (*p == '/'  ||  *p == '\\')
+      return nullptr;
+    const char *name = p;
+    while (isIdentifierChar(*p))
+      p++;
+    if (*p == '\\')
+      return nullptr;
+
+    if (p - name != 7  ||  memcmp(name, "include", 7) != 0) {
+      const char *end = _text(p);
+      return end  &&  !hasInclude(line, end) ? end : nullptr;
+    }
+
+    while (isHorizontalSpace(*p))
+      p++;
+    if (*p == '/'  ||  *p == '\\')
+      return nullptr;
+    if (*p == '<'  ||  *p == '"') {
+      // Scanned as a string-literal would be, if it makes no difference.
+      const char close = *p == '<' ? '>' : '"';
+      for (p++; *p != close; p++) {
+        if (*p == '\n'  ||  *p == '\\')
+          return nullptr;
+        if (close == '>'  &&  (*p == '\''  ||  *p == '"'  ||  (*p == '/'  &&  (p[1] == '*'  ||  p[1] == '/'))))
+          return nullptr;
+      }
+      p++;
+      _resume = _resumeAt = p;
+      _resumeState = Run::None;
+    }
+    const char *end = _text(p);
+    if (!end  ||  memchr(p, '<', end - p)  ||  memchr(p, '"', end - p))
+      return nullptr;
+    return end;
+  }
+
+  // The rest of a line from `p`.
+  const char *Scanner::_text(const char *p)
+  {
+    for (;;) {
+      p = findSpecial(p, _end);
+      if (p == _end)
+        return nullptr;
+      if (*p == '\n') {
+        if (p == _data  ||  p[-1] != '\\')
+          return p + 1;
+        p++;
+      } else if (*p == '/') {
+        if (p[1] == '/')
+          return _lineComment(p);
+        if (p[1] != '*')
+          p++;
+        else if (!(p = _blockComment(p)))
+          return nullptr;
+      } else if (!(p = _literal(p))) {
+        return nullptr;
+      }
+    }
+  }
+
+  // To the end of the line, which line-splices continue.
+  const char *Scanner::_lineComment(const char *p)
+  {
+    for (p += 2; p != _end; p++) {
+      p = static_cast<const char *>(memchr(p, '\n', _end - p));
+      if (p[-1] != '\\')
+        return p + 1;
+    }
+    return nullptr;
+  }
+
+  const char *Scanner::_blockComment(const char *p)
+  {
+    const void *end = memmem(p + 2, _end - (p + 2), "*/", 2);
+    return end ? static_cast<const char *>(end) + 2 : nullptr;
+  }
+
+  // A quote, which starts a literal unless it is a digit separator.
+  const char *Scanner::_literal(const char *p)
+  {
+    const char *q = p;
+    while (q != _data  &&  (isIdentifierChar(q[-1])  ||  q[-1] == '.'  ||  q[-1] == '+'  ||  q[-1] == '-'))
+      q--;
+
+    Run state = Run::None;
+    const char *r = q;
+    if (q == _resume) {
+      state = _resumeState;
+      r = _resumeAt;
+    } else if (q != _data) {
+      // A quote not scanned, or an identifier continued by a line-splice or
+      // by a character outside the basic set.
+      const unsigned char c = q[-1];
+      if (c == '\''  ||  c == '"'  ||  c >= 0x80  ||  (c == '\n'  &&  q - 1 != _data  &&  q[-2] == '\\'))
+        return nullptr;
+    }
+
+    // As PPTokenizerDFA runs through the characters; each one not taken is
+    // looked at again in Run::None.
+    const char *identifier = r;
+    while (r != p) {
+      const char c = *r;
+      switch (state) {
+        case Run::None:
+          if (isDigit(c)) {
+            state = Run::Number;
+          } else if (c == '.') {
+            state = Run::Dot;
+          } else if (isIdentifierChar(c)) {
+            state = Run::Identifier;
+            identifier = r;
+          }
+          r++;
+          break;
+        case Run::Dot:
+        case Run::DotDot:
+          if (isDigit(c)) {
+            state = Run::Number;
+            r++;
+          } else if (c == '.') {
+            state = state == Run::Dot ? Run::DotDot : Run::None;
+            r++;
+          } else {
+            state = Run::None;
+          }
+          break;
+        case Run::Identifier:
+        case Run::Suffix:
+          if (isIdentifierChar(c))
+            r++;
+          else
+            state = Run::None;
+          break;
+        case Run::Literal:
+          if (isIdentifierChar(c)  &&  !isDigit(c)) {
+            state = Run::Suffix;
+            r++;
+          } else {
+            state = Run::None;
+          }
+          break;
+        case Run::Number:
+          if (c == 'e'  ||  c == 'E') {
+            state = Run::NumberE;
+            r++;
+          } else if (isIdentifierChar(c)  ||  c == '.') {
+            r++;
+          } else {
+            state = Run::None;
+          }
+          break;
+        case Run::NumberE:
+          state = Run::Number;
+          r++;
+          break;
+      }
+    }
+
+    const char *end;
+    if (*p == '\''  &&  state == Run::Number) {
+      // A digit separator, which a digit or a nondigit must follow.
+      if (!isIdentifierChar(p[1]))
+        return nullptr;
+      _resume = p + 1;
+      _resumeAt = p + 2;
+      _resumeState = Run::Number;
+      return p + 2;
+    } else if (*p == '"'  &&  state == Run::Identifier  &&  isRawPrefix(identifier, p - identifier)) {
+      end = _raw(p);
+    } else {
+      end = _quoted(p);
+    }
+    _resume = _resumeAt = end;
+    _resumeState = Run::Literal;
+    return end;
+  }
+
+  // A string-literal or a character-literal, from its opening quote. An
+  // error ends the scan.
+  const char *Scanner::_quoted(const char *p)
+  {
+    const char quote = *p;
+    for (p++; p != _end; ) {
+      if (*p == quote)
+        return p + 1;
+      if (*p == '\n')
+        return nullptr;
+      if (*p != '\\') {
+        p++;
+        continue;
+      }
+
+      const char c = p[1];
+      if (c == '\n') {
+        // A line-splice is a character of the literal.
+        p += 2;
+      } else if (c == '\\'  &&  p[2] == '\n') {
+        return nullptr;
+      } else if (c != 0  &&  strchr("'\"?\\abfnrtv", c)) {
+        p += 2;
+      } else if (c >= '0'  &&  c <= '7') {
+        p += 2;
+        for (int i = 0; i < 2  &&  *p >= '0'  &&  *p <= '7'; i++)
+          p++;
+      } else if (c == 'x') {
+        for (p += 2; isHexDigit(*p); p++)
+          ;
+      } else {
+        return nullptr;
+      }
+    }
+    return nullptr;
+  }
+
+  // A raw string-literal, from its opening quote; delimiters of identifier
+  // characters only.
+  const char *Scanner::_raw(const char *p)
+  {
+    const char *d = p + 1;
+    while (isIdentifierChar(*d))
+      d++;
+    if (*d != '(')
+      return nullptr;
+    const std::string close = ")" + std::string(p + 1, d) + "\"";
+    const void *end = memmem(d + 1, _end - (d + 1), close.data(), close.size());
+    return end ? static_cast<const char *>(end) + close.size() : nullptr;
+  }
+
+  void Scanner::_add(const char *begin, const char *end, bool directive, bool blank)
+  {
+    for (const char *p = _counted; (p = static_cast<const char *>(memchr(p, '\n', begin - p))); p++)
+      _line++;
+    _counted = begin;
+
+    if (!directive  &&  !_segments.empty()  &&  !_segments.back().directive
+        &&  _segments.back().end == static_cast<size_t>(begin - _data)) {
+      _segments.back().end = end - _data;
+      _segments.back().blank = _segments.back().blank  &&  blank;
+      return;
+    }
+    _segments.push_back(SourceScanner::Segment{static_cast<size_t>(begin - _data), static_cast<size_t>(end - _data),
+                                               _line, directive, blank});
+  }
+
+} // namespace
+
+size_t SourceScanner::scan(const char *data, size_t size, std::vector<Segment> &segments)
+{
+  return Scanner(data, size, segments).run();
+}
@@ -0,0 +1,39 @@
+#ifndef SourceScanner_h
+#define SourceScanner_h
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Splits a source file into lines without lexing it, so text that is never
+// output, in the groups #if skips, need not go through PPTokenizerDFA.
+//
+// The lines are the logical lines PPTokenizerDFA would delimit with its
+// NewLine tokens: a new-line ends one unless it is part of a line-splice, a
+// block comment or a raw string. A line whose first token would be # is a
+// directive line. The scanner searches for the few bytes that matter, new-
+// lines, quotes and slashes, 16 at a time where SSE2 is available, and
+// follows literals and comments exactly as PPTokenizerDFA does.
+//
+// It stops at the start of the first line it cannot vouch for: one with a
+// lexing error, or with a rare construct it does not follow, such as a
+// universal-character-name, a trigraph, a %: directive or an identifier
+// continued by a line-splice before a quote. The rest of the file has to be
+// lexed then.
+class SourceScanner {
+public:
+  // Directive lines one by one, the other lines in runs.
+  struct Segment {
+    size_t begin;               // offsets in the file
+    size_t end;
+    uint32_t line;              // the physical line of `begin`, from 1
+    bool directive;
+    bool blank;                 // of whitespace and comments only
+  };
+
+  // Appends the segments of `data` to `segments` and returns the offset
+  // where scanning stopped, `size` if it did not.
+  static size_t scan(const char *data, size_t size, std::vector<Segment> &segments);
+};
+
+#endif /* end of include guard */
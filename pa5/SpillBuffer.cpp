@@ -0,0 +1,65 @@
+#include "SpillBuffer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+const size_t SpillBuffer::DefaultLimit;
+
+SpillBuffer::SpillBuffer(size_t limit): _limit(limit), _file(nullptr)
+{
+}
+
+SpillBuffer::~SpillBuffer()
+{
+  if (_file)
+    std::fclose(_file);
+}
+
+SpillBuffer::int_type SpillBuffer::overflow(int_type c)
+{
+  if (!_error.empty())
+    return traits_type::eof();
+
+  size_t size = pptr() - pbase();
+  if (_memory.size() < _limit) {
+    _memory.resize(std::min(std::max<size_t>(2 * _memory.size(), 4096), _limit));
+  } else {
+    if (!_file  &&  !(_file = std::tmpfile())) {
+      _error = std::string("cannot create a temporary file: ") + std::strerror(errno);
+      return traits_type::eof();
+    }
+    if (std::fwrite(pbase(), 1, size, _file) != size) {
+      _error = std::string("cannot write a temporary file: ") + std::strerror(errno);
+      return traits_type::eof();
+    }
+    size = 0;
+  }
+  setp(_memory.data(), _memory.data() + _memory.size());
+  pbump(static_cast<int>(size));
+
+  if (!traits_type::eq_int_type(c, traits_type::eof())) {
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+  }
+  return traits_type::not_eof(c);
+}
+
+void SpillBuffer::copyTo(std::ostream &out)
+{
+  if (_file  &&  _error.empty()  &&  (std::fflush(_file) != 0  ||  std::fseek(_file, 0, SEEK_SET) != 0))
+    _error = std::string("cannot read a temporary file: ") + std::strerror(errno);
+  if (!_error.empty())
+    throw std::runtime_error(_error);
+
+  if (_file) {
+    std::vector<char> chunk(std::min<size_t>(_limit, 1 << 16));
+    size_t n;
+    while ((n = std::fread(chunk.data(), 1, chunk.size(), _file)) != 0)
+      out.write(chunk.data(), n);
+    if (std::ferror(_file))
+      throw std::runtime_error("cannot read a temporary file");
+  }
+  out.write(pbase(), pptr() - pbase());
+}
@@ -0,0 +1,48 @@
+#ifndef SpillBuffer_h
+#define SpillBuffer_h
+
+#include <cstddef>
+#include <cstdio>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+// An output kept in memory up to a limit, and past it in an unnamed
+// temporary file, as a std::streambuf for an std::ostream to format into.
+// Once complete, it is copied out to another stream.
+//
+// The memory grows with the output up to the limit; then every time it is
+// full it is appended to the file, so memory stays the limit whatever the
+// size of the output.
+class SpillBuffer: public std::streambuf {
+public:
+  static const size_t DefaultLimit = 1 << 20;
+
+  // `limit` is at least 1.
+  explicit SpillBuffer(size_t limit = DefaultLimit);
+  // Removes the file, if any.
+  ~SpillBuffer();
+
+  SpillBuffer(const SpillBuffer &) = delete;
+  SpillBuffer &operator=(const SpillBuffer &) = delete;
+
+  // Writes the output to `out`, from its start; not to be formatted into
+  // after. Throws std::runtime_error if the file could not be created,
+  // written or read.
+  void copyTo(std::ostream &out);
+
+  // Whether the output went past the limit.
+  bool spilled() const { return _file != nullptr; }
+
+protected:
+  int_type overflow(int_type c) override;
+
+private:
+  size_t _limit;
+  std::vector<char> _memory;
+  std::FILE *_file;
+  std::string _error;           // of the first failure
+};
+
+#endif /* end of include guard */
@@ -0,0 +1,105 @@
+#ifndef TestSupport_h
+#define TestSupport_h
+
+#include "FileSystem.h"
+#include "Preprocessor.h"
+
+#include <cstdlib>
+#include <dirent.h>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// What the unit tests of PA5 share. Tests whose files may as well be in
+// memory use a MemoryFileSystem; the others, a TemporaryDirectory on disk.
+
+// The file id of `path`, as preproc has PA5GetFileId make it.
+inline bool statFileId(const std::string &path, SourceFileId &id)
+{
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0)
+    return false;
+  id = SourceFileId(st.st_dev, st.st_ino);
+  return true;
+}
+
+// A directory made under /tmp for a test, and removed with all it holds at
+// the end of it.
+class TemporaryDirectory {
+public:
+  explicit TemporaryDirectory(const std::string &test)
+  {
+    std::string name = "/tmp/" + test + ".XXXXXX";
+    if (!mkdtemp(&name[0]))
+      throw std::runtime_error("cannot make " + name);
+    _path = name;
+  }
+
+  ~TemporaryDirectory()
+  {
+    _remove(_path);
+  }
+
+  TemporaryDirectory(const TemporaryDirectory &) = delete;
+  TemporaryDirectory &operator=(const TemporaryDirectory &) = delete;
+
+  const std::string &path() const { return _path; }
+
+  // Makes the directory `name`, and those it is in.
+  std::string mkdir(const std::string &name)
+  {
+    for (size_t slash = name.find('/'); slash != std::string::npos; slash = name.find('/', slash + 1))
+      ::mkdir((_path + "/" + name.substr(0, slash)).c_str(), 0700);
+    const std::string path = _path + "/" + name;
+    ::mkdir(path.c_str(), 0700);
+    return path;
+  }
+
+  // Writes the file `name`, making the directories it is in.
+  std::string add(const std::string &name, const std::string &contents)
+  {
+    const size_t slash = name.rfind('/');
+    if (slash != std::string::npos)
+      mkdir(name.substr(0, slash));
+    const std::string path = _path + "/" + name;
+    std::ofstream(path) << contents;
+    return path;
+  }
+
+private:
+  static void _remove(const std::string &path)
+  {
+    if (DIR *d = opendir(path.c_str())) {
+      while (const dirent *entry = readdir(d)) {
+        const std::string name = entry->d_name;
+        if (name != "."  &&  name != ".."  &&  unlink((path + "/" + name).c_str()) != 0)
+          _remove(path + "/" + name);
+      }
+      closedir(d);
+    }
+    rmdir(path.c_str());
+  }
+
+  std::string _path;
+};
+
+// The spellings of the preprocessed tokens, separated by spaces.
+class Spellings: public PreprocessorOutputIfc {
+public:
+  explicit Spellings(const SpellingTable &spellings): _spellings(spellings) {}
+
+  void put(const MacroToken *first, const MacroToken *last) override
+  {
+    for (; first != last; first++)
+      text += (text.empty() ? "" : " ") + _spellings.spelling(first->spelling);
+  }
+
+  std::string text;
+
+private:
+  const SpellingTable &_spellings;
+};
+
+#endif /* end of include guard */
@@ -0,0 +1,153 @@
+#include "WatchedFileSystem.h"
+
+#include <cerrno>
+#include <stdexcept>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace {
+
+  // What a directory is watched for: its entries changing or being renamed,
+  // and itself going away.
+  const uint32_t Events = IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM |
+    IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+
+  // `path` without trailing slashes; `.` if that leaves nothing.
+  std::string directoryPath(const std::string &path)
+  {
+    size_t end = path.size();
+    while (end > 1  &&  path[end - 1] == '/')
+      end--;
+    return end ? path.substr(0, end) : ".";
+  }
+
+  // The directory `path` is in, and its name there.
+  void split(const std::string &path, std::string &directory, std::string &name)
+  {
+    const size_t slash = path.rfind('/');
+    if (slash == std::string::npos) {
+      directory = ".";
+      name = path;
+    } else {
+      directory = slash ? path.substr(0, slash) : "/";
+      name = path.substr(slash + 1);
+    }
+  }
+
+} // namespace
+
+WatchedFileSystem::WatchedFileSystem(FileSystemIfc &files): _files(files), _changed(false)
+{
+  _fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (_fd < 0)
+    throw std::runtime_error("cannot watch files: inotify not available");
+}
+
+WatchedFileSystem::~WatchedFileSystem()
+{
+  close(_fd);
+}
+
+bool WatchedFileSystem::changed()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  alignas(inotify_event) char buffer[1 << 16];
+  ssize_t n;
+  while ((n = ::read(_fd, buffer, sizeof buffer)) > 0) {
+    for (const char *p = buffer; p < buffer + n; ) {
+      const inotify_event *event = reinterpret_cast<const inotify_event *>(p);
+      p += sizeof *event + event->len;
+      if (event->mask & (IN_Q_OVERFLOW | IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF | IN_UNMOUNT)) {
+        _changed = true;
+        continue;
+      }
+      const auto d = _directories.find(event->wd);
+      if (d == _directories.end())
+        continue;
+      // A name not looked up that appears in a listed directory changes
+      // the listing; one that goes away only leaves a name that is
+      // looked up before it is used.
+      if ((event->len  &&  d->second.names.count(event->name))  ||
+          (d->second.listed  &&  (event->mask & (IN_CREATE | IN_MOVED_TO))))
+        _changed = true;
+    }
+  }
+  return _changed;
+}
+
+size_t WatchedFileSystem::watches()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _directories.size();
+}
+
+bool WatchedFileSystem::fileId(const std::string &path, SourceFileId &id)
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _watchName(path);
+  }
+  return _files.fileId(path, id);
+}
+
+bool WatchedFileSystem::status(const std::string &path, uint64_t &size, int64_t &mtime)
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _watchName(path);
+  }
+  return _files.status(path, size, mtime);
+}
+
+std::unique_ptr<FileContents> WatchedFileSystem::read(const std::string &path)
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _watchName(path);
+  }
+  return _files.read(path);
+}
+
+bool WatchedFileSystem::list(const std::string &directory, std::vector<std::string> &names)
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (Directory *d = _watchDirectory(directory))
+      d->listed = true;
+  }
+  return _files.list(directory, names);
+}
+
+void WatchedFileSystem::_watchName(const std::string &path)
+{
+  std::string directory, name;
+  split(path, directory, name);
+  Directory *d = _watchDirectory(directory);
+  if (d  &&  !name.empty())
+    d->names.insert(name);
+}
+
+WatchedFileSystem::Directory *WatchedFileSystem::_watchDirectory(const std::string &path)
+{
+  const std::string directory = directoryPath(path);
+  const auto w = _watches.find(directory);
+  if (w != _watches.end())
+    return w->second < 0 ? nullptr : &_directories[w->second];
+
+  // Paths of one directory share its watch descriptor.
+  const int wd = inotify_add_watch(_fd, directory.c_str(), Events | IN_ONLYDIR);
+  const int error = errno;
+  _watches[directory] = wd;
+  if (wd >= 0)
+    return &_directories[wd];
+
+  // A directory that is missing, or is not one, is watched for in the one
+  // before, so its creation is seen.
+  std::string parent, name;
+  split(directory, parent, name);
+  if ((error == ENOENT  ||  error == ENOTDIR)  &&  directoryPath(parent) != directory)
+    _watchName(directory);
+  else
+    _changed = true;
+  return nullptr;
+}
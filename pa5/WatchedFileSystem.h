@@ -0,0 +1,70 @@
+#ifndef WatchedFileSystem_h
+#define WatchedFileSystem_h
+
+#include "FileSystem.h"
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+// Another file system, watched with inotify for changes to what was asked of
+// it, so a process keeping what it read across requests knows when that may
+// be out of date.
+//
+// A change is a file that was looked up, found or not, being written,
+// created, removed or renamed; a name created in a directory that was
+// listed; or a watched directory, or one that was missing on the way to a
+// path, being removed, renamed or created. Anything that cannot be watched,
+// and events dropped by the kernel, count as changes. The watch is placed
+// before the call is passed on, so no change is missed in between.
+//
+// Relative paths are watched from the working directory at the time of the
+// call; a process that changes it must use one WatchedFileSystem per working
+// directory, and call each only from its own.
+class WatchedFileSystem: public FileSystemIfc {
+public:
+  // Over `files`. Throws std::runtime_error if inotify is not available.
+  explicit WatchedFileSystem(FileSystemIfc &files);
+  ~WatchedFileSystem();
+
+  WatchedFileSystem(const WatchedFileSystem &) = delete;
+  WatchedFileSystem &operator=(const WatchedFileSystem &) = delete;
+
+  // Whether anything changed since the object was made. Reads the events
+  // so far without waiting; once true, stays true.
+  bool changed();
+
+  // The directories watched.
+  size_t watches();
+
+  bool fileId(const std::string &path, SourceFileId &id) override;
+  bool status(const std::string &path, uint64_t &size, int64_t &mtime) override;
+  std::unique_ptr<FileContents> read(const std::string &path) override;
+  bool list(const std::string &directory, std::vector<std::string> &names) override;
+
+private:
+  // A directory watched, and what in it matters.
+  struct Directory {
+    bool listed = false;
+    std::set<std::string> names;
+  };
+
+  // Watches the name of `path` in its directory. Called locked.
+  void _watchName(const std::string &path);
+  // Watches the directory at `path`, or, if it is missing, its name in the
+  // directory before; nullptr then, and a change if it cannot be watched
+  // at all. Called locked.
+  Directory *_watchDirectory(const std::string &path);
+
+  FileSystemIfc &_files;
+  int _fd;
+  std::mutex _mutex;
+  std::map<int, Directory> _directories;                // by watch descriptor
+  std::map<std::string, int> _watches;                  // by directory path as given
+  bool _changed;
+};
+
+#endif /* end of include guard */
@@ -0,0 +1,63 @@
+#include "AsyncFileWriter.h"
+#include <gtest/gtest.h>
+#include <fstream>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+namespace {
+
+  std::string read(const std::string &path)
+  {
+    std::ifstream in(path);
+    std::ostringstream s;
+    s << in.rdbuf();
+    return s.str();
+  }
+
+} // namespace
+
+TEST(AsyncFileWriter, Blocks)
+{
+  char path[] = "/tmp/gtest_AsyncFileWriter.XXXXXX";
+  close(mkstemp(path));
+
+  // Lines and strings longer than a block, formatted ahead of the writes.
+  std::ostringstream expected;
+  AsyncFileWriter writer(path, 16, 3);
+  std::ostream out(&writer);
+  for (int i = 0; i < 1000; i++) {
+    out << "line " << i << '\n' << std::flush;
+    expected << "line " << i << '\n';
+    if (i % 100 == 0) {
+      out << std::string(50, 'a' + i / 100);
+      expected << std::string(50, 'a' + i / 100);
+    }
+  }
+  EXPECT_TRUE(out.good());
+  writer.close();
+  EXPECT_EQ(expected.str(), read(path));
+  EXPECT_EQ((expected.str().size() + 15) / 16, writer.blocksWritten());
+
+  // Nothing, and a second close.
+  AsyncFileWriter empty(path);
+  empty.close();
+  empty.close();
+  EXPECT_EQ("", read(path));
+  EXPECT_EQ(0u, empty.blocksWritten());
+  unlink(path);
+}
+
+TEST(AsyncFileWriter, Errors)
+{
+  EXPECT_THROW(AsyncFileWriter("/nonexistent/file"), std::runtime_error);
+
+  AsyncFileWriter writer("/dev/full", 16);
+  std::ostream out(&writer);
+  for (int i = 0; i < 100; i++)
+    out << "line " << i << '\n';
+  EXPECT_FALSE(out.good());
+  EXPECT_THROW(writer.close(), std::runtime_error);
+}
@@ -0,0 +1,92 @@
+#include "FileSystem.h"
+#include "TestSupport.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+  std::string contents(FileSystemIfc &files, const std::string &path)
+  {
+    const std::unique_ptr<FileContents> c = files.read(path);
+    return std::string(c->data(), c->size());
+  }
+
+  bool lists(FileSystemIfc &files, const std::string &directory, const std::string &name)
+  {
+    std::vector<std::string> names;
+    files.list(directory, names);
+    return std::find(names.begin(), names.end(), name) != names.end();
+  }
+
+} // namespace
+
+TEST(FileSystem, Memory)
+{
+  MemoryFileSystem files;
+  files.add("inc/sys/a.h", "a\n");
+  files.add("/abs/b.h", "");
+
+  SourceFileId id, id2;
+  ASSERT_TRUE(files.fileId("inc/sys/a.h", id));
+  EXPECT_EQ(MemoryFileSystem::Device, id.first);
+  ASSERT_TRUE(files.fileId("./inc//x/../sys/a.h", id2));
+  EXPECT_EQ(id, id2);
+  EXPECT_FALSE(files.fileId("inc/sys", id2));
+  EXPECT_FALSE(files.fileId("a.h", id2));
+  EXPECT_TRUE(files.fileId("/../abs/b.h", id2));
+
+  EXPECT_EQ("a\n", contents(files, "inc/sys/a.h"));
+  EXPECT_EQ("", contents(files, "/abs/b.h"));
+  EXPECT_THROW(files.read("c.h"), std::runtime_error);
+  uint64_t size;
+  int64_t mtime;
+  ASSERT_TRUE(files.status("inc/sys/a.h", size, mtime));
+  EXPECT_EQ(2u, size);
+
+  EXPECT_TRUE(lists(files, ".", "inc"));
+  EXPECT_TRUE(lists(files, "inc/", "sys"));
+  EXPECT_TRUE(lists(files, "inc/sys", "a.h"));
+  EXPECT_TRUE(lists(files, "/", "abs"));
+  std::vector<std::string> names;
+  EXPECT_FALSE(files.list("none", names));
+
+  // Replaced: a new file, while the old bytes stay readable.
+  const std::unique_ptr<FileContents> old = files.read("inc/sys/a.h");
+  files.add("inc/sys/a.h", "new\n");
+  ASSERT_TRUE(files.fileId("inc/sys/a.h", id2));
+  EXPECT_NE(id, id2);
+  EXPECT_EQ("a\n", std::string(old->data(), old->size()));
+  EXPECT_EQ("new\n", contents(files, "inc/sys/a.h"));
+  int64_t mtime2;
+  ASSERT_TRUE(files.status("inc/sys/a.h", size, mtime2));
+  EXPECT_NE(mtime, mtime2);
+}
+
+TEST(FileSystem, Overlay)
+{
+  TemporaryDirectory dir("gtest_FileSystem");
+  const std::string &d = dir.path();
+  dir.add("disk.h", "disk\n");
+  dir.add("both.h", "disk\n");
+
+  DiskFileSystem disk(statFileId);
+  MemoryFileSystem files(&disk);
+  files.add(d + "/both.h", "memory\n");
+  files.add(d + "/memory.h", "memory\n");
+
+  SourceFileId id;
+  ASSERT_TRUE(files.fileId(d + "/disk.h", id));
+  EXPECT_NE(MemoryFileSystem::Device, id.first);
+  EXPECT_EQ("disk\n", contents(files, d + "/disk.h"));
+  EXPECT_EQ("memory\n", contents(files, d + "/both.h"));
+  EXPECT_EQ("memory\n", contents(files, d + "/memory.h"));
+  EXPECT_FALSE(files.fileId(d + "/none.h", id));
+  EXPECT_THROW(files.read(d + "/none.h"), std::runtime_error);
+
+  EXPECT_TRUE(lists(files, d, "disk.h"));
+  EXPECT_TRUE(lists(files, d, "memory.h"));
+}
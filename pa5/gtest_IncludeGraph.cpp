@@ -0,0 +1,134 @@
+#include "IncludeGraph.h"
+#include "TestSupport.h"
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+  class Discard: public PreprocessorOutputIfc {
+  public:
+    void put(const MacroToken *, const MacroToken *) override {}
+  };
+
+  // Source files in memory, in `dir`, preprocessed by one Preprocessor into
+  // `graph`.
+  class Sources {
+  public:
+    Sources():
+      sources(spellings, files), resolver(sources, std::vector<std::string>()),
+      preprocessor(sources, resolver, "Mar 14 2013", "12:34:56"), dir("/src")
+    {
+      preprocessor.setIncludes(&graph);
+    }
+
+    void add(const std::string &name, const std::string &contents)
+    {
+      files.add(dir + "/" + name, contents);
+    }
+
+    void run(const std::string &path)
+    {
+      Discard out;
+      preprocessor.run(path, out);
+    }
+
+    const IncludeGraph::Node &node(const std::string &name)
+    {
+      SourceFileId id;
+      files.fileId(dir + "/" + name, id);
+      return graph.nodes().at(id);
+    }
+
+    size_t edge(const std::string &from, const std::string &to)
+    {
+      SourceFileId a, b;
+      files.fileId(dir + "/" + from, a);
+      files.fileId(dir + "/" + to, b);
+      const auto it = graph.edges().find(IncludeGraph::Edge(a, b));
+      return it == graph.edges().end() ? 0 : it->second;
+    }
+
+    MemoryFileSystem files;
+    SpellingTable spellings;
+    SourceManager sources;
+    IncludeResolver resolver;
+    Preprocessor preprocessor;
+    IncludeGraph graph;
+    const std::string dir;
+  };
+
+} // namespace
+
+TEST(IncludeGraph, Edges)
+{
+  Sources s;
+  s.add("a.h", "#ifndef A\n#define A\na1 a2\n#endif\n");
+  s.add("b.h", "#pragma once\n#include \"a.h\"\nb\n");
+  s.add("t.c", "#include \"b.h\"\n#include \"a.h\"\n#include \"b.h\"\nt1 t2 t3\n");
+  s.add("u.c", "#include \"a.h\"\n");
+  s.run(s.dir + "/t.c");
+  s.run(s.dir + "/u.c");
+
+  ASSERT_EQ(4u, s.graph.nodes().size());
+  EXPECT_TRUE(s.node("t.c").source);
+  EXPECT_FALSE(s.node("a.h").source);
+  EXPECT_EQ(2u, s.node("a.h").entered);
+  EXPECT_EQ(1u, s.node("b.h").entered);
+  // #pragma once and the include guard skip two #include directives.
+  EXPECT_EQ(2u, s.edge("t.c", "b.h"));
+  EXPECT_EQ(1u, s.edge("t.c", "a.h"));
+  EXPECT_EQ(1u, s.edge("b.h", "a.h"));
+  EXPECT_EQ(1u, s.edge("u.c", "a.h"));
+  EXPECT_EQ(0u, s.edge("a.h", "b.h"));
+  EXPECT_EQ(4u, s.graph.edges().size());
+
+  EXPECT_EQ(3u, s.node("t.c").tokens);
+  EXPECT_EQ(1u, s.node("b.h").tokens);
+  EXPECT_EQ(4u, s.node("a.h").tokens);
+  EXPECT_LE(s.node("t.c").selfTime, s.node("t.c").time);
+  EXPECT_LE(s.node("b.h").time, s.node("t.c").time);
+
+  std::ostringstream deps;
+  s.graph.writeDependencies(deps, "out file");
+  const std::string d = s.dir + "/";
+  EXPECT_EQ("out\\ file: \\\n  " + d + "t.c \\\n  " + d + "u.c \\\n  " + d + "a.h \\\n  " + d + "b.h\n"
+            "\n" + d + "a.h:\n\n" + d + "b.h:\n", deps.str());
+}
+
+TEST(IncludeGraph, Merge)
+{
+  Sources s;
+  s.add("a.h", "a\n");
+  s.add("t.c", "#include \"./a.h\"\n");
+  s.add("u.c", "#include \"a.h\"\n");
+  s.run(s.dir + "/t.c");
+  IncludeGraph first = s.graph;
+  s.graph = IncludeGraph();
+  s.run(s.dir + "/u.c");
+  s.run(s.dir + "/t.c");
+  s.graph.merge(first);
+
+  // The least path names the file.
+  EXPECT_EQ(s.dir + "/./a.h", s.node("a.h").path);
+  EXPECT_EQ(3u, s.node("a.h").entered);
+  EXPECT_EQ(3u, s.node("a.h").tokens);
+  EXPECT_EQ(2u, s.edge("t.c", "a.h"));
+  EXPECT_EQ(1u, s.edge("u.c", "a.h"));
+
+  std::ostringstream dot;
+  s.graph.writeDot(dot);
+  const std::string a = '"' + s.dir + "/./a.h\"";
+  const std::string t = '"' + s.dir + "/t.c\"";
+  EXPECT_EQ(0u, dot.str().find("digraph includes {\n"));
+  EXPECT_NE(std::string::npos, dot.str().find("  " + t + " -> " + a + " [label=\"2\"];\n"));
+  EXPECT_NE(std::string::npos, dot.str().find("  " + a + " [label=\"" + s.dir + "/./a.h\\n3 tokens, "));
+  EXPECT_NE(std::string::npos, dot.str().find(", style=bold];\n"));
+
+  std::ostringstream json;
+  s.graph.writeJson(json);
+  EXPECT_NE(std::string::npos,
+            json.str().find("{\"path\": " + a + ", \"source\": false, \"entered\": 3, \"tokens\": 3, "));
+  EXPECT_NE(std::string::npos, json.str().find("{\"from\": " + t + ", \"to\": " + a + ", \"count\": 2}"));
+}
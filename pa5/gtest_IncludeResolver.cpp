@@ -0,0 +1,89 @@
+#include "IncludeResolver.h"
+#include "TestSupport.h"
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+  // Files in memory, counting the file ids asked for.
+  class CountingFileSystem: public MemoryFileSystem {
+  public:
+    bool fileId(const std::string &path, SourceFileId &id) override
+    {
+      stats++;
+      return MemoryFileSystem::fileId(path, id);
+    }
+
+    size_t stats = 0;
+  };
+
+} // namespace
+
+TEST(IncludeResolver, Order)
+{
+  MemoryFileSystem files;
+  const std::string local = "/root/src/a.h";
+  const std::string b = "/root/inc1/b.h";
+  const std::string c = "/root/inc2/sys/c.h";
+  for (const std::string &path: {local, std::string("/root/inc1/a.h"), b, std::string("/root/inc2/b.h"), c})
+    files.add(path, "x\n");
+
+  SpellingTable spellings;
+  SourceManager sources(spellings, files);
+  IncludeResolver resolver(sources, {"/root/inc1", "/root/inc2/"});
+  const std::string includer = "/root/src/main.c";
+
+  std::string path;
+  SourceFileId id;
+  ASSERT_TRUE(resolver.resolve(includer, "a.h", path, id));
+  EXPECT_EQ(local, path);
+  ASSERT_TRUE(resolver.resolve(includer, "b.h", path, id));
+  EXPECT_EQ(b, path);
+  ASSERT_TRUE(resolver.resolve(includer, "sys/c.h", path, id));
+  EXPECT_EQ(c, path);
+  SourceFileId expected;
+  ASSERT_TRUE(sources.fileId(c, expected));
+  EXPECT_EQ(expected, id);
+
+  EXPECT_FALSE(resolver.resolve(includer, "none.h", path, id));
+
+  // absolute, and relative to the working directory
+  ASSERT_TRUE(resolver.resolve("main.c", b, path, id));
+  EXPECT_EQ(b, path);
+}
+
+TEST(IncludeResolver, Memo)
+{
+  CountingFileSystem files;
+  files.add("/root/inc/a.h", "x\n");
+
+  SpellingTable spellings;
+  SourceManager sources(spellings, files);
+  IncludeResolver resolver(sources, {"/root/none1", "/root/none2", "/root/inc"});
+  const std::string includer = "/root/main.c";
+
+  std::string path;
+  SourceFileId id;
+  ASSERT_TRUE(resolver.resolve(includer, "a.h", path, id));
+  // only the existing candidate is stat'ed, after listing 5 directories: the
+  // includer's, the working directory and the 3 search directories
+  EXPECT_EQ(1u, files.stats);
+  EXPECT_EQ(1u, resolver.stats());
+  EXPECT_EQ(5u, resolver.listings());
+  EXPECT_EQ(5u, resolver.naiveStats());
+
+  EXPECT_FALSE(resolver.resolve(includer, "b.h", path, id));
+  EXPECT_EQ(1u, files.stats);
+  EXPECT_EQ(5u, resolver.listings());
+
+  // memoized, negative results too
+  for (int i = 0; i < 10; i++) {
+    EXPECT_TRUE(resolver.resolve(includer, "a.h", path, id));
+    EXPECT_FALSE(resolver.resolve(includer, "b.h", path, id));
+  }
+  EXPECT_EQ(1u, files.stats);
+  EXPECT_EQ(5u, resolver.listings());
+  EXPECT_EQ(1u, resolver.stats());
+  EXPECT_EQ(5u + 5 + 10 * (5 + 5), resolver.naiveStats());
+}
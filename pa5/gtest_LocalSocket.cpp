@@ -0,0 +1,69 @@
+#include "LocalSocket.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+TEST(LocalSocket, Messages)
+{
+  const std::string path = "/tmp/gtest_LocalSocket." + std::to_string(getpid());
+  std::unique_ptr<LocalSocket> server = LocalSocket::listen(path);
+
+  // Each message comes back reversed; empty strings, messages and large
+  // strings included.
+  std::thread echo([&] {
+    std::unique_ptr<LocalSocket> client = server->accept();
+    std::vector<std::string> message;
+    while (client->receive(message)) {
+      std::vector<std::string> reversed(message.rbegin(), message.rend());
+      client->send(reversed);
+    }
+  });
+
+  std::unique_ptr<LocalSocket> client = LocalSocket::connect(path);
+  const std::vector<std::vector<std::string>> messages = {
+    {"/tmp", "-o", "out", "a.c"},
+    {},
+    {"", "x", ""},
+    {std::string(3 << 20, 'a'), std::string(1, '\0')},
+  };
+  for (const std::vector<std::string> &message : messages) {
+    client->send(message);
+    std::vector<std::string> reply;
+    ASSERT_TRUE(client->receive(reply));
+    EXPECT_EQ(std::vector<std::string>(message.rbegin(), message.rend()), reply);
+  }
+  client.reset();
+  echo.join();
+  EXPECT_THROW(LocalSocket::listen(path), std::runtime_error);
+
+  // The socket file goes with the server, and a stale one is replaced.
+  server.reset();
+  EXPECT_NE(0, access(path.c_str(), F_OK));
+  EXPECT_THROW(LocalSocket::connect(path), std::runtime_error);
+  server = LocalSocket::listen(path);
+  server.reset();
+}
+
+TEST(LocalSocket, Closed)
+{
+  const std::string path = "/tmp/gtest_LocalSocket.closed." + std::to_string(getpid());
+  std::unique_ptr<LocalSocket> server = LocalSocket::listen(path);
+
+  // A message sent before the other end closed is received, and then the
+  // end; sending to a closed connection is an error, not a signal.
+  std::thread peer([&] {
+    std::unique_ptr<LocalSocket> client = LocalSocket::connect(path);
+    client->send({"a"});
+  });
+  std::unique_ptr<LocalSocket> client = server->accept();
+  peer.join();
+  std::vector<std::string> message;
+  ASSERT_TRUE(client->receive(message));
+  EXPECT_EQ(std::vector<std::string>{"a"}, message);
+  EXPECT_FALSE(client->receive(message));
+  EXPECT_THROW({ for (int i = 0; i < 100; i++) client->send({std::string(1 << 16, 'a')}); }, std::runtime_error);
+}
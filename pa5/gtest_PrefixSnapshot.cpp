@@ -0,0 +1,237 @@
+#include "PrefixSnapshot.h"
+#include "Preprocessor.h"
+#include "TestSupport.h"
+#include <gtest/gtest.h>
+#include <dirent.h>
+#include <memory>
+#include <string>
+#include <sys/time.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+  // What one preproc process has: its own spellings, files and snapshots,
+  // the latter kept in `pchDir`.
+  struct Process {
+    explicit Process(const std::string &pchDir, const std::vector<std::string> &searchPaths = {}):
+      sources(spellings, statFileId), resolver(sources, searchPaths), snapshots(sources, pchDir),
+      preprocessor(sources, resolver, "Mar 14 2013", "12:34:56")
+    {
+      preprocessor.setSnapshots(&snapshots);
+    }
+
+    std::string run(const std::string &path)
+    {
+      Spellings out(spellings);
+      preprocessor.run(path, out);
+      return out.text;
+    }
+
+    SpellingTable spellings;
+    SourceManager sources;
+    IncludeResolver resolver;
+    PrefixSnapshotStore snapshots;
+    Preprocessor preprocessor;
+  };
+
+  // Source files, and a directory of snapshots, removed at the end of the
+  // test.
+  class Files: public TemporaryDirectory {
+  public:
+    Files(): TemporaryDirectory("gtest_PrefixSnapshot")
+    {
+      mkdir("pch");
+    }
+
+    // Sets the modification time of `name` to `seconds`.
+    void touch(const std::string &name, long seconds)
+    {
+      const struct timeval times[2] = {{seconds, 0}, {seconds, 0}};
+      utimes((path() + "/" + name).c_str(), times);
+    }
+
+    std::string pchDir() const { return path() + "/pch"; }
+  };
+
+  const char *const Header =
+    "#ifndef A_H\n"
+    "#define A_H\n"
+    "#define twice(x) (x) + (x)\n"
+    "int a = twice(1);\n"
+    "#endif\n";
+
+} // namespace
+
+TEST(PrefixSnapshot, Hash)
+{
+  EXPECT_EQ(14695981039346656037u, PrefixSnapshot::hash("", 0));
+  EXPECT_NE(PrefixSnapshot::hash("ab", 2), PrefixSnapshot::hash("ba", 2));
+}
+
+TEST(PrefixSnapshot, Restore)
+{
+  Files files;
+  files.add("a.h", Header);
+  files.add("once.h", "#pragma once\nint once;\n");
+  const std::string t1 = files.add("t1.c", "#include \"a.h\"\n\n#include \"once.h\"\n"
+                                  "int t = twice(2);\n#include \"a.h\"\n#include \"once.h\"\n");
+  const std::string t2 = files.add("t2.c", "#include \"a.h\"\n#include \"once.h\"\n\nA_H twice(3)\n");
+  const std::string expected1 = "int a = ( 1 ) + ( 1 ) ; int once ; int t = ( 2 ) + ( 2 ) ;";
+  const std::string expected2 = "int a = ( 1 ) + ( 1 ) ; int once ; ( 3 ) + ( 3 )";
+
+  {
+    Process p(files.pchDir());
+    EXPECT_EQ(expected1, p.run(t1));
+    EXPECT_EQ(1u, p.snapshots.written());
+    EXPECT_EQ(0u, p.snapshots.found());
+
+    // The same prefix, up to empty lines, in the same process.
+    EXPECT_EQ(expected2, p.run(t2));
+    EXPECT_EQ(1u, p.snapshots.found());
+    EXPECT_EQ(0u, p.snapshots.loaded());
+  }
+
+  // Another process, from the file; the guard and the #pragma once of the
+  // prefix still hold after it, though the headers are not even read.
+  Process p(files.pchDir());
+  EXPECT_EQ(expected2, p.run(t2));
+  EXPECT_EQ(expected1, p.run(t1));
+  EXPECT_EQ(2u, p.snapshots.found());
+  EXPECT_EQ(1u, p.snapshots.loaded());
+  EXPECT_EQ(0u, p.snapshots.written());
+  EXPECT_EQ(2u, p.sources.misses());
+  EXPECT_EQ(2u, p.preprocessor.includes());
+  EXPECT_EQ(1u, p.preprocessor.guardedIncludes());
+}
+
+TEST(PrefixSnapshot, Stale)
+{
+  Files files;
+  files.add("a.h", Header);
+  const std::string t = files.add("t.c", "#include \"a.h\"\ntwice(2)\n");
+  files.touch("a.h", 1000000000);
+  {
+    Process p(files.pchDir());
+    p.run(t);
+    EXPECT_EQ(1u, p.snapshots.written());
+  }
+
+  // Touched, but the same bytes.
+  files.touch("a.h", 1000000100);
+  {
+    Process p(files.pchDir());
+    p.run(t);
+    EXPECT_EQ(1u, p.snapshots.loaded());
+  }
+
+  // The same size, other bytes.
+  std::string changed = Header;
+  changed.replace(changed.find("(1)"), 3, "(7)");
+  files.add("a.h", changed);
+  files.touch("a.h", 1000000200);
+  {
+    Process p(files.pchDir());
+    EXPECT_EQ("int a = ( 7 ) + ( 7 ) ; ( 2 ) + ( 2 )", p.run(t));
+    EXPECT_EQ(0u, p.snapshots.loaded());
+    EXPECT_EQ(1u, p.snapshots.stale());
+    EXPECT_EQ(1u, p.snapshots.written());
+  }
+  Process p(files.pchDir());
+  EXPECT_EQ("int a = ( 7 ) + ( 7 ) ; ( 2 ) + ( 2 )", p.run(t));
+  EXPECT_EQ(1u, p.snapshots.loaded());
+}
+
+TEST(PrefixSnapshot, Shadowed)
+{
+  // b.h is found in -I B after it was looked for beside a.h, in A.
+  Files files;
+  files.add("A/a.h", "#include \"b.h\"\n");
+  files.add("B/b.h", "int b;\n");
+  const std::string t = files.add("t.c", "#include \"A/a.h\"\n");
+  const std::vector<std::string> searchPaths = {files.path() + "/B"};
+  {
+    Process p(files.pchDir(), searchPaths);
+    EXPECT_EQ("int b ;", p.run(t));
+    EXPECT_EQ(1u, p.snapshots.written());
+  }
+
+  // Now it is.
+  files.add("A/b.h", "int shadow;\n");
+  Process p(files.pchDir(), searchPaths);
+  EXPECT_EQ("int shadow ;", p.run(t));
+  EXPECT_EQ(0u, p.snapshots.loaded());
+  EXPECT_EQ(1u, p.snapshots.stale());
+}
+
+TEST(PrefixSnapshot, Clock)
+{
+  // The clock is the restoring run's, not the recording one's.
+  Files files;
+  files.add("a.h", "#define A 1\n");
+  files.add("b.h", "#undef __TIME__\n#define __TIME__ 0\n");
+  const std::string t1 = files.add("t1.c", "#include \"a.h\"\n__DATE__ __TIME__ A\n");
+  const std::string t2 = files.add("t2.c", "#include \"b.h\"\n__TIME__\n");
+  {
+    Process p(files.pchDir());
+    EXPECT_EQ("\"Mar 14 2013\" \"12:34:56\" 1", p.run(t1));
+    p.preprocessor.setClock("Mar 15 2013", "12:34:58");
+    EXPECT_EQ("\"Mar 15 2013\" \"12:34:58\" 1", p.run(t1));
+    EXPECT_EQ(1u, p.snapshots.found());
+  }
+  Process p(files.pchDir());
+  p.preprocessor.setClock("Mar 16 2013", "01:02:03");
+  EXPECT_EQ("\"Mar 16 2013\" \"01:02:03\" 1", p.run(t1));
+  EXPECT_EQ(1u, p.snapshots.loaded());
+
+  // A prefix redefining the clock is not snapshotted.
+  EXPECT_EQ("0", p.run(t2));
+  EXPECT_EQ(0u, p.snapshots.written());
+}
+
+TEST(PrefixSnapshot, NotSnapshotted)
+{
+  Files files;
+  files.add("a.h", Header);
+  files.add("date.h", "const char *d = __DATE__;\n");
+  // No prefix, a prefix using the clock, and a prefix of another form.
+  const std::string t1 = files.add("t1.c", "int x;\n#include \"a.h\"\n");
+  const std::string t2 = files.add("t2.c", "#include \"date.h\"\n");
+  const std::string t3 = files.add("t3.c", "#define H \"a.h\"\n#include H\n");
+  const std::string t4 = files.add("t4.c", "#include \"a.h\" // comment\n#include \"missing.h\"\n");
+
+  Process p(files.pchDir());
+  EXPECT_EQ("int x ; int a = ( 1 ) + ( 1 ) ;", p.run(t1));
+  EXPECT_EQ("const char * d = \"Mar 14 2013\" ;", p.run(t2));
+  EXPECT_EQ("int a = ( 1 ) + ( 1 ) ;", p.run(t3));
+  EXPECT_THROW(p.run(t4), std::runtime_error);
+  EXPECT_EQ(0u, p.snapshots.written());
+  EXPECT_EQ(0u, p.snapshots.found());
+}
+
+TEST(PrefixSnapshot, Corrupt)
+{
+  Files files;
+  files.add("a.h", Header);
+  const std::string t = files.add("t.c", "#include \"a.h\"\n");
+  {
+    Process p(files.pchDir());
+    p.run(t);
+  }
+
+  DIR *d = opendir(files.pchDir().c_str());
+  ASSERT_NE(nullptr, d);
+  std::string pch;
+  while (const dirent *entry = readdir(d)) {
+    if (std::string(entry->d_name).find(".pch") != std::string::npos)
+      pch = files.pchDir() + "/" + entry->d_name;
+  }
+  closedir(d);
+  ASSERT_FALSE(pch.empty());
+  ASSERT_EQ(0, truncate(pch.c_str(), 60));
+
+  Process p(files.pchDir());
+  EXPECT_EQ("int a = ( 1 ) + ( 1 ) ;", p.run(t));
+  EXPECT_EQ(1u, p.snapshots.stale());
+  EXPECT_EQ(1u, p.snapshots.written());
+}
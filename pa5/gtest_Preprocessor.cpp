@@ -0,0 +1,191 @@
+#include "Preprocessor.h"
+#include "TestSupport.h"
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+  // Source files in memory, in dir(), preprocessed by one Preprocessor.
+  class Sources {
+  public:
+    Sources():
+      sources(spellings, files), resolver(sources, std::vector<std::string>()),
+      preprocessor(sources, resolver, "Mar 14 2013", "12:34:56"), _dir("/src")
+    {}
+
+    std::string add(const std::string &name, const std::string &contents)
+    {
+      const std::string path = _dir + "/" + name;
+      files.add(path, contents);
+      return path;
+    }
+
+    std::string run(const std::string &name)
+    {
+      Spellings out(spellings);
+      preprocessor.run(_dir + "/" + name, out);
+      return out.text;
+    }
+
+    const std::string &dir() const { return _dir; }
+
+    MemoryFileSystem files;
+    SpellingTable spellings;
+    SourceManager sources;
+    IncludeResolver resolver;
+    Preprocessor preprocessor;
+
+  private:
+    std::string _dir;
+  };
+
+} // namespace
+
+TEST(Preprocessor, Conditionals)
+{
+  Sources s;
+  s.add("a.c",
+        "#define X 2\n"
+        "#if X == 2 && defined X && !defined(Y)\n"
+        "a\n"
+        "#elif 1\n"
+        "b\n"
+        "#else\n"
+        "c\n"
+        "#endif\n"
+        "#ifndef X\n"
+        "d\n"
+        "#elif 0\n"
+        "#else\n"
+        "e\n"
+        "#endif\n"
+        "#if 0\n"
+        "#if @\n"
+        "#elif @\n"
+        "#else\n"
+        "#endif\n"
+        "#ifdef X\n"
+        "#else tokens\n"
+        "#endif tokens\n"
+        "#foo\n"
+        "#endif\n");
+  EXPECT_EQ("a e", s.run("a.c"));
+
+  s.add("b.c", "#if 1\n#else\n#elif 1\n#endif\n");
+  EXPECT_THROW(s.run("b.c"), std::runtime_error);
+  s.add("c.c", "#if 0\n#if 1\n#else\n#else\n#endif\n#endif\n");
+  EXPECT_THROW(s.run("c.c"), std::runtime_error);
+  s.add("d.c", "#if 1\n");
+  EXPECT_THROW(s.run("d.c"), std::runtime_error);
+  s.add("e.c", "#if 1 +\n#endif\n");
+  EXPECT_THROW(s.run("e.c"), std::runtime_error);
+  s.add("f.c", "#if 0\n#else X\n#endif\n");
+  EXPECT_THROW(s.run("f.c"), std::runtime_error);
+  s.add("g.c", "#if 1\n#endif X\n");
+  EXPECT_THROW(s.run("g.c"), std::runtime_error);
+}
+
+TEST(Preprocessor, Directives)
+{
+  Sources s;
+  s.add("a.c", "#\n# /* null */\n#define f(x) [x]\nf(1)\n#undef f\nf(1)\n#pragma unknown tokens\n");
+  EXPECT_EQ("[ 1 ] f ( 1 )", s.run("a.c"));
+
+  s.add("b.c", "#error stop\n");
+  EXPECT_THROW(s.run("b.c"), std::runtime_error);
+  s.add("c.c", "#foo\n");
+  EXPECT_THROW(s.run("c.c"), std::runtime_error);
+  s.add("d.c", "# 1\n");
+  EXPECT_THROW(s.run("d.c"), std::runtime_error);
+}
+
+TEST(Preprocessor, Predefined)
+{
+  Sources s;
+  s.add("a.c", "__CPPGM__ __cplusplus __STDC_HOSTED__ __DATE__ __TIME__\n");
+  EXPECT_EQ("201303L 201103L 1 \"Mar 14 2013\" \"12:34:56\"", s.run("a.c"));
+}
+
+TEST(Preprocessor, LineAndFile)
+{
+  Sources s;
+  s.add("a.c",
+        "__LINE__\n"
+        "#define f(x) x __LINE__\n"
+        "f(\n"
+        "__LINE__\n"
+        ")\n"
+        "a \\\n"
+        "__LINE__\n"
+        "#line 100\n"
+        "__LINE__\n"
+        "#line 7 \"x.c\"\n"
+        "__LINE__ __FILE__\n");
+  EXPECT_EQ("1 4 3 a 7 100 7 \"x.c\"", s.run("a.c"));
+
+  // macros and files start anew with every run
+  s.add("b.c", "#define __FILE__ 1\n");
+  EXPECT_THROW(s.run("b.c"), std::runtime_error);
+  s.add("c.c", "#line 0\n");
+  EXPECT_THROW(s.run("c.c"), std::runtime_error);
+  s.add("d.c", "f(1) __FILE__\n");
+  EXPECT_EQ("f ( 1 ) \"" + s.dir() + "/d.c\"", s.run("d.c"));
+}
+
+TEST(Preprocessor, Include)
+{
+  Sources s;
+  s.add("a.h", "#pragma once\nA __FILE__ __LINE__\n");
+  s.add("b.h", "_Pragma(\"once\") B\n");
+  s.add("c.h", "C\n");
+  s.add("a.c",
+        "#include \"a.h\"\n"
+        "#include <a.h>\n"
+        "#define H \"b.h\"\n"
+        "#include H\n"
+        "#include H\n"
+        "#include \"c.h\"\n"
+        "#include \"c.h\"\n"
+        "__LINE__\n");
+  EXPECT_EQ("A \"" + s.dir() + "/a.h\" 2 B C C 8", s.run("a.c"));
+  const size_t misses = s.sources.misses();
+  EXPECT_EQ(4u, misses);
+
+  // the second run reuses every file
+  EXPECT_EQ("A \"" + s.dir() + "/a.h\" 2 B C C 8", s.run("a.c"));
+  EXPECT_EQ(misses, s.sources.misses());
+
+  s.add("d.c", "#include \"none.h\"\n");
+  EXPECT_THROW(s.run("d.c"), std::runtime_error);
+  s.add("e.h", "#if 1\n");
+  s.add("e.c", "#include \"e.h\"\n#endif\n");
+  EXPECT_THROW(s.run("e.c"), std::runtime_error);
+  s.add("f.h", "#include \"f.h\"\n");
+  EXPECT_THROW(s.run("f.h"), std::runtime_error);
+}
+
+TEST(Preprocessor, IncludeGuard)
+{
+  Sources s;
+  s.add("g.h", "#ifndef G\n#define G\ng\n#endif\n");
+  s.add("a.c", "#include \"g.h\"\n#include \"g.h\"\n#undef G\n#include \"g.h\"\n#include \"g.h\"\n");
+  EXPECT_EQ("g g", s.run("a.c"));
+  EXPECT_EQ(4u, s.preprocessor.includes());
+  EXPECT_EQ(2u, s.preprocessor.guardedIncludes());
+
+  // a guard defined before the first inclusion
+  s.add("b.c", "#define G\n#include \"g.h\"\nb\n");
+  EXPECT_EQ("b", s.run("b.c"));
+  EXPECT_EQ(3u, s.preprocessor.guardedIncludes());
+}
+
+TEST(Preprocessor, PragmaOperator)
+{
+  Sources s;
+  s.add("a.c", "#define P _Pragma(\"ignored\") x\na P _Pragma(\"once\") b\n");
+  EXPECT_EQ("a x b", s.run("a.c"));
+  s.add("b.c", "_Pragma(x)\n");
+  EXPECT_THROW(s.run("b.c"), std::runtime_error);
+}
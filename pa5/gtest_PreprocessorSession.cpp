@@ -0,0 +1,79 @@
+#include "PreprocessorSession.h"
+#include "TestSupport.h"
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+  std::string run(PreprocessorSession &session, const std::string &path, const std::vector<std::string> &searchPaths,
+                  const std::string &date = "Mar 14 2013")
+  {
+    PreprocessorSession::Request request;
+    request.path = path;
+    request.searchPaths = searchPaths;
+    request.date = date;
+    request.time = "12:34:56";
+    Spellings out(session.spellings());
+    session.run(request, out);
+    return out.text;
+  }
+
+} // namespace
+
+// Requests in memory, the files read by the first kept for the next.
+TEST(PreprocessorSession, Warm)
+{
+  MemoryFileSystem files;
+  files.add("inc/a.h", "#ifndef A\n#define A\nint a;\n#endif\n");
+  files.add("t.c", "#include <a.h>\n#include <a.h>\nconst char *d = __DATE__;\n");
+  files.add("u.c", "#include <a.h>\n#ifdef A\nu\n#endif\n");
+  files.add("bad.c", "#include <missing.h>\n");
+  PreprocessorSession session(files);
+  const std::vector<std::string> inc = {"inc"};
+
+  EXPECT_EQ("int a ; const char * d = \"Mar 14 2013\" ;", run(session, "t.c", inc));
+  EXPECT_EQ(2u, session.sources().misses());
+  EXPECT_THROW(run(session, "bad.c", inc), std::runtime_error);
+  EXPECT_THROW(run(session, "u.c", {}), std::runtime_error);
+
+  const size_t stats = session.resolver(inc).stats();
+  EXPECT_EQ("int a ; const char * d = \"Apr  1 2014\" ;", run(session, "t.c", inc, "Apr  1 2014"));
+  EXPECT_EQ("int a ; u", run(session, "u.c", inc));
+  // Nothing read, nor stat'ed, again.
+  EXPECT_EQ(4u, session.sources().misses());
+  EXPECT_EQ(stats, session.resolver(inc).stats());
+  EXPECT_EQ(5u, session.runs());
+  EXPECT_EQ(2u, session.guardedIncludes());
+}
+
+TEST(PreprocessorSession, Threads)
+{
+  MemoryFileSystem files;
+  std::vector<std::string> paths;
+  for (int i = 0; i < 20; i++) {
+    files.add("h" + std::to_string(i % 5) + ".h", "#pragma once\n#define F" + std::to_string(i % 5) + " f\n");
+    paths.push_back("t" + std::to_string(i) + ".c");
+    files.add(paths.back(), "#include \"h" + std::to_string(i % 5) + ".h\"\nF" + std::to_string(i % 5) + "\n");
+  }
+  PreprocessorSession session(files);
+
+  const int numThreads = 4;
+  std::vector<std::string> texts(numThreads * paths.size());
+  std::vector<std::thread> threads;
+  for (int k = 0; k < numThreads; k++) {
+    threads.emplace_back([&, k]() {
+      for (size_t i = 0; i < paths.size(); i++)
+        texts[k * paths.size() + i] = run(session, paths[(i + k) % paths.size()], {});
+    });
+  }
+  for (std::thread &thread: threads)
+    thread.join();
+
+  for (const std::string &text: texts)
+    EXPECT_EQ("f", text);
+  EXPECT_EQ(25u, session.sources().misses());
+  EXPECT_EQ(80u, session.runs());
+}
@@ -0,0 +1,175 @@
+#include "SourceManager.h"
+#include "TestSupport.h"
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+  // The tokens of all the segments of `file`.
+  std::vector<MacroToken> tokens(SourceManager &sources, const SourceFile *file)
+  {
+    std::vector<MacroToken> tokens;
+    for (const SourceSegment &segment: file->segments) {
+      const std::vector<MacroToken> &t = sources.tokens(*file, segment);
+      tokens.insert(tokens.end(), t.begin(), t.end());
+    }
+    return tokens;
+  }
+
+} // namespace
+
+TEST(SourceManager, Tokens)
+{
+  MemoryFileSystem files;
+  const std::string path = "/src/a.h";
+  files.add(path, "#define x 1\n  y /* a\nb */ z \\\nw\n");
+  SpellingTable spellings;
+  SourceManager sources(spellings, files);
+
+  const SourceFile *f = sources.open(path);
+  ASSERT_NE(nullptr, f);
+  EXPECT_EQ("", f->error);
+  const std::vector<MacroToken> t = tokens(sources, f);
+  ASSERT_EQ(9u, t.size());
+
+  const char *expected[] = {"#", "define", "x", "1", "", "y", "z", "w", ""};
+  const uint32_t lines[] = {1, 1, 1, 1, 1, 2, 3, 4, 4};
+  const bool spaces[] = {false, false, true, true, false, true, true, true, false};
+  for (size_t i = 0; i < 9; i++) {
+    EXPECT_EQ(expected[i], spellings.spelling(t[i].spelling)) << i;
+    EXPECT_EQ(lines[i], t[i].line) << i;
+    EXPECT_EQ(spaces[i], t[i].precededBySpace) << i;
+  }
+  EXPECT_EQ(PPTokenType::NewLine, t[4].type);
+}
+
+// Text is lexed when first asked for, directive lines with the file.
+TEST(SourceManager, Lazy)
+{
+  MemoryFileSystem files;
+  const std::string text = "#if 0\n" + std::string(1000, 'x') + "\n#endif\n";
+  files.add("/src/a.h", text);
+  SpellingTable spellings;
+  SourceManager sources(spellings, files);
+
+  const SourceFile *f = sources.open("/src/a.h");
+  ASSERT_EQ(3u, f->segments.size());
+  EXPECT_EQ(text.size(), sources.bytesRead());
+  EXPECT_EQ(text.size() - 1001, sources.bytesLexed());
+  EXPECT_EQ("if", spellings.spelling(f->segments[0].tokens[1].spelling));
+
+  const std::vector<MacroToken> &t = sources.tokens(*f, f->segments[1]);
+  ASSERT_EQ(2u, t.size());
+  EXPECT_EQ(2u, t[0].line);
+  EXPECT_EQ(text.size(), sources.bytesLexed());
+  EXPECT_EQ(&t, &sources.tokens(*f, f->segments[1]));
+  EXPECT_EQ(text.size(), sources.bytesLexed());
+}
+
+TEST(SourceManager, Cache)
+{
+  MemoryFileSystem files;
+  const std::string path = "/src/a.h";
+  files.add(path, "a\n");
+  files.add("/src/b.h", "");
+  SpellingTable spellings;
+  SourceManager sources(spellings, files);
+
+  const SourceFile *f = sources.open(path);
+  EXPECT_EQ(f, sources.open(path));
+  // the same file by another path
+  EXPECT_EQ(f, sources.open("/src/./a.h"));
+  EXPECT_EQ(path, f->path);
+  EXPECT_EQ(2u, sources.hits());
+  EXPECT_EQ(1u, sources.misses());
+
+  const SourceFile *empty = sources.open("/src/b.h");
+  ASSERT_NE(nullptr, empty);
+  EXPECT_EQ(0u, empty->size);
+  EXPECT_EQ("", empty->error);
+  EXPECT_EQ(2u, sources.size());
+}
+
+// On disk, where a directory has a file id but cannot be read.
+TEST(SourceManager, Errors)
+{
+  TemporaryDirectory dir("gtest_SourceManager");
+  const std::string path = dir.add("a.h", "a\nb @ \"c\n");
+  SpellingTable spellings;
+  SourceManager sources(spellings, statFileId);
+
+  EXPECT_EQ(nullptr, sources.open(dir.path() + "/none.h"));
+  EXPECT_THROW(sources.open(dir.path()), std::runtime_error);
+
+  const SourceFile *f = sources.open(path);
+  ASSERT_NE(nullptr, f);
+  EXPECT_NE("", f->error);
+  const std::vector<MacroToken> t = tokens(sources, f);
+  ASSERT_LE(3u, t.size());
+  EXPECT_EQ("b", spellings.spelling(t[2].spelling));
+}
+
+TEST(SourceManager, Guard)
+{
+  MemoryFileSystem files;
+  SpellingTable spellings;
+  SourceManager sources(spellings, files);
+  auto guard = [&](const std::string &name, const std::string &contents) {
+    files.add(name, contents);
+    const SourceFile *f = sources.open(name);
+    return spellings.spelling(f->guard);
+  };
+
+  EXPECT_EQ("A", guard("a.h", "#ifndef A\n#define A\n#if x\n#elif y\n#else\n#endif\n#endif\n"));
+  EXPECT_EQ("B", guard("b.h", "\n\n#if !defined B\nb\n#endif\n\n"));
+  EXPECT_EQ("C", guard("c.h", "#if ! defined ( C )\n#endif"));
+
+  EXPECT_EQ("", guard("d.h", "x\n#ifndef D\n#endif\n"));
+  EXPECT_EQ("", guard("e.h", "#ifndef E\n#endif\nx\n"));
+  EXPECT_EQ("", guard("f.h", "#ifndef F\n#else\n#endif\n"));
+  EXPECT_EQ("", guard("g.h", "#ifndef G\n#endif\n#ifndef G\n#endif\n"));
+  EXPECT_EQ("", guard("h.h", "#ifndef H\n#if 1\n#else\n#elif 1\n#endif\n#endif\n"));
+  EXPECT_EQ("", guard("i.h", "#ifndef I\n"));
+  EXPECT_EQ("", guard("j.h", "#if !defined I || 1\n#endif\n"));
+  EXPECT_EQ("", guard("k.h", "#ifndef K\n\"\n#endif\n"));
+}
+
+// Threads opening the same files get the same SourceFile, read once.
+TEST(SourceManager, Concurrent)
+{
+  TemporaryDirectory dir("gtest_SourceManager");
+  std::vector<std::string> paths;
+  for (int i = 0; i < 10; i++)
+    paths.push_back(dir.add("f" + std::to_string(i) + ".h", "#ifndef F\nf" + std::to_string(i) + " x y z\n#endif\n"));
+  SpellingTable spellings;
+  SourceManager sources(spellings, statFileId);
+
+  const int numThreads = 8;
+  std::vector<std::vector<const SourceFile *>> opened(numThreads);
+  std::vector<std::thread> threads;
+  for (int k = 0; k < numThreads; k++) {
+    threads.emplace_back([&, k]() {
+      for (int n = 0; n < 100; n++) {
+        opened[k].push_back(sources.open(paths[(n + k) % paths.size()]));
+        sources.tokens(*opened[k].back(), opened[k].back()->segments[1]);
+      }
+    });
+  }
+  for (std::thread &thread: threads)
+    thread.join();
+
+  EXPECT_EQ(10u, sources.misses());
+  EXPECT_EQ(790u, sources.hits());
+  EXPECT_EQ(10u, sources.fileIdMisses());
+  for (int k = 0; k < numThreads; k++) {
+    for (int n = 0; n < 100; n++) {
+      const SourceFile *f = opened[k][n];
+      ASSERT_EQ(sources.open(paths[(n + k) % paths.size()]), f);
+      EXPECT_EQ("F", spellings.spelling(f->guard));
+      EXPECT_EQ("f" + std::to_string((n + k) % paths.size()), spellings.spelling(sources.tokens(*f, f->segments[1])[0].spelling));
+    }
+  }
+}
@@ -0,0 +1,162 @@
+#include "SourceScanner.h"
+#include "pa1/PPCodeUnitStream.h"
+#include "pa1/PPTokenizerDFA.h"
+#include "pa1/PPUTF32Stream.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+  struct Token {
+    unsigned line;
+    PPTokenType type;
+    std::string text;           // the message of an error
+    bool error;
+
+    bool operator==(const Token &t) const
+    {
+      return line == t.line  &&  type == t.type  &&  text == t.text  &&  error == t.error;
+    }
+  };
+
+  std::ostream &operator<<(std::ostream &out, const Token &t)
+  {
+    return out << (t.error ? "error " : "") << t.line << ":" << static_cast<int>(t.type) << ":" << t.text;
+  }
+
+  // The tokens of `size` bytes at `data`, which start on `line`, and the
+  // error last if there is one.
+  std::vector<Token> lex(const char *data, size_t size, unsigned line)
+  {
+    PPTokenizerDFA dfa(std::make_shared<PPCodeUnitStream>(std::make_shared<PPUTF32Stream>(data, size)));
+    std::vector<Token> tokens;
+    for (; !dfa.isEmpty(); dfa.toNext()) {
+      if (!dfa.getErrorMessage().empty()) {
+        tokens.push_back(Token{0, PPTokenType::NewLine, dfa.getErrorMessage(), true});
+        break;
+      }
+      const std::shared_ptr<PPToken> t = dfa.getPPToken();
+      tokens.push_back(Token{line - 1 + dfa.getLine(), t->getType(), t->getRawText(), false});
+    }
+    return tokens;
+  }
+
+  bool isSpace(const Token &t)
+  {
+    return t.type == PPTokenType::WhitespaceSequence  ||  t.type == PPTokenType::NewLine;
+  }
+
+  // Lexing the segments of `s` one by one, and the rest of it whole, gives
+  // the tokens of lexing `s` whole; segments are what their tokens are.
+  // Returns where the scan stopped.
+  size_t check(const std::string &s)
+  {
+    std::vector<SourceScanner::Segment> segments;
+    const size_t tail = SourceScanner::scan(s.data(), s.size(), segments);
+    std::vector<Token> tokens;
+    size_t end = 0;
+    for (const SourceScanner::Segment &segment: segments) {
+      EXPECT_EQ(end, segment.begin) << s;
+      EXPECT_EQ(1 + std::count(s.begin(), s.begin() + segment.begin, '\n'), segment.line) << s;
+      end = segment.end;
+
+      const std::vector<Token> t = lex(s.data() + segment.begin, segment.end - segment.begin, segment.line);
+      const auto first = std::find_if_not(t.begin(), t.end(), isSpace);
+      EXPECT_EQ(segment.blank, first == t.end()) << s;
+      EXPECT_EQ(segment.directive, first != t.end()  &&  (first->text == "#"  ||  first->text == "%:")) << s;
+      for (const Token &token: t)
+        EXPECT_FALSE(token.error) << s;
+      tokens.insert(tokens.end(), t.begin(), t.end());
+    }
+    EXPECT_EQ(end, tail) << s;
+
+    if (tail != s.size()) {
+      const std::vector<Token> rest = lex(s.data() + tail, s.size() - tail, 1 + std::count(s.begin(), s.begin() + tail, '\n'));
+      tokens.insert(tokens.end(), rest.begin(), rest.end());
+    }
+    EXPECT_EQ(lex(s.data(), s.size(), 1), tokens) << s;
+    return tail;
+  }
+
+} // namespace
+
+TEST(SourceScanner, Segments)
+{
+  const std::string s =
+    "#if 0\n"
+    "a 'b' \"c\\\"\" R\"x(\n"
+    ")\"\n"
+    ")x\" // d \\\n"
+    "e\n"
+    "  /* f\n"
+    "*/ # endif /* g */\n"
+    "\n"
+    "/* h */\n";
+  std::vector<SourceScanner::Segment> segments;
+  ASSERT_EQ(s.size(), SourceScanner::scan(s.data(), s.size(), segments));
+  ASSERT_EQ(4u, segments.size());
+
+  EXPECT_TRUE(segments[0].directive);
+  EXPECT_EQ(0u, segments[0].begin);
+  EXPECT_EQ(6u, segments[0].end);
+
+  // The raw string and the line comment go on over new-lines.
+  EXPECT_FALSE(segments[1].directive);
+  EXPECT_FALSE(segments[1].blank);
+  EXPECT_EQ(2u, segments[1].line);
+  EXPECT_EQ(s.find("  /*"), segments[1].end);
+
+  EXPECT_TRUE(segments[2].directive);
+  EXPECT_EQ(6u, segments[2].line);
+  EXPECT_TRUE(segments[3].blank);
+  EXPECT_EQ(8u, segments[3].line);
+  check(s);
+}
+
+// Where the lexer would fail, or might do what the scanner does not follow.
+TEST(SourceScanner, Stops)
+{
+  EXPECT_EQ(6u, check("#if 0\ndon't\n#endif\n"));
+  EXPECT_EQ(2u, check("a\n\"b\\q\"\n"));
+  EXPECT_EQ(2u, check("a\nR\"(b\n"));
+  EXPECT_EQ(2u, check("a\n/* b\n"));
+  EXPECT_EQ(2u, check("a\n%:define b\n"));
+  EXPECT_EQ(2u, check("a\n#include <b/*c>\n"));
+  EXPECT_EQ(0u, check("a\n\\u0022\n"));
+  EXPECT_EQ(0u, check("a\n?\?=define b\n"));
+  EXPECT_EQ(0u, check("a\nb"));
+
+  EXPECT_EQ(13u, check("x = 1'000'0;\n"));
+  EXPECT_EQ(0u, check("x = 1'+2;\n"));
+  EXPECT_EQ(22u, check("#include <a/b.h> // c\n"));
+}
+
+// Random text of the pieces that matter to the lexer.
+TEST(SourceScanner, Random)
+{
+  const char *pieces[] = {
+    "\n", "\n", "\n", " ", " ", "\t", "\r", "#", "##", "%:", "define", "include", "include_next", "if", "x", "u8", "u", "L",
+    "R", "uR", "e", "E", "1", "0x", ".", "+", "-", "'", "'", "\"", "\"", "\\", "\\\n", "/", "*", "/*", "*/", "//", "<", ">",
+    "(", ")", "a.h", "\xc3\xa9", "\\u00e9", "\\n", "\\x", "\\0", "\\\\", "_", "?", "0", "'0'", "\"a\"", "R\"x(", ")x\"",
+    "/**/", "# include ", "#include <a.h>", "#include \"a.h\"",
+  };
+  const size_t numPieces = sizeof(pieces) / sizeof(pieces[0]);
+  std::mt19937 random(42);
+  size_t scanned = 0;
+  for (int i = 0; i < 20000; i++) {
+    std::string s;
+    const int n = random() % 40;
+    for (int j = 0; j < n; j++)
+      s += pieces[random() % numPieces];
+    s += '\n';
+    scanned += check(s) == s.size();
+    if (HasFailure())
+      return;
+  }
+  // Most of them can be scanned to the end.
+  EXPECT_LT(2000u, scanned);
+}
@@ -0,0 +1,48 @@
+#include "SpillBuffer.h"
+#include <gtest/gtest.h>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+TEST(SpillBuffer, InMemory)
+{
+  SpillBuffer buffer(64);
+  std::ostream out(&buffer);
+  out << "line " << 1 << '\n' << std::string(50, 'a');
+  EXPECT_TRUE(out.good());
+  EXPECT_FALSE(buffer.spilled());
+
+  std::ostringstream copy;
+  buffer.copyTo(copy);
+  EXPECT_EQ("line 1\n" + std::string(50, 'a'), copy.str());
+}
+
+TEST(SpillBuffer, Spilled)
+{
+  // Lines and strings longer than the limit.
+  SpillBuffer buffer(16);
+  std::ostream out(&buffer);
+  std::ostringstream expected;
+  for (int i = 0; i < 1000; i++) {
+    out << "line " << i << '\n';
+    expected << "line " << i << '\n';
+    if (i % 100 == 0) {
+      out << std::string(50, 'a' + i / 100);
+      expected << std::string(50, 'a' + i / 100);
+    }
+  }
+  EXPECT_TRUE(out.good());
+  EXPECT_TRUE(buffer.spilled());
+
+  std::ostringstream copy;
+  buffer.copyTo(copy);
+  EXPECT_EQ(expected.str(), copy.str());
+}
+
+TEST(SpillBuffer, Empty)
+{
+  SpillBuffer buffer;
+  std::ostringstream copy;
+  buffer.copyTo(copy);
+  EXPECT_EQ("", copy.str());
+}
@@ -0,0 +1,95 @@
+#include "WatchedFileSystem.h"
+#include "TestSupport.h"
+#include <gtest/gtest.h>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+  void write(const std::string &path, const std::string &contents)
+  {
+    std::ofstream(path) << contents;
+  }
+
+  // A directory with a.h and b.h.
+  class Tree: public TemporaryDirectory {
+  public:
+    Tree(): TemporaryDirectory("gtest_WatchedFileSystem")
+    {
+      add("a.h", "a");
+      add("b.h", "b");
+    }
+  };
+
+} // namespace
+
+TEST(WatchedFileSystem, Files)
+{
+  Tree tree;
+  const std::string &dir = tree.path();
+  DiskFileSystem disk(statFileId);
+  std::unique_ptr<WatchedFileSystem> files(new WatchedFileSystem(disk));
+  SourceFileId id;
+  EXPECT_TRUE(files->fileId(dir + "/a.h", id));
+  EXPECT_EQ("a", std::string(files->read(dir + "/a.h")->data(), 1));
+  EXPECT_FALSE(files->changed());
+  EXPECT_EQ(1u, files->watches());
+
+  // Files not looked up do not matter, in a directory not listed.
+  write(dir + "/b.h", "bb");
+  write(dir + "/c.h", "c");
+  EXPECT_FALSE(files->changed());
+
+  write(dir + "/a.h", "aa");
+  EXPECT_TRUE(files->changed());
+  EXPECT_TRUE(files->changed());
+}
+
+TEST(WatchedFileSystem, Missing)
+{
+  Tree tree;
+  const std::string &dir = tree.path();
+  DiskFileSystem disk(statFileId);
+  std::unique_ptr<WatchedFileSystem> files(new WatchedFileSystem(disk));
+  // A file not found, and one in a directory not there, appearing.
+  SourceFileId id;
+  EXPECT_FALSE(files->fileId(dir + "/c.h", id));
+  EXPECT_FALSE(files->fileId(dir + "/sub/dir/d.h", id));
+  EXPECT_FALSE(files->changed());
+  write(dir + "/c.h", "c");
+  EXPECT_TRUE(files->changed());
+
+  files.reset(new WatchedFileSystem(disk));
+  EXPECT_FALSE(files->fileId(dir + "/sub/dir/d.h", id));
+  mkdir((dir + "/other").c_str(), 0777);
+  EXPECT_FALSE(files->changed());
+  mkdir((dir + "/sub").c_str(), 0777);
+  EXPECT_TRUE(files->changed());
+}
+
+TEST(WatchedFileSystem, Directories)
+{
+  Tree tree;
+  const std::string &dir = tree.path();
+  DiskFileSystem disk(statFileId);
+  std::unique_ptr<WatchedFileSystem> files(new WatchedFileSystem(disk));
+  // A name added to a listed directory; not one removed.
+  std::vector<std::string> names;
+  EXPECT_TRUE(files->list(dir + "/", names));
+  EXPECT_EQ(4u, names.size());
+  unlink((dir + "/b.h").c_str());
+  EXPECT_FALSE(files->changed());
+  write(dir + "/c.h", "c");
+  EXPECT_TRUE(files->changed());
+
+  // A watched directory renamed.
+  files.reset(new WatchedFileSystem(disk));
+  mkdir((dir + "/sub").c_str(), 0777);
+  SourceFileId id;
+  EXPECT_FALSE(files->fileId(dir + "/sub/a.h", id));
+  EXPECT_FALSE(files->changed());
+  EXPECT_EQ(0, rename((dir + "/sub").c_str(), (dir + "/moved").c_str()));
+  EXPECT_TRUE(files->changed());
+}
@@ -0,0 +1,67 @@
+// preproc-client: the command line of preproc, run by the `preproc --server`
+// listening at the socket $PREPROC_SOCKET names, so its files, lexed tokens,
+// #include results and prefix snapshots stay warm from one run to the next.
+// The output files, stderr and exit status are those of preproc.
+//
+// Without $PREPROC_SOCKET it runs the preproc next to it instead.
+
+#include "LocalSocket.h"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std;
+
+// the preproc in the directory of `argv0`, or on the PATH if that has none
+string PA5PreprocPath(const string& argv0)
+{
+	const size_t slash = argv0.rfind('/');
+	return slash == string::npos ? "preproc" : argv0.substr(0, slash + 1) + "preproc";
+}
+
+int main(int argc, char** argv)
+{
+	const char* socket = getenv("PREPROC_SOCKET");
+	if (!socket || !*socket)
+	{
+		const string preproc = PA5PreprocPath(argv[0]);
+		argv[0] = const_cast<char*>(preproc.c_str());
+		execvp(argv[0], argv);
+		cerr << "ERROR: cannot run " << preproc << endl;
+		return EXIT_FAILURE;
+	}
+
+	try
+	{
+		// the server runs in the working directory of the request
+		char* cwd = getcwd(nullptr, 0);
+		if (!cwd)
+			throw runtime_error("cannot get the working directory");
+		vector<string> request = { cwd };
+		free(cwd);
+		for (int i = 1; i < argc; i++)
+			request.emplace_back(argv[i]);
+
+		unique_ptr<LocalSocket> server = LocalSocket::connect(socket);
+		server->send(request);
+
+		// the exit status, and stderr
+		vector<string> reply;
+		if (!server->receive(reply) || reply.size() != 2)
+			throw runtime_error(string("no reply from the server at ") + socket);
+		cerr << reply[1];
+		return stoi(reply[0]);
+	}
+	catch (exception& e)
+	{
+		cerr << "ERROR: " << e.what() << endl;
+		return EXIT_FAILURE;
+	}
+}
@@ -1,12 +1,34 @@
 // (C) 2013 CPPGM Foundation www.cppgm.org.  All rights reserved.
 
+#include "pa2/DebugPostTokenOutputStream.h"
+#include "pa2/PostTokenizer.h"
+#include "pa3/OrderedPool.h"
+#include "AsyncFileWriter.h"
+#include "FileSystem.h"
+#include "IncludeGraph.h"
+#include "LocalSocket.h"
+#include "PreprocessorSession.h"
+#include "SpillBuffer.h"
+#include "WatchedFileSystem.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <ctime>
+#include <exception>
 #include <utility>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 #include <stdexcept>
 #include <fstream>
 
+#include <unistd.h>
+
 using namespace std;
 
 // For pragma once implementation:
@@ -47,44 +69,443 @@ vector<string> PA5StdIncPaths =
     "/usr/include/"
 };
 
-int main(int argc, char** argv)
+// PA2 output format, where an invalid token is an error
+struct PA5OutputStream : DebugPostTokenOutputStream
 {
-	try
+	explicit PA5OutputStream(ostream& out)
+		: DebugPostTokenOutputStream(out)
+	{}
+
+	void emit_invalid(const string& source)
 	{
-		vector<string> args;
+		throw runtime_error("invalid token " + source);
+	}
+};
 
-		for (int i = 1; i < argc; i++)
-			args.emplace_back(argv[i]);
+// post-tokenizes the preprocessed tokens of one srcfile (see PA2)
+class PA5TokenOutput : public PreprocessorOutputIfc
+{
+public:
+	PA5TokenOutput(const SpellingTable& spellings, ostream& out)
+		: spellings(spellings), output(out), posttokenizer(output)
+	{}
+
+	void put(const MacroToken* first, const MacroToken* last) override
+	{
+		for (; first != last; ++first)
+		{
+			source.assign(spellings.data(first->spelling), spellings.length(first->spelling));
+			posttokenizer.put(first->type, source);
+		}
+	}
+
+	void finish()
+	{
+		posttokenizer.finish();
+	}
+
+private:
+	const SpellingTable& spellings;
+	PA5OutputStream output;
+	PostTokenizer<PA5OutputStream> posttokenizer;
+	string source;
+};
+
+// preprocesses the srcfile of `request` and describes its tokens to `out`
+void PA5PreprocessFile(PreprocessorSession& session, const PreprocessorSession::Request& request, ostream& out)
+{
+	out << "sof " << request.path << '\n';
+
+	PA5TokenOutput output(session.spellings(), out);
+	session.run(request, output);
+	output.finish();
+}
+
+// a srcfile preprocessed on a thread of the pool, into a buffer that spills
+// to a temporary file past a block, so the jobs waiting to be written take a
+// block each at most, however large their output
+struct PA5Job
+{
+	explicit PA5Job(const string& srcfile)
+		: srcfile(srcfile), output(AsyncFileWriter::DefaultBlockSize)
+	{}
+
+	string srcfile;
+	SpillBuffer output;
+	exception_ptr error; // of the partial output
+};
+
+// preprocesses srcfiles on a thread of the pool, with a Preprocessor of the
+// session, and records their includes in a graph of its own, if there is one
+// to merge into at the end
+//
+// the threads share the session, and so its spellings, files and file ids
+class PA5Worker
+{
+public:
+	PA5Worker(PreprocessorSession& session, const PreprocessorSession::Request& request, bool graph)
+		: session(session), request(request)
+	{
+		this->request.includes = graph ? &includeGraph : nullptr;
+	}
+
+	void run(PA5Job& job)
+	{
+		ostream out(&job.output);
+		try
+		{
+			request.path = job.srcfile;
+			PA5PreprocessFile(session, request, out);
+		}
+		catch (...)
+		{
+			job.error = current_exception();
+		}
+	}
+
+	IncludeGraph includeGraph;
+
+private:
+	PreprocessorSession& session;
+	PreprocessorSession::Request request;
+};
 
-		if (args.size() < 3 || args[0] != "-o")
+// the command line of a run
+//
+// preproc -o <outfile> [--stats] [-j <threads>] [-I <dir>]... [--stdinc] [--pch <dir>]
+//     [--deps <depfile>] [--graph <graphfile>] <srcfile>...
+// `depfile` gets a make rule for `outfile`; `graphfile` the include graph, in JSON if it ends
+// with .json, else in DOT
+struct PA5Options
+{
+	string outfile;
+	vector<string> srcfiles;
+	vector<string> searchPaths; // -I, then PA5StdIncPaths on --stdinc
+	string pchdir;
+	string depfile;
+	string graphfile;
+	bool stats = false;
+	size_t nthreads = 0; // 0 to preprocess on the calling thread
+};
+
+PA5Options PA5ParseArgs(const vector<string>& args)
+{
+	if (args.size() < 3 || args[0] != "-o")
+		throw logic_error("invalid usage");
+
+	PA5Options options;
+	options.outfile = args[1];
+	bool stdinc = false;
+	size_t nthreads = thread::hardware_concurrency();
+	for (size_t i = 2; i < args.size(); i++)
+	{
+		if (args[i] == "--stats")
+			options.stats = true;
+		else if (args[i] == "-j" && i + 1 < args.size())
+		{
+			const string& value = args[++i];
+			if (value.empty() || value.find_first_not_of("0123456789") != string::npos)
+				throw logic_error("usage: preproc -o <outfile> [-j <threads>] <srcfile>...");
+			nthreads = stoul(value);
+		}
+		else if (args[i] == "-I" && i + 1 < args.size())
+			options.searchPaths.push_back(args[++i]);
+		else if (args[i] == "--stdinc")
+			stdinc = true;
+		else if (args[i] == "--pch" && i + 1 < args.size())
+			options.pchdir = args[++i];
+		else if (args[i] == "--deps" && i + 1 < args.size())
+			options.depfile = args[++i];
+		else if (args[i] == "--graph" && i + 1 < args.size())
+			options.graphfile = args[++i];
+		else if (args[i][0] == '-')
 			throw logic_error("invalid usage");
+		else
+			options.srcfiles.push_back(args[i]);
+	}
+	if (stdinc)
+		options.searchPaths.insert(options.searchPaths.end(), PA5StdIncPaths.begin(), PA5StdIncPaths.end());
+	options.nthreads = min(nthreads, options.srcfiles.size());
+	if (options.nthreads <= 1)
+		options.nthreads = 0;
+	return options;
+}
+
+// preprocesses the srcfiles of `options` with `session`, whose snapshot
+// directory is the pchdir, and writes the stats, if asked for, to `err`
+void PA5Run(const PA5Options& options, PreprocessorSession& session, ostream& err)
+{
+	// the build date and time, the same for all srcfiles
+	const time_t now = time(nullptr);
+	const string build = asctime(localtime(&now));
+	const string date = build.substr(4, 7) + build.substr(20, 4);
+	const string time = build.substr(11, 8);
 
-		string outfile = args[1];
-		size_t nsrcfiles = args.size() - 2;
+	// formatted into blocks written by a thread of their own, so the output
+	// never has to fit in memory
+	AsyncFileWriter writer(options.outfile);
+	ostream out(&writer);
 
-		ofstream out(outfile);
+	out << "preproc " << options.srcfiles.size() << '\n';
 
-		out << "preproc " << nsrcfiles << endl;
+	PreprocessorSession::Request request;
+	request.searchPaths = options.searchPaths;
+	request.date = date;
+	request.time = time;
+	// the files each srcfile goes through, recorded as they are preprocessed
+	unique_ptr<IncludeGraph> graph;
+	if (!options.depfile.empty() || !options.graphfile.empty())
+		graph.reset(new IncludeGraph());
 
-		for (size_t i = 0; i < nsrcfiles; i++)
+	if (options.nthreads == 0)
+	{
+		request.includes = graph.get();
+		for (const string& srcfile : options.srcfiles)
 		{
-			string srcfile = args[i+2];
+			request.path = srcfile;
+			PA5PreprocessFile(session, request, out);
+		}
+	}
+	else
+	{
+		// the output of every srcfile, up to and including the partial output of the first that
+		// failed, whose error is then thrown, just as preprocessing on the calling thread does
+		OrderedPool<PA5Job, PA5Worker> pool(options.nthreads, 4 * options.nthreads,
+			[&] { return unique_ptr<PA5Worker>(new PA5Worker(session, request, graph != nullptr)); },
+			[&](PA5Job& job)
+			{
+				job.output.copyTo(out);
+				if (job.error)
+					rethrow_exception(job.error);
+			});
+		for (const string& srcfile : options.srcfiles)
+			pool.submit(unique_ptr<PA5Job>(new PA5Job(srcfile)));
+		pool.finish();
+		if (graph)
+			for (const unique_ptr<PA5Worker>& worker : pool.workers())
+				graph->merge(worker->includeGraph);
+	}
 
-			out << "sof " << srcfile << endl;
+	writer.close();
 
-			ifstream in(srcfile);
+	if (!options.depfile.empty())
+	{
+		ofstream deps(options.depfile);
+		graph->writeDependencies(deps, options.outfile);
+		if (!deps)
+			throw runtime_error("cannot write " + options.depfile);
+	}
+	const string& graphfile = options.graphfile;
+	if (!graphfile.empty())
+	{
+		ofstream dump(graphfile);
+		const string json = ".json";
+		if (graphfile.size() >= json.size() && graphfile.compare(graphfile.size() - json.size(), json.size(), json) == 0)
+			graph->writeJson(dump);
+		else
+			graph->writeDot(dump);
+		if (!dump)
+			throw runtime_error("cannot write " + graphfile);
+	}
+
+	// over the life of the session, which for a server is many runs
+	if (options.stats)
+	{
+		SourceManager& sources = session.sources();
+		IncludeResolver& resolver = session.resolver(request.searchPaths);
+		PrefixSnapshotStore* snapshots = session.snapshots();
+		err << "files read: " << sources.misses() << ", reused: " << sources.hits() << endl;
+		err << "bytes read: " << sources.bytesRead() << ", lexed: " << sources.bytesLexed() << endl;
+		err << "output blocks written: " << writer.blocksWritten() << ", waited for: " << writer.waits() << endl;
+		err << "stat calls: " << sources.fileIdMisses() << ", by #include: " << resolver.stats()
+			<< ", by a search without listings: " << resolver.naiveStats() << endl;
+		err << "directories listed: " << resolver.listings() << endl;
+		err << "includes: " << session.includes() << ", skipped by include guard: " << session.guardedIncludes()
+			<< endl;
+		if (snapshots)
+			err << "prefix snapshots used: " << snapshots->found() << ", loaded: " << snapshots->loaded()
+				<< ", written: " << snapshots->written() << ", stale: " << snapshots->stale() << endl;
+	}
+}
 
-			// TODO: implement `preproc` as per PA5 description
-			out << "not yet implemented" << endl;
-	
-			out << "eof" << endl;
+// preproc --server <socket> keeps sessions warm between runs, for
+// preproc-client to send its command lines to
+//
+// a request is the working directory of the client and its arguments; the
+// reply is the exit status and what preproc would have written to stderr.
+// each client is served on a thread of its own. the server runs in the
+// working directory of the requests it serves, so requests from one
+// directory run at once, while one from another waits until they are done.
+// there is a session per working directory and pchdir. a session reads
+// through a WatchedFileSystem, and is dropped for a new one once anything it
+// read has changed; beyond PA5MaxSessions, the one used least recently is
+// dropped, with its mappings and watches, once its last request is done.
+class PA5Server
+{
+public:
+	explicit PA5Server(const string& path)
+		: socket(LocalSocket::listen(path))
+	{}
 
+	// serves requests until killed
+	void serve()
+	{
+		for (;;)
+		{
+			unique_ptr<LocalSocket> client = socket->accept();
+			try
+			{
+				thread(&PA5Server::serveClient, this, move(client)).detach();
+			}
+			catch (exception&)
+			{
+				// no thread for the client; it sees the connection closed
+			}
 		}
 	}
+
+private:
+	static const size_t PA5MaxSessions = 4;
+
+	struct PA5Session
+	{
+		explicit PA5Session(const string& pchdir)
+			: disk(PA5GetFileId), files(disk), session(files)
+		{
+			if (!pchdir.empty())
+				session.setSnapshotDirectory(pchdir);
+		}
+
+		DiskFileSystem disk;
+		WatchedFileSystem files;
+		PreprocessorSession session;
+		uint64_t used = 0; // when last asked for, in requests
+	};
+
+	// runs in the working directory of a request while it lives
+	class PA5Directory
+	{
+	public:
+		PA5Directory(PA5Server& server, const string& path)
+			: server(server)
+		{
+			unique_lock<mutex> lock(server.m);
+			server.directory_cv.wait(lock, [&] { return server.running == 0 || server.directory == path; });
+			if (server.running == 0)
+			{
+				if (chdir(path.c_str()) != 0)
+					throw runtime_error("cannot change to the working directory of the client");
+				server.directory = path;
+			}
+			server.running++;
+		}
+
+		~PA5Directory()
+		{
+			lock_guard<mutex> lock(server.m);
+			if (--server.running == 0)
+				server.directory_cv.notify_all();
+		}
+
+	private:
+		PA5Server& server;
+	};
+
+	void serveClient(unique_ptr<LocalSocket> client)
+	{
+		try
+		{
+			vector<string> message;
+			while (client->receive(message))
+				client->send(reply(message));
+		}
+		catch (exception&)
+		{
+			// the client went away; the others are served all the same
+		}
+	}
+
+	vector<string> reply(const vector<string>& request)
+	{
+		ostringstream err;
+		int status = EXIT_SUCCESS;
+		try
+		{
+			if (request.empty())
+				throw runtime_error("cannot change to the working directory of the client");
+			PA5Directory directory(*this, request[0]);
+			const PA5Options options = PA5ParseArgs(vector<string>(request.begin() + 1, request.end()));
+			const shared_ptr<PA5Session> s = session(request[0] + '\0' + options.pchdir, options.pchdir);
+			PA5Run(options, s->session, err);
+		}
+		catch (exception& e)
+		{
+			err << "ERROR: " << e.what() << endl;
+			status = EXIT_FAILURE;
+		}
+		return { to_string(status), err.str() };
+	}
+
+	// the session of `key`, a new one if it has none or its files changed
+	shared_ptr<PA5Session> session(const string& key, const string& pchdir)
+	{
+		lock_guard<mutex> lock(m);
+		shared_ptr<PA5Session>& s = sessions[key];
+		if (s && s->files.changed())
+			s.reset();
+		if (!s)
+			s = make_shared<PA5Session>(pchdir);
+		s->used = ++requests;
+		const shared_ptr<PA5Session> found = s;
+
+		if (sessions.size() > PA5MaxSessions)
+		{
+			auto lru = sessions.begin();
+			for (auto it = sessions.begin(); it != sessions.end(); ++it)
+				if (it->second->used < lru->second->used)
+					lru = it;
+			sessions.erase(lru);
+		}
+		return found;
+	}
+
+	unique_ptr<LocalSocket> socket;
+	mutex m;
+	condition_variable directory_cv;
+	string directory; // the working directory of the requests running
+	size_t running = 0; // the requests running
+	uint64_t requests = 0;
+	map<string, shared_ptr<PA5Session>> sessions; // by working directory, '\0', pchdir
+};
+
+int main(int argc, char** argv)
+{
+	try
+	{
+		vector<string> args;
+
+		for (int i = 1; i < argc; i++)
+			args.emplace_back(argv[i]);
+
+		if (args.size() == 2 && args[0] == "--server")
+		{
+			PA5Server server(args[1]);
+			server.serve();
+		}
+
+		const PA5Options options = PA5ParseArgs(args);
+
+		// every file is mapped and lexed once, whichever srcfile includes it
+		DiskFileSystem files(PA5GetFileId);
+		PreprocessorSession session(files);
+		// snapshots of the #include lines srcfiles start with, kept in `pchdir` across runs
+		if (!options.pchdir.empty())
+			session.setSnapshotDirectory(options.pchdir);
+		PA5Run(options, session, cerr);
+	}
 	catch (exception& e)
 	{
 		cerr << "ERROR: " << e.what() << endl;
 		return EXIT_FAILURE;
 	}
 }
-
@@ -0,0 +1,146 @@
+#include "Grammar.h"
+
+#include <cctype>
+#include <functional>
+#include <stdexcept>
+
+namespace {
+
+  std::runtime_error error(size_t line, const std::string &what)
+  {
+    return std::runtime_error("line " + std::to_string(line) + ": " + what);
+  }
+
+  bool isNameChar(char c)
+  {
+    return std::isalnum(static_cast<unsigned char>(c))  ||  c == '_'  ||  c == '-';
+  }
+
+  // Parses the elements of `text` from `i` up to a `)`, if `nested`, or the
+  // end.
+  Grammar::Sequence parseSequence(const std::string &text, size_t &i, bool nested, size_t line)
+  {
+    Grammar::Sequence sequence;
+    for (;;) {
+      while (i < text.size()  &&  std::isspace(static_cast<unsigned char>(text[i])))
+        i++;
+      if (i == text.size()) {
+        if (nested)
+          throw error(line, "missing )");
+        break;
+      }
+      if (text[i] == ')') {
+        if (!nested)
+          throw error(line, "unexpected )");
+        i++;
+        break;
+      }
+
+      Grammar::Element element;
+      if (text[i] == '(') {
+        i++;
+        element.kind = Grammar::Element::Group;
+        element.group = parseSequence(text, i, true, line);
+        if (element.group.empty())
+          throw error(line, "empty group");
+      } else if (isNameChar(text[i])) {
+        const size_t begin = i;
+        while (i < text.size()  &&  isNameChar(text[i]))
+          i++;
+        element.name = text.substr(begin, i - begin);
+        // Token names are upper case: KW_INT, OP_LT, TT_IDENTIFIER, ST_EOF.
+        element.kind = std::isupper(static_cast<unsigned char>(element.name[0])) ?
+          Grammar::Element::Terminal : Grammar::Element::Nonterminal;
+      } else {
+        throw error(line, std::string("unexpected ") + text[i]);
+      }
+
+      element.repeat = Grammar::Element::One;
+      if (i < text.size()) {
+        switch (text[i]) {
+          case '?': element.repeat = Grammar::Element::Optional; i++; break;
+          case '*': element.repeat = Grammar::Element::Star; i++; break;
+          case '+': element.repeat = Grammar::Element::Plus; i++; break;
+        }
+      }
+      sequence.push_back(element);
+    }
+    return sequence;
+  }
+
+} // namespace
+
+Grammar::Grammar(const std::string &text)
+{
+  // Logical lines, with the physical line each starts on.
+  std::vector<std::pair<std::string, size_t>> lines;
+  size_t line = 1;
+  bool continued = false;
+  for (size_t i = 0; i < text.size(); ) {
+    size_t end = text.find('\n', i);
+    if (end == std::string::npos)
+      end = text.size();
+    std::string physical = text.substr(i, end - i);
+    if (!physical.empty()  &&  physical.back() == '\r')
+      physical.pop_back();
+    const bool splice = !physical.empty()  &&  physical.back() == '\\';
+    if (splice)
+      physical.pop_back();
+    if (continued)
+      lines.back().first += " " + physical;
+    else
+      lines.emplace_back(physical, line);
+    continued = splice;
+    i = end + 1;
+    line++;
+  }
+
+  Rule *rule = nullptr;
+  for (const auto &l: lines) {
+    const std::string &s = l.first;
+    if (s.find_first_not_of(" \t") == std::string::npos)
+      continue;
+    if (s[0] != ' '  &&  s[0] != '\t') {
+      const size_t colon = s.find(':');
+      const size_t last = s.find_last_not_of(" \t");
+      if (colon == std::string::npos  ||  colon != last  ||  colon == 0)
+        throw error(l.second, "expected a rule name and :");
+      const std::string name = s.substr(0, colon);
+      for (char c: name) {
+        if (!isNameChar(c))
+          throw error(l.second, "invalid rule name " + name);
+      }
+      if (_index.count(name))
+        throw error(l.second, "rule " + name + " defined again");
+      _index[name] = _rules.size();
+      _rules.push_back(Rule{name, {}, l.second});
+      rule = &_rules.back();
+      continue;
+    }
+    if (!rule)
+      throw error(l.second, "alternative outside a rule");
+    size_t i = 0;
+    rule->alternatives.push_back(parseSequence(s, i, false, l.second));
+  }
+
+  // Every nonterminal must be defined.
+  std::function<void (const Sequence &, size_t)> check = [&](const Sequence &sequence, size_t line) {
+    for (const Element &element: sequence) {
+      if (element.kind == Element::Nonterminal  &&  !_index.count(element.name))
+        throw error(line, "undefined rule " + element.name);
+      check(element.group, line);
+    }
+  };
+  for (const Rule &r: _rules) {
+    if (r.alternatives.empty())
+      throw error(r.line, "rule " + r.name + " has no alternatives");
+    for (const Sequence &alternative: r.alternatives)
+      check(alternative, r.line);
+  }
+}
+
+const Grammar::Rule *Grammar::rule(const std::string &name) const
+{
+  const auto it = _index.find(name);
+  return it == _index.end() ? nullptr : &_rules[it->second];
+}
@@ -0,0 +1,49 @@
+#ifndef Grammar_h
+#define Grammar_h
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+// A grammar in the format of pa6.gram: a rule is its name and a colon on a
+// line of its own, then its alternatives, indented, one per logical line, a
+// `\` at the end of a line continuing it. An alternative is a sequence of
+// terminals, which are token names such as KW_INT, OP_LPAREN or
+// TT_IDENTIFIER, nonterminals, which are rule names, and parenthesized
+// groups, each optionally followed by `?`, `*` or `+`.
+class Grammar {
+public:
+  struct Element {
+    enum Kind { Terminal, Nonterminal, Group };
+    enum Repeat { One, Optional, Star, Plus };
+
+    Kind kind;
+    Repeat repeat;
+    std::string name;                   // of a terminal or a nonterminal
+    std::vector<Element> group;         // the sequence of a group
+  };
+
+  typedef std::vector<Element> Sequence;
+
+  struct Rule {
+    std::string name;
+    std::vector<Sequence> alternatives;
+    size_t line;                        // of the name, from 1
+  };
+
+  // Parses `text`. Throws std::runtime_error, with the line, if it is not a
+  // grammar or uses a rule it does not define.
+  explicit Grammar(const std::string &text);
+
+  // In the order of the text.
+  const std::vector<Rule> &rules() const { return _rules; }
+  // nullptr if there is none.
+  const Rule *rule(const std::string &name) const;
+
+private:
+  std::vector<Rule> _rules;
+  std::map<std::string, size_t> _index;         // of _rules, by name
+};
+
+#endif /* end of include guard */
@@ -0,0 +1,23 @@
+#include "NameClassifier.h"
+
+#include <algorithm>
+
+void NameClassifier::reset(const TokenStreamReader &stream)
+{
+  _stream = &stream;
+  _kinds.assign(stream.numStrings(), 0);
+  _lookups = 0;
+}
+
+void NameClassifier::invalidateAll()
+{
+  std::fill(_kinds.begin(), _kinds.end(), 0);
+}
+
+uint8_t NameClassifier::_classify(uint32_t id)
+{
+  _lookups++;
+  const uint8_t kinds = _lookup.nameKinds(_stream->string(id).str()) & (Known - 1);
+  _kinds[id] = kinds | Known;
+  return kinds;
+}
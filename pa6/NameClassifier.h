@@ -0,0 +1,60 @@
+#ifndef NameClassifier_h
+#define NameClassifier_h
+
+#include "ParseTables.h"
+#include "pa2/TokenStream.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Tells what kinds of name an identifier is: a bit, 1 << kind, for each
+// NameKind it is.
+class NameLookupIfc {
+public:
+  virtual ~NameLookupIfc() {}
+  virtual uint8_t nameKinds(const std::string &identifier) = 0;
+};
+
+// The kinds of name of the identifiers of a token stream, by string id.
+// Strings are interned in a stream, so the kinds of an identifier are
+// looked up once, on first use, and kept in a byte per string; each use
+// after is one load.
+//
+// A lookup whose answers change, as a scope lookup's do when a name is
+// declared, has the classifier forget what it kept.
+class NameClassifier {
+public:
+  explicit NameClassifier(NameLookupIfc &lookup): _lookup(lookup), _stream(nullptr), _lookups(0) {}
+
+  // Classifies the identifiers of `stream`, which must outlive its use,
+  // from now on.
+  void reset(const TokenStreamReader &stream);
+
+  bool is(NameKind kind, uint32_t id) { return kinds(id) >> kind & 1; }
+  uint8_t kinds(uint32_t id)
+  {
+    const uint8_t k = _kinds[id];
+    return k & Known ? k & ~Known : _classify(id);
+  }
+
+  void invalidate(uint32_t id) { _kinds[id] = 0; }
+  void invalidateAll();
+
+  // The lookups made since the last reset().
+  size_t lookups() const { return _lookups; }
+
+private:
+  static_assert(NumNameKinds < 8, "the kinds and Known fit in a byte");
+  static const uint8_t Known = 0x80;
+
+  uint8_t _classify(uint32_t id);
+
+  NameLookupIfc &_lookup;
+  const TokenStreamReader *_stream;
+  std::vector<uint8_t> _kinds;  // by string id, Known once looked up
+  size_t _lookups;
+};
+
+#endif /* end of include guard */
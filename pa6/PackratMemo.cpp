@@ -0,0 +1,112 @@
+#include "PackratMemo.h"
+
+#include <algorithm>
+
+PackratMemo::PackratMemo(size_t maxBytes):
+  _size(0), _maxBytes(maxBytes), _peakBytes(0), _hits(0), _misses(0), _evictions(0), _evicted(0)
+{
+  _reset(InitialCapacity);
+}
+
+size_t PackratMemo::minBytes()
+{
+  return InitialCapacity * sizeof(Entry) + sizeof(uint32_t);
+}
+
+bool PackratMemo::find(uint32_t rule, uint32_t pos, const uint32_t *&begin, const uint32_t *&end)
+{
+  const size_t mask = _slots.size() - 1;
+  for (size_t i = _slot(rule, pos); _slots[i].rule != Empty; i = (i + 1) & mask) {
+    const Entry &e = _slots[i];
+    if (e.rule == rule  &&  e.pos == pos) {
+      _hits++;
+      begin = _pool.data() + e.begin;
+      end = begin + e.size;
+      return true;
+    }
+  }
+  _misses++;
+  return false;
+}
+
+bool PackratMemo::fits(size_t numEnds) const
+{
+  const size_t growth = (_size + 1) * 2 > _slots.size() ? _slots.size() * sizeof(Entry) : 0;
+  return bytes() + growth + numEnds * sizeof(uint32_t) <= _maxBytes;
+}
+
+void PackratMemo::evict(uint32_t floor, size_t numEnds)
+{
+  _evictions++;
+  std::vector<Entry> slots;
+  std::vector<uint32_t> pool;
+  slots.swap(_slots);
+  pool.swap(_pool);
+  const size_t size = _size;
+  _reset(slots.size());
+  for (const Entry &e: slots) {
+    if (e.rule != Empty  &&  e.pos >= floor)
+      _put(e.rule, e.pos, pool.data() + e.begin, pool.data() + e.begin + e.size);
+  }
+  if (!fits(numEnds)) {
+    _reset(InitialCapacity);
+    _pool.clear();
+  }
+  _evicted += size - _size;
+}
+
+void PackratMemo::insert(uint32_t rule, uint32_t pos, const uint32_t *begin, const uint32_t *end)
+{
+  if ((_size + 1) * 2 > _slots.size()) {
+    std::vector<Entry> slots;
+    slots.swap(_slots);
+    _reset(slots.size() * 2);
+    for (const Entry &e: slots) {
+      if (e.rule != Empty)
+        _place(e);
+    }
+  }
+  _put(rule, pos, begin, end);
+  _peakBytes = std::max(_peakBytes, bytes());
+}
+
+void PackratMemo::clear()
+{
+  std::fill(_slots.begin(), _slots.end(), Entry{Empty, 0, 0, 0});
+  _pool.clear();
+  _size = 0;
+  _peakBytes = _hits = _misses = _evictions = _evicted = 0;
+}
+
+size_t PackratMemo::bytes() const
+{
+  return _slots.size() * sizeof(Entry) + _pool.size() * sizeof(uint32_t);
+}
+
+size_t PackratMemo::_slot(uint32_t rule, uint32_t pos) const
+{
+  uint64_t h = (uint64_t(rule) << 32 | pos) * 0x9e3779b97f4a7c15;
+  return (h >> 32) & (_slots.size() - 1);
+}
+
+void PackratMemo::_reset(size_t capacity)
+{
+  _slots.assign(capacity, Entry{Empty, 0, 0, 0});
+  _size = 0;
+}
+
+void PackratMemo::_place(const Entry &entry)
+{
+  const size_t mask = _slots.size() - 1;
+  size_t i = _slot(entry.rule, entry.pos);
+  while (_slots[i].rule != Empty)
+    i = (i + 1) & mask;
+  _slots[i] = entry;
+  _size++;
+}
+
+void PackratMemo::_put(uint32_t rule, uint32_t pos, const uint32_t *begin, const uint32_t *end)
+{
+  _place(Entry{rule, pos, static_cast<uint32_t>(_pool.size()), static_cast<uint32_t>(end - begin)});
+  _pool.insert(_pool.end(), begin, end);
+}
@@ -0,0 +1,80 @@
+#ifndef PackratMemo_h
+#define PackratMemo_h
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// The end positions of rules at token positions, memoized for the
+// Recognizer.
+//
+// Entries are kept in a flat hash table with open addressing, keyed by
+// rule and position, and their ends in one pool, so an entry costs no
+// allocation of its own. The memo is bounded in bytes: when an insert
+// would go over, the entries at positions behind a floor the recognizer
+// gives, which no rule it is running can ask for again, are evicted, and
+// if that is not room enough, all of them. The memo is only a cache, so
+// evicting entries costs time, not correctness.
+class PackratMemo {
+public:
+  static const size_t DefaultMaxBytes = 256 << 20;
+
+  explicit PackratMemo(size_t maxBytes = DefaultMaxBytes);
+
+  // The least maxBytes with room for one entry besides the empty table;
+  // below it every insert evicts all.
+  static size_t minBytes();
+
+  // The ends of `rule` at `pos`, valid until the next insert() or evict().
+  bool find(uint32_t rule, uint32_t pos, const uint32_t *&begin, const uint32_t *&end);
+
+  // Whether `numEnds` more ends fit within the bound.
+  bool fits(size_t numEnds) const;
+  // Evicts the entries at positions below `floor`, and all entries if
+  // `numEnds` do not fit then.
+  void evict(uint32_t floor, size_t numEnds);
+  // Not an entry already there.
+  void insert(uint32_t rule, uint32_t pos, const uint32_t *begin, const uint32_t *end);
+
+  // Drops the entries and the counts.
+  void clear();
+
+  size_t hits() const { return _hits; }
+  size_t misses() const { return _misses; }
+  size_t evictions() const { return _evictions; }
+  size_t evicted() const { return _evicted; }   // entries
+  size_t size() const { return _size; }
+  size_t bytes() const;
+  size_t peakBytes() const { return _peakBytes; }
+  size_t maxBytes() const { return _maxBytes; }
+
+private:
+  static const uint32_t Empty = UINT32_MAX;
+  static const size_t InitialCapacity = 1024;
+
+  struct Entry {
+    uint32_t rule;      // Empty for a free slot
+    uint32_t pos;
+    uint32_t begin;     // of _pool
+    uint32_t size;
+  };
+
+  size_t _slot(uint32_t rule, uint32_t pos) const;
+  void _reset(size_t capacity);
+  // Places an entry whose ends are in the pool.
+  void _place(const Entry &entry);
+  // Places an entry and copies its ends to the pool.
+  void _put(uint32_t rule, uint32_t pos, const uint32_t *begin, const uint32_t *end);
+
+  std::vector<Entry> _slots;    // a power of 2 of them, at most half used
+  std::vector<uint32_t> _pool;
+  size_t _size;
+  size_t _maxBytes;
+  size_t _peakBytes;
+  size_t _hits;
+  size_t _misses;
+  size_t _evictions;
+  size_t _evicted;
+};
+
+#endif /* end of include guard */
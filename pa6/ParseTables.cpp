@@ -0,0 +1,408 @@
+#include "ParseTables.h"
+
+#include <deque>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <utility>
+
+bool TokenSet::merge(const TokenSet &other)
+{
+  const uint64_t b0 = bits[0] | other.bits[0];
+  const uint64_t b1 = bits[1] | other.bits[1];
+  const bool changed = b0 != bits[0]  ||  b1 != bits[1];
+  bits[0] = b0;
+  bits[1] = b1;
+  return changed;
+}
+
+namespace {
+
+  // The rules whose TT_IDENTIFIER is a name of a kind.
+  const std::map<std::string, NameKind> NameRules = {
+    {"class-name", ClassName},
+    {"template-name", TemplateName},
+    {"typedef-name", TypedefName},
+    {"enum-name", EnumName},
+    {"namespace-name", NamespaceName},
+  };
+
+  // The operators that are not between template angle brackets.
+  const std::set<std::string> AngleOperatorRules = {"relational-operator", "shift-operator"};
+  const std::set<std::string> AngleOperators = {"OP_GT", "ST_RSHIFT_1", "ST_RSHIFT_2"};
+
+  const char *const CloseAngleBracket = "close-angle-bracket";
+
+  // The rule whose identifier alternative is only a fallback for its
+  // template-id.
+  const char *const FallbackRule = "unqualified-id";
+
+  // What a sequence of elements is within: `(` for any bracket but an angle
+  // one, `<`, or nothing, where the mode of the rule holds.
+  std::vector<char> enclosures(const Grammar::Sequence &sequence)
+  {
+    std::vector<char> result;
+    std::vector<std::string> stack;     // closing terminals and close-angle-bracket
+    for (size_t i = 0; i < sequence.size(); i++) {
+      const Grammar::Element &e = sequence[i];
+      result.push_back(stack.empty() ? 0 : stack.back() == CloseAngleBracket ? '<' : '(');
+      if (!stack.empty()  &&  e.name == stack.back()) {
+        stack.pop_back();
+        result.back() = stack.empty() ? 0 : stack.back() == CloseAngleBracket ? '<' : '(';
+        continue;
+      }
+      if (e.kind != Grammar::Element::Terminal)
+        continue;
+      if (e.name == "OP_LPAREN")
+        stack.push_back("OP_RPAREN");
+      else if (e.name == "OP_LSQUARE")
+        stack.push_back("OP_RSQUARE");
+      else if (e.name == "OP_LBRACE")
+        stack.push_back("OP_RBRACE");
+      else if (e.name == "OP_LT") {
+        // Only a < a close-angle-bracket follows opens a list.
+        for (size_t j = i + 1; j < sequence.size(); j++) {
+          if (sequence[j].name == CloseAngleBracket) {
+            stack.push_back(CloseAngleBracket);
+            break;
+          }
+        }
+      }
+    }
+    return result;
+  }
+
+} // namespace
+
+// Compiles rules as they are first used, the angle variant of a rule only if
+// its alternatives differ from the plain ones.
+class ParseTables::Compiler {
+public:
+  Compiler(const Grammar &grammar, ParseTables &tables): _grammar(grammar), _tables(tables)
+  {
+    for (const Grammar::Rule &rule: grammar.rules())
+      _addSource(&rule, rule.name, rule.alternatives);
+    for (const auto &it: TokenTypeToStringMap) {
+      if (it.first != OP_RSHIFT)
+        _tokenCodes[it.second] = it.first;
+    }
+    _findAngleSensitive();
+  }
+
+  uint32_t compile(const std::string &start)
+  {
+    const Grammar::Rule *rule = _grammar.rule(start);
+    if (!rule)
+      throw std::runtime_error("undefined rule " + start);
+    const uint32_t id = _rule(rule, false);
+    while (!_queue.empty()) {
+      const auto next = _queue.front();
+      _queue.pop_front();
+      _build(next.first, next.second);
+    }
+    _computeFirst();
+    _checkLeftRecursion();
+    return id;
+  }
+
+private:
+  // A rule of the grammar or a group, compiled as a rule.
+  struct Source {
+    std::string name;
+    std::vector<const Grammar::Sequence *> alternatives;
+    bool angleSensitive = false;
+  };
+
+  void _addSource(const void *key, const std::string &name, const std::vector<Grammar::Sequence> &alternatives)
+  {
+    Source &source = _sources[key];
+    source.name = name;
+    for (const Grammar::Sequence &sequence: alternatives)
+      source.alternatives.push_back(&sequence);
+    size_t groups = 0;
+    for (const Grammar::Sequence &sequence: alternatives)
+      _addGroups(sequence, name, groups);
+  }
+
+  void _addGroups(const Grammar::Sequence &sequence, const std::string &name, size_t &groups)
+  {
+    for (const Grammar::Element &e: sequence) {
+      if (e.kind != Grammar::Element::Group)
+        continue;
+      const std::string groupName = name + "#" + std::to_string(++groups);
+      Source &source = _sources[&e];
+      source.name = groupName;
+      source.alternatives.push_back(&e.group);
+      _addGroups(e.group, name, groups);
+    }
+  }
+
+  const void *_key(const Grammar::Element &e) const
+  {
+    return e.kind == Grammar::Element::Group ? static_cast<const void *>(&e) :
+      static_cast<const void *>(_grammar.rule(e.name));
+  }
+
+  // A source is angle sensitive if it is one of the operators, or uses one
+  // that is where the mode of the rule holds.
+  void _findAngleSensitive()
+  {
+    for (auto &it: _sources)
+      it.second.angleSensitive = AngleOperatorRules.count(it.second.name) != 0;
+    for (bool changed = true; changed; ) {
+      changed = false;
+      for (auto &it: _sources) {
+        Source &source = it.second;
+        if (source.angleSensitive)
+          continue;
+        for (const Grammar::Sequence *sequence: source.alternatives) {
+          const std::vector<char> within = enclosures(*sequence);
+          for (size_t i = 0; i < sequence->size()  &&  !source.angleSensitive; i++) {
+            const Grammar::Element &e = (*sequence)[i];
+            if (!within[i]  &&  e.kind != Grammar::Element::Terminal  &&  _sources.at(_key(e)).angleSensitive)
+              source.angleSensitive = changed = true;
+          }
+        }
+      }
+    }
+  }
+
+  uint32_t _rule(const void *key, bool angle)
+  {
+    const Source &source = _sources.at(key);
+    angle = angle  &&  source.angleSensitive;
+    const auto found = _ids.find(std::make_pair(key, angle));
+    if (found != _ids.end())
+      return found->second;
+    const uint32_t id = _tables._rules.size();
+    _ids[std::make_pair(key, angle)] = id;
+    Rule rule;
+    rule.name = source.name + (angle ? "<>" : "");
+    rule.begin = rule.end = 0;
+    rule.nullable = false;
+    _tables._rules.push_back(rule);
+    _queue.emplace_back(key, angle);
+    return id;
+  }
+
+  uint32_t _terminal(const std::string &name, const std::string &ruleName)
+  {
+    Terminal t;
+    t.name = name;
+    t.check = CheckNone;
+    t.kind = NumNameKinds;
+    const auto nameRule = NameRules.find(ruleName);
+    if (name == "TT_IDENTIFIER"  &&  nameRule != NameRules.end()) {
+      t.code = TokenIdentifier;
+      t.check = CheckName;
+      t.kind = nameRule->second;
+      t.name += "(" + ruleName + ")";
+    } else if (name == "TT_IDENTIFIER") {
+      t.code = TokenIdentifier;
+    } else if (name == "TT_LITERAL") {
+      t.code = TokenLiteral;
+    } else if (name == "ST_EMPTYSTR") {
+      t.code = TokenLiteral;
+      t.check = CheckEmptyString;
+    } else if (name == "ST_ZERO") {
+      t.code = TokenLiteral;
+      t.check = CheckZero;
+    } else if (name == "ST_OVERRIDE") {
+      t.code = TokenIdentifier;
+      t.check = CheckOverride;
+    } else if (name == "ST_FINAL") {
+      t.code = TokenIdentifier;
+      t.check = CheckFinal;
+    } else if (name == "ST_NONPAREN") {
+      t.code = 0;
+      t.check = CheckNonParen;
+    } else if (name == "ST_RSHIFT_1") {
+      t.code = TokenRShift1;
+    } else if (name == "ST_RSHIFT_2") {
+      t.code = TokenRShift2;
+    } else if (name == "ST_EOF") {
+      t.code = TokenEof;
+    } else {
+      const auto it = _tokenCodes.find(name);
+      if (it == _tokenCodes.end())
+        throw std::runtime_error("unknown terminal " + name + " in rule " + ruleName);
+      t.code = it->second;
+    }
+
+    const auto found = _terminalIds.find(t.name);
+    if (found != _terminalIds.end())
+      return found->second;
+    const uint32_t id = _tables._terminals.size();
+    _terminalIds[t.name] = id;
+    _tables._terminals.push_back(t);
+    TokenSet first;
+    if (t.check == CheckNonParen) {
+      for (unsigned code = 0; code < NumTokenCodes; code++) {
+        if (code != OP_LPAREN  &&  code != OP_RPAREN  &&  code != OP_LSQUARE  &&  code != OP_RSQUARE  &&
+            code != OP_LBRACE  &&  code != OP_RBRACE  &&  code != TokenEof  &&  code != OP_RSHIFT)
+          first.add(code);
+      }
+    } else {
+      first.add(t.code);
+    }
+    _tables._terminalFirst.push_back(first);
+    return id;
+  }
+
+  void _build(const void *key, bool angle)
+  {
+    const Source &source = _sources.at(key);
+    const uint32_t id = _ids.at(std::make_pair(key, angle));
+    const bool angleOperators = angle  &&  AngleOperatorRules.count(source.name);
+    // The rule the terminals of a group are in, for the names.
+    const std::string ruleName = source.name.substr(0, source.name.find('#'));
+
+    std::vector<std::vector<Item>> items;
+    std::vector<Item> fallback;
+    for (const Grammar::Sequence *sequence: source.alternatives) {
+      bool dropped = false;
+      std::vector<Item> alternative;
+      const std::vector<char> within = enclosures(*sequence);
+      for (size_t i = 0; i < sequence->size(); i++) {
+        const Grammar::Element &e = (*sequence)[i];
+        Item item;
+        item.repeat = static_cast<Repeat>(e.repeat);
+        if (e.kind == Grammar::Element::Terminal) {
+          if (angleOperators  &&  AngleOperators.count(e.name))
+            dropped = true;
+          item.terminal = true;
+          item.symbol = _terminal(e.name, ruleName);
+        } else {
+          item.terminal = false;
+          item.symbol = _rule(_key(e), within[i] ? within[i] == '<' : angle);
+          if (source.name == "decl-specifier-seq"  &&  e.name == "decl-specifier"  &&  e.repeat == Grammar::Element::Plus)
+            item.repeat = DeclSpecifiers;
+        }
+        alternative.push_back(item);
+      }
+      if (dropped)
+        continue;
+      if (source.name == FallbackRule  &&  sequence->size() == 1  &&  (*sequence)[0].name == "TT_IDENTIFIER")
+        fallback = alternative;
+      else
+        items.push_back(alternative);
+    }
+    if (!fallback.empty())
+      items.push_back(fallback);
+
+    Rule &rule = _tables._rules[id];
+    rule.begin = _tables._alternatives.size();
+    for (const std::vector<Item> &alternative: items) {
+      Alternative a;
+      a.begin = _tables._items.size();
+      _tables._items.insert(_tables._items.end(), alternative.begin(), alternative.end());
+      a.end = _tables._items.size();
+      a.nullable = false;
+      a.fallback = !fallback.empty()  &&  &alternative == &items.back();
+      _tables._alternatives.push_back(a);
+    }
+    rule.end = _tables._alternatives.size();
+  }
+
+  void _computeFirst()
+  {
+    for (bool changed = true; changed; ) {
+      changed = false;
+      for (Rule &rule: _tables._rules) {
+        for (uint32_t a = rule.begin; a < rule.end; a++) {
+          Alternative &alternative = _tables._alternatives[a];
+          bool nullable = true;
+          for (uint32_t i = alternative.begin; i < alternative.end  &&  nullable; i++) {
+            const Item &item = _tables._items[i];
+            changed |= alternative.first.merge(_tables.first(item));
+            nullable = _tables.nullable(item);
+          }
+          if (nullable  &&  !alternative.nullable)
+            alternative.nullable = changed = true;
+          changed |= rule.first.merge(alternative.first);
+          if (alternative.nullable  &&  !rule.nullable)
+            rule.nullable = changed = true;
+        }
+      }
+    }
+  }
+
+  // A rule that can call itself before consuming a token would never
+  // finish.
+  void _checkLeftRecursion()
+  {
+    const std::vector<Rule> &rules = _tables._rules;
+    std::vector<char> state(rules.size(), 0);   // 1 on the path, 2 done
+    std::vector<std::pair<uint32_t, std::vector<uint32_t>>> stack;
+    auto calls = [&](uint32_t r) {
+      std::vector<uint32_t> result;
+      for (uint32_t a = rules[r].begin; a < rules[r].end; a++) {
+        const Alternative &alternative = _tables._alternatives[a];
+        for (uint32_t i = alternative.begin; i < alternative.end; i++) {
+          const Item &item = _tables._items[i];
+          if (!item.terminal)
+            result.push_back(item.symbol);
+          if (!_tables.nullable(item))
+            break;
+        }
+      }
+      return result;
+    };
+    for (uint32_t root = 0; root < rules.size(); root++) {
+      if (state[root])
+        continue;
+      state[root] = 1;
+      stack.emplace_back(root, calls(root));
+      while (!stack.empty()) {
+        if (stack.back().second.empty()) {
+          state[stack.back().first] = 2;
+          stack.pop_back();
+          continue;
+        }
+        const uint32_t next = stack.back().second.back();
+        stack.back().second.pop_back();
+        if (state[next] == 1)
+          throw std::runtime_error("left recursive rule " + rules[next].name);
+        if (state[next] == 0) {
+          state[next] = 1;
+          stack.emplace_back(next, calls(next));
+        }
+      }
+    }
+  }
+
+  const Grammar &_grammar;
+  ParseTables &_tables;
+  std::map<const void *, Source> _sources;      // by rule or group element
+  std::map<std::pair<const void *, bool>, uint32_t> _ids;      // by source and angle
+  std::deque<std::pair<const void *, bool>> _queue;           // rules to build
+  std::map<std::string, uint8_t> _tokenCodes;
+  std::map<std::string, uint32_t> _terminalIds;
+};
+
+ParseTables::ParseTables(const Grammar &grammar, const std::string &start)
+{
+  Compiler compiler(grammar, *this);
+  _start = compiler.compile(start);
+}
+
+int32_t ParseTables::rule(const std::string &name) const
+{
+  for (size_t i = 0; i < _rules.size(); i++) {
+    if (_rules[i].name == name)
+      return i;
+  }
+  return -1;
+}
+
+const TokenSet &ParseTables::first(const Item &item) const
+{
+  return item.terminal ? _terminalFirst[item.symbol] : _rules[item.symbol].first;
+}
+
+bool ParseTables::nullable(const Item &item) const
+{
+  if (item.repeat == Optional  ||  item.repeat == Star)
+    return true;
+  return !item.terminal  &&  _rules[item.symbol].nullable;
+}
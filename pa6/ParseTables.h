@@ -0,0 +1,143 @@
+#ifndef ParseTables_h
+#define ParseTables_h
+
+#include "Grammar.h"
+#include "pa2/TokenType.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// What the recognizer tells tokens apart by: the ETokenType of a simple
+// token, or one of these. OP_RSHIFT never occurs; it is split into
+// TokenRShift1 and TokenRShift2, as the PA6 grammar has it.
+enum TokenCode {
+  TokenIdentifier = OP_ARROW + 1,
+  TokenLiteral,
+  TokenRShift1,
+  TokenRShift2,
+  TokenEof,
+  NumTokenCodes
+};
+
+// A set of token codes.
+struct TokenSet {
+  uint64_t bits[2] = {0, 0};
+
+  bool contains(unsigned code) const { return bits[code / 64] >> code % 64 & 1; }
+  void add(unsigned code) { bits[code / 64] |= uint64_t(1) << code % 64; }
+  // Whether anything was added.
+  bool merge(const TokenSet &other);
+};
+
+// The kinds of name the mock name lookup of PA6 tells identifiers apart by.
+enum NameKind {
+  ClassName,
+  TemplateName,
+  TypedefName,
+  EnumName,
+  NamespaceName,
+  NumNameKinds
+};
+
+// A grammar compiled for recognizing one of its rules: flat arrays of
+// rules, their alternatives and the items of those, with the FIRST set of
+// each rule and alternative for predicting which to try.
+//
+// What C++ adds to the grammar is compiled in:
+//
+// - TT_IDENTIFIER in class-name, template-name, typedef-name, enum-name and
+//   namespace-name only matches an identifier that is a name of that kind;
+// - a rule is compiled a second time, as an angle variant, for use between
+//   the < and the close-angle-bracket of a template argument or parameter
+//   list, where relational-operator has no > and shift-operator no >>
+//   (14.2/3); brackets nested in such a list start over from the plain
+//   rules;
+// - the decl-specifier+ of decl-specifier-seq is marked, for the recognizer
+//   to apply the rule about type-names in decl-specifier-seqs (7.1/3);
+// - the TT_IDENTIFIER of unqualified-id is moved last and made a fallback,
+//   so a template-name followed by a template argument list is a template-id
+//   and never an identifier followed by < (14.2/3).
+//
+// Groups become rules of their own. Left recursion is rejected, so a rule
+// never calls itself without consuming a token.
+class ParseTables {
+public:
+  // How a terminal checks a token, on top of its code.
+  enum Check: uint8_t {
+    CheckNone,
+    CheckEmptyString,   // ST_EMPTYSTR, a literal ""
+    CheckZero,          // ST_ZERO, a literal 0
+    CheckOverride,      // ST_OVERRIDE, an identifier override
+    CheckFinal,         // ST_FINAL
+    CheckNonParen,      // ST_NONPAREN, any code but brackets and TokenEof
+    CheckName,          // a name of `kind`
+  };
+
+  struct Terminal {
+    std::string name;
+    uint8_t code;
+    Check check;
+    NameKind kind;
+  };
+
+  enum Repeat: uint8_t {
+    One,
+    Optional,
+    Star,
+    Plus,
+    DeclSpecifiers,     // a Plus under the type-name rule of decl-specifier-seq
+  };
+
+  struct Item {
+    uint32_t symbol;    // a terminal or a rule
+    bool terminal;
+    Repeat repeat;
+  };
+
+  struct Alternative {
+    uint32_t begin;     // of items
+    uint32_t end;
+    TokenSet first;
+    bool nullable;
+    bool fallback;      // tried only if the alternatives before it found no end
+  };
+
+  struct Rule {
+    std::string name;   // with a `<>` suffix for an angle variant, and `#n` for a group
+    uint32_t begin;     // of alternatives
+    uint32_t end;
+    TokenSet first;
+    bool nullable;
+  };
+
+  // Compiles the rules of `grammar` that `start` uses. Throws
+  // std::runtime_error for an unknown terminal or left recursion.
+  ParseTables(const Grammar &grammar, const std::string &start);
+
+  uint32_t start() const { return _start; }
+  const std::vector<Rule> &rules() const { return _rules; }
+  const std::vector<Alternative> &alternatives() const { return _alternatives; }
+  const std::vector<Item> &items() const { return _items; }
+  const std::vector<Terminal> &terminals() const { return _terminals; }
+
+  // The rule compiled from `name`, its plain variant; -1 if there is none.
+  int32_t rule(const std::string &name) const;
+
+  // The FIRST set of an item's symbol, and whether it can be empty.
+  const TokenSet &first(const Item &item) const;
+  bool nullable(const Item &item) const;
+
+private:
+  class Compiler;
+
+  uint32_t _start;
+  std::vector<Rule> _rules;
+  std::vector<Alternative> _alternatives;
+  std::vector<Item> _items;
+  std::vector<Terminal> _terminals;
+  std::vector<TokenSet> _terminalFirst;
+};
+
+#endif /* end of include guard */
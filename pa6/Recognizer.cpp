@@ -0,0 +1,352 @@
+#include "Recognizer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+  // Of a decl-specifier-seq state, with the position above them.
+  const uint32_t NonEmpty = 1;          // a decl-specifier was taken
+  const uint32_t Seen = 2;              // a type-specifier but a cv-qualifier was
+
+  bool equals(const TokenString &s, const char *literal)
+  {
+    return s.size == std::strlen(literal)  &&  std::memcmp(s.data, literal, s.size) == 0;
+  }
+
+  uint8_t flag(ParseTables::Check check)
+  {
+    return 1 << check;
+  }
+
+  bool isBracket(unsigned code)
+  {
+    return code == OP_LPAREN  ||  code == OP_RPAREN  ||  code == OP_LSQUARE  ||  code == OP_RSQUARE  ||
+      code == OP_LBRACE  ||  code == OP_RBRACE;
+  }
+
+  // Whether a decl-specifier starting with `code` is a type-specifier
+  // other than a cv-qualifier.
+  bool isTypeSpecifier(unsigned code)
+  {
+    switch (code) {
+      case KW_REGISTER: case KW_STATIC: case KW_THREAD_LOCAL: case KW_EXTERN: case KW_MUTABLE:
+      case KW_INLINE: case KW_VIRTUAL: case KW_EXPLICIT:
+      case KW_FRIEND: case KW_TYPEDEF: case KW_CONSTEXPR:
+      case KW_CONST: case KW_VOLATILE:
+        return false;
+      default:
+        return true;
+    }
+  }
+
+  // "file:line: " of a token, or less of it as the stream knows.
+  std::string location(const TokenStreamReader &tokens, const TokenRecord &r)
+  {
+    std::string s = tokens.string(r.file).str();
+    if (r.line != 0)
+      s += (s.empty() ? "line " : ":") + std::to_string(r.line);
+    return s.empty() ? s : s + ": ";
+  }
+
+  // Whether a decl-specifier starting with `code` would be a type-name.
+  bool isTypeNameStart(unsigned code)
+  {
+    return code == TokenIdentifier  ||  code == OP_COLON2;
+  }
+
+} // namespace
+
+Recognizer::Recognizer(const ParseTables &tables, NameLookupIfc &names, size_t memoBytes):
+  _tables(tables), _names(names), _depth(0), _memo(memoBytes), _memoize(memoBytes >= PackratMemo::minBytes()),
+  _single(0), _calls(0), _backtracks(0), _maxDepth(0)
+{
+}
+
+bool Recognizer::recognize(const TokenStreamReader &tokens)
+{
+  _prepare(tokens);
+  _memo.clear();
+  _calls = 0;
+  _backtracks = 0;
+  _maxDepth = 0;
+  _depth = 0;
+  _ruleStats.assign(_tables.rules().size(), RuleStats{0, 0, 0});
+
+  _push(_tables.start(), 0);
+  bool returned = false;
+  while (_depth) {
+    Frame &f = _frames[_depth - 1];
+    if (returned) {
+      returned = false;
+      const std::vector<uint32_t> &ends = _frames[_depth].ends;
+      _expand(f, f.state, ends.data(), ends.data() + ends.size());
+    }
+
+    // Runs `f` until it calls a rule or finishes.
+    for (;;) {
+      if (f.expanding) {
+        if (!f.work.empty()) {
+          std::pop_heap(f.work.begin(), f.work.end(), std::greater<uint32_t>());
+          const uint32_t state = f.work.back();
+          f.work.pop_back();
+          if (state == f.last)
+            continue;
+          f.last = state;
+          const uint32_t *begin;
+          const uint32_t *end;
+          if (!_lookup(f, state, begin, end))
+            break;
+          _expand(f, state, begin, end);
+          continue;
+        }
+        f.expanding = false;
+        std::sort(f.next.begin(), f.next.end());
+        f.next.erase(std::unique(f.next.begin(), f.next.end()), f.next.end());
+        f.current.swap(f.next);
+        f.item++;
+      }
+
+      if (f.alternative == _tables.rules()[f.rule].end) {
+        _finish(f);
+        returned = true;
+        break;
+      }
+      const ParseTables::Alternative &a = _tables.alternatives()[f.alternative];
+      if (f.current.empty()  ||  f.item == a.end) {
+        if (f.current.empty()) {
+          _backtracks++;
+          _ruleStats[f.rule].backtracks++;
+        }
+        f.ends.insert(f.ends.end(), f.current.begin(), f.current.end());
+        f.alternative++;
+        _startAlternative(f);
+        continue;
+      }
+      _startItem(f);
+    }
+  }
+
+  const std::vector<uint32_t> &ends = _frames[0].ends;
+  return std::find(ends.begin(), ends.end(), _tokens.size()) != ends.end();
+}
+
+void Recognizer::_prepare(const TokenStreamReader &tokens)
+{
+  _names.reset(tokens);
+  _tokens.clear();
+  _tokens.reserve(tokens.size() + 1);
+  for (const TokenRecord &r: tokens) {
+    Token t = {0, 0, r.source};
+    switch (r.kind) {
+      case TokenKind::Invalid:
+        throw std::runtime_error(location(tokens, r) + "invalid token " + tokens.string(r.source).str());
+      case TokenKind::Simple:
+        if (r.type == OP_RSHIFT) {
+          t.code = TokenRShift1;
+          _tokens.push_back(t);
+          t.code = TokenRShift2;
+        } else {
+          t.code = r.type;
+        }
+        break;
+      case TokenKind::Identifier:
+        t.code = TokenIdentifier;
+        if (equals(tokens.string(r.source), "override"))
+          t.flags = flag(ParseTables::CheckOverride);
+        else if (equals(tokens.string(r.source), "final"))
+          t.flags = flag(ParseTables::CheckFinal);
+        break;
+      case TokenKind::Eof:
+        t.code = TokenEof;
+        break;
+      default:
+        t.code = TokenLiteral;
+        if (equals(tokens.string(r.source), "\"\""))
+          t.flags = flag(ParseTables::CheckEmptyString);
+        else if (equals(tokens.string(r.source), "0"))
+          t.flags = flag(ParseTables::CheckZero);
+        break;
+    }
+    _tokens.push_back(t);
+  }
+  if (_tokens.empty()  ||  _tokens.back().code != TokenEof)
+    _tokens.push_back(Token{TokenEof, 0, 0});
+}
+
+bool Recognizer::_match(const ParseTables::Terminal &terminal, uint32_t pos)
+{
+  const Token &t = _tokens[pos];
+  if (terminal.check == ParseTables::CheckNonParen)
+    return !isBracket(t.code)  &&  t.code != TokenEof;
+  if (t.code != terminal.code)
+    return false;
+  switch (terminal.check) {
+    case ParseTables::CheckNone:
+      return true;
+    case ParseTables::CheckName:
+      return _names.is(terminal.kind, t.source);
+    default:
+      return t.flags & flag(terminal.check);
+  }
+}
+
+Recognizer::Frame &Recognizer::_push(uint32_t rule, uint32_t pos)
+{
+  if (_depth == _frames.size())
+    _frames.emplace_back();
+  Frame &f = _frames[_depth++];
+  _maxDepth = std::max(_maxDepth, _depth);
+  _calls++;
+  _ruleStats[rule].calls++;
+  f.rule = rule;
+  f.pos = pos;
+  f.alternative = _tables.rules()[rule].begin;
+  f.expanding = false;
+  f.ends.clear();
+  _startAlternative(f);
+  return f;
+}
+
+void Recognizer::_startAlternative(Frame &f)
+{
+  const unsigned code = _tokens[f.pos].code;
+  const uint32_t end = _tables.rules()[f.rule].end;
+  for (; f.alternative < end; f.alternative++) {
+    const ParseTables::Alternative &a = _tables.alternatives()[f.alternative];
+    if (a.fallback  &&  !f.ends.empty())
+      continue;
+    if (a.nullable  ||  a.first.contains(code)) {
+      f.item = a.begin;
+      f.current.assign(1, f.pos);
+      return;
+    }
+  }
+}
+
+void Recognizer::_startItem(Frame &f)
+{
+  const ParseTables::Item &item = _tables.items()[f.item];
+  f.work.clear();
+  for (uint32_t pos: f.current)
+    f.work.push_back(item.repeat == ParseTables::DeclSpecifiers ? pos << 2 : pos);
+  // Sorted ascending, a heap already.
+  if (item.repeat == ParseTables::Optional  ||  item.repeat == ParseTables::Star)
+    f.next = f.current;
+  else
+    f.next.clear();
+  f.last = UINT32_MAX;
+  f.expanding = true;
+}
+
+bool Recognizer::_lookup(Frame &f, uint32_t state, const uint32_t *&begin, const uint32_t *&end)
+{
+  const ParseTables::Item &item = _tables.items()[f.item];
+  const uint32_t pos = item.repeat == ParseTables::DeclSpecifiers ? state >> 2 : state;
+  begin = end = &_single;
+
+  if (item.terminal) {
+    if (_match(_tables.terminals()[item.symbol], pos)) {
+      _single = pos + 1;
+      end = begin + 1;
+    }
+    return true;
+  }
+
+  const unsigned code = _tokens[pos].code;
+  // A type-name after a type-specifier ends the decl-specifier-seq.
+  if (item.repeat == ParseTables::DeclSpecifiers  &&  (state & Seen)  &&  isTypeNameStart(code))
+    return true;
+  const ParseTables::Rule &rule = _tables.rules()[item.symbol];
+  if (!rule.first.contains(code)) {
+    if (rule.nullable) {
+      _single = pos;
+      end = begin + 1;
+    }
+    return true;
+  }
+  if (_memoize  &&  _memo.find(item.symbol, pos, begin, end)) {
+    _ruleStats[item.symbol].memoHits++;
+    return true;
+  }
+
+  f.state = state;
+  _push(item.symbol, pos);
+  return false;
+}
+
+void Recognizer::_expand(Frame &f, uint32_t state, const uint32_t *begin, const uint32_t *end)
+{
+  const ParseTables::Item &item = _tables.items()[f.item];
+  switch (item.repeat) {
+    case ParseTables::One:
+    case ParseTables::Optional:
+      f.next.insert(f.next.end(), begin, end);
+      break;
+    case ParseTables::Star:
+    case ParseTables::Plus:
+      for (const uint32_t *p = begin; p != end; p++) {
+        f.next.push_back(*p);
+        // Another round only from where a token was consumed.
+        if (*p > state) {
+          f.work.push_back(*p);
+          std::push_heap(f.work.begin(), f.work.end(), std::greater<uint32_t>());
+        }
+      }
+      break;
+    case ParseTables::DeclSpecifiers: {
+      const uint32_t pos = state >> 2;
+      const unsigned code = _tokens[pos].code;
+      uint32_t seen;
+      if (isTypeNameStart(code)) {
+        // The sequence ends before a type-name only if there was a
+        // type-specifier, or it is not one.
+        if ((state & Seen)  ||  begin == end) {
+          if (state & NonEmpty)
+            f.next.push_back(pos);
+          break;
+        }
+        seen = Seen;
+      } else {
+        if (state & NonEmpty)
+          f.next.push_back(pos);
+        seen = (state & Seen)  ||  isTypeSpecifier(code) ? Seen : 0;
+      }
+      for (const uint32_t *p = begin; p != end; p++) {
+        if (*p > pos) {
+          f.work.push_back(*p << 2 | seen | NonEmpty);
+          std::push_heap(f.work.begin(), f.work.end(), std::greater<uint32_t>());
+        }
+      }
+      break;
+    }
+  }
+}
+
+void Recognizer::_finish(Frame &f)
+{
+  std::sort(f.ends.begin(), f.ends.end());
+  f.ends.erase(std::unique(f.ends.begin(), f.ends.end()), f.ends.end());
+  if (_memoize) {
+    if (!_memo.fits(f.ends.size()))
+      _memo.evict(_floor(), f.ends.size());
+    _memo.insert(f.rule, f.pos, f.ends.data(), f.ends.data() + f.ends.size());
+  }
+  _depth--;
+}
+
+uint32_t Recognizer::_floor() const
+{
+  uint32_t floor = UINT32_MAX;
+  for (size_t i = 0; i < _depth; i++) {
+    const Frame &f = _frames[i];
+    // A frame goes on from the positions before its item, ascending, but
+    // the next alternative starts over from its own.
+    const bool more = f.alternative + 1 < _tables.rules()[f.rule].end;
+    floor = std::min(floor, more  ||  f.current.empty() ? f.pos : f.current.front());
+  }
+  return floor;
+}
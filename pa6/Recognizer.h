@@ -0,0 +1,123 @@
+#ifndef Recognizer_h
+#define Recognizer_h
+
+#include "NameClassifier.h"
+#include "PackratMemo.h"
+#include "ParseTables.h"
+#include "pa2/TokenStream.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Decides whether a token stream derives the start rule of ParseTables.
+//
+// The recognizer is top-down and generalized: what it computes for a rule
+// and a token position is every position the rule can end at from there,
+// so an ambiguous construct, a declaration or an expression, a type-id or
+// an expression in a template argument, is followed both ways at once
+// without backtracking, and the grammar is taken as it is written, not as
+// ordered choices. The end positions are memoized by rule and position in a
+// PackratMemo, so each rule is computed once at a position however many
+// callers ask, as long as the memo has room. A rule or alternative whose
+// FIRST set does not have the token at the position is not tried.
+//
+// Rules are run on a stack of frames of its own, not the call stack, and
+// repetitions are iterated within a frame, so the stack is as deep as the
+// nesting of the source, whatever its length.
+//
+// The type-name rule of decl-specifier-seq (7.1/3) is applied as the
+// parsers of the PA6 reference implementation do: a type-name is part of
+// the sequence if and only if no type-specifier but a cv-qualifier comes
+// before it.
+//
+// A recognizer may be used for one token stream after another, not by
+// threads at once.
+class Recognizer {
+public:
+  // Of a rule over the last stream: the times it was run, found in the memo
+  // instead, and an alternative of it failed after it was started.
+  struct RuleStats {
+    size_t calls;
+    size_t memoHits;
+    size_t backtracks;
+  };
+
+  // Looks names up through `names`, once per identifier of a stream.
+  // Memoizes in at most `memoBytes`; not at all if that is less than
+  // PackratMemo::minBytes(), such as 0.
+  Recognizer(const ParseTables &tables, NameLookupIfc &names,
+             size_t memoBytes = PackratMemo::DefaultMaxBytes);
+
+  // Whether `tokens`, which end with an eof, derive the start rule. Throws
+  // std::runtime_error for an invalid token.
+  bool recognize(const TokenStreamReader &tokens);
+
+  // Of the last stream: the tokens, with OP_RSHIFT split in two, the rules
+  // run, found in the memo and failed, and the deepest the stack was.
+  size_t tokens() const { return _tokens.size(); }
+  size_t calls() const { return _calls; }
+  size_t memoHits() const { return _memo.hits(); }
+  size_t backtracks() const { return _backtracks; }
+  size_t maxDepth() const { return _maxDepth; }
+  // By rule of the tables.
+  const std::vector<RuleStats> &ruleStats() const { return _ruleStats; }
+  const PackratMemo &memo() const { return _memo; }
+  const NameClassifier &names() const { return _names; }
+
+private:
+  struct Token {
+    uint8_t code;       // TokenCode
+    uint8_t flags;      // of ParseTables::Check
+    uint32_t source;    // string id
+  };
+
+  // A rule being run at a position.
+  struct Frame {
+    uint32_t rule;
+    uint32_t pos;
+    uint32_t alternative;
+    uint32_t item;
+    bool expanding;                     // the item
+    std::vector<uint32_t> current;      // positions before the item
+    std::vector<uint32_t> work;         // heap of states to expand the item from
+    std::vector<uint32_t> next;         // positions after the item
+    std::vector<uint32_t> ends;         // of the rule
+    uint32_t state;                     // the state a call was made for
+    uint32_t last;                      // popped from `work`
+  };
+
+  void _prepare(const TokenStreamReader &tokens);
+  bool _match(const ParseTables::Terminal &terminal, uint32_t pos);
+  Frame &_push(uint32_t rule, uint32_t pos);
+  // Starts the first alternative of `f` from its current one that the
+  // token at its position can start, if any.
+  void _startAlternative(Frame &f);
+  void _startItem(Frame &f);
+  // The ends of the item of `f` from `state` if known without a call;
+  // otherwise pushes the frame of the call, which invalidates `f`, and
+  // returns false.
+  bool _lookup(Frame &f, uint32_t state, const uint32_t *&begin, const uint32_t *&end);
+  void _expand(Frame &f, uint32_t state, const uint32_t *begin, const uint32_t *end);
+  // Memoizes the ends of `f` and pops it; they stay in the frame until the
+  // next push.
+  void _finish(Frame &f);
+  // The lowest position a rule being run can still ask the memo for.
+  uint32_t _floor() const;
+
+  const ParseTables &_tables;
+  NameClassifier _names;
+  std::vector<Token> _tokens;
+  std::vector<Frame> _frames;           // reused, the top at _depth - 1
+  size_t _depth;
+  PackratMemo _memo;
+  bool _memoize;
+  uint32_t _single;                     // the end of a terminal or an empty rule
+  size_t _calls;
+  size_t _backtracks;
+  size_t _maxDepth;
+  std::vector<RuleStats> _ruleStats;
+};
+
+#endif /* end of include guard */
@@ -0,0 +1,60 @@
+#include "Grammar.h"
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+
+TEST(Grammar, Rules)
+{
+  const Grammar g(
+    "list:\n"
+    "\titem (OP_COMMA item)* OP_COMMA?\n"
+    "\n"
+    "item:\n"
+    "\tTT_IDENTIFIER\n"
+    "\tOP_LPAREN list \\\n"
+    "\t  OP_RPAREN\n");
+  ASSERT_EQ(2u, g.rules().size());
+
+  const Grammar::Rule *list = g.rule("list");
+  ASSERT_NE(nullptr, list);
+  EXPECT_EQ(1u, list->line);
+  ASSERT_EQ(1u, list->alternatives.size());
+  const Grammar::Sequence &s = list->alternatives[0];
+  ASSERT_EQ(3u, s.size());
+  EXPECT_EQ(Grammar::Element::Nonterminal, s[0].kind);
+  EXPECT_EQ("item", s[0].name);
+  EXPECT_EQ(Grammar::Element::Group, s[1].kind);
+  EXPECT_EQ(Grammar::Element::Star, s[1].repeat);
+  ASSERT_EQ(2u, s[1].group.size());
+  EXPECT_EQ(Grammar::Element::Terminal, s[1].group[0].kind);
+  EXPECT_EQ("OP_COMMA", s[1].group[0].name);
+  EXPECT_EQ(Grammar::Element::Optional, s[2].repeat);
+
+  // A continued line is one alternative.
+  const Grammar::Rule *item = g.rule("item");
+  ASSERT_NE(nullptr, item);
+  EXPECT_EQ(4u, item->line);
+  ASSERT_EQ(2u, item->alternatives.size());
+  EXPECT_EQ(3u, item->alternatives[1].size());
+  EXPECT_EQ("OP_RPAREN", item->alternatives[1][2].name);
+
+  EXPECT_EQ(nullptr, g.rule("missing"));
+}
+
+TEST(Grammar, Errors)
+{
+  EXPECT_THROW(Grammar("a:\n\tb\n"), std::runtime_error);
+  EXPECT_THROW(Grammar("a:\n\t(TT_IDENTIFIER\n"), std::runtime_error);
+  EXPECT_THROW(Grammar("a:\n\tTT_IDENTIFIER)\n"), std::runtime_error);
+  EXPECT_THROW(Grammar("a:\n\t()\n"), std::runtime_error);
+  EXPECT_THROW(Grammar("a:\n\tTT_IDENTIFIER\na:\n\tTT_LITERAL\n"), std::runtime_error);
+  EXPECT_THROW(Grammar("\tTT_IDENTIFIER\n"), std::runtime_error);
+  EXPECT_THROW(Grammar("a:\n"), std::runtime_error);
+
+  try {
+    Grammar("a:\n\tTT_IDENTIFIER\n\nb:\n\tc\n");
+    FAIL();
+  } catch (const std::runtime_error &e) {
+    EXPECT_EQ("line 4: undefined rule c", std::string(e.what()));
+  }
+}
@@ -0,0 +1,78 @@
+#include "NameClassifier.h"
+#include <gtest/gtest.h>
+#include <map>
+#include <sstream>
+#include <string>
+
+namespace {
+
+  // Names declared as the test goes, counting the lookups of each.
+  struct Scope: NameLookupIfc {
+    uint8_t nameKinds(const std::string &identifier) override
+    {
+      lookups[identifier]++;
+      const auto it = declared.find(identifier);
+      return it == declared.end() ? 0 : it->second;
+    }
+
+    std::map<std::string, uint8_t> declared;
+    std::map<std::string, int> lookups;
+  };
+
+} // namespace
+
+TEST(NameClassifier, Classify)
+{
+  TokenStreamWriter writer;
+  writer.emit_identifier("vector");
+  writer.emit_identifier("x");
+  writer.emit_identifier("std");
+  writer.emit_identifier("vector");
+  writer.emit_eof();
+  std::ostringstream out;
+  writer.write(out);
+  const std::string data = out.str();
+  const TokenStreamReader tokens(data.data(), data.size());
+
+  Scope scope;
+  scope.declared["vector"] = 1 << TemplateName | 1 << ClassName;
+  scope.declared["std"] = 1 << NamespaceName;
+  NameClassifier names(scope);
+  names.reset(tokens);
+
+  const uint32_t vector = tokens[0].source;
+  const uint32_t x = tokens[1].source;
+  const uint32_t std = tokens[2].source;
+  EXPECT_EQ(vector, tokens[3].source);
+  for (int i = 0; i < 3; i++) {
+    EXPECT_TRUE(names.is(TemplateName, vector));
+    EXPECT_TRUE(names.is(ClassName, vector));
+    EXPECT_FALSE(names.is(TypedefName, vector));
+    EXPECT_TRUE(names.is(NamespaceName, std));
+    EXPECT_FALSE(names.is(EnumName, std));
+    EXPECT_EQ(0, names.kinds(x));
+  }
+  // Once each, whatever the kinds asked.
+  EXPECT_EQ(1, scope.lookups["vector"]);
+  EXPECT_EQ(1, scope.lookups["std"]);
+  EXPECT_EQ(1, scope.lookups["x"]);
+  EXPECT_EQ(3u, names.lookups());
+
+  // A declaration changes what the lookup answers.
+  scope.declared["x"] = 1 << TypedefName;
+  EXPECT_FALSE(names.is(TypedefName, x));
+  names.invalidate(x);
+  EXPECT_TRUE(names.is(TypedefName, x));
+  EXPECT_EQ(2, scope.lookups["x"]);
+  EXPECT_EQ(1, scope.lookups["std"]);
+
+  scope.declared.erase("vector");
+  names.invalidateAll();
+  EXPECT_FALSE(names.is(ClassName, vector));
+  EXPECT_TRUE(names.is(TypedefName, x));
+
+  names.reset(tokens);
+  EXPECT_EQ(0u, names.lookups());
+  EXPECT_TRUE(names.is(NamespaceName, std));
+  EXPECT_EQ(1u, names.lookups());
+}
@@ -0,0 +1,65 @@
+#include "PackratMemo.h"
+#include <gtest/gtest.h>
+#include <vector>
+
+TEST(PackratMemo, FindInsert)
+{
+  PackratMemo memo;
+  const uint32_t *begin;
+  const uint32_t *end;
+  EXPECT_FALSE(memo.find(1, 0, begin, end));
+
+  // Enough entries to grow the table a few times.
+  std::vector<uint32_t> ends;
+  for (uint32_t pos = 0; pos < 10000; pos++) {
+    ends.assign(pos % 3, pos + 1);
+    for (uint32_t rule = 0; rule < 3; rule++)
+      memo.insert(rule, pos, ends.data(), ends.data() + ends.size());
+  }
+  EXPECT_EQ(30000u, memo.size());
+  for (uint32_t pos = 0; pos < 10000; pos++) {
+    for (uint32_t rule = 0; rule < 3; rule++) {
+      ASSERT_TRUE(memo.find(rule, pos, begin, end));
+      ASSERT_EQ(pos % 3, end - begin);
+      for (const uint32_t *p = begin; p != end; p++)
+        EXPECT_EQ(pos + 1, *p);
+    }
+  }
+  EXPECT_FALSE(memo.find(3, 0, begin, end));
+  EXPECT_EQ(30000u, memo.hits());
+  EXPECT_EQ(2u, memo.misses());
+  EXPECT_EQ(memo.bytes(), memo.peakBytes());
+
+  memo.clear();
+  EXPECT_EQ(0u, memo.size());
+  EXPECT_FALSE(memo.find(0, 1, begin, end));
+}
+
+TEST(PackratMemo, Evict)
+{
+  PackratMemo memo(64 << 10);
+  const uint32_t *begin;
+  const uint32_t *end;
+  const uint32_t ends[] = {7, 8, 9};
+  uint32_t pos = 0;
+  for (; memo.fits(3); pos++)
+    memo.insert(0, pos, ends, ends + 3);
+  ASSERT_GT(pos, 100u);
+  EXPECT_LE(memo.bytes(), memo.maxBytes());
+
+  // Only what is behind the floor goes.
+  memo.evict(pos / 2, 3);
+  EXPECT_EQ(1u, memo.evictions());
+  EXPECT_EQ(pos / 2, memo.evicted());
+  EXPECT_TRUE(memo.fits(3));
+  EXPECT_FALSE(memo.find(0, pos / 2 - 1, begin, end));
+  ASSERT_TRUE(memo.find(0, pos / 2, begin, end));
+  EXPECT_EQ(3, end - begin);
+  EXPECT_EQ(9u, begin[2]);
+  ASSERT_TRUE(memo.find(0, pos - 1, begin, end));
+
+  // All go if what is ahead is too much.
+  memo.evict(0, 1 << 20);
+  EXPECT_EQ(0u, memo.size());
+  EXPECT_FALSE(memo.find(0, pos - 1, begin, end));
+}
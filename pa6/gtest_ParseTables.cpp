@@ -0,0 +1,126 @@
+#include "ParseTables.h"
+#include <gtest/gtest.h>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+  std::string readFile(const std::string &path)
+  {
+    std::ifstream in(path);
+    std::ostringstream text;
+    text << in.rdbuf();
+    return text.str();
+  }
+
+} // namespace
+
+TEST(ParseTables, First)
+{
+  const Grammar g(
+    "list:\n"
+    "\titem* ST_EOF\n"
+    "\n"
+    "item:\n"
+    "\tKW_INT? TT_IDENTIFIER\n"
+    "\tOP_LPAREN item+ OP_RPAREN\n");
+  const ParseTables tables(g, "list");
+  const ParseTables::Rule &list = tables.rules()[tables.start()];
+  EXPECT_EQ("list", list.name);
+  EXPECT_FALSE(list.nullable);
+  EXPECT_TRUE(list.first.contains(KW_INT));
+  EXPECT_TRUE(list.first.contains(TokenIdentifier));
+  EXPECT_TRUE(list.first.contains(OP_LPAREN));
+  EXPECT_TRUE(list.first.contains(TokenEof));
+  EXPECT_FALSE(list.first.contains(OP_RPAREN));
+
+  const int32_t item = tables.rule("item");
+  ASSERT_GE(item, 0);
+  const ParseTables::Rule &r = tables.rules()[item];
+  ASSERT_EQ(2u, r.end - r.begin);
+  const ParseTables::Alternative &a = tables.alternatives()[r.begin];
+  EXPECT_TRUE(a.first.contains(KW_INT));
+  EXPECT_TRUE(a.first.contains(TokenIdentifier));
+  EXPECT_FALSE(a.first.contains(OP_LPAREN));
+  EXPECT_EQ(ParseTables::Optional, tables.items()[a.begin].repeat);
+  EXPECT_EQ(-1, tables.rule("missing"));
+}
+
+TEST(ParseTables, Groups)
+{
+  const Grammar g(
+    "list:\n"
+    "\tTT_LITERAL (OP_COMMA TT_LITERAL)* ST_EOF\n");
+  const ParseTables tables(g, "list");
+  const int32_t group = tables.rule("list#1");
+  ASSERT_GE(group, 0);
+  EXPECT_TRUE(tables.rules()[group].first.contains(OP_COMMA));
+  EXPECT_EQ(ParseTables::Star, tables.items()[tables.alternatives()[tables.rules()[tables.start()].begin].begin + 1].repeat);
+}
+
+TEST(ParseTables, Names)
+{
+  const Grammar g(
+    "start:\n"
+    "\tclass-name TT_IDENTIFIER\n"
+    "\n"
+    "class-name:\n"
+    "\tTT_IDENTIFIER\n");
+  const ParseTables tables(g, "start");
+  size_t names = 0;
+  for (const ParseTables::Terminal &t: tables.terminals()) {
+    if (t.check == ParseTables::CheckName) {
+      EXPECT_EQ(ClassName, t.kind);
+      EXPECT_EQ(TokenIdentifier, t.code);
+      names++;
+    }
+  }
+  EXPECT_EQ(1u, names);
+}
+
+TEST(ParseTables, AngleVariants)
+{
+  const Grammar g(
+    "expression:\n"
+    "\tTT_LITERAL (relational-operator TT_LITERAL)*\n"
+    "\tTT_IDENTIFIER OP_LT expression close-angle-bracket\n"
+    "\tOP_LPAREN expression OP_RPAREN\n"
+    "\n"
+    "relational-operator:\n"
+    "\tOP_LT\n"
+    "\tOP_GT\n"
+    "\n"
+    "close-angle-bracket:\n"
+    "\tOP_GT\n");
+  const ParseTables tables(g, "expression");
+  const int32_t angle = tables.rule("relational-operator<>");
+  ASSERT_GE(angle, 0);
+  const ParseTables::Rule &r = tables.rules()[angle];
+  EXPECT_EQ(1u, r.end - r.begin);
+  EXPECT_FALSE(r.first.contains(OP_GT));
+  EXPECT_GE(tables.rule("expression<>"), 0);
+  // Not sensitive to the mode.
+  EXPECT_EQ(-1, tables.rule("close-angle-bracket<>"));
+}
+
+TEST(ParseTables, Errors)
+{
+  EXPECT_THROW(ParseTables(Grammar("a:\n\tKW_NONE\n"), "a"), std::runtime_error);
+  EXPECT_THROW(ParseTables(Grammar("a:\n\tTT_LITERAL\n"), "b"), std::runtime_error);
+  EXPECT_THROW(ParseTables(Grammar("a:\n\tb? a TT_LITERAL\n\nb:\n\tOP_PLUS\n"), "a"), std::runtime_error);
+}
+
+TEST(ParseTables, Grammars)
+{
+  for (const char *path: {"pa6.gram", "../pa7/pa7.gram", "../pa8/pa8.gram"}) {
+    const std::string text = readFile(path);
+    ASSERT_FALSE(text.empty()) << path;
+    const ParseTables tables(Grammar(text), "translation-unit");
+    EXPECT_GT(tables.rules().size(), 40u) << path;
+    const int32_t unqualified = tables.rule("unqualified-id");
+    ASSERT_GE(unqualified, 0) << path;
+    EXPECT_TRUE(tables.alternatives()[tables.rules()[unqualified].end - 1].fallback) << path;
+  }
+}
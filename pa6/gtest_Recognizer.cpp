@@ -0,0 +1,265 @@
+#include "Recognizer.h"
+#include <gtest/gtest.h>
+#include <cctype>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+  // Names as PA6 mocks them: with a C, a class name, and so on.
+  struct Names: NameLookupIfc {
+    uint8_t nameKinds(const std::string &identifier) override
+    {
+      uint8_t kinds = 0;
+      for (int kind = 0; kind < NumNameKinds; kind++) {
+        if (identifier.find("CTYEN"[kind]) != std::string::npos)
+          kinds |= 1 << kind;
+      }
+      return kinds;
+    }
+  };
+
+  // The token stream of the space-separated tokens of `text`.
+  class Tokens {
+  public:
+    explicit Tokens(const std::string &text)
+    {
+      TokenStreamWriter writer;
+      std::istringstream in(text);
+      std::string token;
+      const int value = 0;
+      while (in >> token) {
+        const auto simple = StringToTokenTypeMap.find(token);
+        if (simple != StringToTokenTypeMap.end())
+          writer.emit_simple(token, simple->second);
+        else if (token[0] == '"')
+          writer.emit_literal_array(token, token.size() - 1, FT_CHAR, token.data() + 1, token.size() - 1);
+        else if (std::isdigit(token[0]))
+          writer.emit_literal(token, FT_INT, &value, sizeof(value));
+        else
+          writer.emit_identifier(token);
+      }
+      writer.emit_eof();
+      std::ostringstream out;
+      writer.write(out);
+      _data = out.str();
+      _reader.reset(new TokenStreamReader(_data.data(), _data.size()));
+    }
+
+    const TokenStreamReader &reader() const { return *_reader; }
+
+  private:
+    std::string _data;
+    std::unique_ptr<TokenStreamReader> _reader;
+  };
+
+  const char *const Lists =
+    "list:\n"
+    "\titem* ST_EOF\n"
+    "\n"
+    "item:\n"
+    "\tTT_IDENTIFIER\n"
+    "\tTT_IDENTIFIER OP_LPAREN (item (OP_COMMA item)*)? OP_RPAREN\n"
+    "\tOP_LSQUARE ST_NONPAREN* OP_RSQUARE\n"
+    "\tST_ZERO OP_PLUS\n";
+
+  std::string readFile(const std::string &path)
+  {
+    std::ifstream in(path);
+    std::ostringstream text;
+    text << in.rdbuf();
+    return text.str();
+  }
+
+} // namespace
+
+TEST(Recognizer, Sequences)
+{
+  const ParseTables tables(Grammar(Lists), "list");
+  Names names;
+  Recognizer r(tables, names);
+  EXPECT_TRUE(r.recognize(Tokens("").reader()));
+  EXPECT_TRUE(r.recognize(Tokens("a b ( ) c ( d , e ( f ) )").reader()));
+  EXPECT_TRUE(r.recognize(Tokens("[ a + 1 ; ] 0 +").reader()));
+  EXPECT_FALSE(r.recognize(Tokens("a ( b").reader()));
+  EXPECT_FALSE(r.recognize(Tokens("a ( b , )").reader()));
+  EXPECT_FALSE(r.recognize(Tokens("[ ( ]").reader()));
+  EXPECT_FALSE(r.recognize(Tokens("1 +").reader()));
+  EXPECT_FALSE(r.recognize(Tokens(")").reader()));
+}
+
+TEST(Recognizer, Ambiguity)
+{
+  // Both alternatives of `pair` match a prefix; only one leads to the end.
+  const ParseTables tables(Grammar(
+    "start:\n"
+    "\tpair OP_SEMICOLON ST_EOF\n"
+    "\n"
+    "pair:\n"
+    "\tTT_IDENTIFIER TT_IDENTIFIER?\n"
+    "\tTT_IDENTIFIER OP_STAR TT_IDENTIFIER\n"
+    "\tTT_IDENTIFIER OP_STAR TT_IDENTIFIER OP_PLUS TT_IDENTIFIER\n"), "start");
+  Names names;
+  Recognizer r(tables, names);
+  EXPECT_TRUE(r.recognize(Tokens("a ;").reader()));
+  EXPECT_TRUE(r.recognize(Tokens("a b ;").reader()));
+  EXPECT_TRUE(r.recognize(Tokens("a * b ;").reader()));
+  EXPECT_TRUE(r.recognize(Tokens("a * b + c ;").reader()));
+  EXPECT_FALSE(r.recognize(Tokens("a * b + ;").reader()));
+}
+
+TEST(Recognizer, Memo)
+{
+  // Both alternatives of `entry` run `item`, the second from the memo.
+  const ParseTables tables(Grammar(
+    "list:\n"
+    "\tentry* ST_EOF\n"
+    "\n"
+    "entry:\n"
+    "\titem OP_SEMICOLON\n"
+    "\titem OP_COMMA\n"
+    "\n"
+    "item:\n"
+    "\tTT_IDENTIFIER (OP_LPAREN item* OP_RPAREN)?\n"), "list");
+  Names names;
+  Recognizer r(tables, names);
+  std::string text;
+  for (int i = 0; i < 10000; i++)
+    text += "a ( b c ( x ) ) , d ; ";
+  EXPECT_TRUE(r.recognize(Tokens(text).reader()));
+  EXPECT_EQ(20000u, r.memoHits());
+  // Repetitions do not deepen the frames.
+  EXPECT_LT(r.maxDepth(), 10u);
+
+
+  // Nesting deepens the frames, not the call stack.
+  text.clear();
+  for (int i = 0; i < 100000; i++)
+    text += "a ( ";
+  EXPECT_FALSE(r.recognize(Tokens(text + "a ;").reader()));
+  for (int i = 0; i < 100000; i++)
+    text += ") ";
+  EXPECT_TRUE(r.recognize(Tokens(text + ";").reader()));
+  EXPECT_GT(r.maxDepth(), 100000u);
+}
+
+TEST(Recognizer, MemoBytes)
+{
+  const Grammar g(Lists);
+  const ParseTables tables(g, "list");
+  Names names;
+  std::string text;
+  for (int i = 0; i < 20000; i++)
+    text += "a ( b , c ( [ x ] ) ) ";
+  const Tokens tokens(text);
+  const Tokens bad(text + "a (");
+
+  Recognizer full(tables, names);
+  EXPECT_TRUE(full.recognize(tokens.reader()));
+  EXPECT_EQ(0u, full.memo().evictions());
+
+  // A small memo evicts what is behind, and recognizes the same.
+  Recognizer small(tables, names, 64 << 10);
+  EXPECT_TRUE(small.recognize(tokens.reader()));
+  EXPECT_GT(small.memo().evictions(), 0u);
+  EXPECT_LE(small.memo().peakBytes(), 64u << 10);
+  EXPECT_EQ(full.calls(), small.calls());
+  EXPECT_FALSE(small.recognize(bad.reader()));
+  EXPECT_FALSE(full.recognize(bad.reader()));
+
+  Recognizer none(tables, names, 0);
+  EXPECT_TRUE(none.recognize(tokens.reader()));
+  EXPECT_EQ(0u, none.memoHits());
+  EXPECT_FALSE(none.recognize(bad.reader()));
+
+  // Too small a memo for one entry is no memo, not one that evicts always.
+  Recognizer tiny(tables, names, 4096);
+  EXPECT_TRUE(tiny.recognize(tokens.reader()));
+  EXPECT_EQ(0u, tiny.memo().evictions());
+  EXPECT_EQ(0u, tiny.memo().hits() + tiny.memo().misses());
+  EXPECT_FALSE(tiny.recognize(bad.reader()));
+  EXPECT_EQ(none.calls(), tiny.calls());
+}
+
+TEST(Recognizer, RuleStats)
+{
+  const ParseTables tables(Grammar(Lists), "list");
+  Names names;
+  Recognizer r(tables, names);
+  EXPECT_TRUE(r.recognize(Tokens("a b ( c )").reader()));
+  const Recognizer::RuleStats &item = r.ruleStats()[tables.rule("item")];
+  EXPECT_EQ(3u, item.calls);
+  // The call alternative fails after a and c.
+  EXPECT_EQ(2u, item.backtracks);
+  EXPECT_EQ(r.backtracks(), item.backtracks);
+}
+
+TEST(Recognizer, InvalidToken)
+{
+  const ParseTables tables(Grammar(Lists), "list");
+  Names names;
+  Recognizer r(tables, names);
+  TokenStreamWriter writer;
+  writer.emit_invalid("#");
+  writer.emit_eof();
+  std::ostringstream out;
+  writer.write(out);
+  const std::string data = out.str();
+  EXPECT_THROW(r.recognize(TokenStreamReader(data.data(), data.size())), std::runtime_error);
+
+  // Told where it is.
+  TokenStreamWriter located;
+  located.set_location(located.intern("t.cpp"), 3);
+  located.emit_invalid("#");
+  located.emit_eof();
+  try {
+    r.recognize(TokenStreamReader(located));
+    ADD_FAILURE();
+  } catch (const std::runtime_error &e) {
+    EXPECT_EQ(std::string("t.cpp:3: invalid token #"), e.what());
+  }
+}
+
+TEST(Recognizer, Cpp)
+{
+  const ParseTables tables(Grammar(readFile("pa6.gram")), "translation-unit");
+  Names names;
+  Recognizer r(tables, names);
+  auto recognize = [&](const std::string &text) { return r.recognize(Tokens(text).reader()); };
+
+  // Name kinds.
+  EXPECT_TRUE(recognize("C1 x ;"));
+  EXPECT_TRUE(recognize("Y1 x ;"));
+  EXPECT_FALSE(recognize("a x ;"));
+  EXPECT_TRUE(recognize("int x = N1 :: C1 :: y ;"));
+
+  // The type-name rule of decl-specifier-seq.
+  EXPECT_TRUE(recognize("int C1 ;"));
+  EXPECT_TRUE(recognize("C1 C2 ;"));
+  EXPECT_TRUE(recognize("static C1 ;"));
+  EXPECT_FALSE(recognize("C1 C2 x ;"));
+  EXPECT_FALSE(recognize("const C1 = 5 ;"));
+
+  // Angle brackets.
+  EXPECT_TRUE(recognize("TC1 < ( 1 > 2 ) > x ;"));
+  EXPECT_TRUE(recognize("TC1 < TC2 < 1 >> x ;"));
+  EXPECT_TRUE(recognize("int x [ ] = { a >> 1 } ;"));
+  EXPECT_FALSE(recognize("int x = TC1 < 3 >> 2 ;"));
+  EXPECT_FALSE(recognize("template < int a = 1 > 2 > int x ;"));
+
+  // A template-name followed by a template argument list is a template-id.
+  EXPECT_TRUE(recognize("int x = T1 < 2 ;"));
+  EXPECT_FALSE(recognize("int x = T1 < 1 > 2 > y ;"));
+  EXPECT_TRUE(recognize("int x = a < 1 > 2 > y ;"));
+
+  // Each identifier is looked up once.
+  EXPECT_TRUE(recognize("C1 C1 ( C1 ) ;"));
+  EXPECT_EQ(1u, r.names().lookups());
+
+  // Special terminals.
+  EXPECT_TRUE(recognize("struct C1 { virtual void f ( ) override final = 0 ; } ;"));
+  EXPECT_TRUE(recognize("int operator \"\" _x ( const char * ) ;"));
+}
@@ -1,13 +1,33 @@
 // (C) 2013 CPPGM Foundation www.cppgm.org.  All rights reserved.
 
+#include "pa2/PostTokenizer.h"
+#include "pa2/TokenStream.h"
+#include "pa3/OrderedPool.h"
+#include "pa5/FileSystem.h"
+#include "pa5/PreprocessorSession.h"
+#include "Grammar.h"
+#include "ParseTables.h"
+#include "Recognizer.h"
+
+#include <algorithm>
+#include <ctime>
+#include <memory>
+#include <thread>
+#include <utility>
 #include <vector>
 #include <string>
+#include <sstream>
 #include <stdexcept>
 #include <fstream>
 #include <iostream>
 
 using namespace std;
 
+// the text of pa6.gram, embedded by the Makefile
+const char* PA6Grammar =
+#include "pa6gram.h"
+;
+
 bool PA6_IsClassName(const string& identifier)
 {
 	return identifier.find('C') != string::npos;
@@ -33,12 +53,215 @@ bool PA6_IsNamespaceName(const string& identifier)
 	return identifier.find('N') != string::npos;
 }
 
-void DoRecog(istream& in)
+// the mock name lookup above, for the recognizer, which asks once per
+// identifier of a srcfile
+struct PA6NameLookup : NameLookupIfc
+{
+	uint8_t nameKinds(const string& identifier) override
+	{
+		return PA6_IsClassName(identifier) << ClassName | PA6_IsTemplateName(identifier) << TemplateName |
+			PA6_IsTypedefName(identifier) << TypedefName | PA6_IsEnumName(identifier) << EnumName |
+			PA6_IsNamespaceName(identifier) << NamespaceName;
+	}
+};
+
+typedef pair<unsigned long int, unsigned long int> PA6FileId;
+
+// bootstrap system call interface, used by PA6GetFileId
+extern "C" long int syscall(long int n, ...) throw ();
+
+// PA6GetFileId returns true iff file found at path `path`.
+// out parameter `out_fileid` is set to file id
+bool PA6GetFileId(const string& path, PA6FileId& out_fileid)
+{
+	struct
+	{
+			unsigned long int dev;
+			unsigned long int ino;
+			long int unused[16];
+	} data;
+
+	int res = syscall(4, path.c_str(), &data);
+
+	out_fileid = make_pair(data.dev, data.ino);
+
+	return res == 0;
+}
+
+// post-tokenizes the preprocessed tokens of a srcfile into a token stream,
+// each at its line in the file it is output from, which the preprocessor
+// tells as it enters and leaves the files
+class PA6TokenOutput : public PreprocessorOutputIfc, public PreprocessorIncludeIfc
+{
+public:
+	explicit PA6TokenOutput(const SpellingTable& spellings)
+		: spellings(spellings), posttokenizer(writer)
+	{}
+
+	void put(const MacroToken* first, const MacroToken* last) override
+	{
+		const uint32_t file = files.empty() ? 0 : files.back();
+		for (; first != last; ++first)
+		{
+			source.assign(spellings.data(first->spelling), spellings.length(first->spelling));
+			posttokenizer.put(first->type, source, file, first->line);
+		}
+	}
+
+	void enter(const string& path, const SourceFile&) override
+	{
+		files.push_back(writer.intern(path));
+	}
+
+	void leave() override
+	{
+		files.pop_back();
+	}
+
+	void skip(const string&, const SourceFileId&) override {}
+	void output(size_t) override {}
+
+	// the tokens, ending with eof, read in place by a TokenStreamReader
+	const TokenStreamWriter& finish()
+	{
+		posttokenizer.finish();
+		return writer;
+	}
+
+private:
+	const SpellingTable& spellings;
+	TokenStreamWriter writer;
+	PostTokenizer<TokenStreamWriter> posttokenizer;
+	vector<uint32_t> files; // string ids of the files entered and not left
+	string source;
+};
+
+// what recognizing the srcfiles shares: one session, whose spellings and
+// files every thread uses, and the translation-unit tables, compiled once
+struct PA6Context
+{
+	PA6Context()
+		: disk(PA6GetFileId), session(disk), tables(Grammar(PA6Grammar), "translation-unit")
+	{
+		// the build date and time, the same for all srcfiles
+		const time_t now = ::time(nullptr);
+		const string build = asctime(localtime(&now));
+		date = build.substr(4, 7) + build.substr(20, 4);
+		time = build.substr(11, 8);
+	}
+
+	DiskFileSystem disk;
+	PreprocessorSession session;
+	ParseTables tables;
+	string date;
+	string time;
+	bool token_streams = false; // the srcfiles are token streams, written by posttoken -o
+};
+
+// a srcfile recognized on a thread of the pool, into buffers
+struct PA6Job
 {
-	if (/* TODO: implement PA6 */ false)
-		return;
-	else
-		throw logic_error("not yet implemented");
+	string srcfile;
+	bool stats;
+	string output;
+	string errors;
+};
+
+// preprocesses, post-tokenizes and recognizes srcfiles, or maps their token
+// streams and recognizes them, on one thread, with a
+// recognizer of its own, whose memo is bounded by `memo_bytes`, 0 for none
+class PA6Recognizer
+{
+public:
+	PA6Recognizer(PA6Context& context, size_t memo_bytes)
+		: context(context), recognizer(context.tables, names, memo_bytes)
+	{}
+
+	// writes the status line of the srcfile to `out`, and why it is BAD and
+	// the stats, if asked for, to `err`
+	void DoRecog(const string& srcfile, bool stats, ostream& out, ostream& err)
+	{
+		try
+		{
+			if (context.token_streams)
+			{
+				Recognize(TokenStreamReader(srcfile), srcfile);
+			}
+			else
+			{
+				PreprocessorSession::Request request;
+				request.path = srcfile;
+				request.date = context.date;
+				request.time = context.time;
+
+				PA6TokenOutput output(context.session.spellings());
+				request.includes = &output;
+				context.session.run(request, output);
+				Recognize(TokenStreamReader(output.finish()), srcfile);
+			}
+			out << srcfile << " OK" << endl;
+		}
+		catch (exception& e)
+		{
+			err << e.what() << endl;
+			out << srcfile << " BAD" << endl;
+		}
+		if (stats)
+			WriteStats(srcfile, err);
+	}
+
+	// recognizes the srcfile of `job` into its buffers, on a thread of the pool
+	void run(PA6Job& job)
+	{
+		ostringstream out;
+		ostringstream err;
+		DoRecog(job.srcfile, job.stats, out, err);
+		job.output = out.str();
+		job.errors = err.str();
+	}
+
+private:
+	void Recognize(const TokenStreamReader& tokens, const string& srcfile)
+	{
+		if (!recognizer.recognize(tokens))
+			throw runtime_error("not a translation-unit: " + srcfile);
+	}
+
+	// writes the stats of the last srcfile to `err`: the memo, and the rules
+	// whose alternatives failed most
+	void WriteStats(const string& srcfile, ostream& err)
+	{
+		const PackratMemo& memo = recognizer.memo();
+		const size_t lookups = memo.hits() + memo.misses();
+		err << srcfile << ": tokens: " << recognizer.tokens() << ", rules run: " << recognizer.calls()
+			<< ", deepest: " << recognizer.maxDepth() << endl;
+		err << "memo hits: " << memo.hits() << " of " << lookups << " ("
+			<< (lookups ? 100 * memo.hits() / lookups : 0) << "%), entries: " << memo.size()
+			<< ", peak bytes: " << memo.peakBytes() << ", evictions: " << memo.evictions()
+			<< ", entries evicted: " << memo.evicted() << endl;
+
+		const vector<Recognizer::RuleStats>& stats = recognizer.ruleStats();
+		vector<size_t> rules;
+		for (size_t i = 0; i < stats.size(); i++)
+			if (stats[i].backtracks)
+				rules.push_back(i);
+		sort(rules.begin(), rules.end(), [&](size_t a, size_t b)
+		{
+			return stats[a].backtracks > stats[b].backtracks;
+		});
+		err << "names looked up: " << recognizer.names().lookups() << endl;
+		err << "backtracks: " << recognizer.backtracks() << endl;
+		for (size_t i = 0; i < rules.size() && i < 10; i++)
+		{
+			const Recognizer::RuleStats& rule = stats[rules[i]];
+			err << "  " << context.tables.rules()[rules[i]].name << ": " << rule.backtracks << " backtracks, "
+				<< rule.calls << " runs, " << rule.memoHits << " memo hits" << endl;
+		}
+	}
+
+	PA6Context& context;
+	PA6NameLookup names;
+	Recognizer recognizer;
 };
 
 int main(int argc, char** argv)
@@ -50,31 +273,69 @@ int main(int argc, char** argv)
 		for (int i = 1; i < argc; i++)
 			args.emplace_back(argv[i]);
 
+		// recog -o <outfile> [--stats] [--tokens] [-j <threads>] [--memo-bytes <n>] <srcfile>...
+		// where the memo bound is for the whole process, split evenly among the threads,
+		// and with --tokens the srcfiles are token streams, written by posttoken -o
 		if (args.size() < 3 || args[0] != "-o")
 			throw logic_error("invalid usage");
 
 		string outfile = args[1];
-		size_t nsrcfiles = args.size() - 2;
+		vector<string> srcfiles;
+		bool stats = false;
+		bool token_streams = false;
+		size_t nthreads = thread::hardware_concurrency();
+		size_t memo_bytes = PackratMemo::DefaultMaxBytes;
+		// the value of -j or --memo-bytes, all digits
+		const auto count = [&](const string& value) -> size_t
+		{
+			if (value.empty() || value.find_first_not_of("0123456789") != string::npos)
+				throw logic_error("usage: " + string(argv[0]) + " -o <outfile> [-j <threads>] [--memo-bytes <n>] <srcfile>...");
+			return stoul(value);
+		};
+		for (size_t i = 2; i < args.size(); i++)
+		{
+			if (args[i] == "--stats")
+				stats = true;
+			else if (args[i] == "--tokens")
+				token_streams = true;
+			else if (args[i] == "-j" && i + 1 < args.size())
+				nthreads = count(args[++i]);
+			else if (args[i] == "--memo-bytes" && i + 1 < args.size())
+				memo_bytes = count(args[++i]);
+			else if (args[i][0] == '-')
+				throw logic_error("invalid usage");
+			else
+				srcfiles.push_back(args[i]);
+		}
+		nthreads = min(nthreads, srcfiles.size());
 
 		ofstream out(outfile);
 
-		out << "recog " << nsrcfiles << endl;
+		out << "recog " << srcfiles.size() << endl;
 
-		for (size_t i = 0; i < nsrcfiles; i++)
-		{
-			string srcfile = args[i+2];
+		PA6Context context;
+		context.token_streams = token_streams;
 
-			try
-			{
-				ifstream in(srcfile);
-				DoRecog(in);
-				out << srcfile << " OK" << endl;
-			}
-			catch (exception& e)
-			{
-				cerr << e.what() << endl;
-				out << srcfile << " BAD" << endl;
-			}
+		if (nthreads <= 1)
+		{
+			PA6Recognizer recognizer(context, memo_bytes);
+			for (const string& srcfile : srcfiles)
+				recognizer.DoRecog(srcfile, stats, out, cerr);
+		}
+		else
+		{
+			// each thread with a recognizer of its own, the output in command-line order, so it is the
+			// same as on one thread
+			OrderedPool<PA6Job, PA6Recognizer> pool(nthreads, 4 * nthreads,
+				[&] { return unique_ptr<PA6Recognizer>(new PA6Recognizer(context, memo_bytes / nthreads)); },
+				[&](PA6Job& job)
+				{
+					out << job.output;
+					cerr << job.errors;
+				});
+			for (const string& srcfile : srcfiles)
+				pool.submit(unique_ptr<PA6Job>(new PA6Job{srcfile, stats, string(), string()}));
+			pool.finish();
 		}
 	}
 	catch (exception& e)
@@ -83,4 +344,3 @@ int main(int argc, char** argv)
 		return EXIT_FAILURE;
 	}
 }
-